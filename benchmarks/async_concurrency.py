@@ -0,0 +1,35 @@
+import os
+
+import yaml
+
+from async_cases import *
+
+import taichi as ti
+
+# Runs the async cases on the CPU with one and with several concurrently
+# executing tasks. Each setting is written to benchmark.yml as a case of its
+# own, e.g. fill_scalar_x1 and fill_scalar_x4.
+
+cases = [
+    chain_copy, increments, fill_array, fill_scalar, sparse_saxpy, autodiff,
+    stencil_reduction
+]
+
+for c in cases:
+    for concurrency in [1, 4]:
+        name = f'{c.__name__}_x{concurrency}'
+        print(f'* Running {name}')
+        os.environ['TI_CURRENT_BENCHMARK'] = name
+        ti.init(arch=ti.cpu,
+                async_mode=True,
+                async_max_concurrent_tasks=concurrency,
+                verbose=False)
+        c.__wrapped__(2)
+
+with open('benchmark.yml') as f:
+    data = yaml.load(f, Loader=yaml.SafeLoader)
+for c in cases:
+    t1, t4 = (data[f'{c.__name__}_x{concurrency}']['wall_clk_t']['x64']
+              ['async'] for concurrency in [1, 4])
+    print(f'{c.__name__}: {t1 * 1000:.3f} ms -> {t4 * 1000:.3f} ms '
+          f'({t1 / t4:.2f}x)')
@@ -0,0 +1,57 @@
+import time
+
+import taichi as ti
+
+# Host time of flushing the same launch sequence every frame in async mode,
+# with and without reusing the optimized task lists of earlier flushes.
+
+n = 1024 * 1024
+num_substeps = 16
+frames = 200
+
+
+def measure(trace_cache):
+    ti.init(arch=ti.cpu,
+            async_mode=True,
+            async_flush_every=0,
+            async_opt_trace_cache=trace_cache,
+            verbose=False)
+    x = ti.field(ti.f32)
+    y = ti.field(ti.f32)
+    ti.root.pointer(ti.i, n // 256).dense(ti.i, 256).place(x, y)
+
+    @ti.kernel
+    def init():
+        for i in range(0, n, 3):
+            x[i] = 1
+
+    @ti.kernel
+    def scale(k: ti.f32):
+        for i in x:
+            x[i] *= k
+
+    @ti.kernel
+    def gather():
+        for i in x:
+            y[i] += x[i]
+
+    init()
+    ti.sync()
+    flush_t = 0
+    for frame in range(frames + 1):
+        for _ in range(num_substeps):
+            scale(0.5)
+            scale(2)
+            gather()
+        t = time.perf_counter()
+        ti.async_flush()
+        if frame > 0:
+            flush_t += time.perf_counter() - t
+        ti.sync()
+    return flush_t / frames
+
+
+without_cache = measure(False)
+with_cache = measure(True)
+print(f'flush latency: {without_cache * 1000:.3f} ms -> '
+      f'{with_cache * 1000:.3f} ms ({without_cache / with_cache:.2f}x)')
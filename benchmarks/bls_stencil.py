@@ -0,0 +1,41 @@
+import taichi as ti
+
+# A 3D 7-point stencil over a sparse grid, reading its input straight from the
+# field or through a BLS buffer holding each block and its halo.
+
+n = 256
+block_size = 8
+
+
+def _benchmark_stencil_3d(use_bls):
+    x = ti.field(ti.f32)
+    y = ti.field(ti.f32)
+    block = ti.root.pointer(ti.ijk, n // block_size)
+    block.dense(ti.ijk, block_size).place(x)
+    block.dense(ti.ijk, block_size).place(y)
+
+    @ti.kernel
+    def populate():
+        for i, j, k in ti.ndrange((1, n - 1), (1, n - 1), (1, n - 1)):
+            x[i, j, k] = ti.sin(i * 0.1) + ti.cos(j * 0.2) + k * 0.01
+
+    @ti.kernel
+    def stencil():
+        if ti.static(use_bls):
+            ti.block_local(x)
+        for i, j, k in x:
+            y[i, j, k] = x[i, j, k] * 6 - x[i - 1, j, k] - x[i + 1, j, k] - x[
+                i, j - 1, k] - x[i, j + 1, k] - x[i, j, k - 1] - x[i, j, k + 1]
+
+    populate()
+    ti.benchmark(stencil, repeat=50)
+
+
+@ti.test(arch=ti.cpu)
+def benchmark_stencil_3d_bls():
+    _benchmark_stencil_3d(use_bls=True)
+
+
+@ti.test(arch=ti.cpu)
+def benchmark_stencil_3d_no_bls():
+    _benchmark_stencil_3d(use_bls=False)
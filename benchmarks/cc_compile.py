@@ -0,0 +1,43 @@
+import tempfile
+import time
+
+import taichi as ti
+
+# Time to the first launch of many kernels on the C backend: compiled one at
+# a time on first launch, compiled as a batch, and loaded from the cache.
+
+num_kernels = 16
+
+
+def compile_and_run(cache_dir, batch):
+    ti.init(arch=ti.cc, offline_cache=True, offline_cache_file_path=cache_dir)
+    n = 1024
+    x = ti.field(ti.f32, shape=n)
+
+    # Binds k per kernel: ti.static(k + 1) is evaluated when a kernel is
+    # compiled, after the loop would have finished.
+    def make(k):
+
+        @ti.kernel
+        def step():
+            for i in x:
+                x[i] = ti.sin(x[i]) * ti.static(k + 1) + ti.sqrt(ti.abs(x[i]))
+
+        return step
+
+    kernels = [make(k) for k in range(num_kernels)]
+
+    t = time.time()
+    if batch:
+        ti.precompile(*kernels)
+    for step in kernels:
+        step()
+    return time.time() - t
+
+
+def benchmark_cc_compile():
+    with tempfile.TemporaryDirectory() as cache_dir:
+        ti.stat_write('one_by_one_t', compile_and_run(cache_dir, batch=False))
+    with tempfile.TemporaryDirectory() as cache_dir:
+        ti.stat_write('batch_t', compile_and_run(cache_dir, batch=True))
+        ti.stat_write('cached_t', compile_and_run(cache_dir, batch=True))
@@ -0,0 +1,52 @@
+import multiprocessing
+import time
+
+import taichi as ti
+
+# Compares the range-for loops of the C backend with those of the LLVM CPU
+# backend, on a single thread and on all of them.
+
+n = 8 * 1024 * 1024
+repeat = 10
+
+
+def measure(arch, num_threads):
+    ti.init(arch=arch, cpu_max_num_threads=num_threads)
+    x = ti.field(ti.f32, shape=n)
+    y = ti.field(ti.f32, shape=n)
+    total = ti.field(ti.f32, shape=())
+
+    @ti.kernel
+    def saxpy(a: ti.f32):
+        for i in range(n):
+            y[i] = a * x[i] + y[i]
+
+    @ti.kernel
+    def reduce():
+        for i in range(n):
+            total[None] += y[i]
+
+    saxpy(1.0)
+    reduce()
+    ti.sync()
+    t = time.time()
+    for _ in range(repeat):
+        saxpy(0.5)
+    ti.sync()
+    saxpy_t = (time.time() - t) / repeat
+    t = time.time()
+    for _ in range(repeat):
+        reduce()
+    ti.sync()
+    reduce_t = (time.time() - t) / repeat
+    return saxpy_t, reduce_t
+
+
+def benchmark_cc_parallel_range_for():
+    max_threads = multiprocessing.cpu_count()
+    for arch in [ti.cpu, ti.cc]:
+        for num_threads in [1, max_threads]:
+            # Recorded per arch by stat_write.
+            saxpy_t, reduce_t = measure(arch, num_threads)
+            ti.stat_write(f'saxpy_{num_threads}_threads_t', saxpy_t)
+            ti.stat_write(f'reduce_{num_threads}_threads_t', reduce_t)
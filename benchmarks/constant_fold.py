@@ -0,0 +1,44 @@
+import time
+
+import taichi as ti
+
+# Compiles kernels full of constant expressions over many op/type
+# combinations, with and without constant folding. Folding used to compile
+# an evaluator kernel for each new combination; the difference between the
+# two timings is what folding costs at compile time.
+
+dtypes = [ti.i32, ti.i64, ti.u32, ti.u64, ti.f32, ti.f64]
+num_kernels = 8
+
+
+def compile_time(constant_folding):
+    ti.init(arch=ti.cpu, constant_folding=constant_folding)
+    x = ti.field(ti.f64, shape=len(dtypes))
+
+    def make_kernel(k):
+        @ti.kernel
+        def fold():
+            for i, dt in ti.static(enumerate(dtypes)):
+                a = ti.cast(ti.static(k + 7), dt)
+                b = ti.cast(3, dt)
+                c = (a + b) * (a - b) // b + a % b
+                c = ti.max(c, b) - ti.min(a, b)
+                if ti.static(dt in [ti.f32, ti.f64]):
+                    c += ti.sqrt(a) / b + ti.sin(a) * ti.exp(b)
+                else:
+                    c += (a << 2) >> 1 | (a & b) ^ ~b
+                x[i] = ti.cast(c, ti.f64) + ti.cast(a < b, ti.f64)
+
+        return fold
+
+    kernels = [make_kernel(k) for k in range(num_kernels)]
+    t = time.time()
+    for fold in kernels:
+        fold()
+    ti.sync()
+    return time.time() - t
+
+
+def benchmark_constant_fold_compile_time():
+    ti.stat_write('no_folding_compile_t', compile_time(False))
+    ti.stat_write('folding_compile_t', compile_time(True))
@@ -0,0 +1,36 @@
+import time
+
+import taichi as ti
+
+# Launches kernels of increasing size in async mode, where every new
+# offloaded task is hashed before it is inserted into the state flow graph.
+# The launch time includes lowering the kernel; the time spent hashing alone
+# is the `hash` entry of the printed profile.
+
+sizes = [250, 1000, 4000]
+
+
+def launch_time(num_steps):
+    ti.init(arch=ti.cpu, async_mode=True, async_flush_every=0, verbose=False)
+    x = ti.field(ti.f32, shape=16)
+
+    @ti.kernel
+    def generated():
+        for i in x:
+            v = x[i]
+            for k in ti.static(range(num_steps)):
+                v = v * 0.5 + ti.sin(v + k)
+            x[i] = v
+
+    ti.clear_profile_info()
+    t = time.time()
+    generated()
+    t = time.time() - t
+    ti.print_profile_info()
+    ti.sync()
+    return t
+
+
+def benchmark_ir_hash():
+    for n in sizes:
+        ti.stat_write(f'ir_hash_launch_{n}_t', launch_time(n))
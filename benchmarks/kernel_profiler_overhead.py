@@ -0,0 +1,43 @@
+import time
+
+import taichi as ti
+
+# Time per launch of microsecond kernels with and without the kernel profiler
+# on CPU. The profiler's overhead should stay within a few percent.
+
+steps = 5000
+
+
+def time_per_launch(kernel_profiler):
+    ti.init(arch=ti.cpu, kernel_profiler=kernel_profiler, verbose=False)
+    x = ti.field(ti.f32, shape=4096)
+
+    @ti.kernel
+    def tiny():
+        for i in x:
+            x[i] += 1
+
+    @ti.kernel
+    def serial():
+        x[0] += 1
+
+    times = []
+    for kernel in [tiny, serial]:
+        kernel()
+        ti.sync()
+        t = time.perf_counter()
+        for _ in range(steps):
+            kernel()
+        ti.sync()
+        times.append((time.perf_counter() - t) / steps)
+    return times
+
+
+def benchmark_kernel_profiler_overhead():
+    base = time_per_launch(False)
+    profiled = time_per_launch(True)
+    for name, t0, t1 in zip(['range_for', 'serial'], base, profiled):
+        ti.stat_write(f'kernel_profiler_{name}_t', t0)
+        ti.stat_write(f'kernel_profiler_{name}_profiled_t', t1)
+        print(f'{name}: {t0 * 1e6:.2f} us -> {t1 * 1e6:.2f} us '
+              f'(+{(t1 / t0 - 1) * 100:.1f}%)')
@@ -0,0 +1,55 @@
+import time
+
+import taichi as ti
+
+# Host overhead of launching a fixed sequence of tiny kernels, as in the time
+# step loop of a solver: once from Python, once as a replayed ti.LaunchGraph.
+
+num_kernels = 20
+steps = 2000
+
+
+def measure(**kwargs):
+    ti.init(arch=ti.cpu, **kwargs)
+    x = ti.field(ti.f32, shape=num_kernels)
+
+    def make_step(k):
+        @ti.kernel
+        def step(dt: ti.f32):
+            x[k] += dt
+
+        return step
+
+    kernels = [make_step(k) for k in range(num_kernels)]
+
+    def run_python():
+        for step in kernels:
+            step(1e-3)
+
+    graph = ti.LaunchGraph()
+    with graph.capture():
+        for step in kernels:
+            step(graph.arg('dt', 1e-3))
+
+    times = []
+    for run in [run_python, graph.run]:
+        run()
+        ti.sync()
+        t = time.time()
+        for _ in range(steps):
+            run()
+        ti.sync()
+        times.append((time.time() - t) / (steps * num_kernels))
+    return times
+
+
+def benchmark_launch_overhead():
+    python_t, graph_t = measure()
+    ti.stat_write('launch_overhead_python_t', python_t)
+    ti.stat_write('launch_overhead_graph_t', graph_t)
+
+
+def benchmark_launch_overhead_async():
+    python_t, graph_t = measure(cpu_async_launch=True)
+    ti.stat_write('launch_overhead_async_python_t', python_t)
+    ti.stat_write('launch_overhead_async_graph_t', graph_t)
@@ -0,0 +1,52 @@
+import multiprocessing
+import time
+
+import taichi as ti
+
+# Struct-for over sparse grids with millions of blocks, where generating the
+# element lists dominates.
+
+
+def measure(num_threads, deterministic):
+    ti.init(arch=ti.cpu,
+            cpu_max_num_threads=num_threads,
+            cpu_deterministic_listgen=deterministic)
+    a = ti.field(dtype=ti.f32)
+    N = 2048
+
+    ti.root.pointer(ti.ij, [N, N]).bitmasked(ti.ij, [2, 2]).place(a)
+
+    @ti.kernel
+    def fill():
+        for i, j in ti.ndrange(N * 2, N * 2):
+            if (i + j) % 3 == 0:
+                a[i, j] = 1.0
+
+    @ti.kernel
+    def scale():
+        for i, j in a:
+            a[i, j] *= 2.0
+
+    fill()
+    scale()
+    ti.sync()
+    t = time.time()
+    repeat = 10
+    for _ in range(repeat):
+        scale()
+    ti.sync()
+    return (time.time() - t) / repeat
+
+
+def benchmark_listgen_serial():
+    ti.stat_write('serial_t', measure(1, True))
+
+
+def benchmark_listgen_parallel_deterministic():
+    ti.stat_write('parallel_deterministic_t',
+                  measure(multiprocessing.cpu_count(), True))
+
+
+def benchmark_listgen_parallel_nondeterministic():
+    ti.stat_write('parallel_nondeterministic_t',
+                  measure(multiprocessing.cpu_count(), False))
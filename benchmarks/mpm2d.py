@@ -239,3 +239,68 @@ def benchmark_struct():
         Jp[i] = 1
 
     ti.benchmark(substep, repeat=4000)
+
+
+def _benchmark_p2g(use_bls):
+    # The P2G scatter of the substeps above, with the particles bucketed into
+    # the grid blocks so that the grid can be cached with BLS.
+    n_grid, block_size, ppc = 256, 16, 8
+    n_particles = n_grid**2 * ppc // 4
+    dx, inv_dx = 1 / n_grid, float(n_grid)
+    p_mass = (dx * 0.5)**2
+
+    x = ti.Vector.field(2, dtype=ti.f32, shape=n_particles)
+    v = ti.Vector.field(2, dtype=ti.f32, shape=n_particles)
+    grid_v = ti.Vector.field(2, dtype=ti.f32)
+    grid_m = ti.field(dtype=ti.f32)
+    pid = ti.field(dtype=ti.i32)
+    block = ti.root.pointer(ti.ij, n_grid // block_size)
+    block.dense(ti.ij, block_size).place(grid_v, grid_m)
+    block.dynamic(ti.l, block_size**2 * ppc * 16,
+                  chunk_size=block_size**2 * ppc).place(pid)
+
+    @ti.kernel
+    def init():
+        for p in x:
+            x[p] = [ti.random() * 0.5 + 0.25, ti.random() * 0.5 + 0.25]
+            v[p] = [ti.random() - 0.5, ti.random() - 0.5]
+
+    @ti.kernel
+    def insert():
+        for p in x:
+            base = ti.floor(x[p] * inv_dx - 0.5).cast(int)
+            ti.append(pid.parent(), ti.rescale_index(grid_m, pid, base), p)
+
+    @ti.kernel
+    def p2g():
+        if ti.static(use_bls):
+            ti.block_local(grid_v, grid_m)
+        for I in ti.grouped(pid):
+            p = pid[I]
+            base_ = ti.floor(x[p] * inv_dx - 0.5).cast(int)
+            Im = ti.rescale_index(pid, grid_m, I)
+            base = ti.Vector([
+                ti.assume_in_range(base_[0], Im[0], 0, 1),
+                ti.assume_in_range(base_[1], Im[1], 0, 1)
+            ])
+            fx = x[p] * inv_dx - base.cast(float)
+            w = [0.5 * (1.5 - fx)**2, 0.75 - (fx - 1)**2, 0.5 * (fx - 0.5)**2]
+            for i, j in ti.static(ti.ndrange(3, 3)):
+                offset = ti.Vector([i, j])
+                weight = w[i][0] * w[j][1]
+                grid_v[base + offset] += weight * p_mass * v[p]
+                grid_m[base + offset] += weight * p_mass
+
+    init()
+    insert()
+    ti.benchmark(p2g, repeat=100)
+
+
+@ti.test(arch=ti.cpu)
+def benchmark_p2g_bls():
+    _benchmark_p2g(use_bls=True)
+
+
+@ti.test(arch=ti.cpu)
+def benchmark_p2g_no_bls():
+    _benchmark_p2g(use_bls=False)
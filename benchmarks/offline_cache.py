@@ -0,0 +1,40 @@
+import tempfile
+import time
+
+import taichi as ti
+
+
+def compile_and_run(cache_dir):
+    ti.init(arch=ti.cpu, offline_cache=True, offline_cache_file_path=cache_dir)
+    n = 1024 * 1024
+    x = ti.field(ti.f32, shape=n)
+
+    # Binds k per kernel: ti.static(k + 1) is evaluated when a kernel is
+    # compiled, after the loop would have finished.
+    def make(k):
+
+        @ti.kernel
+        def step():
+            for i in x:
+                x[i] = ti.sin(x[i]) * ti.static(k + 1) + ti.sqrt(ti.abs(x[i]))
+
+        return step
+
+    kernels = [make(k) for k in range(16)]
+
+    t = time.time()
+    for step in kernels:
+        step()
+    ti.sync()
+    return time.time() - t
+
+
+@ti.archs_support_sparse
+def benchmark_offline_cache_cold_vs_warm_start():
+    if ti.cfg.arch != ti.cpu:
+        return
+    with tempfile.TemporaryDirectory() as cache_dir:
+        cold = compile_and_run(cache_dir)
+        warm = compile_and_run(cache_dir)
+    ti.stat_write('cold_start_t', cold)
+    ti.stat_write('warm_start_t', warm)
@@ -0,0 +1,38 @@
+import time
+
+import taichi as ti
+
+# A range-for loop whose iterations get more expensive towards the end of
+# the range, like particles clustered in a few cells. Compares the CPU
+# range-for schedules, including the autotuned one after its tuning launches.
+
+n = 1024 * 1024
+repeat = 20
+
+
+def measure(schedule):
+    ti.init(arch=ti.cpu, cpu_range_for_schedule=schedule)
+    x = ti.field(ti.f32, shape=n)
+
+    @ti.kernel
+    def skewed():
+        for i in range(n):
+            s = 0.0
+            for j in range(i * 64 // n):
+                s += ti.sin(s + j)
+            x[i] = s
+
+    # The autotuner takes a launch per candidate twice, plus a warm-up one.
+    for _ in range(32):
+        skewed()
+    ti.sync()
+    t = time.time()
+    for _ in range(repeat):
+        skewed()
+    ti.sync()
+    return (time.time() - t) / repeat
+
+
+def benchmark_range_for_schedule():
+    for schedule in ['static', 'dynamic', 'guided', 'auto']:
+        ti.stat_write(f'{schedule}_t', measure(schedule))
@@ -0,0 +1,44 @@
+import time
+
+import taichi as ti
+
+# Throughput of simple CPU range-for loops, which are bound by the per
+# iteration overhead of the loop as much as by memory.
+
+n = 64 * 1024 * 1024
+repeat = 20
+
+
+def measure(**kwargs):
+    ti.init(arch=ti.cpu, **kwargs)
+    x = ti.field(ti.f32, shape=n)
+    y = ti.field(ti.f32, shape=n)
+
+    @ti.kernel
+    def fill(v: ti.f32):
+        for i in range(n):
+            x[i] = v
+
+    @ti.kernel
+    def saxpy(a: ti.f32):
+        for i in range(n):
+            y[i] = a * x[i] + y[i]
+
+    results = {}
+    for name, kernel, bytes_per_it in [('fill', fill, 4),
+                                       ('saxpy', saxpy, 12)]:
+        kernel(1.0)
+        ti.sync()
+        t = time.time()
+        for _ in range(repeat):
+            kernel(0.5)
+        ti.sync()
+        t = (time.time() - t) / repeat
+        results[name] = n * bytes_per_it / t / 1e9
+    return results
+
+
+def benchmark_range_for_throughput():
+    for suffix, kwargs in [('', {}), ('_simd', {'cpu_simd_range_for': True})]:
+        for name, gbps in measure(**kwargs).items():
+            ti.stat_write(f'{name}{suffix}_GBps', gbps)
@@ -0,0 +1,56 @@
+import taichi as ti
+
+# The kernels of memory_bound.py on smaller buffers that fit in the caches,
+# plus a compute-bound one, with and without SIMD range-for bodies on CPU.
+
+N = 1024 * 1024
+
+
+def _saxpy():
+    x = ti.field(dtype=ti.f32, shape=N)
+    y = ti.field(dtype=ti.f32, shape=N)
+    z = ti.field(dtype=ti.f32, shape=N)
+
+    @ti.kernel
+    def task():
+        for i in x:
+            a = 123
+            z[i] = a * x[i] + y[i]
+
+    return ti.benchmark(task, repeat=100)
+
+
+def _polynomial():
+    x = ti.field(dtype=ti.f32, shape=N)
+    y = ti.field(dtype=ti.f32, shape=N)
+
+    @ti.kernel
+    def task():
+        for i in x:
+            t = x[i]
+            s = 0.0
+            for k in ti.static(range(16)):
+                s = s * t + (k + 1) * 0.25
+            y[i] = s
+
+    return ti.benchmark(task, repeat=100)
+
+
+@ti.test(arch=ti.cpu)
+def benchmark_saxpy_scalar():
+    return _saxpy()
+
+
+@ti.test(arch=ti.cpu, cpu_simd_range_for=True)
+def benchmark_saxpy_simd():
+    return _saxpy()
+
+
+@ti.test(arch=ti.cpu)
+def benchmark_polynomial_scalar():
+    return _polynomial()
+
+
+@ti.test(arch=ti.cpu, cpu_simd_range_for=True)
+def benchmark_polynomial_simd():
+    return _polynomial()
@@ -0,0 +1,84 @@
+import time
+
+import taichi as ti
+
+# Measures how fast pointer SNode cells are activated (and recycled) at
+# different thread counts, with and without the per-thread node allocator
+# cache.
+
+
+def measure(num_threads, cache, repeat=20):
+    ti.init(arch=ti.cpu,
+            cpu_max_num_threads=num_threads,
+            cpu_node_allocator_cache=cache)
+    a = ti.field(dtype=ti.f32)
+    N = 512
+
+    # Leaf blocks are small so that allocation dominates.
+    block = ti.root.pointer(ti.ij, [N, N])
+    block.dense(ti.ij, [2, 2]).place(a)
+
+    @ti.kernel
+    def fill():
+        for i, j in ti.ndrange(N * 2, N * 2):
+            a[i, j] = 1.0
+
+    def task():
+        block.deactivate_all()
+        fill()
+
+    task()
+    ti.sync()
+    t = time.time()
+    for _ in range(repeat):
+        task()
+    ti.sync()
+    return (time.time() - t) / repeat, N * N
+
+
+@ti.archs_support_sparse
+def benchmark_pointer_activation():
+    for cache in [False, True]:
+        for num_threads in [1, 2, 4, 8, 16, 32]:
+            t, n = measure(num_threads, cache)
+            name = 'cached' if cache else 'shared'
+            ti.stat_write(
+                f'{name}_{num_threads}_threads_activations_per_s', n / t)
+
+
+@ti.archs_support_sparse
+def benchmark_pointer_gc():
+    N = 1024
+    for lazy in [False, True]:
+        for num_threads in [1, 4, 16]:
+            ti.init(arch=ti.cpu,
+                    cpu_max_num_threads=num_threads,
+                    cpu_gc_lazy_zero_fill=lazy)
+            a = ti.field(dtype=ti.f32)
+            block = ti.root.pointer(ti.ij, [N, N])
+            block.dense(ti.ij, [2, 2]).place(a)
+
+            @ti.kernel
+            def fill():
+                for i, j in ti.ndrange(N * 2, N * 2):
+                    a[i, j] = 1.0
+
+            @ti.kernel
+            def clear():
+                for i, j in block:
+                    ti.deactivate(block, [i, j])
+
+            fill()
+            clear()
+            t = 0.0
+            repeat = 10
+            for _ in range(repeat):
+                fill()
+                ti.sync()
+                start = time.time()
+                # Deactivates N * N cells and garbage-collects them.
+                clear()
+                ti.sync()
+                t += time.time() - start
+            name = 'lazy' if lazy else 'eager'
+            ti.stat_write(f'gc_{name}_{num_threads}_threads_t', t / repeat)
@@ -0,0 +1,57 @@
+import time
+
+import taichi as ti
+
+# Activates cells of a large 1D domain through a pointer and a hash SNode,
+# then sums them with a struct-for. The active cells are either packed into
+# a single run (clustered) or spread over the whole domain (scattered).
+
+N = 1 << 22
+num_active = 1 << 16
+
+
+def measure(node_type, scattered, repeat=10):
+    ti.init(arch=ti.cpu)
+    x = ti.field(dtype=ti.f32)
+    s = ti.field(dtype=ti.f32, shape=())
+    if node_type == 'pointer':
+        block = ti.root.pointer(ti.i, N)
+    else:
+        block = ti.root.hash(ti.i, N, max_num_active=num_active)
+    block.place(x)
+    stride = 61 if scattered else 1
+
+    @ti.kernel
+    def activate():
+        for i in range(num_active):
+            x[i * stride % N] = 1.0
+
+    @ti.kernel
+    def reduce():
+        for i in x:
+            s[None] += x[i]
+
+    activate()
+    reduce()
+    ti.sync()
+    t = time.time()
+    for _ in range(repeat):
+        block.deactivate_all()
+        activate()
+    ti.sync()
+    reactivation_t = (time.time() - t) / repeat
+    t = time.time()
+    for _ in range(repeat):
+        reduce()
+    ti.sync()
+    return reactivation_t, (time.time() - t) / repeat
+
+
+def benchmark_sparse_hash():
+    for node_type in ['pointer', 'hash']:
+        for scattered in [False, True]:
+            reactivation_t, reduce_t = measure(node_type, scattered)
+            keys = 'scattered' if scattered else 'clustered'
+            ti.stat_write(f'{node_type}_{keys}_reactivation_t',
+                          reactivation_t)
+            ti.stat_write(f'{node_type}_{keys}_struct_for_t', reduce_t)
@@ -0,0 +1,93 @@
+import time
+
+import numpy as np
+
+import taichi as ti
+
+# Time steps of a 2D Poisson problem whose matrix keeps its pattern but
+# changes its values every step. Compares building and solving from scratch
+# every step with a solver session that reuses the pattern.
+
+n = 128
+num_steps = 10
+
+
+def measure(step):
+    ti.init(arch=ti.cpu)
+    N = n * n
+    builder = ti.linalg.SparseMatrixBuilder(N,
+                                            N,
+                                            max_num_triplets=N * 5,
+                                            dtype=ti.f64)
+
+    @ti.kernel
+    def fill(A: ti.linalg.sparse_matrix_builder(dtype=ti.f64), k: ti.f64):
+        for i, j in ti.ndrange(n, n):
+            row = i * n + j
+            A[row, row] += 4.0 + k
+            if i > 0:
+                A[row, row - n] -= 1.0
+            if i < n - 1:
+                A[row, row + n] -= 1.0
+            if j > 0:
+                A[row, row - 1] -= 1.0
+            if j < n - 1:
+                A[row, row + 1] -= 1.0
+
+    b = np.ones((N, 4))
+    x = None
+    t = time.time()
+    for k in range(num_steps):
+        fill(builder, 0.1 * k)
+        x = step(builder, b, x)
+    return (time.time() - t) / num_steps
+
+
+def direct_from_scratch(builder, b, x):
+    A = builder.build(dtype=ti.f64)
+    solver = ti.linalg.SparseSolver(dtype=ti.f64, solver_type="LLT")
+    solver.compute(A)
+    return np.stack([solver.solve(b[:, c]) for c in range(b.shape[1])],
+                    axis=1)
+
+
+direct_solver = None
+
+
+def direct_session(builder, b, x):
+    global direct_solver
+    if direct_solver is None:
+        direct_solver = ti.linalg.SparseSolver(dtype=ti.f64,
+                                               solver_type="LLT")
+    direct_solver.factorize(builder)
+    return direct_solver.solve(b)
+
+
+cg_solver = None
+
+
+def cg_session(builder, b, x):
+    global cg_solver
+    if cg_solver is None:
+        cg_solver = ti.linalg.SparseSolver(dtype=ti.f64,
+                                           solver_type="CG",
+                                           preconditioner="IC",
+                                           tol=1e-8)
+    cg_solver.factorize(builder)
+    return cg_solver.solve(b, x0=x)
+
+
+def benchmark_sparse_solver_direct_from_scratch():
+    ti.stat_write('direct_from_scratch_step_t', measure(direct_from_scratch))
+
+
+def benchmark_sparse_solver_direct_session():
+    global direct_solver
+    direct_solver = None
+    ti.stat_write('direct_session_step_t', measure(direct_session))
+
+
+def benchmark_sparse_solver_cg_session():
+    global cg_solver
+    cg_solver = None
+    ti.stat_write('cg_session_step_t', measure(cg_session))
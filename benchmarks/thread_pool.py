@@ -0,0 +1,40 @@
+import time
+
+import taichi as ti
+
+# Compares the CPU thread pool at different thread counts. Run this on two
+# commits to compare thread pool implementations.
+
+
+def measure(num_threads, n, repeat):
+    ti.init(arch=ti.cpu, cpu_max_num_threads=num_threads)
+    a = ti.field(dtype=ti.f32, shape=n)
+
+    @ti.kernel
+    def fill():
+        for i in a:
+            a[i] = ti.sqrt(a[i] + 1.0)
+
+    for _ in range(3):
+        fill()
+    ti.sync()
+    t = time.time()
+    for _ in range(repeat):
+        fill()
+    ti.sync()
+    return (time.time() - t) / repeat
+
+
+def benchmark_thread_pool_launch_latency():
+    for num_threads in [1, 8, 64]:
+        # Small enough that the launch overhead dominates.
+        t = measure(num_threads, n=1024, repeat=10000)
+        ti.stat_write(f'launch_latency_{num_threads}_threads_t', t)
+
+
+def benchmark_thread_pool_throughput():
+    for num_threads in [1, 8, 64]:
+        n = 32 * 1024 * 1024
+        t = measure(num_threads, n=n, repeat=20)
+        ti.stat_write(f'throughput_{num_threads}_threads_elements_per_s',
+                      n / t)
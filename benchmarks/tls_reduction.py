@@ -0,0 +1,57 @@
+import time
+
+import taichi as ti
+
+# Large sum and max reductions on the CPU, over a range-for and a struct-for.
+# Small blocks make many blocks per launch, which used to cost one round of
+# global atomics each; the thread-local partial results are now merged once
+# per thread.
+
+n = 16 * 1024 * 1024
+repeat = 10
+
+
+def measure(block_dim):
+    ti.init(arch=ti.cpu)
+    x = ti.field(ti.f32)
+    ti.root.pointer(ti.i, n // 1024).dense(ti.i, 1024).place(x)
+    total = ti.field(ti.f32, shape=())
+    max_val = ti.field(ti.f32, shape=())
+
+    @ti.kernel
+    def fill():
+        for i in range(n):
+            x[i] = (i % 1001) * 0.5
+
+    @ti.kernel
+    def reduce_range():
+        ti.block_dim(block_dim)
+        for i in range(n):
+            total[None] += x[i]
+            ti.atomic_max(max_val[None], x[i])
+
+    @ti.kernel
+    def reduce_struct():
+        ti.block_dim(block_dim)
+        for i in x:
+            total[None] += x[i]
+            ti.atomic_max(max_val[None], x[i])
+
+    fill()
+    times = []
+    for reduce in [reduce_range, reduce_struct]:
+        reduce()
+        ti.sync()
+        t = time.time()
+        for _ in range(repeat):
+            reduce()
+        ti.sync()
+        times.append((time.time() - t) / repeat)
+    return times
+
+
+def benchmark_tls_reduction():
+    for block_dim in [16, 256]:
+        range_t, struct_t = measure(block_dim)
+        ti.stat_write(f'tls_reduction_range_for_b{block_dim}_t', range_t)
+        ti.stat_write(f'tls_reduction_struct_for_b{block_dim}_t', struct_t)
@@ -1,6 +1,7 @@
 from contextlib import contextmanager
 from pathlib import Path, PurePosixPath
 
+from taichi.core.util import ti_core as _ti_core
 from taichi.lang import impl, kernel_impl
 from taichi.lang.field import ScalarField
 from taichi.lang.matrix import MatrixField
@@ -119,25 +120,34 @@ class Module:
                                     field.dtype, field.snode.shape, row_num,
                                     column_num)
 
-    def add_kernel(self, kernel_fn, name=None):
+    def add_kernel(self, kernel_fn, name=None, example_any_arrays=None):
         """Add a taichi kernel to the AOT module.
 
         Args:
           kernel_fn (Function): the function decorated by taichi `kernel`.
           name (str): Name to identify this kernel in the module. If not
             provided, uses the built-in ``__name__`` attribute of `kernel_fn`.
-
-        TODO:
-          * Support external array
+          example_any_arrays (Dict[int, numpy.ndarray]): An example array for
+            each `ext_arr`/`any_arr` argument, by argument index. The kernel is
+            compiled for arrays of the same dtype and number of dimensions.
+            Only the CPU backend supports such arguments.
         """
         name = name or kernel_fn.__name__
         kernel = kernel_fn._primal
         assert isinstance(kernel, kernel_impl.Kernel)
+        example_any_arrays = example_any_arrays or {}
         injected_args = []
-        for anno in kernel.argument_annotations:
+        for i, anno in enumerate(kernel.argument_annotations):
             if isinstance(anno, ArgAnyArray):
-                raise RuntimeError(
-                    'Arg type `ext_arr`/`any_arr` not supported yet')
+                if self._arch not in (_ti_core.x64, _ti_core.arm64):
+                    raise RuntimeError(
+                        'Arg type `ext_arr`/`any_arr` not supported yet')
+                if i not in example_any_arrays:
+                    raise RuntimeError(
+                        f'Arg type `ext_arr`/`any_arr` of argument {i} needs '
+                        'an example array in `example_any_arrays`')
+                injected_args.append(example_any_arrays[i])
+                continue
             # For primitive types, we can just inject a dummy value.
             injected_args.append(0)
         kernel.ensure_compiled(*injected_args)
@@ -104,13 +104,18 @@ class ComposerCC(ComposerBase):
         self.emit('')
 
     def do_compile_kernel(self, e):
+        name = e['kernel_name']
         source = e['kernel_source']
 
+        # The kernel is preceded by the static functions running the blocks
+        # of its range-for loops.
+        start = source.index(f'void Tk_{name}(')
+        self.emit(source[:start])
         if self.emscripten:
             self.emit('EMSCRIPTEN_KEEPALIVE')
-        self.emit(source)
+        self.emit(source[start:])
         self.emit('')
-        declaration = source.split('{', 1)[0].strip()
+        declaration = source[start:].split('{', 1)[0].strip()
         self.emit_header(f'extern {declaration};')
 
     def do_config(self, e):
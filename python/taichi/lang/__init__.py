@@ -32,13 +32,16 @@ from taichi.lang.impl import (axes, begin_frontend_if,
                               ti_int, ti_print, var, zero)
 from taichi.lang.kernel_arguments import SparseMatrixProxy
 from taichi.lang.kernel_impl import (KernelArgError, KernelDefError,
-                                     data_oriented, func, kernel, pyfunc)
+                                     data_oriented, func, kernel, precompile,
+                                     pyfunc)
+from taichi.lang.launch_graph import LaunchGraph
 from taichi.lang.matrix import Matrix, MatrixField, Vector
 from taichi.lang.mesh import Mesh, MeshElementFieldProxy, TetMesh, TriMesh
 from taichi.lang.ndrange import GroupedNDRange, ndrange
 from taichi.lang.ops import *  # pylint: disable=W0622
 from taichi.lang.quant_impl import quant
-from taichi.lang.runtime_ops import async_flush, sync
+from taichi.lang.runtime_ops import (async_flush, query_event, record_event,
+                                     sync, wait_event)
 from taichi.lang.snode import SNode
 from taichi.lang.source_builder import SourceBuilder
 from taichi.lang.struct import Struct, StructField
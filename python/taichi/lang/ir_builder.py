@@ -329,7 +329,9 @@ class IRBuilder(Builder):
                 elif isinstance(ctx.func.argument_annotations[i],
                                 ti.linalg.sparse_matrix_builder):
                     ctx.create_variable(
-                        arg.arg, ti.lang.kernel_arguments.decl_sparse_matrix())
+                        arg.arg,
+                        ti.lang.kernel_arguments.decl_sparse_matrix(
+                            ctx.func.argument_annotations[i].dtype))
                 elif isinstance(ctx.func.argument_annotations[i], ti.any_arr):
                     ctx.create_variable(
                         arg.arg,
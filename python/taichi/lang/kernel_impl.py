@@ -14,6 +14,7 @@ from taichi.lang.ast.checkers import KernelSimplicityASTChecker
 from taichi.lang.ast.transformer import ASTTransformerTotal
 from taichi.lang.enums import Layout
 from taichi.lang.exception import TaichiSyntaxError
+from taichi.lang.launch_graph import LaunchGraphArg
 from taichi.lang.shell import _shell_pop_print, oinspect
 from taichi.lang.util import to_taichi_type
 from taichi.linalg.sparse_matrix import sparse_matrix_builder
@@ -293,6 +294,8 @@ class TaichiCallableTemplateMapper:
                                              element_dim] if layout == Layout.SOA else shape[
                                                  -element_dim:]
             return to_taichi_type(arg.dtype), len(shape), element_shape, layout
+        if isinstance(arg, LaunchGraphArg):
+            return type(arg.value).__name__,
         return type(arg).__name__,
 
     def extract(self, args):
@@ -484,10 +487,18 @@ class Kernel:
 
             actual_argument_slot = 0
             launch_ctx = t_kernel.make_launch_context()
+            graph = self.runtime.target_graph
+            graph_bindings = []
             for i, v in enumerate(args):
                 needed = self.argument_annotations[i]
                 if isinstance(needed, template):
                     continue
+                if graph is not None and isinstance(v, LaunchGraphArg):
+                    if id(needed) not in primitive_types.type_ids:
+                        raise KernelArgError(i, needed.to_string(),
+                                             type(v.value))
+                    graph_bindings.append((v.name, actual_argument_slot))
+                    v = v.value
                 provided = type(v)
                 # Note: do not use sth like "needed == f32". That would be slow.
                 if id(needed) in primitive_types.real_type_ids:
@@ -499,6 +510,10 @@ class Kernel:
                         raise KernelArgError(i, needed.to_string(), provided)
                     launch_ctx.set_arg_int(actual_argument_slot, int(v))
                 elif isinstance(needed, sparse_matrix_builder):
+                    if v.dtype != needed.dtype:
+                        raise KernelArgError(
+                            i, f'sparse_matrix_builder({needed.dtype})',
+                            f'sparse_matrix_builder({v.dtype})')
                     # Pass only the base pointer of the ti.linalg.sparse_matrix_builder() argument
                     launch_ctx.set_arg_int(actual_argument_slot, v.get_addr())
                 elif isinstance(needed, any_arr) and (
@@ -582,6 +597,14 @@ class Kernel:
             if not self.is_grad and self.runtime.target_tape and not self.runtime.grad_replaced:
                 self.runtime.target_tape.insert(self, args)
 
+            if graph is not None:
+                if self.return_type is not None or callbacks:
+                    raise ValueError(
+                        f'Kernel {self.func.__name__} cannot be captured into a graph: it returns a value or copies arrays between devices'
+                    )
+                graph.add_launch(t_kernel, launch_ctx, tmps, graph_bindings)
+                return None
+
             t_kernel(launch_ctx)
 
             ret = None
@@ -789,6 +812,45 @@ class _BoundedDifferentiableMethod:
         return self._adjoint(self._kernel_owner, *args, **kwargs)
 
 
+def precompile(*kernels):
+    """Compiles Taichi kernels before their first launch.
+
+    Kernels are otherwise compiled lazily when they are first called. With
+    ``ti.init(num_compile_threads=N)`` on CPU, the given kernels are compiled
+    concurrently on N threads. On the C backend, the C compiler always runs
+    for the given kernels concurrently.
+
+    Args:
+        *kernels: Functions decorated by :func:`kernel`, or ``(kernel, args)``
+            tuples for kernels that take arguments. As in a call, ``args``
+            selects the template instance to compile.
+
+    Example::
+
+        >>> ti.init(arch=ti.cpu, num_compile_threads=8)
+        >>>
+        >>> ti.precompile(init, (substep, (0.5, )), paint)
+    """
+    _taichi_skip_traceback = 1
+    kernels_cpp = []
+    for kernel_fn in kernels:
+        args = ()
+        if isinstance(kernel_fn, tuple):
+            kernel_fn, args = kernel_fn
+        args = tuple(args)
+        if isinstance(kernel_fn, _BoundedDifferentiableMethod
+                      ) and not kernel_fn._is_staticmethod:
+            args = (kernel_fn._kernel_owner, ) + args
+        primal = kernel_fn._primal
+        instance_id, _ = primal.mapper.lookup(args)
+        if (primal.func, instance_id) in primal.compiled_functions:
+            # Already launched, hence compiled.
+            continue
+        primal.ensure_compiled(*args)
+        kernels_cpp.append(primal.kernel_cpp)
+    _ti_core.compile_kernels(kernels_cpp)
+
+
 def data_oriented(cls):
     """Marks a class as Taichi compatible.
 
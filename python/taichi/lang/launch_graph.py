@@ -0,0 +1,80 @@
+from contextlib import contextmanager
+
+from taichi.core.util import ti_core as _ti_core
+from taichi.lang import impl
+
+
+class LaunchGraphArg:
+    """A scalar kernel argument that can be updated between replays of a
+    :class:`LaunchGraph`. Created by :meth:`LaunchGraph.arg`."""
+    def __init__(self, name, value):
+        self.name = name
+        self.value = value
+
+
+class LaunchGraph:
+    """A fixed sequence of kernel launches, captured once and replayed with a
+    single call.
+
+    Kernels called inside :meth:`capture` are compiled and recorded together
+    with their arguments instead of being launched. :meth:`run` then launches
+    all of them in order, without the per-launch host overhead of calling the
+    kernels from Python. Arguments passed as :meth:`arg` can be updated with
+    :meth:`set_arg` between runs; all other arguments are fixed at capture
+    time. External arrays passed to the captured kernels must stay alive and
+    in place, and kernels with return values cannot be captured.
+
+    Example::
+
+        >>> graph = ti.LaunchGraph()
+        >>> with graph.capture():
+        >>>     for _ in range(substeps):
+        >>>         substep(graph.arg('dt', 1e-4))
+        >>> for frame in range(1000):
+        >>>     graph.run()
+        >>> graph.set_arg('dt', 5e-5)
+        >>> graph.run()
+    """
+    def __init__(self):
+        impl.get_runtime().materialize()
+        self.graph = _ti_core.LaunchGraph(impl.get_runtime().prog)
+        # Keeps the contiguous copies of the captured numpy arrays alive.
+        self.tmps = []
+
+    @contextmanager
+    def capture(self):
+        """Records the kernels called in the `with` block into the graph."""
+        runtime = impl.get_runtime()
+        assert runtime.target_graph is None, 'Graphs cannot be nested.'
+        runtime.target_graph = self
+        try:
+            yield self
+        finally:
+            runtime.target_graph = None
+
+    def arg(self, name, value):
+        """Passes `value` as an argument that can later be updated with
+        :meth:`set_arg` under `name`. The same name may be passed to several
+        launches."""
+        return LaunchGraphArg(name, value)
+
+    def add_launch(self, t_kernel, launch_ctx, tmps, bindings):
+        launch_id = self.graph.add_launch(t_kernel, launch_ctx)
+        for name, slot in bindings:
+            self.graph.bind_arg(name, launch_id, slot)
+        self.tmps.extend(tmps)
+
+    def set_arg(self, name, value):
+        """Updates the arguments passed as `arg(name, ...)` for later runs."""
+        if isinstance(value, int):
+            self.graph.set_arg_int(name, value)
+        else:
+            self.graph.set_arg_float(name, float(value))
+
+    @property
+    def num_launches(self):
+        return self.graph.num_launches()
+
+    def run(self):
+        """Launches the captured kernels in order."""
+        self.graph.run()
@@ -7,3 +7,24 @@ def sync():
 
 def async_flush():
     impl.get_runtime().prog.async_flush()
+
+
+def record_event():
+    """Records an event that completes once all kernels launched so far have
+    finished.
+
+    Returns:
+        int: The event, to be passed to :func:`query_event` or :func:`wait_event`.
+    """
+    impl.get_runtime().materialize()
+    return impl.get_runtime().prog.record_event()
+
+
+def query_event(event):
+    """Returns whether `event` has completed, without blocking."""
+    return impl.get_runtime().prog.query_event(event)
+
+
+def wait_event(event):
+    """Blocks until `event` has completed."""
+    impl.get_runtime().prog.wait_event(event)
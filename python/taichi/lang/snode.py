@@ -58,15 +58,33 @@ class SNode:
             self.ptr.pointer(axes, dimensions,
                              impl.current_cfg().packed))
 
-    @staticmethod
-    def hash(axes, dimensions):
-        # original code is #def hash(self,axes, dimensions) without #@staticmethod   before fix pylint R0201
-        """Not supported."""
-        raise RuntimeError('hash not yet supported')
-        # if isinstance(dimensions, int):
-        #     dimensions = [dimensions] * len(axes)
-        # return SNode(self.ptr.hash(axes, dimensions,
-        #                            impl.current_cfg().packed))
+    def hash(self, axes, dimensions, max_num_active=None):
+        """Adds a hash SNode as a child component of `self`.
+
+        Only the active cells take memory, so the shape can be much larger
+        than a pointer SNode could afford. Hash SNodes must be children of the
+        root and are only supported on CPU backends.
+
+        Args:
+            axes (List[Axis]): Axes to activate.
+            dimensions (Union[List[int], int]): Shape of each axis.
+            max_num_active (int): The number of cells that can be active at
+                the same time. Defaults to the number of cells, capped at
+                65536.
+
+        Returns:
+            The added :class:`~taichi.lang.SNode` instance.
+        """
+        if isinstance(dimensions, int):
+            dimensions = [dimensions] * len(axes)
+        if max_num_active is None:
+            num_cells = 1
+            for d in dimensions:
+                num_cells *= d
+            max_num_active = min(num_cells, 65536)
+        return SNode(
+            self.ptr.hash(axes, dimensions, max_num_active,
+                          impl.current_cfg().packed))
 
     def dynamic(self, axis, dimension, chunk_size=None):
         """Adds a dynamic SNode as a child component of `self`.
@@ -312,7 +330,8 @@ class SNode:
         for c in ch:
             c.deactivate_all()
         SNodeType = _ti_core.SNodeType
-        if self.ptr.type == SNodeType.pointer or self.ptr.type == SNodeType.bitmasked:
+        if self.ptr.type in (SNodeType.pointer, SNodeType.hash,
+                             SNodeType.bitmasked):
             taichi.lang.meta.snode_deactivate(self)
         if self.ptr.type == SNodeType.dynamic:
             # Note that dynamic nodes are different from other sparse nodes:
@@ -1,7 +1,8 @@
 import numpy as np
+import taichi.lang
 from taichi.core.util import ti_core as _ti_core
 from taichi.lang.field import Field
-from taichi.type.primitive_types import f32
+from taichi.type.primitive_types import f32, i32
 
 
 class SparseMatrix:
@@ -13,16 +14,32 @@ class SparseMatrix:
         n (int): the first dimension of a sparse matrix.
         m (int): the second dimension of a sparse matrix.
         sm (SparseMatrix): another sparse matrix that will be built from.
+        dtype (DataType): the value type, ti.f32 or ti.f64.
+        _format (str): the storage format, 'CSC' or 'CSR'.
+        index_dtype (DataType): the index type, ti.i32 or ti.i64.
     """
-    def __init__(self, n=None, m=None, sm=None, dtype=f32):
+    def __init__(self,
+                 n=None,
+                 m=None,
+                 sm=None,
+                 dtype=f32,
+                 _format='CSC',
+                 index_dtype=i32):
         if sm is None:
             self.n = n
             self.m = m if m else n
-            self.matrix = _ti_core.create_sparse_matrix(n, m)
+            self.matrix = _ti_core.create_sparse_matrix(
+                self.n, self.m, dtype, _format, index_dtype)
         else:
             self.n = sm.num_rows()
             self.m = sm.num_cols()
             self.matrix = sm
+        self.dtype = self.matrix.get_data_type()
+        self.format = self.matrix.get_storage_format()
+
+    def num_nonzeros(self):
+        """Number of stored entries, including explicit zeros."""
+        return self.matrix.num_nonzeros()
 
     def __add__(self, other):
         """Addition operation for sparse matrix.
@@ -130,6 +147,7 @@ class SparseMatrixBuilder:
         num_rows (int): the first dimension of a sparse matrix.
         num_cols (int): the second dimension of a sparse matrix.
         max_num_triplets (int): the maximum number of triplets.
+        dtype (DataType): the value type, ti.f32 or ti.f64.
     """
     def __init__(self,
                  num_rows=None,
@@ -138,9 +156,10 @@ class SparseMatrixBuilder:
                  dtype=f32):
         self.num_rows = num_rows
         self.num_cols = num_cols if num_cols else num_rows
+        self.dtype = dtype
         if num_rows is not None:
             self.ptr = _ti_core.create_sparse_matrix_builder(
-                num_rows, num_cols, max_num_triplets)
+                num_rows, self.num_cols, max_num_triplets, dtype)
 
     def get_addr(self):
         """Get the address of the sparse matrix"""
@@ -150,9 +169,29 @@ class SparseMatrixBuilder:
         """Print the triplets stored in the builder"""
         self.ptr.print_triplets()
 
-    def build(self, dtype=f32, _format='CSR'):
-        """Create a sparse matrix using the triplets"""
-        sm = self.ptr.build()
+    def build(self,
+              dtype=None,
+              _format='CSC',
+              index_dtype=i32,
+              reuse_pattern=False):
+        """Create a sparse matrix using the triplets, summing up duplicates.
+
+        The builder is cleared afterwards.
+
+        Args:
+            dtype (DataType): must match the dtype of the builder if given.
+            _format (str): the storage format, 'CSC' or 'CSR'.
+            index_dtype (DataType): the index type, ti.i32 or ti.i64.
+            reuse_pattern (bool): keep the sparsity pattern of the result, so
+                that the next build with the same format and triplets on the
+                same pattern skips sorting. Pattern entries the next build
+                does not hit are stored as explicit zeros.
+        Returns:
+            The built SparseMatrix.
+        """
+        assert dtype is None or dtype == self.dtype, f"The builder holds {self.dtype} values, cannot build a {dtype} matrix"
+        taichi.lang.impl.get_runtime().sync()
+        sm = self.ptr.build(_format, index_dtype, reuse_pattern)
         return SparseMatrix(sm=sm)
 
 
@@ -1,8 +1,8 @@
 import numpy as np
 import taichi.lang
 from taichi.core.util import ti_core as _ti_core
-from taichi.linalg import SparseMatrix
-from taichi.type.primitive_types import f32
+from taichi.linalg import SparseMatrix, SparseMatrixBuilder
+from taichi.type.primitive_types import f32, f64
 
 
 class SparseSolver:
@@ -10,70 +10,127 @@ class SparseSolver:
 
     Use this class to solve linear systems represented by sparse matrices.
 
+    A solver keeps the result of `analyze_pattern` and only redoes it when
+    `factorize` is given a matrix with a different sparsity pattern, so a
+    sequence of matrices with the same pattern only pays for the numerical
+    factorization.
+
     Args:
-        solver_type (str): The factorization type.
-        ordering (str): The method for matrices re-ordering.
+        dtype (DataType): The value type of the matrices, ti.f32 or ti.f64.
+        solver_type (str): The factorization type, "LLT", "LDLT" or "LU", or
+            the iterative method, "CG" or "BICGSTAB".
+        ordering (str): The method for matrices re-ordering of the
+            factorizations.
+        preconditioner (str): The preconditioner of the iterative methods,
+            "Jacobi", "IC" (CG only) or "ILUT" (BICGSTAB only).
+        tol (float): The relative residual tolerance of the iterative
+            methods. Defaults to the machine epsilon of dtype.
+        max_iterations (int): The maximum number of iterations of the
+            iterative methods. Defaults to twice the number of columns.
     """
-    def __init__(self, dtype=f32, solver_type="LLT", ordering="AMD"):
+    def __init__(self,
+                 dtype=f32,
+                 solver_type="LLT",
+                 ordering="AMD",
+                 preconditioner="Jacobi",
+                 tol=None,
+                 max_iterations=None):
         solver_type_list = ["LLT", "LDLT", "LU"]
         solver_ordering = ['AMD', 'COLAMD']
+        iterative_preconditioners = {
+            "CG": ["Jacobi", "IC"],
+            "BICGSTAB": ["Jacobi", "ILUT"]
+        }
+        assert dtype in (f32, f64), f"SparseSolver only supports f32 and f64, not {dtype}."
+        taichi_arch = taichi.lang.impl.get_runtime().prog.config.arch
+        assert taichi_arch == _ti_core.Arch.x64 or taichi_arch == _ti_core.Arch.arm64, "SparseSolver only supports CPU for now."
+        self.dtype = dtype
+        self.np_dtype = np.float64 if dtype == f64 else np.float32
+        self.iterative = solver_type in iterative_preconditioners
         if solver_type in solver_type_list and ordering in solver_ordering:
-            taichi_arch = taichi.lang.impl.get_runtime().prog.config.arch
-            assert taichi_arch == _ti_core.Arch.x64 or taichi_arch == _ti_core.Arch.arm64, "SparseSolver only supports CPU for now."
-            self.solver = _ti_core.make_sparse_solver(solver_type, ordering)
+            self.solver = _ti_core.make_sparse_solver(dtype, solver_type,
+                                                      ordering)
+        elif self.iterative and preconditioner in iterative_preconditioners[
+                solver_type]:
+            self.solver = _ti_core.make_iterative_solver(
+                dtype, solver_type, preconditioner)
+            if tol is not None:
+                self.solver.set_tolerance(tol)
+            if max_iterations is not None:
+                self.solver.set_max_iterations(max_iterations)
         else:
-            assert False, f"The solver type {solver_type} with {ordering} is not supported for now. Only {solver_type_list} with {solver_ordering} are supported."
+            assert False, f"The solver type {solver_type} with {ordering} is not supported for now. Only {solver_type_list} with {solver_ordering}, or {iterative_preconditioners} are supported."
 
     @staticmethod
     def type_assert(sparse_matrix):
         assert False, f"The parameter type: {type(sparse_matrix)} is not supported in linear solvers for now."
 
+    def _get_matrix(self, sparse_matrix):
+        if isinstance(sparse_matrix, SparseMatrixBuilder):
+            # Keep the pattern in the builder, so that the next build on the
+            # same pattern skips sorting the triplets.
+            sparse_matrix = sparse_matrix.build(dtype=self.dtype,
+                                                _format='CSC',
+                                                reuse_pattern=True)
+        if isinstance(sparse_matrix, SparseMatrix):
+            return sparse_matrix.matrix
+        self.type_assert(sparse_matrix)
+        return None
+
+    def _get_rhs(self, b):
+        if isinstance(b, taichi.lang.Field):
+            b = b.to_numpy()
+        if not isinstance(b, np.ndarray):
+            assert False, f"The parameter type: {type(b)} is not supported in linear solvers for now."
+        assert b.ndim in (1, 2), f"The right-hand side must be a vector or a matrix of one vector per column, not of shape {b.shape}."
+        return np.asfortranarray(b, dtype=self.np_dtype)
+
     def compute(self, sparse_matrix):
         """This method is equivalent to calling both `analyze_pattern` and then `factorize`.
 
         Args:
-            sparse_matrix (SparseMatrix): The sparse matrix to be computed.
+            sparse_matrix (SparseMatrix or SparseMatrixBuilder): The sparse matrix to be computed. A builder is built into a matrix first.
         """
-        if isinstance(sparse_matrix, SparseMatrix):
-            self.solver.compute(sparse_matrix.matrix)
-        else:
-            self.type_assert(sparse_matrix)
+        return self.solver.compute(self._get_matrix(sparse_matrix))
 
     def analyze_pattern(self, sparse_matrix):
         """Reorder the nonzero elements of the matrix, such that the factorization step creates less fill-in.
 
         Args:
-            sparse_matrix (SparseMatrix): The sparse matrix to be analyzed.
+            sparse_matrix (SparseMatrix or SparseMatrixBuilder): The sparse matrix to be analyzed. A builder is built into a matrix first.
         """
-        if isinstance(sparse_matrix, SparseMatrix):
-            self.solver.analyze_pattern(sparse_matrix.matrix)
-        else:
-            self.type_assert(sparse_matrix)
+        self.solver.analyze_pattern(self._get_matrix(sparse_matrix))
 
     def factorize(self, sparse_matrix):
-        """Do the factorization step
+        """Do the factorization step, or compute the preconditioner of the iterative methods.
+
+        The pattern is analyzed again first if it differs from the one last analyzed.
 
         Args:
-            sparse_matrix (SparseMatrix): The sparse matrix to be factorized.
+            sparse_matrix (SparseMatrix or SparseMatrixBuilder): The sparse matrix to be factorized. A builder is built into a matrix first, reusing the sparsity pattern of its last build.
         """
-        if isinstance(sparse_matrix, SparseMatrix):
-            self.solver.factorize(sparse_matrix.matrix)
-        else:
-            self.type_assert(sparse_matrix)
+        self.solver.factorize(self._get_matrix(sparse_matrix))
 
-    def solve(self, b):
+    def solve(self, b, x0=None):
         """Computes the solution of the linear systems.
         Args:
-            b (numpy.array or Field): The right-hand side of the linear systems.
+            b (numpy.array or Field): The right-hand side of the linear systems. A 2D array solves one system per column.
+            x0 (numpy.array or Field): The initial guess of the iterative methods, of the same shape as b.
 
         Returns:
-            numpy.array: The solution of linear systems.
+            numpy.array: The solution of linear systems, of the same shape as b.
         """
-        if isinstance(b, taichi.lang.Field):
-            return self.solver.solve(b.to_numpy())
-        if isinstance(b, np.ndarray):
-            return self.solver.solve(b)
-        assert False, f"The parameter type: {type(b)} is not supported in linear solvers for now."
+        rhs = self._get_rhs(b)
+        if x0 is None:
+            x = self.solver.solve(rhs)
+        else:
+            assert self.iterative, "Only iterative solvers support an initial guess."
+            guess = self._get_rhs(x0)
+            assert guess.shape == rhs.shape, f"The initial guess of shape {guess.shape} does not match the right-hand side of shape {rhs.shape}."
+            x = self.solver.solve_with_guess(rhs, guess)
+        if rhs.ndim == 1:
+            return x.reshape(-1)
+        return x
 
     def info(self):
         """Check if the linear systems are solved successfully.
@@ -82,3 +139,11 @@ class SparseSolver:
             bool: True if the solving process succeeded, False otherwise.
         """
         return self.solver.info()
+
+    def num_iterations(self):
+        """The number of iterations of the last solve of the iterative methods."""
+        return self.solver.num_iterations()
+
+    def error(self):
+        """The estimated relative residual of the last solve of the iterative methods."""
+        return self.solver.error()
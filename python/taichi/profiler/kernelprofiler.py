@@ -275,6 +275,14 @@ class KernelProfiler:
         # there is no corresponding implementation in other backends yet.
         # Profiler dose not print invalid kernel attributes info for now.
         kernel_attribute_state = self._traced_records[0].register_per_thread > 0
+        # Backends choosing the launch dimensions at launch time (e.g. the
+        # autotuned range-for loops on CPU) record them without attributes.
+        launch_dims_state = not kernel_attribute_state and any(
+            record.block_size > 0 for record in self._traced_records)
+        # The CPU profiler counts range-for iterations and the load imbalance
+        # among the workers of the thread pool.
+        cpu_state = any(record.iterations > 0
+                        for record in self._traced_records)
 
         # headers
         table_header = self._make_table_header('trace')
@@ -283,6 +291,10 @@ class KernelProfiler:
             column_header += (
                 '   regs  |   shared mem | grid size | block size | occupancy |'
             )  #kernel_attributes
+        elif launch_dims_state:
+            column_header += ' grid size | block size |'
+        if cpu_state:
+            column_header += ' iterations | imbalance |'
         for idx in range(values_num):
             column_header += metric_list[idx].header + '|'
         column_header = (column_header + '] Kernel name').replace("|]", "]")
@@ -306,6 +318,12 @@ class KernelProfiler:
                     record.grid_size, record.block_size,
                     record.active_blocks_per_multiprocessor
                 ]
+            elif launch_dims_state:
+                formatted_str += '    {:6d} |     {:6d} |'
+                values += [record.grid_size, record.block_size]
+            if cpu_state:
+                formatted_str += ' {:10d} |    {:5.2f}x |'
+                values += [record.iterations, record.load_imbalance]
             for idx in range(values_num):
                 formatted_str += metric_list[idx].format + '|'
                 values += [record.metric_values[idx] * metric_list[idx].scale]
@@ -1,6 +1,9 @@
 #include "taichi/analysis/arithmetic_interpretor.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <type_traits>
 #include <vector>
 
@@ -14,6 +17,385 @@ namespace {
 using CodeRegion = ArithmeticInterpretor::CodeRegion;
 using EvalContext = ArithmeticInterpretor::EvalContext;
 
+// What the results of floating-point operations depend on, per backend.
+struct Target {
+  // Subnormal operands and results may be flushed to zero, e.g. on GPUs.
+  bool may_flush_subnormals;
+  // f32/f64 divisions and square roots are correctly rounded.
+  bool exact_div_sqrt;
+  // Transcendental functions are computed by the host's libm, as the LLVM
+  // runtime on CPUs calls it.
+  bool uses_host_libm;
+};
+
+Target make_target(Arch arch, bool fast_math) {
+  const bool cpu = arch_is_cpu(arch);
+  return Target{!cpu, cpu || (arch == Arch::cuda && !fast_math), cpu};
+}
+
+template <typename T>
+T get_value(const TypedConstant &c) {
+  T value;
+  std::memcpy(&value, &c.value_bits, sizeof(T));
+  return value;
+}
+
+// Unlike TypedConstant(dt, value), leaves the bits above |value| zero.
+template <typename T>
+TypedConstant make_constant(DataType dt, T value) {
+  TypedConstant c(dt);
+  std::memcpy(&c.value_bits, &value, sizeof(T));
+  return c;
+}
+
+// Calls |f| with a value of the C++ type of |dt|. Types that are not
+// evaluated, e.g. f16 and custom types, yield std::nullopt.
+template <typename F>
+std::optional<TypedConstant> dispatch(DataType dt, const F &f) {
+  if (dt->is_primitive(PrimitiveTypeID::i8)) {
+    return f(int8());
+  } else if (dt->is_primitive(PrimitiveTypeID::i16)) {
+    return f(int16());
+  } else if (dt->is_primitive(PrimitiveTypeID::i32)) {
+    return f(int32());
+  } else if (dt->is_primitive(PrimitiveTypeID::i64)) {
+    return f(int64());
+  } else if (dt->is_primitive(PrimitiveTypeID::u8)) {
+    return f(uint8());
+  } else if (dt->is_primitive(PrimitiveTypeID::u16)) {
+    return f(uint16());
+  } else if (dt->is_primitive(PrimitiveTypeID::u32)) {
+    return f(uint32());
+  } else if (dt->is_primitive(PrimitiveTypeID::u64)) {
+    return f(uint64());
+  } else if (dt->is_primitive(PrimitiveTypeID::f32)) {
+    return f(float32());
+  } else if (dt->is_primitive(PrimitiveTypeID::f64)) {
+    return f(float64());
+  }
+  return std::nullopt;
+}
+
+template <typename T>
+bool is_subnormal(T x) {
+  return std::fpclassify(x) == FP_SUBNORMAL;
+}
+
+// Integers are truncated or extended, and the other conversions round to
+// nearest, like the backends do.
+template <typename From, typename To>
+std::optional<TypedConstant> eval_cast(From a,
+                                       DataType to_dt,
+                                       const Target &target) {
+  if constexpr (std::is_floating_point_v<From>) {
+    if (target.may_flush_subnormals && is_subnormal(a)) {
+      return std::nullopt;
+    }
+    if constexpr (std::is_integral_v<To>) {
+      // Out-of-range conversions yield poison in LLVM.
+      const From lo = std::numeric_limits<To>::min();
+      const From hi = std::ldexp(From(1), std::numeric_limits<To>::digits);
+      if (std::isnan(a) || !(std::trunc(a) >= lo && std::trunc(a) < hi)) {
+        return std::nullopt;
+      }
+    }
+  }
+  const auto res = static_cast<To>(a);
+  if constexpr (std::is_floating_point_v<To>) {
+    if (target.may_flush_subnormals && is_subnormal(res)) {
+      return std::nullopt;
+    }
+  }
+  return make_constant(to_dt, res);
+}
+
+template <typename T>
+std::optional<TypedConstant> eval_unary_op(UnaryOpType op,
+                                           DataType dt,
+                                           T a,
+                                           DataType cast_type,
+                                           const Target &target) {
+  if (op == UnaryOpType::cast_bits) {
+    if (data_type_size(cast_type) != sizeof(T)) {
+      return std::nullopt;
+    }
+    return dispatch(cast_type, [&](auto to) -> std::optional<TypedConstant> {
+      std::memcpy(&to, &a, sizeof(T));
+      return make_constant(cast_type, to);
+    });
+  }
+  if (op == UnaryOpType::cast_value) {
+    return dispatch(cast_type, [&](auto to) {
+      return eval_cast<T, decltype(to)>(a, cast_type, target);
+    });
+  }
+  if constexpr (std::is_integral_v<T>) {
+    using U = std::make_unsigned_t<T>;
+    switch (op) {
+      case UnaryOpType::neg:
+        return make_constant(dt, T(U(0) - U(a)));
+      case UnaryOpType::abs:
+        if (std::is_signed_v<T> && a == std::numeric_limits<T>::min()) {
+          return std::nullopt;
+        }
+        return make_constant(dt, T(a < 0 ? -a : a));
+      case UnaryOpType::sgn:
+        return make_constant(dt, T(a > 0 ? 1 : (a < 0 ? -1 : 0)));
+      case UnaryOpType::bit_not:
+        return make_constant(dt, T(~U(a)));
+      case UnaryOpType::logic_not:
+        return make_constant(dt, T(a == 0 ? 1 : 0));
+      default:
+        return std::nullopt;
+    }
+  } else {
+    if (target.may_flush_subnormals && is_subnormal(a)) {
+      return std::nullopt;
+    }
+    std::optional<T> res;
+    switch (op) {
+      case UnaryOpType::neg:
+        res = -a;
+        break;
+      case UnaryOpType::abs:
+        res = std::fabs(a);
+        break;
+      case UnaryOpType::sgn:
+        res = T(a > 0 ? 1 : (a < 0 ? -1 : 0));
+        break;
+      case UnaryOpType::floor:
+        res = std::floor(a);
+        break;
+      case UnaryOpType::ceil:
+        res = std::ceil(a);
+        break;
+      case UnaryOpType::sqrt:
+        if (target.exact_div_sqrt) {
+          res = std::sqrt(a);
+        }
+        break;
+      case UnaryOpType::rsqrt:
+        // GPUs may approximate it instead of computing 1 / sqrt(a).
+        if (target.uses_host_libm) {
+          res = T(1) / std::sqrt(a);
+        }
+        break;
+      default:
+        break;
+    }
+    if (target.uses_host_libm) {
+      switch (op) {
+        case UnaryOpType::sin:
+          res = std::sin(a);
+          break;
+        case UnaryOpType::asin:
+          res = std::asin(a);
+          break;
+        case UnaryOpType::cos:
+          res = std::cos(a);
+          break;
+        case UnaryOpType::acos:
+          res = std::acos(a);
+          break;
+        case UnaryOpType::tan:
+          res = std::tan(a);
+          break;
+        case UnaryOpType::tanh:
+          res = std::tanh(a);
+          break;
+        case UnaryOpType::exp:
+          res = std::exp(a);
+          break;
+        case UnaryOpType::log:
+          res = std::log(a);
+          break;
+        default:
+          break;
+      }
+    }
+    if (!res || (target.may_flush_subnormals && is_subnormal(*res))) {
+      return std::nullopt;
+    }
+    return make_constant(dt, *res);
+  }
+}
+
+template <typename T>
+std::optional<TypedConstant> eval_binary_op(BinaryOpType op,
+                                            DataType dt,
+                                            T a,
+                                            T b,
+                                            const Target &target) {
+  if constexpr (std::is_floating_point_v<T>) {
+    if (target.may_flush_subnormals && (is_subnormal(a) || is_subnormal(b))) {
+      return std::nullopt;
+    }
+  }
+  if (is_comparison(op)) {
+    if constexpr (std::is_floating_point_v<T>) {
+      // The LLVM backends use ordered predicates, so that NaN != x is false,
+      // while the C-like ones emit !=, for which it is true.
+      if (std::isnan(a) || std::isnan(b)) {
+        return std::nullopt;
+      }
+    }
+    bool res;
+    switch (op) {
+      case BinaryOpType::cmp_lt:
+        res = a < b;
+        break;
+      case BinaryOpType::cmp_le:
+        res = a <= b;
+        break;
+      case BinaryOpType::cmp_gt:
+        res = a > b;
+        break;
+      case BinaryOpType::cmp_ge:
+        res = a >= b;
+        break;
+      case BinaryOpType::cmp_eq:
+        res = a == b;
+        break;
+      default:
+        res = a != b;
+        break;
+    }
+    // True is all ones.
+    return make_constant(PrimitiveType::i32, int32(res ? -1 : 0));
+  }
+  if constexpr (std::is_integral_v<T>) {
+    using U = std::make_unsigned_t<T>;
+    constexpr int bits = sizeof(T) * 8;
+    switch (op) {
+      // Wrap around on overflow like the backends. Unsigned 64-bit
+      // arithmetic avoids the promotion of narrow types to int.
+      case BinaryOpType::add:
+        return make_constant(dt, T(uint64(a) + uint64(b)));
+      case BinaryOpType::sub:
+        return make_constant(dt, T(uint64(a) - uint64(b)));
+      case BinaryOpType::mul:
+        return make_constant(dt, T(uint64(a) * uint64(b)));
+      case BinaryOpType::div:
+      case BinaryOpType::floordiv:
+      case BinaryOpType::mod: {
+        if (b == 0) {
+          return std::nullopt;
+        }
+        if constexpr (std::is_signed_v<T>) {
+          if (a == std::numeric_limits<T>::min() && b == -1) {
+            return std::nullopt;
+          }
+        } else {
+          // The LLVM backends divide unsigned integers as signed ones, so
+          // only the operands where both agree are evaluated.
+          if (((a | b) >> (bits - 1)) != 0) {
+            return std::nullopt;
+          }
+        }
+        T res;
+        if (op == BinaryOpType::mod) {
+          res = a % b;
+        } else {
+          res = a / b;
+          if (op == BinaryOpType::floordiv && (a < 0) != (b < 0) &&
+              res * b != a) {
+            res--;
+          }
+        }
+        return make_constant(dt, res);
+      }
+      case BinaryOpType::max:
+        return make_constant(dt, a > b ? a : b);
+      case BinaryOpType::min:
+        return make_constant(dt, a < b ? a : b);
+      case BinaryOpType::bit_and:
+        return make_constant(dt, T(a & b));
+      case BinaryOpType::bit_or:
+        return make_constant(dt, T(a | b));
+      case BinaryOpType::bit_xor:
+        return make_constant(dt, T(a ^ b));
+      case BinaryOpType::bit_shl:
+      case BinaryOpType::bit_shr:
+      case BinaryOpType::bit_sar:
+        // Shifting by the bit width or more yields poison in LLVM.
+        if (uint64(b) >= uint64(bits)) {
+          return std::nullopt;
+        }
+        if (op == BinaryOpType::bit_shl) {
+          return make_constant(dt, T(U(a) << b));
+        } else if (op == BinaryOpType::bit_shr) {
+          return make_constant(dt, T(U(a) >> b));
+        }
+        // Logical for unsigned integers.
+        return make_constant(dt, T(a >> b));
+      case BinaryOpType::pow: {
+        // Only defined for non-negative exponents of 32/64-bit integers.
+        if (b < 0 || bits < 32) {
+          return std::nullopt;
+        }
+        uint64 res = 1, base = a;
+        for (auto n = b; n; n >>= 1) {
+          if (n & 1) {
+            res *= base;
+          }
+          base *= base;
+        }
+        return make_constant(dt, T(res));
+      }
+      default:
+        return std::nullopt;
+    }
+  } else {
+    std::optional<T> res;
+    switch (op) {
+      case BinaryOpType::add:
+        res = a + b;
+        break;
+      case BinaryOpType::sub:
+        res = a - b;
+        break;
+      case BinaryOpType::mul:
+        res = a * b;
+        break;
+      case BinaryOpType::div:
+      case BinaryOpType::truediv:
+        if (target.exact_div_sqrt) {
+          res = a / b;
+        }
+        break;
+      case BinaryOpType::floordiv:
+        if (target.exact_div_sqrt) {
+          res = std::floor(a / b);
+        }
+        break;
+      case BinaryOpType::max:
+      case BinaryOpType::min:
+        // Backends disagree on NaN operands and on the sign of zero results.
+        if (std::isnan(a) || std::isnan(b) || (a == 0 && b == 0)) {
+          break;
+        }
+        res = op == BinaryOpType::max ? std::fmax(a, b) : std::fmin(a, b);
+        break;
+      case BinaryOpType::atan2:
+        if (target.uses_host_libm) {
+          res = std::atan2(a, b);
+        }
+        break;
+      case BinaryOpType::pow:
+        if (target.uses_host_libm) {
+          res = std::pow(a, b);
+        }
+        break;
+      default:
+        break;
+    }
+    if (!res || (target.may_flush_subnormals && is_subnormal(*res))) {
+      return std::nullopt;
+    }
+    return make_constant(dt, *res);
+  }
+}
+
 std::vector<Stmt *> get_raw_statements(const Block *block) {
   const auto &stmts = block->statements;
   std::vector<Stmt *> res(stmts.size());
@@ -24,7 +406,8 @@ std::vector<Stmt *> get_raw_statements(const Block *block) {
 
 class EvalVisitor : public IRVisitor {
  public:
-  explicit EvalVisitor() {
+  explicit EvalVisitor(const ArithmeticInterpretor *interpretor)
+      : interpretor_(interpretor) {
     allow_undefined_visitor = true;
     invoke_default_visitor = true;
   }
@@ -63,6 +446,17 @@ class EvalVisitor : public IRVisitor {
     context_.insert(stmt, stmt->val.data[0]);
   }
 
+  void visit(UnaryOpStmt *stmt) override {
+    auto operand_opt = context_.maybe_get(stmt->operand);
+    if (!operand_opt) {
+      failed_ = true;
+      return;
+    }
+    insert_or_failed(stmt, interpretor_->evaluate_unary_op(
+                               stmt->op_type, operand_opt.value(),
+                               stmt->cast_type));
+  }
+
   void visit(BinaryOpStmt *stmt) override {
     auto lhs_opt = context_.maybe_get(stmt->lhs);
     auto rhs_opt = context_.maybe_get(stmt->rhs);
@@ -70,31 +464,22 @@ class EvalVisitor : public IRVisitor {
       failed_ = true;
       return;
     }
-    auto lhs = lhs_opt.value();
-    auto rhs = rhs_opt.value();
-    if (lhs.dt != rhs.dt) {
-      failed_ = true;
-      return;
-    }
+    insert_or_failed(stmt, interpretor_->evaluate_binary_op(
+                               stmt->op_type, lhs_opt.value(),
+                               rhs_opt.value()));
+  }
 
-    const auto op = stmt->op_type;
-    const auto dt = lhs.dt;
-    // TODO: Consider using macros to avoid duplication
-    if (is_real(dt)) {
-      // Put floating point numbers first because is_signed/unsigned asserts
-      // that the data type being integral.
-      auto res_opt = eval_bin_op(lhs.val_float(), rhs.val_float(), op);
-      insert_or_failed(stmt, dt, res_opt);
-    } else if (is_signed(dt)) {
-      auto res_opt = eval_bin_op(lhs.val_int(), rhs.val_int(), op);
-      insert_or_failed(stmt, dt, res_opt);
-    } else if (is_unsigned(dt)) {
-      auto res_opt = eval_bin_op(lhs.val_uint(), rhs.val_uint(), op);
-      insert_or_failed(stmt, dt, res_opt);
-    } else {
-      TI_NOT_IMPLEMENTED;
+  void visit(TernaryOpStmt *stmt) override {
+    auto op1_opt = context_.maybe_get(stmt->op1);
+    auto op2_opt = context_.maybe_get(stmt->op2);
+    auto op3_opt = context_.maybe_get(stmt->op3);
+    if (!op1_opt || !op2_opt || !op3_opt) {
       failed_ = true;
+      return;
     }
+    insert_or_failed(stmt, interpretor_->evaluate_ternary_op(
+                               stmt->op_type, op1_opt.value(),
+                               op2_opt.value(), op3_opt.value()));
   }
 
   void visit(BitExtractStmt *stmt) override {
@@ -130,37 +515,13 @@ class EvalVisitor : public IRVisitor {
   }
 
  private:
-  template <typename T>
-  static std::optional<T> eval_bin_op(T lhs, T rhs, BinaryOpType op) {
-    if (op == BinaryOpType::add) {
-      return lhs + rhs;
-    }
-    if (op == BinaryOpType::sub) {
-      return lhs - rhs;
-    }
-    if (op == BinaryOpType::mul) {
-      return lhs * rhs;
-    }
-    if (op == BinaryOpType::div) {
-      return lhs / rhs;
-    }
-    if constexpr (std::is_integral_v<T>) {
-      if (op == BinaryOpType::mod) {
-        return lhs % rhs;
-      }
-    }
-    return std::nullopt;
-  }
-
-  template <typename T>
   void insert_or_failed(const Stmt *stmt,
-                        DataType dt,
-                        std::optional<T> val_opt) {
+                        const std::optional<TypedConstant> &val_opt) {
     if (!val_opt) {
       failed_ = true;
       return;
     }
-    context_.insert(stmt, TypedConstant(dt, val_opt.value()));
+    context_.insert(stmt, val_opt.value());
   }
 
   template <typename T>
@@ -168,6 +529,7 @@ class EvalVisitor : public IRVisitor {
     context_.insert(stmt, TypedConstant(dt, val));
   }
 
+  const ArithmeticInterpretor *interpretor_;
   EvalContext context_;
   bool failed_{false};
 };
@@ -177,9 +539,56 @@ class EvalVisitor : public IRVisitor {
 std::optional<TypedConstant> ArithmeticInterpretor::evaluate(
     const CodeRegion &region,
     const EvalContext &init_ctx) const {
-  EvalVisitor ev;
+  EvalVisitor ev(this);
   return ev.run(region, init_ctx);
 }
 
+std::optional<TypedConstant> ArithmeticInterpretor::evaluate_unary_op(
+    UnaryOpType op,
+    const TypedConstant &operand,
+    DataType cast_type) const {
+  const auto target = make_target(arch_, fast_math_);
+  const auto dt = operand.dt;
+  return dispatch(dt, [&](auto type) {
+    using T = decltype(type);
+    return eval_unary_op(op, dt, get_value<T>(operand), cast_type, target);
+  });
+}
+
+std::optional<TypedConstant> ArithmeticInterpretor::evaluate_binary_op(
+    BinaryOpType op,
+    const TypedConstant &lhs,
+    const TypedConstant &rhs) const {
+  if (lhs.dt != rhs.dt) {
+    return std::nullopt;
+  }
+  const auto target = make_target(arch_, fast_math_);
+  const auto dt = lhs.dt;
+  return dispatch(dt, [&](auto type) {
+    using T = decltype(type);
+    return eval_binary_op(op, dt, get_value<T>(lhs), get_value<T>(rhs),
+                          target);
+  });
+}
+
+std::optional<TypedConstant> ArithmeticInterpretor::evaluate_ternary_op(
+    TernaryOpType op,
+    const TypedConstant &op1,
+    const TypedConstant &op2,
+    const TypedConstant &op3) const {
+  if (op != TernaryOpType::select || op2.dt != op3.dt) {
+    return std::nullopt;
+  }
+  if (!op1.dt->is_primitive(PrimitiveTypeID::i32)) {
+    return std::nullopt;
+  }
+  // The LLVM backends test the lowest bit of the condition, the others test
+  // it against zero. Both agree on 0, on -1 (true) and on 1.
+  if (op1.val_i32 != 0 && (op1.val_i32 & 1) == 0) {
+    return std::nullopt;
+  }
+  return op1.val_i32 != 0 ? op2 : op3;
+}
+
 }  // namespace lang
 }  // namespace taichi
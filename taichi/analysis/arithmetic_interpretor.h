@@ -6,6 +6,7 @@
 
 #include "taichi/ir/statements.h"
 #include "taichi/ir/type.h"
+#include "taichi/program/arch.h"
 
 namespace taichi {
 namespace lang {
@@ -13,9 +14,28 @@ namespace lang {
 /**
  * Interprets a sequence of CHI IR statements within a block (acts like a
  * VM based on CHI).
+ *
+ * Operations are evaluated bit-exactly the way the target backend computes
+ * them at run time. An operation whose result may differ from the backend,
+ * e.g. a transcendental function computed by the device's math library, or
+ * whose result is undefined, e.g. an integer division by zero, is not
+ * evaluated.
  */
 class ArithmeticInterpretor {
  public:
+  /**
+   * Evaluates operations the way the CPU backends do.
+   */
+  ArithmeticInterpretor() = default;
+
+  /**
+   * @param arch: The backend whose results are reproduced
+   * @param fast_math: Whether the backend is compiled with fast math
+   */
+  ArithmeticInterpretor(Arch arch, bool fast_math)
+      : arch_(arch), fast_math_(fast_math) {
+  }
+
   /**
    * Evaluation context that maps from a Stmt to a constant value.
    */
@@ -94,6 +114,45 @@ class ArithmeticInterpretor {
    */
   std::optional<TypedConstant> evaluate(const CodeRegion &region,
                                         const EvalContext &init_ctx) const;
+
+  /**
+   * Evaluates a single unary operation.
+   *
+   * @param op: The operation
+   * @param operand: The operand
+   * @param cast_type: The destination type if |op| is a cast
+   * @return: The result, empty if it cannot be evaluated exactly
+   */
+  std::optional<TypedConstant> evaluate_unary_op(
+      UnaryOpType op,
+      const TypedConstant &operand,
+      DataType cast_type = PrimitiveType::unknown) const;
+
+  /**
+   * Evaluates a single binary operation. Both operands must have the same
+   * type, as they do after type_check.
+   *
+   * @return: The result, empty if it cannot be evaluated exactly
+   */
+  std::optional<TypedConstant> evaluate_binary_op(
+      BinaryOpType op,
+      const TypedConstant &lhs,
+      const TypedConstant &rhs) const;
+
+  /**
+   * Evaluates a single ternary operation.
+   *
+   * @return: The result, empty if it cannot be evaluated exactly
+   */
+  std::optional<TypedConstant> evaluate_ternary_op(
+      TernaryOpType op,
+      const TypedConstant &op1,
+      const TypedConstant &op2,
+      const TypedConstant &op3) const;
+
+ private:
+  Arch arch_{Arch::x64};
+  bool fast_math_{false};
 };
 
 }  // namespace lang
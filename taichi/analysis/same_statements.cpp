@@ -232,6 +232,22 @@ class IRNodeComparator : public IRVisitor {
     map_id(stmt->id, other->id);
   }
 
+  // Compares two (possibly null) blocks of the current statements.
+  void check_block(Block *this_block, Block *other_block) {
+    if (!same)
+      return;
+    if ((this_block == nullptr) != (other_block == nullptr)) {
+      same = false;
+      return;
+    }
+    if (this_block == nullptr)
+      return;
+    IRNode *backup_other_node = other_node;
+    other_node = other_block;
+    this_block->accept(this);
+    other_node = backup_other_node;
+  }
+
   void visit(Stmt *stmt) override {
     basic_check(stmt);
   }
@@ -241,24 +257,8 @@ class IRNodeComparator : public IRVisitor {
     if (!same)
       return;
     auto other = other_node->as<IfStmt>();
-    if (stmt->true_statements) {
-      if (!other->true_statements) {
-        same = false;
-        return;
-      }
-      other_node = other->true_statements.get();
-      stmt->true_statements->accept(this);
-      other_node = other;
-    }
-    if (stmt->false_statements && same) {
-      if (!other->false_statements) {
-        same = false;
-        return;
-      }
-      other_node = other->false_statements.get();
-      stmt->false_statements->accept(this);
-      other_node = other;
-    }
+    check_block(stmt->true_statements.get(), other->true_statements.get());
+    check_block(stmt->false_statements.get(), other->false_statements.get());
   }
 
   void visit(FuncBodyStmt *stmt) override {
@@ -301,18 +301,25 @@ class IRNodeComparator : public IRVisitor {
     other_node = other;
   }
 
+  void visit(MeshForStmt *stmt) override {
+    basic_check(stmt);
+    if (!same)
+      return;
+    auto other = other_node->as<MeshForStmt>();
+    check_block(stmt->body.get(), other->body.get());
+  }
+
   void visit(OffloadedStmt *stmt) override {
     basic_check(stmt);
     if (!same)
       return;
     auto other = other_node->as<OffloadedStmt>();
-    if (stmt->has_body()) {
-      TI_ASSERT(stmt->body);
-      TI_ASSERT(other->body);
-      other_node = other->body.get();
-      stmt->body->accept(this);
-      other_node = other;
-    }
+    check_block(stmt->tls_prologue.get(), other->tls_prologue.get());
+    check_block(stmt->mesh_prologue.get(), other->mesh_prologue.get());
+    check_block(stmt->bls_prologue.get(), other->bls_prologue.get());
+    check_block(stmt->body.get(), other->body.get());
+    check_block(stmt->bls_epilogue.get(), other->bls_epilogue.get());
+    check_block(stmt->tls_epilogue.get(), other->tls_epilogue.get());
   }
 
   static bool run(IRNode *root1,
@@ -332,6 +339,115 @@ class IRNodeComparator : public IRVisitor {
   }
 };
 
+// Hash an IRNode consistently with IRNodeComparator (without id_map or
+// check_same_value): roots that are the same have the same hash. The
+// traversal and what is hashed must be kept in sync with the comparator.
+class IRNodeHasher : public IRVisitor {
+ private:
+  uint64 hash_;
+  // map the id of each visited statement to its position in the root
+  std::unordered_map<int, int> id_map_;
+  int num_visited_;
+
+  IRNodeHasher() : hash_(0), num_visited_(0) {
+    allow_undefined_visitor = true;
+    invoke_default_visitor = true;
+  }
+
+  void combine(uint64 value) {
+    hash_ = hash_ * 100000007UL + value;
+  }
+
+  void hash_block(Block *block) {
+    combine(block != nullptr);
+    if (block)
+      block->accept(this);
+  }
+
+  void basic_hash(Stmt *stmt) {
+    combine(typeid(*stmt).hash_code());
+    combine(stmt->field_manager.hash());
+    combine(stmt->num_operands());
+    for (int i = 0; i < stmt->num_operands(); i++) {
+      auto operand = stmt->operand(i);
+      if (operand == nullptr) {
+        combine(0);
+        continue;
+      }
+      // Operands in the root are compared by position, and the others
+      // by id.
+      auto it = id_map_.find(operand->id);
+      if (it != id_map_.end()) {
+        combine(1);
+        combine(it->second);
+      } else {
+        combine(2);
+        combine(operand->id);
+      }
+    }
+    id_map_.emplace(stmt->id, num_visited_++);
+  }
+
+ public:
+  void visit(Block *stmt_list) override {
+    combine(stmt_list->size());
+    for (auto &stmt : stmt_list->statements) {
+      stmt->accept(this);
+    }
+  }
+
+  void visit(Stmt *stmt) override {
+    basic_hash(stmt);
+  }
+
+  void visit(IfStmt *stmt) override {
+    basic_hash(stmt);
+    hash_block(stmt->true_statements.get());
+    hash_block(stmt->false_statements.get());
+  }
+
+  void visit(FuncBodyStmt *stmt) override {
+    basic_hash(stmt);
+    hash_block(stmt->body.get());
+  }
+
+  void visit(WhileStmt *stmt) override {
+    basic_hash(stmt);
+    hash_block(stmt->body.get());
+  }
+
+  void visit(RangeForStmt *stmt) override {
+    basic_hash(stmt);
+    hash_block(stmt->body.get());
+  }
+
+  void visit(StructForStmt *stmt) override {
+    basic_hash(stmt);
+    hash_block(stmt->body.get());
+  }
+
+  void visit(MeshForStmt *stmt) override {
+    basic_hash(stmt);
+    hash_block(stmt->body.get());
+  }
+
+  void visit(OffloadedStmt *stmt) override {
+    basic_hash(stmt);
+    hash_block(stmt->tls_prologue.get());
+    hash_block(stmt->mesh_prologue.get());
+    hash_block(stmt->bls_prologue.get());
+    hash_block(stmt->body.get());
+    hash_block(stmt->bls_epilogue.get());
+    hash_block(stmt->tls_epilogue.get());
+  }
+
+  static uint64 run(IRNode *root) {
+    IRNodeHasher hasher;
+    root->accept(&hasher);
+    return hasher.hash_;
+  }
+};
+
 namespace irpass::analysis {
 bool same_statements(
     IRNode *root1,
@@ -379,6 +495,10 @@ bool same_statements(
                                /*check_same_value=*/false, std::nullopt,
                                /*ir_bank=*/nullptr);
 }
+uint64 hash_statements(IRNode *root) {
+  TI_ASSERT(root);
+  return IRNodeHasher::run(root);
+}
 bool same_value(Stmt *stmt1,
                 Stmt *stmt2,
                 const AsyncStateSet &possibly_modified_states,
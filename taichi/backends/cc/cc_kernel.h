@@ -1,6 +1,8 @@
 #pragma once
 
 #include "taichi/lang_util.h"
+#include "taichi/system/dynamic_loader.h"
+#include <memory>
 #include <set>
 
 TLANG_NAMESPACE_BEGIN
@@ -11,6 +13,10 @@ class CCProgramImpl;
 
 namespace cccp {
 
+struct CCContext;
+
+using CCFuncEntryType = void(CCContext *);
+
 class CCKernel {
  public:
   CCKernel(CCProgramImpl *cc_program_impl,
@@ -23,10 +29,19 @@ class CCKernel {
         source_(source) {
   }
 
+  // Generates the full C source and finds the cached shared object of the
+  // kernel, without invoking the C compiler yet.
   void compile();
+  // Compiles and links the shared object if it is not cached already. Safe to
+  // call from several threads on different kernels.
+  //
+  // @return Whether the shared object is ready, and whether it was cached.
+  bool build(bool &cache_hit);
+  void load();
   void launch(RuntimeContext *ctx);
-  std::string get_object() {
-    return obj_path_;
+
+  bool loaded() const {
+    return entry_ != nullptr;
   }
 
  private:
@@ -36,8 +51,11 @@ class CCKernel {
   std::string name_;
   std::string source_;
 
-  std::string src_path_;
-  std::string obj_path_;
+  // The runtime header, the layout and the kernel itself.
+  std::string full_source_;
+  std::string dll_path_;
+  std::unique_ptr<DynamicLoader> dll_;
+  CCFuncEntryType *entry_{nullptr};
 };
 
 }  // namespace cccp
@@ -1,9 +1,46 @@
 #include "taichi/backends/cc/cc_program.h"
 
+#include <chrono>
+#include <filesystem>
+
+#include "taichi/util/io.h"
+#include "taichi/util/statistics.h"
+
 using namespace taichi::lang::cccp;
 
 TLANG_NAMESPACE_BEGIN
 
+namespace {
+
+namespace fs = std::filesystem;
+
+// FNV-1a. std::hash is not guaranteed to be stable across processes, which
+// is required here since the shared objects are cached on disk.
+uint64 fnv1a_64(const std::string &str, uint64 basis) {
+  uint64 h = basis;
+  for (unsigned char c : str) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+// Kernels differing only in their names share a cached shared object, in
+// which the symbols of the kernel are renamed to this prefix.
+constexpr const char *kCachedKernelPrefix = "Tk_cached";
+
+std::string rename_kernel(std::string source,
+                          const std::string &from,
+                          const std::string &to) {
+  for (auto pos = source.find(from); pos != std::string::npos;
+       pos = source.find(from, pos + to.size())) {
+    source.replace(pos, from.size(), to);
+  }
+  return source;
+}
+
+}  // namespace
+
 CCProgramImpl::CCProgramImpl(CompileConfig &config) : ProgramImpl(config) {
   this->config = &config;
   runtime_ = std::make_unique<CCRuntime>(this,
@@ -13,6 +50,14 @@ CCProgramImpl::CCProgramImpl(CompileConfig &config) : ProgramImpl(config) {
                                          "\n");
   runtime_->compile();
   context_ = std::make_unique<CCContext>();
+  thread_pool_ = std::make_unique<ThreadPool>(config.cpu_max_num_threads);
+  // Without the offline cache, kernels are only shared within this process.
+  cache_dir_ = config.offline_cache ? config.offline_cache_file_path + "/cc"
+                                    : runtime_tmp_dir + "/cc_cache";
+  create_directories(cache_dir_);
+  // Called by the kernels to run the blocks of their range-for loops.
+  context_->parallel_for = reinterpret_cast<void *>(&ThreadPool::static_run);
+  context_->thread_pool = thread_pool_.get();
 }
 
 FunctionType CCProgramImpl::compile(Kernel *kernel, OffloadedStmt *) {
@@ -23,6 +68,13 @@ FunctionType CCProgramImpl::compile(Kernel *kernel, OffloadedStmt *) {
   return [ker_ptr](RuntimeContext &ctx) { return ker_ptr->launch(&ctx); };
 }
 
+std::vector<FunctionType> CCProgramImpl::compile_batch(
+    const std::vector<Kernel *> &kernels) {
+  auto ret = ProgramImpl::compile_batch(kernels);
+  build_pending_kernels();
+  return ret;
+}
+
 void CCProgramImpl::materialize_runtime(MemoryPool *memory_pool,
                                         KernelProfilerBase *,
                                         uint64 **result_buffer_ptr) {
@@ -62,26 +114,108 @@ void CCProgramImpl::materialize_snode_tree(
 }
 
 void CCProgramImpl::add_kernel(std::unique_ptr<CCKernel> kernel) {
+  pending_kernels_.push_back(kernel.get());
   kernels_.push_back(std::move(kernel));
-  need_relink_ = true;
+}
+
+void CCProgramImpl::build_pending_kernels() {
+  if (pending_kernels_.empty())
+    return;
+
+  struct BuildContext {
+    std::vector<CCKernel *> *kernels;
+    std::vector<char> succeeded;
+    std::vector<char> cache_hits;
+  } ctx;
+  ctx.kernels = &pending_kernels_;
+  ctx.succeeded.resize(pending_kernels_.size());
+  ctx.cache_hits.resize(pending_kernels_.size());
+  // Each task mostly waits for the C compiler, so use up to one thread per
+  // kernel.
+  thread_pool_->run(
+      (int)pending_kernels_.size(), (int)pending_kernels_.size(), &ctx,
+      [](void *ctx_, int, int i) {
+        auto *ctx = (BuildContext *)ctx_;
+        bool cache_hit = false;
+        ctx->succeeded[i] = (*ctx->kernels)[i]->build(cache_hit);
+        ctx->cache_hits[i] = cache_hit;
+      });
+
+  auto pending = std::move(pending_kernels_);
+  pending_kernels_.clear();
+  for (int i = 0; i < (int)pending.size(); i++) {
+    stat.add(ctx.cache_hits[i] ? "cc_kernel_cache_hits"
+                               : "cc_kernel_cache_misses");
+    TI_ERROR_IF(!ctx.succeeded[i], "[cc] failed to build kernel");
+    pending[i]->load();
+  }
 }
 
 void CCKernel::compile() {
-  if (!kernel_->is_evaluator)
-    ActionRecorder::get_instance().record(
-        "compile_kernel", {
-                              ActionArg("kernel_name", name_),
-                              ActionArg("kernel_source", source_),
-                          });
+  ActionRecorder::get_instance().record(
+      "compile_kernel", {
+                            ActionArg("kernel_name", name_),
+                            ActionArg("kernel_source", source_),
+                        });
+
+  auto *runtime = cc_program_impl_->get_runtime();
+  full_source_ = fmt::format(
+      "{}\n{}\n{}", runtime->header, cc_program_impl_->get_layout()->source,
+      rename_kernel(source_, "Tk_" + name_, kCachedKernelPrefix));
+  // The runtime object is linked into the shared object of every kernel.
+  const auto key_source = fmt::format(
+      "{}\n{}\n{}\n{}", cc_program_impl_->config->cc_compile_cmd,
+      cc_program_impl_->config->cc_link_cmd, runtime->source, full_source_);
+  dll_path_ = fmt::format("{}/{:016x}{:016x}.so",
+                          cc_program_impl_->get_cache_dir(),
+                          fnv1a_64(key_source, 14695981039346656037ULL),
+                          fnv1a_64(key_source, 0x9e3779b97f4a7c15ULL));
+}
 
-  obj_path_ = fmt::format("{}/{}.o", runtime_tmp_dir, name_);
-  src_path_ = fmt::format("{}/{}.c", runtime_tmp_dir, name_);
+bool CCKernel::build(bool &cache_hit) {
+  std::error_code ec;
+  cache_hit = fs::exists(dll_path_, ec);
+  if (cache_hit) {
+    TI_TRACE("[cc] reusing cached kernel [{}]", dll_path_);
+    return true;
+  }
+  // Build under temporary names first, so that other processes sharing the
+  // cache never load a partially written shared object.
+  const auto tmp_prefix = fmt::format(
+      "{}.{}.{}.tmp", dll_path_, name_,
+      std::chrono::steady_clock::now().time_since_epoch().count());
+  const auto src_path = tmp_prefix + ".c";
+  const auto obj_path = tmp_prefix + ".o";
+  const auto tmp_dll_path = tmp_prefix + ".so";
+  std::ofstream(src_path) << full_source_;
+  TI_DEBUG("[cc] compiling [{}] -> [{}]:\n{}\n", name_, obj_path, source_);
+  const auto *config = cc_program_impl_->config;
+  bool ok = execute(config->cc_compile_cmd, shell_escape(obj_path),
+                    shell_escape(src_path)) == 0;
+  if (ok) {
+    const std::vector<std::string> objects = {
+        obj_path, cc_program_impl_->get_runtime()->get_object()};
+    TI_DEBUG("[cc] linking kernel [{}] -> [{}]", name_, dll_path_);
+    ok = execute(config->cc_link_cmd, shell_escape(tmp_dll_path),
+                 shell_escape(objects)) == 0;
+  }
+  if (ok) {
+    fs::rename(tmp_dll_path, dll_path_, ec);
+    ok = !ec;
+  }
+  fs::remove(src_path, ec);
+  fs::remove(obj_path, ec);
+  fs::remove(tmp_dll_path, ec);
+  return ok;
+}
 
-  std::ofstream(src_path_) << cc_program_impl_->get_runtime()->header << "\n"
-                           << cc_program_impl_->get_layout()->source << "\n"
-                           << source_;
-  TI_DEBUG("[cc] compiling [{}] -> [{}]:\n{}\n", name_, obj_path_, source_);
-  execute(cc_program_impl_->config->cc_compile_cmd, obj_path_, src_path_);
+void CCKernel::load() {
+  TI_DEBUG("[cc] loading shared object: {}", dll_path_);
+  dll_ = std::make_unique<DynamicLoader>(dll_path_);
+  TI_ASSERT_INFO(dll_->loaded(), "[cc] could not load shared object: {}",
+                 dll_path_);
+  entry_ = reinterpret_cast<CCFuncEntryType *>(
+      dll_->load_function(kCachedKernelPrefix));
 }
 
 void CCRuntime::compile() {
@@ -96,22 +230,23 @@ void CCRuntime::compile() {
 
   std::ofstream(src_path_) << header << "\n" << source;
   TI_DEBUG("[cc] compiling runtime -> [{}]:\n{}\n", obj_path_, source);
-  execute(cc_program_impl_->config->cc_compile_cmd, obj_path_, src_path_);
+  execute(cc_program_impl_->config->cc_compile_cmd, shell_escape(obj_path_),
+          shell_escape(src_path_));
 }
 
 void CCKernel::launch(RuntimeContext *ctx) {
-  if (!kernel_->is_evaluator)
-    ActionRecorder::get_instance().record("launch_kernel",
-                                          {
-                                              ActionArg("kernel_name", name_),
-                                          });
+  ActionRecorder::get_instance().record("launch_kernel",
+                                        {
+                                            ActionArg("kernel_name", name_),
+                                        });
 
-  cc_program_impl_->relink();
+  if (!loaded()) {
+    cc_program_impl_->build_pending_kernels();
+  }
   TI_TRACE("[cc] entering kernel [{}]", name_);
-  auto entry = cc_program_impl_->load_kernel(name_);
-  TI_ASSERT(entry);
+  TI_ASSERT(entry_);
   auto *context = cc_program_impl_->update_context(ctx);
-  (*entry)(context);
+  (*entry_)(context);
   cc_program_impl_->context_to_result_buffer();
   TI_TRACE("[cc] leaving kernel [{}]", name_);
 }
@@ -133,10 +268,12 @@ size_t CCLayout::compile() {
                            << "}\n";
 
   TI_DEBUG("[cc] compiling root struct -> [{}]:\n{}\n", obj_path_, source);
-  execute(cc_program_impl_->config->cc_compile_cmd, obj_path_, src_path_);
+  execute(cc_program_impl_->config->cc_compile_cmd, shell_escape(obj_path_),
+          shell_escape(src_path_));
 
   TI_DEBUG("[cc] linking root struct object [{}] -> [{}]", obj_path_, dll_path);
-  execute(cc_program_impl_->config->cc_link_cmd, dll_path, obj_path_);
+  execute(cc_program_impl_->config->cc_link_cmd, shell_escape(dll_path),
+          shell_escape(obj_path_));
 
   TI_DEBUG("[cc] loading root struct object: {}", dll_path);
   DynamicLoader dll(dll_path);
@@ -150,35 +287,6 @@ size_t CCLayout::compile() {
   return (*get_root_size)();
 }
 
-void CCProgramImpl::relink() {
-  if (!need_relink_)
-    return;
-
-  dll_path_ = fmt::format("{}/libti_program.so", runtime_tmp_dir);
-
-  std::vector<std::string> objects;
-  objects.push_back(runtime_->get_object());
-  for (auto const &ker : kernels_) {
-    objects.push_back(ker->get_object());
-  }
-
-  TI_DEBUG("[cc] linking shared object [{}] with [{}]", dll_path_,
-           fmt::join(objects, "] ["));
-  execute(this->config->cc_link_cmd, dll_path_, fmt::join(objects, "' '"));
-
-  dll_ = nullptr;
-  TI_DEBUG("[cc] loading shared object: {}", dll_path_);
-  dll_ = std::make_unique<DynamicLoader>(dll_path_);
-  TI_ASSERT_INFO(dll_->loaded(), "[cc] could not load shared object: {}",
-                 dll_path_);
-
-  need_relink_ = false;
-}
-
-CCFuncEntryType *CCProgramImpl::load_kernel(std::string const &name) {
-  return reinterpret_cast<CCFuncEntryType *>(dll_->load_function("Tk_" + name));
-}
-
 CCContext *CCProgramImpl::update_context(RuntimeContext *ctx) {
   // TODO(k-ye): Do you have other zero-copy ideas for arg buf?
   std::memcpy(context_->args, ctx->args, taichi_max_num_args * sizeof(uint64));
@@ -4,6 +4,7 @@
 #include "taichi/program/kernel.h"
 #include "taichi/program/program.h"
 #include "taichi/system/dynamic_loader.h"
+#include "taichi/system/threading.h"
 #include "taichi/util/action_recorder.h"
 #include "struct_cc.h"
 #include "cc_runtime.h"
@@ -23,7 +24,6 @@ TI_NAMESPACE_END
 TLANG_NAMESPACE_BEGIN
 
 using namespace taichi::lang::cccp;
-using CCFuncEntryType = void(cccp::CCContext *);
 
 class CCProgramImpl : public ProgramImpl {
  public:
@@ -31,6 +31,9 @@ class CCProgramImpl : public ProgramImpl {
 
   FunctionType compile(Kernel *kernel, OffloadedStmt *) override;
 
+  std::vector<FunctionType> compile_batch(
+      const std::vector<Kernel *> &kernels) override;
+
   std::size_t get_snode_num_dynamically_allocated(
       SNode *snode,
       uint64 *result_buffer) override {
@@ -69,8 +72,14 @@ class CCProgramImpl : public ProgramImpl {
   ~CCProgramImpl() {
   }
 
-  CCFuncEntryType *load_kernel(std::string const &name);
-  void relink();
+  // Builds the shared objects of all kernels compiled so far, running the C
+  // compiler for several kernels at once.
+  void build_pending_kernels();
+
+  // Where the shared objects of kernels are cached, keyed by their source.
+  const std::string &get_cache_dir() const {
+    return cache_dir_;
+  }
 
   CCContext *update_context(RuntimeContext *ctx);
   void context_to_result_buffer();
@@ -79,15 +88,16 @@ class CCProgramImpl : public ProgramImpl {
   void add_kernel(std::unique_ptr<CCKernel> kernel);
 
   std::vector<std::unique_ptr<CCKernel>> kernels_;
+  // Kernels compiled to C but not built into shared objects yet.
+  std::vector<CCKernel *> pending_kernels_;
+  std::string cache_dir_;
   std::unique_ptr<CCContext> context_;
   std::unique_ptr<CCRuntime> runtime_;
   std::unique_ptr<CCLayout> layout_;
-  std::unique_ptr<DynamicLoader> dll_;
-  std::string dll_path_;
+  std::unique_ptr<ThreadPool> thread_pool_;
   std::vector<char> args_buf_;
   std::vector<char> root_buf_;
   std::vector<char> gtmp_buf_;
   uint64 *result_buffer_{nullptr};
-  bool need_relink_{true};
 };
 TLANG_NAMESPACE_END
@@ -6,6 +6,7 @@
 #include <sstream>
 #include <cstdlib>
 #include <iomanip>
+#include <vector>
 
 TLANG_NAMESPACE_BEGIN
 namespace cccp {
@@ -36,6 +37,25 @@ inline std::string cc_atomic_op_type_symbol(AtomicOpType op) {
   }
 }
 
+// The suffix of the __atomic_fetch_* builtin performing |op|, for integers.
+inline std::string cc_atomic_op_type_builtin_name(AtomicOpType op) {
+  switch (op) {
+    case AtomicOpType::add:
+      return "add";
+    case AtomicOpType::sub:
+      return "sub";
+    case AtomicOpType::bit_or:
+      return "or";
+    case AtomicOpType::bit_xor:
+      return "xor";
+    case AtomicOpType::bit_and:
+      return "and";
+    default:
+      TI_ERROR("Unsupported AtomicOpType={} on C backend",
+               atomic_op_type_name(op));
+  }
+}
+
 inline bool cc_is_binary_op_infix(BinaryOpType op) {
   switch (op) {
     case BinaryOpType::max:
@@ -72,6 +92,28 @@ inline std::string unary_op_type_symbol(UnaryOpType op) {
   }
 }
 
+// Quotes |arg| as a single POSIX shell word.
+inline std::string shell_escape(const std::string &arg) {
+  std::string ret = "'";
+  for (char c : arg) {
+    if (c == '\'') {
+      ret += "'\\''";
+    } else {
+      ret += c;
+    }
+  }
+  return ret + "'";
+}
+
+// Quotes each of |args| as a separate shell word.
+inline std::string shell_escape(const std::vector<std::string> &args) {
+  std::vector<std::string> words;
+  for (const auto &arg : args) {
+    words.push_back(shell_escape(arg));
+  }
+  return fmt::format("{}", fmt::join(words, " "));
+}
+
 template <typename... Args>
 inline int execute(std::string fmt, Args &&... args) {
   auto cmd = fmt::format(fmt, std::forward<Args>(args)...);
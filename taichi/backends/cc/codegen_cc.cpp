@@ -2,6 +2,7 @@
 #include "cc_kernel.h"
 #include "cc_layout.h"
 #include "cc_program.h"
+#include "taichi/ir/analysis.h"
 #include "taichi/ir/ir.h"
 #include "taichi/ir/statements.h"
 #include "taichi/ir/transforms.h"
@@ -28,7 +29,12 @@ class CCTransformer : public IRVisitor {
 
   LineAppender line_appender;
   LineAppender line_appender_header;
+  // Functions running the blocks of range-for loops, defined before the
+  // kernel.
+  LineAppender line_appender_tasks;
   bool is_top_level{true};
+  // Whether the statements being emitted may run on several threads at once.
+  bool is_parallel{false};
   GetRootStmt *root_stmt;
 
  public:
@@ -49,14 +55,17 @@ class CCTransformer : public IRVisitor {
     auto ir = kernel->ir.get();
     auto config = kernel->program->config;
     config.demote_dense_struct_fors = true;
-    irpass::compile_to_executable(ir, config, kernel,
-                                  /*vectorize=*/false, kernel->grad,
-                                  /*ad_use_stack=*/true, config.print_ir,
-                                  /*lower_global_access*/ true);
+    irpass::compile_to_executable(
+        ir, config, kernel,
+        /*vectorize=*/false, kernel->grad,
+        /*ad_use_stack=*/true, config.print_ir,
+        /*lower_global_access*/ true,
+        /*make_thread_local=*/config.make_thread_local);
   }
 
   std::string get_source() {
-    return line_appender_header.lines() + line_appender.lines();
+    return line_appender_tasks.lines() + line_appender_header.lines() +
+           line_appender.lines();
   }
 
  private:
@@ -144,6 +153,13 @@ class CCTransformer : public IRVisitor {
     emit("{} = ({}) (ti_ctx->gtmp + {});", var, ptr_type, stmt->offset);
   }
 
+  void visit(ThreadLocalPtrStmt *stmt) override {
+    auto ptr_type =
+        cc_data_type_name(stmt->element_type().ptr_removed()) + " *";
+    auto var = define_var(ptr_type, stmt->raw_name());
+    emit("{} = ({}) (ti_tls.data + {});", var, ptr_type, stmt->offset);
+  }
+
   void visit(LinearizeStmt *stmt) override {
     std::string val = "0";
     for (int i = 0; i < stmt->inputs.size(); i++) {
@@ -381,14 +397,43 @@ class CCTransformer : public IRVisitor {
     const auto src_name = stmt->val->raw_name();
     const auto op = cc_atomic_op_type_symbol(stmt->op_type);
     const auto type = stmt->dest->element_type().ptr_removed();
+    const auto is_min_max = stmt->op_type == AtomicOpType::max ||
+                            stmt->op_type == AtomicOpType::min;
     auto var = define_var(cc_data_type_name(type), stmt->raw_name());
-    emit("{} = *{};", var, dest_ptr);
-    if (stmt->op_type == AtomicOpType::max ||
-        stmt->op_type == AtomicOpType::min) {
-      emit("*{} = {};", dest_ptr,
-           invoke_libc(op, type, "*{}, {}", dest_ptr, src_name));
+    // The thread-local storage is private to a block.
+    if (!is_parallel || stmt->dest->is<ThreadLocalPtrStmt>()) {
+      emit("{} = *{};", var, dest_ptr);
+      if (is_min_max) {
+        emit("*{} = {};", dest_ptr,
+             invoke_libc(op, type, "*{}, {}", dest_ptr, src_name));
+      } else {
+        emit("*{} {}= {};", dest_ptr, op, src_name);
+      }
+    } else if (is_integral(type) && !is_min_max) {
+      emit("{} = __atomic_fetch_{}({}, {}, __ATOMIC_SEQ_CST);", var,
+           cc_atomic_op_type_builtin_name(stmt->op_type), dest_ptr,
+           src_name);
     } else {
-      emit("*{} {}= {};", dest_ptr, op, src_name);
+      // A compare-and-swap loop, which also works for floats.
+      const auto old_name = stmt->raw_name();
+      const auto new_name = old_name + "_new";
+      emit("{};", var);
+      emit("__atomic_load({}, &{}, __ATOMIC_SEQ_CST);", dest_ptr, old_name);
+      emit("for (;;) {{");
+      {
+        ScopedIndent _s(line_appender);
+        const auto new_value =
+            is_min_max
+                ? invoke_libc(op, type, "{}, {}", old_name, src_name)
+                : fmt::format("{} {} {}", old_name, op, src_name);
+        emit("{} = {};", define_var(cc_data_type_name(type), new_name),
+             new_value);
+        emit("if (__atomic_compare_exchange({}, &{}, &{}, 0, "
+             "__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))",
+             dest_ptr, old_name, new_name);
+        emit("  break;");
+      }
+      emit("}}");
     }
   }
 
@@ -420,38 +465,69 @@ class CCTransformer : public IRVisitor {
   }
 
   void generate_range_for_kernel(OffloadedStmt *stmt) {
-    if (stmt->const_begin && stmt->const_end) {
+    // The C runtime's random number generator is not thread-safe.
+    const bool has_rand = !irpass::analysis::gather_statements(
+                               stmt, [](Stmt *s) { return s->is<RandStmt>(); })
+                               .empty();
+    const int num_threads = has_rand ? 1 : stmt->num_cpu_threads;
+    const auto task_name =
+        fmt::format("Tk_{}_{}_task", kernel->name, stmt->raw_name());
+    generate_range_for_task(stmt, task_name, num_threads > 1);
+
+    ScopedIndent _s(line_appender);
+    std::string begin_expr, end_expr;
+    if (stmt->const_begin) {
+      begin_expr = std::to_string(stmt->begin_value);
+    } else {
+      begin_expr = "tmp_begin_" + stmt->raw_name();
+      emit("{} = *(Ti_i32 *) (ti_ctx->gtmp + {});",
+           define_var("Ti_i32", begin_expr), stmt->begin_offset);
+    }
+    if (stmt->const_end) {
+      end_expr = std::to_string(stmt->end_value);
+    } else {
+      end_expr = "tmp_end_" + stmt->raw_name();
+      emit("{} = *(Ti_i32 *) (ti_ctx->gtmp + {});",
+           define_var("Ti_i32", end_expr), stmt->end_offset);
+    }
+    emit("Ti_parallel_range_for(ti_ctx, {}, {}, {}, {}, {});", begin_expr,
+         end_expr, stmt->block_dim, num_threads, task_name);
+  }
+
+  // Emits a function running the iterations [begin, end) of |stmt|, with the
+  // thread-local storage of that block.
+  void generate_range_for_task(OffloadedStmt *stmt,
+                               const std::string &task_name,
+                               bool parallel) {
+    LineAppender kernel_appender;
+    std::swap(line_appender, kernel_appender);
+    is_parallel = parallel;
+
+    emit("static void {}(struct Ti_Context *ti_ctx, Ti_i32 begin, "
+         "Ti_i32 end) {{",
+         task_name);
+    {
       ScopedIndent _s(line_appender);
-      auto begin_value = stmt->begin_value;
-      auto end_value = stmt->end_value;
+      if (stmt->tls_prologue) {
+        emit("union {{ Ti_f64 align; Ti_u8 data[{}]; }} ti_tls;",
+             stmt->tls_size);
+        stmt->tls_prologue->accept(this);
+      }
       auto var = define_var("Ti_i32", stmt->raw_name());
-      emit("for ({} = {}; {} < {}; {} += {}) {{", var, begin_value,
-           stmt->raw_name(), end_value, stmt->raw_name(), 1 /* stmt->step? */);
+      emit("for ({} = begin; {} < end; {} += 1) {{", var, stmt->raw_name(),
+           stmt->raw_name());
       stmt->body->accept(this);
       emit("}}");
-    } else {
-      auto var = define_var("Ti_i32", stmt->raw_name());
-      auto begin_expr = "tmp_begin_" + stmt->raw_name();
-      auto end_expr = "tmp_end_" + stmt->raw_name();
-      auto begin_var = define_var("Ti_i32", begin_expr);
-      auto end_var = define_var("Ti_i32", end_expr);
-      if (!stmt->const_begin) {
-        emit("{} = *(Ti_i32 *) (ti_ctx->gtmp + {});", begin_var,
-             stmt->begin_offset);
-      } else {
-        emit("{} = {};", begin_var, stmt->begin_value);
+      if (stmt->tls_epilogue) {
+        stmt->tls_epilogue->accept(this);
       }
-      if (!stmt->const_end) {
-        emit("{} = *(Ti_i32 *) (ti_ctx->gtmp + {});", end_var,
-             stmt->end_offset);
-      } else {
-        emit("{} = {};", end_var, stmt->end_value);
-      }
-      emit("for ({} = {}; {} < {}; {} += {}) {{", var, begin_expr,
-           stmt->raw_name(), end_expr, stmt->raw_name(), 1 /* stmt->step? */);
-      stmt->body->accept(this);
-      emit("}}");
     }
+    emit("}}");
+    emit("");
+
+    is_parallel = false;
+    std::swap(line_appender, kernel_appender);
+    line_appender_tasks.append_raw(kernel_appender.lines());
   }
 
   void visit(OffloadedStmt *stmt) override {
@@ -26,6 +26,9 @@ union Ti_BitCast {
   void *ptr_void;
 };
 
+typedef void (*Ti_ParallelForTask)(void *range_ctx, Ti_i32 thread_id,
+                                   Ti_i32 task_id);
+
 struct Ti_Context {
   struct Ti_S0root *root;
   // In some C compilers `void *p; p + 1 == p;`, so let's use `char *p`:
@@ -33,7 +36,65 @@ struct Ti_Context {
 
   union Ti_BitCast *args;
   int *earg;
+
+  // Runs task(range_ctx, thread_id, task_id) for every task_id in
+  // [0, num_tasks) on up to num_threads threads, and returns once all of them
+  // are done. Parallel loops run serially when it is NULL.
+  void (*parallel_for)(void *thread_pool, Ti_i32 num_tasks,
+                       Ti_i32 num_threads, void *range_ctx,
+                       Ti_ParallelForTask task);
+  void *thread_pool;
+};
+
+typedef void (*Ti_RangeForBody)(struct Ti_Context *ti_ctx, Ti_i32 begin,
+                                Ti_i32 end);
+
+struct Ti_RangeForContext {
+  struct Ti_Context *ti_ctx;
+  Ti_RangeForBody body;
+  Ti_i32 begin;
+  Ti_i32 end;
+  Ti_i32 block_dim;
 };
+
+static inline void Ti_range_for_task(void *range_ctx, Ti_i32 thread_id,
+                                     Ti_i32 task_id) {
+  struct Ti_RangeForContext *ctx = (struct Ti_RangeForContext *)range_ctx;
+  Ti_i32 begin = ctx->begin + task_id * ctx->block_dim;
+  Ti_i32 end = ctx->end - begin < ctx->block_dim ? ctx->end
+                                                 : begin + ctx->block_dim;
+  ctx->body(ctx->ti_ctx, begin, end);
+}
+
+// Splits [begin, end) into blocks of block_dim iterations, and runs them on
+// the thread pool of ti_ctx.
+static inline void Ti_parallel_range_for(struct Ti_Context *ti_ctx,
+                                         Ti_i32 begin, Ti_i32 end,
+                                         Ti_i32 block_dim, Ti_i32 num_threads,
+                                         Ti_RangeForBody body) {
+  struct Ti_RangeForContext ctx;
+  if (begin >= end) {
+    return;
+  }
+  if (ti_ctx->parallel_for == 0 || num_threads <= 1) {
+    body(ti_ctx, begin, end);
+    return;
+  }
+  if (block_dim == 0) {
+    // Same as the LLVM CPU backend: ~32 blocks per thread for load
+    // balancing, and at most 512 iterations per block.
+    block_dim = (end - begin) / (num_threads * 32);
+    block_dim = block_dim < 1 ? 1 : block_dim > 512 ? 512 : block_dim;
+  }
+  ctx.ti_ctx = ti_ctx;
+  ctx.body = body;
+  ctx.begin = begin;
+  ctx.end = end;
+  ctx.block_dim = block_dim;
+  ti_ctx->parallel_for(ti_ctx->thread_pool,
+                       (end - begin - 1) / block_dim + 1, num_threads, &ctx,
+                       Ti_range_for_task);
+}
 )
 
 // clang-format on
@@ -52,6 +113,9 @@ struct CCContext {
 
   uint64_t *args;
   int *earg;
+
+  void *parallel_for;
+  void *thread_pool;
 };
 
 };  // namespace cccp
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "taichi/common/core.h"
+#include "taichi/common/serialization.h"
+
+namespace taichi {
+namespace lang {
+namespace cpu {
+
+struct AotKernelArg {
+  std::string dtype_name;
+  bool is_external_array{false};
+
+  TI_IO_DEF(dtype_name, is_external_array);
+};
+
+struct AotCompiledKernel {
+  std::string identifier;
+  // Symbols exported by the shared object, in launch order.
+  std::vector<std::string> offloaded_task_names;
+  std::vector<AotKernelArg> args;
+  std::vector<std::string> ret_dtype_names;
+
+  TI_IO_DEF(identifier, offloaded_task_names, args, ret_dtype_names);
+};
+
+struct AotCompiledKernelTmpl {
+  std::string identifier;
+  std::unordered_map<std::string, AotCompiledKernel> kernels;
+
+  TI_IO_DEF(identifier, kernels);
+};
+
+struct CompiledNodeAllocator {
+  int snode_id{0};
+  std::size_t node_size{0};
+
+  TI_IO_DEF(snode_id, node_size);
+};
+
+// Everything runtime_initialize_snodes() and the node allocators of an SNode
+// tree are initialized with.
+struct CompiledSNodeTree {
+  int tree_id{0};
+  int root_id{0};
+  int num_snodes{0};
+  std::size_t root_size{0};
+  bool all_dense{false};
+  std::vector<CompiledNodeAllocator> node_allocators;
+
+  TI_IO_DEF(tree_id,
+            root_id,
+            num_snodes,
+            root_size,
+            all_dense,
+            node_allocators);
+};
+
+struct CompiledFieldData {
+  std::string field_name;
+  std::string dtype_name;
+  int snode_tree_id{0};
+  int snode_id{0};
+  std::vector<int> shape;
+  bool is_scalar{false};
+  int row_num{0};
+  int column_num{0};
+
+  TI_IO_DEF(field_name,
+            dtype_name,
+            snode_tree_id,
+            snode_id,
+            shape,
+            is_scalar,
+            row_num,
+            column_num);
+};
+
+struct AotData {
+  // File name of the shared object, relative to the metadata file.
+  std::string library_file;
+  // The object code is tuned for this CPU.
+  std::string target_cpu;
+
+  // LLVMRuntime settings the kernels were compiled against.
+  int cpu_max_num_threads{1};
+  int random_seed{0};
+  bool node_allocator_cache{false};
+  bool gc_lazy_zero_fill{false};
+
+  std::vector<AotCompiledKernel> kernels;
+  std::vector<AotCompiledKernelTmpl> kernel_tmpls;
+  std::vector<CompiledFieldData> fields;
+  std::vector<CompiledSNodeTree> snode_trees;
+
+  TI_IO_DEF(library_file,
+            target_cpu,
+            cpu_max_num_threads,
+            random_seed,
+            node_allocator_cache,
+            gc_lazy_zero_fill,
+            kernels,
+            kernel_tmpls,
+            fields,
+            snode_trees);
+};
+
+}  // namespace cpu
+}  // namespace lang
+}  // namespace taichi
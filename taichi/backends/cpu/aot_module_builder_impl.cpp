@@ -0,0 +1,149 @@
+#include "taichi/backends/cpu/aot_module_builder_impl.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include "llvm/Support/Host.h"
+
+#include "taichi/backends/cc/cc_utils.h"
+#include "taichi/backends/cpu/codegen_cpu.h"
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/llvm/llvm_program.h"
+#include "taichi/util/str.h"
+
+namespace taichi {
+namespace lang {
+namespace cpu {
+
+AotModuleBuilderImpl::AotModuleBuilderImpl(
+    LlvmProgramImpl *prog,
+    const std::vector<CompiledSNodeTree> &compiled_snode_trees)
+    : prog_(prog) {
+  TI_AUTO_PROF
+  const auto &config = *prog_->config;
+  // Profiled kernels call back into the KernelProfiler of this process.
+  TI_ERROR_IF(config.kernel_profiler,
+              "AOT: kernel_profiler is not supported on CPU");
+  aot_data_.target_cpu = llvm::sys::getHostCPUName().str();
+  aot_data_.cpu_max_num_threads = config.cpu_max_num_threads;
+  aot_data_.random_seed = config.random_seed;
+  aot_data_.node_allocator_cache = config.cpu_node_allocator_cache;
+  aot_data_.gc_lazy_zero_fill = config.cpu_gc_lazy_zero_fill;
+  aot_data_.snode_trees = compiled_snode_trees;
+
+  // Only the entry points the loader calls into are exported. Kernels carry
+  // their own (internalized) copies of the runtime functions they use.
+  auto *tlctx = prog_->get_llvm_context(host_arch());
+  auto runtime_module = tlctx->clone_struct_module();
+  TaichiLLVMContext::eliminate_unused_functions(
+      runtime_module.get(), [](const std::string &func_name) {
+        return starts_with(func_name, "runtime_") ||
+               starts_with(func_name, "LLVMRuntime_");
+      });
+  object_codes_.push_back(
+      tlctx->jit->compile_to_object(std::move(runtime_module)));
+}
+
+void AotModuleBuilderImpl::dump(const std::string &output_dir,
+                                const std::string &filename) const {
+  std::vector<std::string> object_paths;
+  for (int i = 0; i < (int)object_codes_.size(); i++) {
+    const auto object_path = fmt::format("{}/{}_{}.o", output_dir, filename, i);
+    std::ofstream fs(object_path, std::ios::binary);
+    fs.write(object_codes_[i].data(), object_codes_[i].size());
+    fs.close();
+    object_paths.push_back(object_path);
+  }
+
+  AotData aot_data = aot_data_;
+  aot_data.library_file = fmt::format("{}.so", filename);
+  const std::string library_path =
+      fmt::format("{}/{}", output_dir, aot_data.library_file);
+  int ret = cccp::execute(prog_->config->cpu_aot_link_cmd,
+                          cccp::shell_escape(library_path),
+                          cccp::shell_escape(object_paths));
+  for (const auto &object_path : object_paths) {
+    std::remove(object_path.c_str());
+  }
+  TI_ERROR_IF(ret != 0, "AOT: failed to link {}", library_path);
+
+  const std::string bin_path =
+      fmt::format("{}/{}_metadata.tcb", output_dir, filename);
+  write_to_binary_file(aot_data, bin_path);
+
+  const std::string txt_path =
+      fmt::format("{}/{}_metadata.json", output_dir, filename);
+  TextSerializer ts;
+  ts.serialize_to_json("aot_data", aot_data);
+  ts.write_to_file(txt_path);
+}
+
+AotCompiledKernel AotModuleBuilderImpl::compile_kernel(
+    const std::string &identifier,
+    Kernel *kernel) {
+  if (!kernel->lowered()) {
+    kernel->lower();
+  }
+  // External functions are called through addresses in this process.
+  auto external_calls = irpass::analysis::gather_statements(
+      kernel->ir.get(), [](Stmt *s) { return s->is<ExternalFuncCallStmt>(); });
+  TI_ERROR_IF(!external_calls.empty(),
+              "AOT: external function calls are not supported on CPU");
+
+  AotCompiledKernel compiled;
+  compiled.identifier = identifier;
+  CodeGenCPU codegen(kernel);
+  object_codes_.push_back(
+      codegen.codegen_object(compiled.offloaded_task_names));
+  for (const auto &arg : kernel->args) {
+    compiled.args.push_back({arg.dt.to_string(), arg.is_external_array});
+  }
+  for (const auto &ret : kernel->rets) {
+    compiled.ret_dtype_names.push_back(ret.dt.to_string());
+  }
+  return compiled;
+}
+
+void AotModuleBuilderImpl::add_per_backend(const std::string &identifier,
+                                           Kernel *kernel) {
+  aot_data_.kernels.push_back(compile_kernel(identifier, kernel));
+}
+
+void AotModuleBuilderImpl::add_field_per_backend(const std::string &identifier,
+                                                 const SNode *rep_snode,
+                                                 bool is_scalar,
+                                                 DataType dt,
+                                                 std::vector<int> shape,
+                                                 int row_num,
+                                                 int column_num) {
+  // Only tree roots know their tree id.
+  const SNode *root = rep_snode;
+  while (root->parent) {
+    root = root->parent;
+  }
+  aot_data_.fields.push_back({identifier, dt.to_string(),
+                              root->get_snode_tree_id(), rep_snode->id, shape,
+                              is_scalar, row_num, column_num});
+}
+
+void AotModuleBuilderImpl::add_per_backend_tmpl(const std::string &identifier,
+                                                const std::string &key,
+                                                Kernel *kernel) {
+  auto compiled = compile_kernel(identifier, kernel);
+  for (auto &k : aot_data_.kernel_tmpls) {
+    if (k.identifier == identifier) {
+      k.kernels.insert(std::make_pair(key, std::move(compiled)));
+      return;
+    }
+  }
+
+  AotCompiledKernelTmpl tmpldata;
+  tmpldata.identifier = identifier;
+  tmpldata.kernels.insert(std::make_pair(key, std::move(compiled)));
+  aot_data_.kernel_tmpls.push_back(std::move(tmpldata));
+}
+
+}  // namespace cpu
+}  // namespace lang
+}  // namespace taichi
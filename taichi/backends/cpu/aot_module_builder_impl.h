@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "taichi/program/aot_module_builder.h"
+#include "taichi/backends/cpu/aot_data.h"
+
+namespace taichi {
+namespace lang {
+
+class LlvmProgramImpl;
+
+namespace cpu {
+
+/**
+ * Builds AOT modules of LLVM CPU kernels.
+ *
+ * dump() writes a shared object holding the optimized machine code of the
+ * LLVM runtime and of every added kernel, together with the metadata needed
+ * to materialize the SNode trees and launch the kernels. These are loaded by
+ * cpu::AotModuleLoaderImpl, which neither needs LLVM nor compiles anything.
+ */
+class AotModuleBuilderImpl : public AotModuleBuilder {
+ public:
+  explicit AotModuleBuilderImpl(
+      LlvmProgramImpl *prog,
+      const std::vector<CompiledSNodeTree> &compiled_snode_trees);
+
+  void dump(const std::string &output_dir,
+            const std::string &filename) const override;
+
+ protected:
+  void add_per_backend(const std::string &identifier, Kernel *kernel) override;
+
+  void add_field_per_backend(const std::string &identifier,
+                             const SNode *rep_snode,
+                             bool is_scalar,
+                             DataType dt,
+                             std::vector<int> shape,
+                             int row_num,
+                             int column_num) override;
+
+  void add_per_backend_tmpl(const std::string &identifier,
+                            const std::string &key,
+                            Kernel *kernel) override;
+
+ private:
+  AotCompiledKernel compile_kernel(const std::string &identifier,
+                                   Kernel *kernel);
+
+  LlvmProgramImpl *prog_;
+  // Object code of the runtime, followed by that of the added kernels.
+  std::vector<std::string> object_codes_;
+  AotData aot_data_;
+};
+
+}  // namespace cpu
+}  // namespace lang
+}  // namespace taichi
@@ -0,0 +1,229 @@
+#include "taichi/backends/cpu/aot_module_loader_impl.h"
+
+#include <cstdio>
+#include <vector>
+
+#include "taichi/backends/cpu/cpu_device.h"
+#include "taichi/math/arithmetic.h"
+
+namespace taichi {
+namespace lang {
+namespace cpu {
+namespace {
+
+void assert_failed_host(const char *msg) {
+  TI_ERROR("Assertion failure: {}", msg);
+}
+
+void *taichi_allocate_aligned(MemoryPool *memory_pool,
+                              std::size_t size,
+                              std::size_t alignment) {
+  return memory_pool->allocate(size, alignment);
+}
+
+// Same conversions as Kernel::LaunchContextBuilder::set_arg_float().
+template <typename T>
+void set_scalar_arg(RuntimeContext &context,
+                    const AotKernelArg &arg,
+                    int i,
+                    T value) {
+  TI_ERROR_IF(arg.is_external_array,
+              "AOT: argument {} is an ndarray, not a scalar", i);
+  const auto &dt = arg.dtype_name;
+  if (dt == "f32" || dt == "f16") {
+    context.set_arg(i, (float32)value);
+  } else if (dt == "f64") {
+    context.set_arg(i, (float64)value);
+  } else if (dt == "i32") {
+    context.set_arg(i, (int32)value);
+  } else if (dt == "i64") {
+    context.set_arg(i, (int64)value);
+  } else if (dt == "i8") {
+    context.set_arg(i, (int8)value);
+  } else if (dt == "i16") {
+    context.set_arg(i, (int16)value);
+  } else if (dt == "u8") {
+    context.set_arg(i, (uint8)value);
+  } else if (dt == "u16") {
+    context.set_arg(i, (uint16)value);
+  } else if (dt == "u32") {
+    context.set_arg(i, (uint32)value);
+  } else if (dt == "u64") {
+    context.set_arg(i, (uint64)value);
+  } else {
+    TI_ERROR("AOT: unsupported type {} of argument {}", dt, i);
+  }
+}
+
+}  // namespace
+
+AotModuleLoaderImpl::AotModuleLoaderImpl(const std::string &output_dir,
+                                         const std::string &filename) {
+  TI_AUTO_PROF
+  const std::string bin_path =
+      fmt::format("{}/{}_metadata.tcb", output_dir, filename);
+  read_from_binary_file(aot_data_, bin_path);
+
+  const std::string library_path =
+      fmt::format("{}/{}", output_dir, aot_data_.library_file);
+  library_ = std::make_unique<DynamicLoader>(library_path);
+  TI_ERROR_IF(!library_->loaded(), "AOT: failed to load {}", library_path);
+
+  device_ = std::make_unique<cpu::CpuDevice>();
+  memory_pool_ = std::make_unique<MemoryPool>(host_arch(), device_.get());
+  thread_pool_ = std::make_unique<ThreadPool>(aot_data_.cpu_max_num_threads);
+  materialize_runtime();
+  for (const auto &tree : aot_data_.snode_trees) {
+    materialize_snode_tree(tree);
+  }
+}
+
+// Mirrors LlvmProgramImpl::materialize_runtime() on CPU.
+void AotModuleLoaderImpl::materialize_runtime() {
+  result_buffer_ = (uint64 *)memory_pool_->allocate(
+      sizeof(uint64) * taichi_result_buffer_entries, 8);
+
+  using RuntimeInitializeFunc =
+      void (*)(void *, void *, std::size_t, void *, int, int, void *, void *,
+               void *);
+  auto runtime_initialize =
+      (RuntimeInitializeFunc)library_->load_function("runtime_initialize");
+  runtime_initialize(result_buffer_, memory_pool_.get(), 0, nullptr,
+                     aot_data_.random_seed * 1048576,
+                     aot_data_.cpu_max_num_threads,
+                     (void *)&taichi_allocate_aligned, (void *)std::printf,
+                     (void *)std::vsnprintf);
+  llvm_runtime_ = (void *)result_buffer_[taichi_result_buffer_ret_value_id];
+
+  call("runtime_get_mem_req_queue");
+  memory_pool_->set_queue(
+      (MemRequestQueue *)result_buffer_[taichi_result_buffer_ret_value_id]);
+
+  call<void *, void *>(
+      "LLVMRuntime_initialize_thread_pool", thread_pool_.get(),
+      (void *)ThreadPool::static_run_with_thread_id_base);
+  call<void *>("LLVMRuntime_set_assert_failed", (void *)assert_failed_host);
+  if (aot_data_.node_allocator_cache) {
+    call<int>("LLVMRuntime_set_num_node_allocator_caches",
+              aot_data_.cpu_max_num_threads);
+  }
+  if (aot_data_.gc_lazy_zero_fill) {
+    call<int>("LLVMRuntime_set_node_allocator_lazy_zero_fill", 1);
+  }
+}
+
+// Mirrors LlvmProgramImpl::initialize_llvm_runtime_snodes() on CPU.
+void AotModuleLoaderImpl::materialize_snode_tree(
+    const CompiledSNodeTree &tree) {
+  std::size_t rounded_size = iroundup(tree.root_size, taichi_page_size);
+  call<std::size_t, std::size_t>("runtime_memory_allocate_aligned",
+                                 rounded_size, taichi_page_size);
+  auto root_buffer =
+      (uint8 *)result_buffer_[taichi_result_buffer_runtime_query_id];
+  snode_tree_roots_[tree.tree_id] = root_buffer;
+
+  call<std::size_t, int, int, int, std::size_t, uint8 *, bool>(
+      "runtime_initialize_snodes", tree.root_size, tree.root_id,
+      tree.num_snodes, tree.tree_id, rounded_size, root_buffer,
+      tree.all_dense);
+  for (const auto &allocator : tree.node_allocators) {
+    call<int, std::size_t>("runtime_NodeAllocator_initialize",
+                           allocator.snode_id, allocator.node_size);
+    call<int, std::size_t>("runtime_allocate_ambient", allocator.snode_id,
+                           allocator.node_size);
+  }
+}
+
+RuntimeContext AotModuleLoaderImpl::make_context() const {
+  RuntimeContext context{};
+  context.runtime = (LLVMRuntime *)llvm_runtime_;
+  return context;
+}
+
+AotModuleLoaderImpl::KernelFunc AotModuleLoaderImpl::make_kernel_func(
+    const AotCompiledKernel &kernel) const {
+  using TaskFunc = void (*)(RuntimeContext *);
+  std::vector<TaskFunc> tasks;
+  for (const auto &name : kernel.offloaded_task_names) {
+    tasks.push_back((TaskFunc)library_->load_function(name));
+  }
+  return [tasks](RuntimeContext &context) {
+    for (auto task : tasks) {
+      task(&context);
+    }
+  };
+}
+
+AotModuleLoaderImpl::KernelFunc AotModuleLoaderImpl::get_kernel(
+    const std::string &identifier) const {
+  return make_kernel_func(get_kernel_data(identifier));
+}
+
+const AotCompiledKernel &AotModuleLoaderImpl::get_kernel_data(
+    const std::string &identifier) const {
+  for (const auto &k : aot_data_.kernels) {
+    if (k.identifier == identifier) {
+      return k;
+    }
+  }
+  TI_ERROR("AOT: kernel {} not found", identifier);
+}
+
+void AotModuleLoaderImpl::set_arg_int(RuntimeContext &context,
+                                      const AotKernelArg &arg,
+                                      int i,
+                                      int64 value) {
+  set_scalar_arg(context, arg, i, value);
+}
+
+void AotModuleLoaderImpl::set_arg_float(RuntimeContext &context,
+                                        const AotKernelArg &arg,
+                                        int i,
+                                        float64 value) {
+  set_scalar_arg(context, arg, i, value);
+}
+
+void AotModuleLoaderImpl::set_arg_ndarray(RuntimeContext &context,
+                                          const AotKernelArg &arg,
+                                          int i,
+                                          void *ptr,
+                                          const std::vector<int> &shape) {
+  TI_ERROR_IF(!arg.is_external_array,
+              "AOT: argument {} is a scalar, not an ndarray", i);
+  TI_ERROR_IF(i >= taichi_max_num_args_extra,
+              "AOT: ndarray argument {} is past the first {} arguments", i,
+              taichi_max_num_args_extra);
+  TI_ERROR_IF(shape.size() > taichi_max_num_indices,
+              "AOT: ndarray argument {} has more than {} dimensions", i,
+              taichi_max_num_indices);
+  context.set_arg(i, (uint64)ptr);
+  for (int j = 0; j < (int)shape.size(); j++) {
+    context.extra_args[i][j] = shape[j];
+  }
+}
+
+AotModuleLoaderImpl::KernelFunc AotModuleLoaderImpl::get_kernel_template(
+    const std::string &identifier,
+    const std::string &key) const {
+  for (const auto &k : aot_data_.kernel_tmpls) {
+    if (k.identifier == identifier) {
+      auto it = k.kernels.find(key);
+      TI_ERROR_IF(it == k.kernels.end(),
+                  "AOT: kernel template {} has no instance {}", identifier,
+                  key);
+      return make_kernel_func(it->second);
+    }
+  }
+  TI_ERROR("AOT: kernel template {} not found", identifier);
+}
+
+void *AotModuleLoaderImpl::get_snode_tree_root(int tree_id) const {
+  auto it = snode_tree_roots_.find(tree_id);
+  TI_ERROR_IF(it == snode_tree_roots_.end(), "AOT: SNode tree {} not found",
+              tree_id);
+  return it->second;
+}
+
+}  // namespace cpu
+}  // namespace lang
+}  // namespace taichi
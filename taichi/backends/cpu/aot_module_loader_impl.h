@@ -0,0 +1,121 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "taichi/backends/cpu/aot_data.h"
+#include "taichi/backends/device.h"
+#include "taichi/system/dynamic_loader.h"
+#include "taichi/system/memory_pool.h"
+#include "taichi/system/threading.h"
+#define TI_RUNTIME_HOST
+#include "taichi/program/context.h"
+#undef TI_RUNTIME_HOST
+
+namespace taichi {
+namespace lang {
+namespace cpu {
+
+/**
+ * Runs the kernels of an AOT module dumped by cpu::AotModuleBuilderImpl.
+ *
+ * The shared object is loaded with the system dynamic loader, and a fresh
+ * LLVMRuntime with the SNode trees of the module is materialized through the
+ * runtime functions it exports. Nothing is compiled and no Program is needed,
+ * but the loader is still only built with TI_WITH_LLVM.
+ */
+class AotModuleLoaderImpl {
+ public:
+  using KernelFunc = std::function<void(RuntimeContext &)>;
+
+  AotModuleLoaderImpl(const std::string &output_dir,
+                      const std::string &filename);
+
+  const AotData &get_aot_data() const {
+    return aot_data_;
+  }
+
+  /**
+   * @return A zero-initialized context bound to the runtime of this module.
+   */
+  RuntimeContext make_context() const;
+
+  KernelFunc get_kernel(const std::string &identifier) const;
+
+  /**
+   * @return The argument and return types of kernel |identifier|.
+   */
+  const AotCompiledKernel &get_kernel_data(const std::string &identifier) const;
+
+  /**
+   * Sets scalar argument |i| of a kernel, converted to the type of |arg|.
+   */
+  static void set_arg_int(RuntimeContext &context,
+                          const AotKernelArg &arg,
+                          int i,
+                          int64 value);
+
+  static void set_arg_float(RuntimeContext &context,
+                            const AotKernelArg &arg,
+                            int i,
+                            float64 value);
+
+  /**
+   * Passes the contiguous array at |ptr| with dimensions |shape| as ndarray
+   * argument |i| of a kernel. The array must outlive the launch.
+   */
+  static void set_arg_ndarray(RuntimeContext &context,
+                              const AotKernelArg &arg,
+                              int i,
+                              void *ptr,
+                              const std::vector<int> &shape);
+
+  KernelFunc get_kernel_template(const std::string &identifier,
+                                 const std::string &key) const;
+
+  /**
+   * @return The i-th return value of the kernel launched last.
+   */
+  template <typename T>
+  T get_ret(int i) const {
+    return taichi_union_cast_with_different_sizes<T>(
+        result_buffer_[taichi_result_buffer_ret_value_id + i]);
+  }
+
+  /**
+   * @return The root buffer of SNode tree |tree_id|, laid out exactly as in
+   * the process that built the module.
+   */
+  void *get_snode_tree_root(int tree_id) const;
+
+ private:
+  template <typename... Args>
+  void call(const std::string &name, Args... args) const {
+    using FuncType = void (*)(void *, Args...);
+    auto func = (FuncType)library_->load_function(name);
+    func(llvm_runtime_, args...);
+  }
+
+  void materialize_runtime();
+
+  void materialize_snode_tree(const CompiledSNodeTree &tree);
+
+  KernelFunc make_kernel_func(const AotCompiledKernel &kernel) const;
+
+  AotData aot_data_;
+  std::unique_ptr<DynamicLoader> library_;
+  std::unique_ptr<Device> device_;
+  std::unique_ptr<MemoryPool> memory_pool_;
+  // Declared after |memory_pool_| so that it is destroyed first.
+  std::unique_ptr<ThreadPool> thread_pool_;
+  uint64 *result_buffer_{nullptr};
+  void *llvm_runtime_{nullptr};
+  std::unordered_map<int, void *> snode_tree_roots_;
+};
+
+}  // namespace cpu
+}  // namespace lang
+}  // namespace taichi
@@ -1,7 +1,9 @@
 #include "taichi/backends/cpu/codegen_cpu.h"
 
+#include "taichi/backends/cpu/range_for_tuner.h"
 #include "taichi/codegen/codegen_llvm.h"
 #include "taichi/llvm/llvm_program.h"
+#include "taichi/llvm/llvm_offline_cache.h"
 #include "taichi/common/core.h"
 #include "taichi/util/io.h"
 #include "taichi/lang_util.h"
@@ -12,12 +14,85 @@
 
 TLANG_NAMESPACE_BEGIN
 
+namespace {
+
+int32 get_range_for_schedule(const CompileConfig &config) {
+  const auto &schedule = config.cpu_range_for_schedule;
+  if (schedule == "static" || schedule == "auto") {
+    // Autotuned loops get their schedule at launch time.
+    return kCpuRangeForStatic;
+  } else if (schedule == "dynamic") {
+    return kCpuRangeForDynamic;
+  } else if (schedule == "guided") {
+    return kCpuRangeForGuided;
+  }
+  TI_ERROR(
+      "Unknown cpu_range_for_schedule \"{}\", expected \"static\", "
+      "\"dynamic\", \"guided\" or \"auto\"",
+      schedule);
+}
+
+}  // namespace
+
 class CodeGenLLVMCPU : public CodeGenLLVM {
  public:
   using IRVisitor::visit;
 
-  CodeGenLLVMCPU(Kernel *kernel, IRNode *ir) : CodeGenLLVM(kernel, ir) {
+  CodeGenLLVMCPU(Kernel *kernel,
+                 IRNode *ir,
+                 const std::string &offline_cache_key = "")
+      : CodeGenLLVM(kernel, ir), offline_cache_key(offline_cache_key) {
+    TI_AUTO_PROF
+  }
+
+  FunctionType compile_module_to_executable() override {
+    if (!offline_cache_key.empty()) {
+      // The JIT session retains the generated object code of modules named
+      // after offline cache keys.
+      module->setModuleIdentifier(offline_cache_key);
+    }
+    auto ret = CodeGenLLVM::compile_module_to_executable();
+
+    std::vector<std::string> task_names;
+    std::vector<int> range_for_num_threads;
+    for (auto &task : offloaded_tasks) {
+      task_names.push_back(task.name);
+      auto it = range_for_num_threads_.find(task.name);
+      range_for_num_threads.push_back(
+          it == range_for_num_threads_.end() ? 0 : it->second);
+    }
+    if (prog->config.cpu_range_for_schedule == "auto") {
+      std::vector<OffloadedTask::task_fp_type> tasks;
+      for (auto &task : offloaded_tasks) {
+        tasks.push_back(task.func);
+      }
+      ret = cpu::make_autotuned_launcher(task_names, tasks,
+                                         range_for_num_threads,
+                                         prog->profiler.get());
+    }
+    if (offline_cache_key.empty()) {
+      return ret;
+    }
+
+    LlvmOfflineCache::KernelCacheData data;
+    data.kernel_key = offline_cache_key;
+    data.offloaded_task_names = task_names;
+    data.range_for_num_threads = range_for_num_threads;
+    data.object_code = tlctx->jit->take_compiled_object(offline_cache_key);
+    if (!data.object_code.empty()) {
+      prog->get_llvm_program_impl()->get_offline_cache()->put_kernel(data);
+    }
+    return ret;
+  }
+
+  std::string compile_module_to_object(
+      std::vector<std::string> &offloaded_task_names) {
     TI_AUTO_PROF
+    eliminate_unused_functions();
+    for (auto &task : offloaded_tasks) {
+      offloaded_task_names.push_back(task.name);
+    }
+    return tlctx->jit->compile_to_object(std::move(module));
   }
 
   void create_offload_range_for(OffloadedStmt *stmt) override {
@@ -32,21 +107,8 @@ class CodeGenLLVMCPU : public CodeGenLLVM {
 
     auto *tls_prologue = create_xlogue(stmt->tls_prologue);
 
-    // The loop body
-    llvm::Function *body;
-    {
-      auto guard = get_function_creation_guard(
-          {llvm::PointerType::get(get_runtime_type("RuntimeContext"), 0),
-           llvm::Type::getInt8PtrTy(*llvm_context),
-           tlctx->get_data_type<int>()});
-
-      auto loop_var = create_entry_block_alloca(PrimitiveType::i32);
-      loop_vars_llvm[stmt].push_back(loop_var);
-      builder->CreateStore(get_arg(2), loop_var);
-      stmt->body->accept(this);
-
-      body = guard.body;
-    }
+    const int simd_width = get_simd_width(stmt);
+    auto body = create_range_for_block_body(stmt, simd_width);
 
     llvm::Value *epilogue = create_xlogue(stmt->tls_epilogue);
 
@@ -55,7 +117,95 @@ class CodeGenLLVMCPU : public CodeGenLLVM {
         "cpu_parallel_range_for",
         {get_arg(0), tlctx->get_constant(stmt->num_cpu_threads), begin, end,
          tlctx->get_constant(step), tlctx->get_constant(stmt->block_dim),
-         tls_prologue, body, epilogue, tlctx->get_constant(stmt->tls_size)});
+         tlctx->get_constant(get_range_for_schedule(prog->config)),
+         tls_prologue, body, tlctx->get_constant(simd_width), epilogue,
+         tlctx->get_constant(stmt->tls_size)});
+    range_for_num_threads_[current_task->name] = stmt->num_cpu_threads;
+  }
+
+  // 1 unless the iterations of |stmt| are to be vectorized.
+  int get_simd_width(OffloadedStmt *stmt) {
+    const auto &config = prog->config;
+    if (!config.cpu_simd_range_for || stmt->reversed) {
+      return 1;
+    }
+    return std::max(config.simd_width, 1);
+  }
+
+  // Creates the function that the runtime calls on each block of iterations
+  // [begin, end) of |stmt|. The loop is part of the function rather than of
+  // the runtime, so that LLVM can optimize and vectorize it together with the
+  // body instead of seeing one indirect call per iteration. With a
+  // |simd_width| above 1, LLVM is asked to vectorize the loop by that width;
+  // accesses to dense SNodes then become contiguous vector loads and stores,
+  // and the others gathers and scatters.
+  llvm::Function *create_range_for_block_body(OffloadedStmt *stmt,
+                                              int simd_width) {
+    using namespace llvm;
+    auto guard = get_function_creation_guard(
+        {llvm::PointerType::get(get_runtime_type("RuntimeContext"), 0),
+         llvm::Type::getInt8PtrTy(*llvm_context), tlctx->get_data_type<int>(),
+         tlctx->get_data_type<int>()});
+    auto begin = get_arg(2);
+    auto end = get_arg(3);
+
+    auto loop_var = create_entry_block_alloca(PrimitiveType::i32);
+    loop_vars_llvm[stmt].push_back(loop_var);
+    if (!stmt->reversed) {
+      builder->CreateStore(begin, loop_var);
+    } else {
+      builder->CreateStore(builder->CreateSub(end, tlctx->get_constant(1)),
+                           loop_var);
+    }
+
+    auto loop_test = BasicBlock::Create(*llvm_context, "block_loop_test", func);
+    auto loop_body = BasicBlock::Create(*llvm_context, "block_loop_body", func);
+    auto loop_inc = BasicBlock::Create(*llvm_context, "block_loop_inc", func);
+    auto after_loop =
+        BasicBlock::Create(*llvm_context, "block_after_loop", func);
+    builder->CreateBr(loop_test);
+
+    builder->SetInsertPoint(loop_test);
+    llvm::Value *cond;
+    if (!stmt->reversed) {
+      cond = builder->CreateICmpSLT(builder->CreateLoad(loop_var), end);
+    } else {
+      cond = builder->CreateICmpSGE(builder->CreateLoad(loop_var), begin);
+    }
+    builder->CreateCondBr(cond, loop_body, after_loop);
+
+    builder->SetInsertPoint(loop_body);
+    offloaded_loop_reentry = loop_inc;
+    stmt->body->accept(this);
+    offloaded_loop_reentry = nullptr;
+    builder->CreateBr(loop_inc);
+
+    builder->SetInsertPoint(loop_inc);
+    create_increment(loop_var, tlctx->get_constant(stmt->reversed ? -1 : 1));
+    auto latch = builder->CreateBr(loop_test);
+    if (simd_width > 1) {
+      latch->setMetadata(LLVMContext::MD_loop,
+                         create_vectorize_loop_metadata(simd_width));
+    }
+
+    builder->SetInsertPoint(after_loop);
+    return guard.body;
+  }
+
+  llvm::MDNode *create_vectorize_loop_metadata(int width) {
+    using namespace llvm;
+    auto hint = [&](const char *name, Constant *value) {
+      return MDNode::get(*llvm_context, {MDString::get(*llvm_context, name),
+                                         ConstantAsMetadata::get(value)});
+    };
+    // The first operand of a loop ID refers to the node itself.
+    auto temp = MDNode::getTemporary(*llvm_context, None);
+    auto loop_id = MDNode::getDistinct(
+        *llvm_context,
+        {temp.get(), hint("llvm.loop.vectorize.enable", builder->getTrue()),
+         hint("llvm.loop.vectorize.width", builder->getInt32(width))});
+    loop_id->replaceOperandWith(0, loop_id);
+    return loop_id;
   }
 
   void create_offload_mesh_for(OffloadedStmt *stmt) override {
@@ -159,8 +309,11 @@ class CodeGenLLVMCPU : public CodeGenLLVM {
     } else if (stmt->task_type == Type::mesh_for) {
       create_offload_mesh_for(stmt);
     } else if (stmt->task_type == Type::struct_for) {
-      stmt->block_dim = std::min(stmt->snode->parent->max_num_elements(),
-                                 (int64)stmt->block_dim);
+      // With BLS, make_block_local has already sized the blocks.
+      if (stmt->bls_size == 0) {
+        stmt->block_dim = std::min(stmt->snode->parent->max_num_elements(),
+                                   (int64)stmt->block_dim);
+      }
       create_offload_struct_for(stmt);
     } else if (stmt->task_type == Type::listgen) {
       emit_list_gen(stmt);
@@ -187,11 +340,67 @@ class CodeGenLLVMCPU : public CodeGenLLVM {
       TI_NOT_IMPLEMENTED
     }
   }
+
+ private:
+  std::string offline_cache_key;
+  // The number of threads of each range-for task, by task name.
+  std::unordered_map<std::string, int> range_for_num_threads_;
 };
 
+namespace {
+
+FunctionType load_cached_kernel(
+    TaichiLLVMContext *tlctx,
+    const LlvmOfflineCache::KernelCacheData &data,
+    Program *prog) {
+  TI_AUTO_PROF
+  auto *jit_module = tlctx->jit->add_object(data.object_code);
+  std::vector<OffloadedTask::task_fp_type> tasks;
+  for (auto &name : data.offloaded_task_names) {
+    // Look up inside the loaded module only: symbols with the same name may
+    // exist in kernels compiled by this process.
+    auto *func = jit_module->lookup_function(name);
+    TI_ASSERT_INFO(func, "Function {} not found", name);
+    tasks.push_back((OffloadedTask::task_fp_type)func);
+  }
+  if (prog->config.cpu_range_for_schedule == "auto") {
+    return cpu::make_autotuned_launcher(data.offloaded_task_names, tasks,
+                                        data.range_for_num_threads,
+                                        prog->profiler.get());
+  }
+  return [tasks](RuntimeContext &context) {
+    for (auto task : tasks) {
+      task(&context);
+    }
+  };
+}
+
+}  // namespace
+
 FunctionType CodeGenCPU::codegen() {
   TI_AUTO_PROF
-  return CodeGenLLVMCPU(kernel, ir).gen();
+  auto *llvm_prog = prog->get_llvm_program_impl();
+  auto *offline_cache = llvm_prog->get_offline_cache();
+  std::string cache_key;
+  // Only whole kernels are cached. Offloaded tasks compiled individually by
+  // the async engine are not.
+  if (offline_cache && ir == kernel->ir.get()) {
+    cache_key = LlvmOfflineCache::make_kernel_key(kernel, prog->config);
+    LlvmOfflineCache::KernelCacheData data;
+    if (!cache_key.empty() && offline_cache->get_kernel(cache_key, data)) {
+      return load_cached_kernel(llvm_prog->get_llvm_context(kernel->arch),
+                                data, prog);
+    }
+  }
+  return CodeGenLLVMCPU(kernel, ir, cache_key).gen();
+}
+
+std::string CodeGenCPU::codegen_object(
+    std::vector<std::string> &offloaded_task_names) {
+  TI_AUTO_PROF
+  CodeGenLLVMCPU gen(kernel, ir);
+  gen.emit_to_module();
+  return gen.compile_module_to_object(offloaded_task_names);
 }
 
 TLANG_NAMESPACE_END
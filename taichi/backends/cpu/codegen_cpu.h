@@ -12,6 +12,11 @@ class CodeGenCPU : public KernelCodeGen {
   }
 
   virtual FunctionType codegen() override;
+
+  // Compiles the kernel to relocatable object code without loading it (AOT).
+  // The offloaded tasks, which are the only symbols the object exports, are
+  // appended to |offloaded_task_names| in launch order.
+  std::string codegen_object(std::vector<std::string> &offloaded_task_names);
 };
 
 TLANG_NAMESPACE_END
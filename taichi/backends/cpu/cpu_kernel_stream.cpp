@@ -0,0 +1,96 @@
+#include "taichi/backends/cpu/cpu_kernel_stream.h"
+
+#include "taichi/system/timeline.h"
+
+namespace taichi {
+namespace lang {
+namespace cpu {
+
+CpuKernelStream::CpuKernelStream(const std::string &name) : name_(name) {
+  thread_ = std::thread([this] { this->worker_loop(); });
+}
+
+CpuKernelStream::~CpuKernelStream() {
+  {
+    std::lock_guard<std::mutex> _(mut_);
+    exiting_ = true;
+  }
+  worker_cv_.notify_one();
+  thread_.join();
+  if (error_) {
+    TI_WARN("Discarding an unreported error on stream {}", name_);
+  }
+}
+
+uint64 CpuKernelStream::enqueue(Task task) {
+  uint64 event;
+  {
+    std::lock_guard<std::mutex> _(mut_);
+    queue_.push_back(std::move(task));
+    event = ++num_enqueued_;
+  }
+  worker_cv_.notify_one();
+  return event;
+}
+
+uint64 CpuKernelStream::record_event() {
+  std::lock_guard<std::mutex> _(mut_);
+  return num_enqueued_;
+}
+
+bool CpuKernelStream::query(uint64 event) {
+  std::lock_guard<std::mutex> _(mut_);
+  return num_completed_ >= event;
+}
+
+void CpuKernelStream::wait(uint64 event) {
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(mut_);
+    TI_ASSERT(event <= num_enqueued_);
+    completed_cv_.wait(lock, [&] { return num_completed_ >= event; });
+    std::swap(error, error_);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void CpuKernelStream::worker_loop() {
+  Timeline::get_this_thread_instance().set_name(name_);
+  while (true) {
+    Task task;
+    bool skip;
+    {
+      std::unique_lock<std::mutex> lock(mut_);
+      worker_cv_.wait(lock, [this] { return !queue_.empty() || exiting_; });
+      if (queue_.empty()) {
+        // |exiting_| is set and everything has been executed.
+        break;
+      }
+      task = std::move(queue_.front());
+      queue_.pop_front();
+      skip = error_ != nullptr;
+    }
+    std::exception_ptr error;
+    if (!skip) {
+      try {
+        task();
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+    {
+      std::lock_guard<std::mutex> _(mut_);
+      if (error && !error_) {
+        error_ = error;
+      }
+      num_completed_++;
+    }
+    completed_cv_.notify_all();
+  }
+}
+
+}  // namespace cpu
+}  // namespace lang
+}  // namespace taichi
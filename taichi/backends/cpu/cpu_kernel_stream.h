@@ -0,0 +1,86 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "taichi/common/core.h"
+
+namespace taichi {
+namespace lang {
+namespace cpu {
+
+/**
+ * An ordered queue of work executed by a dedicated host thread, analogous to a
+ * CUDA stream.
+ *
+ * Tasks run one at a time in the order they are enqueued. Every task is
+ * assigned an event id, which increases monotonically; an event completes once
+ * its task and all the tasks before it have finished. If a task throws, the
+ * remaining tasks are skipped until the error is reported by wait() or
+ * synchronize().
+ */
+class CpuKernelStream {
+ public:
+  using Task = std::function<void()>;
+
+  explicit CpuKernelStream(const std::string &name);
+
+  ~CpuKernelStream();
+
+  /**
+   * Enqueues |task| without waiting for it to run.
+   *
+   * @return The event that completes once |task| has finished.
+   */
+  uint64 enqueue(Task task);
+
+  /**
+   * @return The event of the most recently enqueued task, or 0 if nothing has
+   * been enqueued yet.
+   */
+  uint64 record_event();
+
+  /**
+   * @return Whether |event| has completed. Does not report errors.
+   */
+  bool query(uint64 event);
+
+  /**
+   * Blocks until |event| has completed, and rethrows the first exception
+   * thrown by a task since the last wait(), if any.
+   */
+  void wait(uint64 event);
+
+  void synchronize() {
+    wait(record_event());
+  }
+
+ private:
+  void worker_loop();
+
+  std::string name_;
+
+  std::mutex mut_;
+  // All guarded by |mut_|
+  std::deque<Task> queue_;
+  uint64 num_enqueued_{0};
+  uint64 num_completed_{0};
+  std::exception_ptr error_{nullptr};
+  bool exiting_{false};
+
+  // Signals the worker that a task has been enqueued or that it should exit.
+  std::condition_variable worker_cv_;
+  // Signals waiters that a task has completed.
+  std::condition_variable completed_cv_;
+
+  std::thread thread_;
+};
+
+}  // namespace cpu
+}  // namespace lang
+}  // namespace taichi
@@ -3,9 +3,11 @@
 #include <memory>
 
 #include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/ExecutionEngine/Orc/Core.h"
 #include "llvm/ExecutionEngine/Orc/CompileOnDemandLayer.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
@@ -26,6 +28,7 @@
 #include "llvm/Support/DynamicLibrary.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
@@ -38,6 +41,7 @@
 #include "taichi/jit/jit_session.h"
 #include "taichi/util/file_sequence_writer.h"
 #include "taichi/llvm/llvm_program.h"
+#include "taichi/llvm/llvm_offline_cache.h"
 
 TLANG_NAMESPACE_BEGIN
 
@@ -67,6 +71,43 @@ std::pair<JITTargetMachineBuilder, llvm::DataLayout> get_host_target_info() {
 
 class JITSessionCPU;
 
+// Retains the object code of kernel modules that should be written to the
+// offline cache. Note that objects are never provided through getObject():
+// cached kernels are loaded via JITSessionCPU::add_object() without going
+// through LLVM IR at all.
+class OfflineCacheObjectListener : public llvm::ObjectCache {
+ public:
+  void notifyObjectCompiled(const llvm::Module *M,
+                            llvm::MemoryBufferRef obj) override {
+    const auto &id = M->getModuleIdentifier();
+    if (!starts_with(id, LlvmOfflineCache::kModuleIdPrefix)) {
+      return;
+    }
+    std::lock_guard<std::mutex> _(mut_);
+    objects_[id] = obj.getBuffer().str();
+  }
+
+  std::unique_ptr<llvm::MemoryBuffer> getObject(
+      const llvm::Module *M) override {
+    return nullptr;
+  }
+
+  std::string take(const std::string &module_id) {
+    std::lock_guard<std::mutex> _(mut_);
+    auto it = objects_.find(module_id);
+    if (it == objects_.end()) {
+      return "";
+    }
+    auto ret = std::move(it->second);
+    objects_.erase(it);
+    return ret;
+  }
+
+ private:
+  std::mutex mut_;
+  std::unordered_map<std::string, std::string> objects_;
+};
+
 class JITModuleCPU : public JITModule {
  private:
   JITSessionCPU *session;
@@ -87,6 +128,7 @@ class JITModuleCPU : public JITModule {
 class JITSessionCPU : public JITSession {
  private:
   ExecutionSession ES;
+  OfflineCacheObjectListener object_listener;
   RTDyldObjectLinkingLayer object_layer;
   IRCompileLayer compile_layer;
   DataLayout DL;
@@ -106,7 +148,8 @@ class JITSessionCPU : public JITSession {
                      }),
         compile_layer(ES,
                       object_layer,
-                      std::make_unique<ConcurrentIRCompiler>(JTMB)),
+                      std::make_unique<ConcurrentIRCompiler>(JTMB,
+                                                             &object_listener)),
         DL(DL),
         Mangle(ES, this->DL),
         module_counter(0),
@@ -136,22 +179,44 @@ class JITSessionCPU : public JITSession {
     TI_ASSERT(M);
     global_optimize_module_cpu(M.get());
     std::lock_guard<std::mutex> _(mut);
-    auto &dylib = ES.createJITDylib(fmt::format("{}", module_counter));
-    dylib.addGenerator(
-        cantFail(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
-            DL.getGlobalPrefix())));
+    auto &dylib = create_dylib();
     auto *thread_safe_context = get_current_program()
                                     .get_llvm_program_impl()
                                     ->get_llvm_context(host_arch())
                                     ->get_this_thread_thread_safe_context();
     cantFail(compile_layer.add(dylib, llvm::orc::ThreadSafeModule(
                                           std::move(M), *thread_safe_context)));
-    all_libs.push_back(&dylib);
-    auto new_module = std::make_unique<JITModuleCPU>(this, &dylib);
-    auto new_module_raw_ptr = new_module.get();
-    modules.push_back(std::move(new_module));
-    module_counter++;
-    return new_module_raw_ptr;
+    return register_dylib(dylib);
+  }
+
+  JITModule *add_object(const std::string &object_code) override {
+    std::lock_guard<std::mutex> _(mut);
+    auto &dylib = create_dylib();
+    cantFail(object_layer.add(
+        dylib, llvm::MemoryBuffer::getMemBufferCopy(object_code)));
+    return register_dylib(dylib);
+  }
+
+  std::string take_compiled_object(const std::string &module_id) override {
+    return object_listener.take(module_id);
+  }
+
+  std::string compile_to_object(std::unique_ptr<llvm::Module> M) override {
+    TI_AUTO_PROF
+    TI_ASSERT(M);
+    global_optimize_module_cpu(M.get());
+    auto target_machine = create_target_machine();
+    llvm::SmallString<0> object_code;
+    llvm::raw_svector_ostream ostream(object_code);
+    legacy::PassManager pass_manager;
+    bool fail = target_machine->addPassesToEmitFile(
+        pass_manager, ostream, nullptr, llvm::CGFT_ObjectFile, true);
+    TI_ERROR_IF(fail, "Failed to set up passes to emit object code");
+    {
+      TI_PROFILER("llvm_emit_object");
+      pass_manager.run(*M);
+    }
+    return std::string(object_code.begin(), object_code.end());
   }
 
   void *lookup(const std::string Name) override {
@@ -179,6 +244,25 @@ class JITSessionCPU : public JITSession {
   }
 
  private:
+  JITDylib &create_dylib() {
+    auto &dylib = ES.createJITDylib(fmt::format("{}", module_counter));
+    dylib.addGenerator(
+        cantFail(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            DL.getGlobalPrefix())));
+    return dylib;
+  }
+
+  JITModule *register_dylib(JITDylib &dylib) {
+    all_libs.push_back(&dylib);
+    auto new_module = std::make_unique<JITModuleCPU>(this, &dylib);
+    auto new_module_raw_ptr = new_module.get();
+    modules.push_back(std::move(new_module));
+    module_counter++;
+    return new_module_raw_ptr;
+  }
+
+  static std::unique_ptr<TargetMachine> create_target_machine();
+
   static void global_optimize_module_cpu(llvm::Module *module);
 };
 
@@ -186,13 +270,7 @@ void *JITModuleCPU::lookup_function(const std::string &name) {
   return session->lookup_in_module(dylib, name);
 }
 
-void JITSessionCPU::global_optimize_module_cpu(llvm::Module *module) {
-  TI_AUTO_PROF
-  if (llvm::verifyModule(*module, &llvm::errs())) {
-    module->print(llvm::errs(), nullptr);
-    TI_ERROR("Module broken");
-  }
-
+std::unique_ptr<TargetMachine> JITSessionCPU::create_target_machine() {
   auto triple = get_host_target_info().first.getTargetTriple();
 
   std::string err_str;
@@ -219,15 +297,26 @@ void JITSessionCPU::global_optimize_module_cpu(llvm::Module *module) {
   options.GuaranteedTailCallOpt = false;
   options.StackAlignmentOverride = 0;
 
-  legacy::FunctionPassManager function_pass_manager(module);
-  legacy::PassManager module_pass_manager;
-
   llvm::StringRef mcpu = llvm::sys::getHostCPUName();
   std::unique_ptr<TargetMachine> target_machine(target->createTargetMachine(
       triple.str(), mcpu.str(), "", options, llvm::Reloc::PIC_,
       llvm::CodeModel::Small, CodeGenOpt::Aggressive));
 
   TI_ERROR_UNLESS(target_machine.get(), "Could not allocate target machine!");
+  return target_machine;
+}
+
+void JITSessionCPU::global_optimize_module_cpu(llvm::Module *module) {
+  TI_AUTO_PROF
+  if (llvm::verifyModule(*module, &llvm::errs())) {
+    module->print(llvm::errs(), nullptr);
+    TI_ERROR("Module broken");
+  }
+
+  legacy::FunctionPassManager function_pass_manager(module);
+  legacy::PassManager module_pass_manager;
+
+  auto target_machine = create_target_machine();
 
   module->setDataLayout(target_machine->createDataLayout());
 
@@ -0,0 +1,131 @@
+#include "taichi/backends/cpu/range_for_tuner.h"
+
+#include <limits>
+
+#include "taichi/program/kernel_profiler.h"
+#include "taichi/system/timer.h"
+
+namespace taichi {
+namespace lang {
+namespace cpu {
+namespace {
+
+constexpr int kLaunchesPerCandidate = 2;
+
+const char *schedule_name(int32 schedule) {
+  switch (schedule) {
+    case kCpuRangeForDynamic:
+      return "dynamic";
+    case kCpuRangeForGuided:
+      return "guided";
+    default:
+      return "static";
+  }
+}
+
+void apply(const RangeForTuner::Candidate &c, RuntimeContext *context) {
+  context->cpu_range_for_block_dim = c.block_dim;
+  context->cpu_range_for_num_threads = c.num_threads;
+  context->cpu_range_for_schedule = c.schedule;
+}
+
+}  // namespace
+
+RangeForTuner::RangeForTuner(const std::string &task_name,
+                             int num_threads,
+                             KernelProfilerBase *profiler)
+    : task_name_(task_name), profiler_(profiler) {
+  // The default comes first, so that it is also what the warm-up launch
+  // uses.
+  for (int block_dim : {0, 8, 32, 128, 512, 2048}) {
+    candidates_.push_back({block_dim, num_threads, kCpuRangeForStatic});
+  }
+  // Skewed per-iteration costs favor smaller blocks handed out on demand.
+  for (int block_dim : {16, 256}) {
+    candidates_.push_back({block_dim, num_threads, kCpuRangeForDynamic});
+  }
+  candidates_.push_back({4, num_threads, kCpuRangeForGuided});
+  // Memory-bound loops may not scale to all threads.
+  for (int t = num_threads / 2; t >= 1 && t >= num_threads / 4; t /= 2) {
+    candidates_.push_back({0, t, kCpuRangeForStatic});
+  }
+  times_.resize(candidates_.size(), std::numeric_limits<double>::infinity());
+}
+
+void RangeForTuner::launch(int32 (*task)(void *), RuntimeContext *context) {
+  int candidate = -1;
+  if (!tuned()) {
+    std::lock_guard<std::mutex> _(mut_);
+    // The first launch warms up caches and is not timed.
+    int trial = num_launches_++ - 1;
+    if (trial >= 0 && trial < (int)candidates_.size() * kLaunchesPerCandidate) {
+      candidate = trial / kLaunchesPerCandidate;
+    }
+  }
+  const auto &c = candidate >= 0 ? candidates_[candidate]
+                                 : (tuned() ? best_ : candidates_[0]);
+  apply(c, context);
+  if (profiler_) {
+    profiler_->set_launch_dims(c.num_threads, c.block_dim);
+  }
+  auto t = Time::get_time();
+  task(context);
+  t = Time::get_time() - t;
+  apply(Candidate{0, 0, 0}, context);
+  if (profiler_) {
+    profiler_->set_launch_dims(0, 0);
+  }
+  if (candidate >= 0) {
+    record(candidate, t);
+  }
+}
+
+void RangeForTuner::record(int candidate, double seconds) {
+  std::lock_guard<std::mutex> _(mut_);
+  times_[candidate] = std::min(times_[candidate], seconds);
+  if (++num_recorded_ < (int)candidates_.size() * kLaunchesPerCandidate) {
+    return;
+  }
+  int best = 0;
+  for (int i = 1; i < (int)candidates_.size(); i++) {
+    if (times_[i] < times_[best]) {
+      best = i;
+    }
+  }
+  best_ = candidates_[best];
+  tuned_.store(true, std::memory_order_release);
+  TI_DEBUG("[cpu] {}: block_dim={} num_threads={} schedule={} ({:.3f} ms)",
+           task_name_, best_.block_dim, best_.num_threads,
+           schedule_name(best_.schedule), times_[best] * 1000);
+}
+
+FunctionType make_autotuned_launcher(
+    const std::vector<std::string> &task_names,
+    const std::vector<int32 (*)(void *)> &tasks,
+    const std::vector<int> &range_for_num_threads,
+    KernelProfilerBase *profiler) {
+  TI_ASSERT(tasks.size() == task_names.size());
+  TI_ASSERT(tasks.size() == range_for_num_threads.size());
+  // Shared by the copies of the launcher.
+  std::vector<std::shared_ptr<RangeForTuner>> tuners;
+  for (int i = 0; i < (int)tasks.size(); i++) {
+    tuners.push_back(range_for_num_threads[i] > 0
+                         ? std::make_shared<RangeForTuner>(
+                               task_names[i], range_for_num_threads[i],
+                               profiler)
+                         : nullptr);
+  }
+  return [tasks, tuners](RuntimeContext &context) {
+    for (int i = 0; i < (int)tasks.size(); i++) {
+      if (tuners[i]) {
+        tuners[i]->launch(tasks[i], &context);
+      } else {
+        tasks[i](&context);
+      }
+    }
+  };
+}
+
+}  // namespace cpu
+}  // namespace lang
+}  // namespace taichi
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "taichi/common/core.h"
+#include "taichi/lang_util.h"
+#define TI_RUNTIME_HOST
+#include "taichi/program/context.h"
+#undef TI_RUNTIME_HOST
+
+namespace taichi {
+namespace lang {
+
+class KernelProfilerBase;
+
+namespace cpu {
+
+/**
+ * Autotunes the scheduling of the range-for loop of an offloaded CPU task.
+ *
+ * The first launches of the task try a list of candidate block sizes, thread
+ * counts and schedules, two launches each, and the fastest candidate is kept
+ * for all later launches. The choice is passed to cpu_parallel_range_for
+ * through the cpu_range_for_* fields of RuntimeContext.
+ */
+class RangeForTuner {
+ public:
+  struct Candidate {
+    // 0 chooses the block size from the number of iterations.
+    int block_dim{0};
+    int num_threads{0};
+    int32 schedule{kCpuRangeForStatic};
+  };
+
+  RangeForTuner(const std::string &task_name,
+                int num_threads,
+                KernelProfilerBase *profiler);
+
+  // Runs |task| on |context| with the candidate being tried, or the chosen
+  // one once tuning is over. Safe to call concurrently.
+  void launch(int32 (*task)(void *), RuntimeContext *context);
+
+  bool tuned() const {
+    return tuned_.load(std::memory_order_acquire);
+  }
+
+  const std::vector<Candidate> &candidates() const {
+    return candidates_;
+  }
+
+  // Only meaningful once tuned() returns true.
+  const Candidate &best() const {
+    return best_;
+  }
+
+ private:
+  void record(int candidate, double seconds);
+
+  std::string task_name_;
+  KernelProfilerBase *profiler_{nullptr};
+  std::vector<Candidate> candidates_;
+  // The shortest time measured for each candidate.
+  std::vector<double> times_;
+  int num_launches_{0};
+  int num_recorded_{0};
+  Candidate best_;
+  std::atomic<bool> tuned_{false};
+  std::mutex mut_;
+};
+
+/**
+ * Makes a function launching the offloaded tasks of a CPU kernel in order.
+ * The tasks with a nonzero entry in |range_for_num_threads|, which are the
+ * range-for loops, are autotuned by a RangeForTuner each.
+ */
+FunctionType make_autotuned_launcher(
+    const std::vector<std::string> &task_names,
+    const std::vector<int32 (*)(void *)> &tasks,
+    const std::vector<int> &range_for_num_threads,
+    KernelProfilerBase *profiler);
+
+}  // namespace cpu
+}  // namespace lang
+}  // namespace taichi
@@ -147,7 +147,6 @@ class KernelCodegenImpl : public IRVisitor {
         offloaded_(offloaded),
         ctx_attribs_(*kernel_) {
     ti_kernel_attribs_.name = taichi_kernel_name;
-    ti_kernel_attribs_.is_jit_evaluator = kernel->is_evaluator;
     for (const auto s : kAllSections) {
       section_appenders_[s] = LineAppender();
     }
@@ -90,7 +90,6 @@ using InputBuffersMap =
 class CompiledMtlKernelBase {
  public:
   struct Params {
-    bool is_jit_evaluator;
     const CompileConfig *config;
     const KernelAttributes *kernel_attribs;
     MTLDevice *device;
@@ -100,7 +99,6 @@ class CompiledMtlKernelBase {
   explicit CompiledMtlKernelBase(Params &params)
       : kernel_attribs_(*params.kernel_attribs),
         config_(params.config),
-        is_jit_evalutor_(params.is_jit_evaluator),
         pipeline_state_(
             new_compute_pipeline_state_with_function(params.device,
                                                      params.mtl_func)) {
@@ -140,23 +138,21 @@ class CompiledMtlKernelBase {
 
     const auto tgs = get_thread_grid_settings(
         num_threads, kernel_attribs_.advisory_num_threads_per_group);
-    if (!is_jit_evalutor_) {
-      const auto tt = kernel_attribs_.task_type;
-      std::vector<ActionArg> record_args = {
-          ActionArg("mtl_kernel_name", kernel_attribs_.name),
-          ActionArg("advisory_num_threads", num_threads),
-          ActionArg("num_threadgroups", tgs.num_threadgroups),
-          ActionArg("num_threads_per_group", tgs.num_threads_per_group),
-          ActionArg("task_type", offloaded_task_type_name(tt)),
-      };
-      const auto &buffers = kernel_attribs_.buffers;
-      for (int i = 0; i < buffers.size(); ++i) {
-        record_args.push_back(ActionArg(fmt::format("mtl_buffer_{}", i),
-                                        buffers[i].debug_string()));
-      }
-      ActionRecorder::get_instance().record("launch_kernel",
-                                            std::move(record_args));
+    const auto tt = kernel_attribs_.task_type;
+    std::vector<ActionArg> record_args = {
+        ActionArg("mtl_kernel_name", kernel_attribs_.name),
+        ActionArg("advisory_num_threads", num_threads),
+        ActionArg("num_threadgroups", tgs.num_threadgroups),
+        ActionArg("num_threads_per_group", tgs.num_threads_per_group),
+        ActionArg("task_type", offloaded_task_type_name(tt)),
+    };
+    const auto &buffers = kernel_attribs_.buffers;
+    for (int i = 0; i < buffers.size(); ++i) {
+      record_args.push_back(ActionArg(fmt::format("mtl_buffer_{}", i),
+                                      buffers[i].debug_string()));
     }
+    ActionRecorder::get_instance().record("launch_kernel",
+                                          std::move(record_args));
     TI_TRACE(
         "Dispatching Metal kernel {}, num_threadgroups={} "
         "num_threads_per_group={}",
@@ -202,7 +198,6 @@ class CompiledMtlKernelBase {
 
   KernelAttributes kernel_attribs_;
   const CompileConfig *const config_;
-  const bool is_jit_evalutor_;
   nsobj_unique_ptr<MTLComputePipelineState> pipeline_state_;
 };
 
@@ -332,8 +327,7 @@ class CompiledTaichiKernel {
       TI_ERROR("Failed to compile Metal kernel! Generated code:\n\n{}",
                params.mtl_source_code);
     }
-    if (!ti_kernel_attribs.is_jit_evaluator &&
-        ActionRecorder::get_instance().is_recording()) {
+    if (ActionRecorder::get_instance().is_recording()) {
       static FileSequenceWriter writer("shader{:04d}.mtl", "Metal shader");
       auto fn = writer.write(params.mtl_source_code);
       ActionRecorder::get_instance().record(
@@ -350,7 +344,6 @@ class CompiledTaichiKernel {
       if (ktype == KernelTaskType::listgen) {
         ListgenOpMtlKernel::Params kparams;
         kparams.kernel_attribs = &ka;
-        kparams.is_jit_evaluator = false;
         kparams.config = params.compile_config;
         kparams.device = device;
         kparams.mtl_func = mtl_func.get();
@@ -359,7 +352,6 @@ class CompiledTaichiKernel {
       } else if (ktype == KernelTaskType::gc) {
         GcOpMtlKernel::Params kparams;
         kparams.kernel_attribs = &ka;
-        kparams.is_jit_evaluator = false;
         kparams.config = params.compile_config;
         kparams.device = device;
         kparams.mtl_func = mtl_func.get();
@@ -368,7 +360,6 @@ class CompiledTaichiKernel {
       } else {
         UserMtlKernel::Params kparams;
         kparams.kernel_attribs = &ka;
-        kparams.is_jit_evaluator = ti_kernel_attribs.is_jit_evaluator;
         kparams.config = params.compile_config;
         kparams.device = device;
         kparams.mtl_func = mtl_func.get();
@@ -383,12 +374,10 @@ class CompiledTaichiKernel {
     if (!ctx_attribs.empty()) {
       ctx_mem = std::make_unique<BufferMemoryView>(ctx_attribs.total_bytes(),
                                                    params.mem_pool);
-      if (!ti_kernel_attribs.is_jit_evaluator) {
-        ActionRecorder::get_instance().record(
-            "allocate_context_buffer",
-            {ActionArg("ti_kernel_name", std::string(ti_kernel_attribs.name)),
-             ActionArg("size_in_bytes", (int64)ctx_attribs.total_bytes())});
-      }
+      ActionRecorder::get_instance().record(
+          "allocate_context_buffer",
+          {ActionArg("ti_kernel_name", std::string(ti_kernel_attribs.name)),
+           ActionArg("size_in_bytes", (int64)ctx_attribs.total_bytes())});
       ctx_buffer =
           new_mtl_buffer_no_copy(device, ctx_mem->ptr(), ctx_mem->size());
     }
@@ -409,8 +398,7 @@ class HostMetalCtxBlitter {
                       RuntimeContext *host_ctx,
                       uint64_t *host_result_buffer,
                       const std::string &kernel_name)
-      : ti_kernel_attribs_(&kernel.ti_kernel_attribs),
-        ctx_attribs_(&kernel.ctx_attribs),
+      : ctx_attribs_(&kernel.ctx_attribs),
         host_ctx_(host_ctx),
         host_result_buffer_(host_result_buffer),
         kernel_ctx_mem_(kernel.ctx_mem.get()),
@@ -435,12 +423,10 @@ class HostMetalCtxBlitter {
       const auto &arg = ctx_attribs_->args()[i];
       const auto dt = arg.dt;
       char *device_ptr = base + arg.offset_in_mem;
-      if (!ti_kernel_attribs_->is_jit_evaluator) {
-        ActionRecorder::get_instance().record(
-            "context_host_to_metal",
-            {ActionArg("ti_kernel_name", kernel_name_), ActionArg("arg_id", i),
-             ActionArg("offset_in_bytes", (int64)arg.offset_in_mem)});
-      }
+      ActionRecorder::get_instance().record(
+          "context_host_to_metal",
+          {ActionArg("ti_kernel_name", kernel_name_), ActionArg("arg_id", i),
+           ActionArg("offset_in_bytes", (int64)arg.offset_in_mem)});
       if (arg.is_array) {
         const void *host_ptr = host_ctx_->get_arg<void *>(i);
         std::memcpy(device_ptr, host_ptr, arg.stride);
@@ -487,20 +473,18 @@ class HostMetalCtxBlitter {
         void *host_ptr = host_ctx_->get_arg<void *>(i);
         std::memcpy(host_ptr, device_ptr, arg.stride);
 
-        if (!ti_kernel_attribs_->is_jit_evaluator) {
-          ActionRecorder::get_instance().record(
-              "context_metal_to_host",
-              {
-                  ActionArg("ti_kernel_name", kernel_name_),
-                  ActionArg("arg_id", i),
-                  ActionArg("arg_type", "ptr"),
-                  ActionArg("size_in_bytes", (int64)arg.stride),
-                  ActionArg("host_address",
-                            fmt::format("0x{:x}", (uint64)host_ptr)),
-                  ActionArg("device_address",
-                            fmt::format("0x{:x}", (uint64)device_ptr)),
-              });
-        }
+        ActionRecorder::get_instance().record(
+            "context_metal_to_host",
+            {
+                ActionArg("ti_kernel_name", kernel_name_),
+                ActionArg("arg_id", i),
+                ActionArg("arg_type", "ptr"),
+                ActionArg("size_in_bytes", (int64)arg.stride),
+                ActionArg("host_address",
+                          fmt::format("0x{:x}", (uint64)host_ptr)),
+                ActionArg("device_address",
+                          fmt::format("0x{:x}", (uint64)device_ptr)),
+            });
       }
     }
     for (int i = 0; i < ctx_attribs_->rets().size(); ++i) {
@@ -549,7 +533,6 @@ class HostMetalCtxBlitter {
   }
 
  private:
-  const TaichiKernelAttributes *const ti_kernel_attribs_;
   const KernelContextAttributes *const ctx_attribs_;
   RuntimeContext *const host_ctx_;
   uint64_t *const host_result_buffer_;
@@ -1813,7 +1813,6 @@ class KernelCodegen {
     }
     kernel_attribs.ctx_attribs = std::move(ctx_attribs_);
     kernel_attribs.name = params_.ti_kernel_name;
-    kernel_attribs.is_jit_evaluator = params_.kernel->is_evaluator;
     return res;
   }
 
@@ -246,8 +246,6 @@ class KernelContextAttributes {
 struct TaichiKernelAttributes {
   // Taichi kernel name
   std::string name;
-  // Is this kernel for evaluating the constant fold result?
-  bool is_jit_evaluator{false};
   // Attributes of all the tasks produced from this single Taichi kernel.
   std::vector<TaskAttributes> tasks_attribs;
 
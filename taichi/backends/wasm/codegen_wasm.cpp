@@ -153,8 +153,6 @@ class CodeGenLLVMWASM : public CodeGenLLVM {
    * https://github.com/taichi-dev/taichi/blob/734da3f8f4439ce7f6a5337df7c54fb6dc34def8/python/taichi/lang/kernel_impl.py#L360-L362
    */
   std::string extract_original_kernel_name(const std::string &kernel_name) {
-    if (kernel->is_evaluator)
-      return kernel_name;
     int pos = kernel_name.length() - 1;
     int underline_count = 0;
     int redundant_count = 3;
@@ -124,7 +124,7 @@ CodeGenStmtGuard make_while_after_loop_guard(CodeGenLLVM *cg) {
 
 // CodeGenLLVM
 
-uint64 CodeGenLLVM::task_counter = 0;
+std::atomic<uint64> CodeGenLLVM::task_counter = 0;
 
 void CodeGenLLVM::visit(Block *stmt_list) {
   for (auto &stmt : stmt_list->statements) {
@@ -239,6 +239,10 @@ std::unique_ptr<RuntimeObject> CodeGenLLVM::emit_struct_meta_object(
   } else if (snode->type == SNodeType::pointer) {
     meta = std::make_unique<RuntimeObject>("PointerMeta", this, builder.get());
     emit_struct_meta_base("Pointer", meta->ptr, snode);
+  } else if (snode->type == SNodeType::hash) {
+    meta = std::make_unique<RuntimeObject>("HashMeta", this, builder.get());
+    emit_struct_meta_base("Hash", meta->ptr, snode);
+    meta->call("set_num_slots", tlctx->get_constant(snode->hash_num_slots));
   } else if (snode->type == SNodeType::root) {
     meta = std::make_unique<RuntimeObject>("RootMeta", this, builder.get());
     emit_struct_meta_base("Root", meta->ptr, snode);
@@ -267,7 +271,8 @@ void CodeGenLLVM::emit_struct_meta_base(const std::string &name,
         StructCompilerLLVM::get_llvm_body_type(module.get(), snode);
     auto element_ty = body_type->getArrayElementType();
     element_size = tlctx->get_type_size(element_ty);
-  } else if (snode->type == SNodeType::pointer) {
+  } else if (snode->type == SNodeType::pointer ||
+             snode->type == SNodeType::hash) {
     auto element_ty = StructCompilerLLVM::get_llvm_node_type(
         module.get(), snode->ch[0].get());
     element_size = tlctx->get_type_size(element_ty);
@@ -887,7 +892,11 @@ void CodeGenLLVM::visit(ContinueStmt *stmt) {
     return false;
   };
   if (stmt_in_off_range_for()) {
-    builder->CreateRetVoid();
+    if (offloaded_loop_reentry) {
+      builder->CreateBr(offloaded_loop_reentry);
+    } else {
+      builder->CreateRetVoid();
+    }
   } else {
     TI_ASSERT(current_loop_reentry != nullptr);
     builder->CreateBr(current_loop_reentry);
@@ -931,18 +940,36 @@ void CodeGenLLVM::emit_list_gen(OffloadedStmt *listgen) {
   auto snode_parent = listgen->snode->parent;
   auto meta_child = cast_pointer(emit_struct_meta(snode_child), "StructMeta");
   auto meta_parent = cast_pointer(emit_struct_meta(snode_parent), "StructMeta");
-  if (snode_parent->type == SNodeType::root) {
+  auto num_threads = tlctx->get_constant(prog->config.cpu_max_num_threads);
+  auto deterministic =
+      tlctx->get_constant((int)prog->config.cpu_deterministic_listgen);
+  if (snode_child->type == SNodeType::hash) {
+    // Lists the active cells from the slots of the table.
+    call("element_listgen_hash", get_runtime(), meta_parent, meta_child,
+         num_threads);
+  } else if (snode_parent->type == SNodeType::root) {
     // Since there's only one container to expand, we need a special kernel for
     // more parallelism.
-    call("element_listgen_root", get_runtime(), meta_parent, meta_child);
+    call("element_listgen_root", get_runtime(), meta_parent, meta_child,
+         num_threads, deterministic);
   } else {
-    call("element_listgen_nonroot", get_runtime(), meta_parent, meta_child);
+    call("element_listgen_nonroot", get_runtime(), meta_parent, meta_child,
+         num_threads, deterministic);
   }
 }
 
 void CodeGenLLVM::emit_gc(OffloadedStmt *stmt) {
-  auto snode = stmt->snode->id;
-  call("node_gc", get_runtime(), tlctx->get_constant(snode));
+  auto snode = stmt->snode;
+  auto num_threads = tlctx->get_constant(prog->config.cpu_max_num_threads);
+  if (snode->type == SNodeType::hash) {
+    auto meta_child = cast_pointer(emit_struct_meta(snode), "StructMeta");
+    auto meta_parent =
+        cast_pointer(emit_struct_meta(snode->parent), "StructMeta");
+    call("node_gc_hash", get_runtime(), meta_parent, meta_child, num_threads);
+  } else {
+    call("node_gc", get_runtime(), tlctx->get_constant(snode->id),
+         num_threads);
+  }
 }
 
 llvm::Value *CodeGenLLVM::create_call(llvm::Value *func,
@@ -1505,6 +1532,7 @@ void CodeGenLLVM::visit(SNodeLookupStmt *stmt) {
     llvm_val[stmt] = builder->CreateGEP(parent, llvm_val[stmt->input_index]);
   } else if (snode->type == SNodeType::dense ||
              snode->type == SNodeType::pointer ||
+             snode->type == SNodeType::hash ||
              snode->type == SNodeType::dynamic ||
              snode->type == SNodeType::bitmasked) {
     if (stmt->activate) {
@@ -1605,9 +1633,9 @@ std::string CodeGenLLVM::init_offloaded_task_function(OffloadedStmt *stmt,
       llvm::FunctionType::get(llvm::Type::getVoidTy(*llvm_context),
                               {llvm::PointerType::get(context_ty, 0)}, false);
 
-  auto task_kernel_name = fmt::format("{}_{}_{}{}", kernel_name, task_counter,
-                                      stmt->task_name(), suffix);
-  task_counter += 1;
+  auto task_kernel_name = fmt::format("{}_{}_{}{}", kernel_name,
+                                      task_counter++, stmt->task_name(),
+                                      suffix);
   func = llvm::Function::Create(task_function_type,
                                 llvm::Function::ExternalLinkage,
                                 task_kernel_name, module.get());
@@ -1681,6 +1709,19 @@ void CodeGenLLVM::create_offload_struct_for(OffloadedStmt *stmt, bool spmd) {
   llvm::Function *body = nullptr;
   auto leaf_block = stmt->snode;
 
+  // On CPUs the TLS xlogues run once per worker thread in the runtime instead
+  // of once per block, so they get functions of their own.
+  llvm::Value *tls_prologue = nullptr, *tls_epilogue = nullptr;
+  if (spmd) {
+    auto xlogue_ptr_type =
+        llvm::PointerType::get(get_xlogue_function_type(), 0);
+    tls_prologue = llvm::ConstantPointerNull::get(xlogue_ptr_type);
+    tls_epilogue = llvm::ConstantPointerNull::get(xlogue_ptr_type);
+  } else {
+    tls_prologue = create_xlogue(stmt->tls_prologue);
+    tls_epilogue = create_xlogue(stmt->tls_epilogue);
+  }
+
   // When looping over bit_arrays, we always vectorize and generate struct for
   // on their parent node (usually "dense") instead of itself for higher
   // performance. Also, note that the loop must be bit_vectorized for
@@ -1762,7 +1803,7 @@ void CodeGenLLVM::create_offload_struct_for(OffloadedStmt *stmt, bool spmd) {
     create_call(refine, {parent_coordinates, block_corner_coordinates,
                          tlctx->get_constant(0)});
 
-    if (stmt->tls_prologue) {
+    if (spmd && stmt->tls_prologue) {
       stmt->tls_prologue->accept(this);
     }
 
@@ -1873,7 +1914,7 @@ void CodeGenLLVM::create_offload_struct_for(OffloadedStmt *stmt, bool spmd) {
     }
 
     if (snode->type == SNodeType::bitmasked ||
-        snode->type == SNodeType::pointer) {
+        snode->type == SNodeType::pointer || snode->type == SNodeType::hash) {
       // test whether the current voxel is active or not
       auto is_active = call(snode, element.get("element"), "is_active",
                             {builder->CreateLoad(loop_index)});
@@ -1913,13 +1954,17 @@ void CodeGenLLVM::create_offload_struct_for(OffloadedStmt *stmt, bool spmd) {
       call("block_barrier");  // "__syncthreads()"
     }
 
-    if (stmt->tls_epilogue) {
+    if (spmd && stmt->tls_epilogue) {
       stmt->tls_epilogue->accept(this);
     }
   }
 
-  int list_element_size = std::min(leaf_block->max_num_elements(),
-                                   (int64)taichi_listgen_max_element_size);
+  // Each element of a hash node holds a single cell.
+  int list_element_size =
+      leaf_block->type == SNodeType::hash
+          ? 1
+          : std::min(leaf_block->max_num_elements(),
+                     (int64)taichi_listgen_max_element_size);
   int num_splits = std::max(1, list_element_size / stmt->block_dim);
 
   auto struct_for_func = get_runtime_function("parallel_struct_for");
@@ -1967,7 +2012,7 @@ void CodeGenLLVM::create_offload_struct_for(OffloadedStmt *stmt, bool spmd) {
       struct_for_func,
       {get_context(), tlctx->get_constant(leaf_block->id),
        tlctx->get_constant(list_element_size), tlctx->get_constant(num_splits),
-       body, tlctx->get_constant(stmt->tls_size),
+       body, tls_prologue, tls_epilogue, tlctx->get_constant(stmt->tls_size),
        tlctx->get_constant(stmt->num_cpu_threads)});
   // TODO: why do we need num_cpu_threads on GPUs?
 
@@ -2,6 +2,7 @@
 #pragma once
 #ifdef TI_WITH_LLVM
 
+#include <atomic>
 #include <set>
 #include <unordered_map>
 
@@ -49,7 +50,8 @@ class FunctionCreationGuard {
 
 class CodeGenLLVM : public IRVisitor, public LLVMModuleBuilder {
  public:
-  static uint64 task_counter;
+  // Offloaded tasks of one kernel may be compiled on several threads.
+  static std::atomic<uint64> task_counter;
 
   Kernel *kernel;
   IRNode *ir;
@@ -64,6 +66,9 @@ class CodeGenLLVM : public IRVisitor, public LLVMModuleBuilder {
   llvm::GlobalVariable *bls_buffer{nullptr};
   // Mainly for supporting continue stmt
   llvm::BasicBlock *current_loop_reentry;
+  // Where a continue stmt of an offloaded range-for goes when the body
+  // function runs several iterations. Null when it runs one and returns.
+  llvm::BasicBlock *offloaded_loop_reentry{nullptr};
   // Mainly for supporting break stmt
   llvm::BasicBlock *current_while_after_loop;
   llvm::FunctionType *task_function_type;
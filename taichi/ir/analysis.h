@@ -165,6 +165,12 @@ bool same_statements(
     IRNode *root1,
     IRNode *root2,
     const std::optional<std::unordered_map<int, int>> &id_map = std::nullopt);
+/**
+ * Compute a structural hash of root, without printing it. If
+ * same_statements(root1, root2) is true, root1 and root2 have the same hash.
+ * Statements in root are hashed by position and operands outside root by id.
+ */
+uint64 hash_statements(IRNode *root);
 /**
  * Test if stmt1 and stmt2 definitely have the same value.
  *
@@ -98,6 +98,10 @@ bool StmtFieldSNode::equal(const StmtField *other_generic) const {
   }
 }
 
+std::size_t StmtFieldSNode::hash() const {
+  return std::hash<int>()(get_snode_id(snode));
+}
+
 bool StmtFieldMemoryAccessOptions::equal(const StmtField *other_generic) const {
   if (auto other =
           dynamic_cast<const StmtFieldMemoryAccessOptions *>(other_generic)) {
@@ -108,6 +112,20 @@ bool StmtFieldMemoryAccessOptions::equal(const StmtField *other_generic) const {
   }
 }
 
+std::size_t StmtFieldMemoryAccessOptions::hash() const {
+  // The options are unordered, so the hashes of the (SNode, flag) pairs are
+  // summed.
+  std::size_t ret = 0;
+  for (const auto &[snode, flags] : opt_.get_all()) {
+    const auto snode_hash =
+        std::hash<int>()(StmtFieldSNode::get_snode_id(snode));
+    for (auto flag : flags) {
+      ret += snode_hash * 100000007UL + std::size_t(flag);
+    }
+  }
+  return ret;
+}
+
 bool StmtFieldManager::equal(StmtFieldManager &other) const {
   if (fields.size() != other.fields.size()) {
     return false;
@@ -121,6 +139,14 @@ bool StmtFieldManager::equal(StmtFieldManager &other) const {
   return true;
 }
 
+std::size_t StmtFieldManager::hash() const {
+  std::size_t ret = fields.size();
+  for (auto &field : fields) {
+    ret = ret * 100000007UL + field->hash();
+  }
+  return ret;
+}
+
 std::atomic<int> Stmt::instance_id_counter(0);
 
 Stmt::Stmt() : field_manager(this), fields_registered(false) {
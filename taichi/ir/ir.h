@@ -389,9 +389,40 @@ class StmtField {
 
   virtual bool equal(const StmtField *other) const = 0;
 
+  // Fields that are equal must have the same hash.
+  virtual std::size_t hash() const = 0;
+
   virtual ~StmtField() = default;
 };
 
+template <typename T>
+struct is_unordered_set : std::false_type {};
+
+template <typename T>
+struct is_unordered_set<std::unordered_set<T>> : std::true_type {};
+
+template <typename T>
+std::size_t hash_stmt_field_value(const T &value) {
+  using decay_T = std::remove_cv_t<T>;
+  if constexpr (std::is_same_v<decay_T, DataType>) {
+    return std::hash<const Type *>()(value);
+  } else if constexpr (std::is_same_v<decay_T, TypedConstant>) {
+    return value.hash();
+  } else if constexpr (is_unordered_set<decay_T>::value) {
+    // Summed, so that the hash does not depend on the iteration order.
+    std::size_t ret = 0;
+    for (const auto &element : value) {
+      ret += hash_stmt_field_value(element);
+    }
+    return ret;
+  } else if constexpr (std::is_default_constructible_v<std::hash<decay_T>>) {
+    return std::hash<decay_T>()(value);
+  } else {
+    // Fields without a std::hash only take part in equal().
+    return 0;
+  }
+}
+
 template <typename T>
 class StmtFieldNumeric final : public StmtField {
  private:
@@ -423,6 +454,14 @@ class StmtFieldNumeric final : public StmtField {
       return false;
     }
   }
+
+  std::size_t hash() const override {
+    if (std::holds_alternative<T *>(value)) {
+      return hash_stmt_field_value(*std::get<T *>(value));
+    } else {
+      return hash_stmt_field_value(std::get<T>(value));
+    }
+  }
 };
 
 class StmtFieldSNode final : public StmtField {
@@ -436,6 +475,8 @@ class StmtFieldSNode final : public StmtField {
   static int get_snode_id(SNode *snode);
 
   bool equal(const StmtField *other_generic) const override;
+
+  std::size_t hash() const override;
 };
 
 class StmtFieldMemoryAccessOptions final : public StmtField {
@@ -448,6 +489,8 @@ class StmtFieldMemoryAccessOptions final : public StmtField {
   }
 
   bool equal(const StmtField *other_generic) const override;
+
+  std::size_t hash() const override;
 };
 
 class StmtFieldManager {
@@ -475,6 +518,8 @@ class StmtFieldManager {
   }
 
   bool equal(StmtFieldManager &other) const;
+
+  std::size_t hash() const;
 };
 
 #define TI_STMT_DEF_FIELDS(...) TI_IO_DEF(__VA_ARGS__)
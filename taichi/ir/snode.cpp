@@ -131,6 +131,19 @@ SNode &SNode::dynamic(const Axis &expr, int n, int chunk_size, bool packed) {
   return snode;
 }
 
+SNode &SNode::hash(const std::vector<Axis> &axes,
+                   const std::vector<int> &sizes,
+                   int max_num_active,
+                   bool packed) {
+  TI_ERROR_IF(max_num_active <= 0, "max_num_active must be positive.");
+  auto &snode = create_node(axes, sizes, SNodeType::hash, packed);
+  max_num_active =
+      (int)std::min((int64)max_num_active, snode.max_num_elements());
+  // Keep the load factor at most 1/2 so that the probe sequences stay short.
+  snode.hash_num_slots = (int)bit::least_pot_bound(2 * (int64)max_num_active);
+  return snode;
+}
+
 SNode &SNode::bit_struct(int num_bits, bool packed) {
   auto &snode = create_node({}, {}, SNodeType::bit_struct, packed);
   snode.physical_type =
@@ -276,7 +289,7 @@ void SNode::set_snode_tree_id(int id) {
   snode_tree_id_ = id;
 }
 
-int SNode::get_snode_tree_id() {
+int SNode::get_snode_tree_id() const {
   return snode_tree_id_;
 }
 
@@ -122,6 +122,8 @@ class SNode {
   int total_num_bits{0};
   int total_bit_start{0};
   int chunk_size{0};
+  // Number of slots of the table of a hash SNode, a power of two.
+  int hash_num_slots{0};
   std::size_t cell_size_bytes{0};
   PrimitiveType *physical_type{nullptr};  // for bit_struct and bit_array only
   DataType dt;
@@ -216,18 +218,22 @@ class SNode {
     return SNode::bitmasked(std::vector<Axis>{axis}, size, packed);
   }
 
+  // |max_num_active|: the number of cells that can be active at the same
+  // time.
   SNode &hash(const std::vector<Axis> &axes,
               const std::vector<int> &sizes,
-              bool packed) {
-    return create_node(axes, sizes, SNodeType::hash, packed);
-  }
+              int max_num_active,
+              bool packed);
 
-  SNode &hash(const std::vector<Axis> &axes, int sizes, bool packed) {
-    return create_node(axes, std::vector<int>{sizes}, SNodeType::hash, packed);
+  SNode &hash(const std::vector<Axis> &axes,
+              int sizes,
+              int max_num_active,
+              bool packed) {
+    return hash(axes, std::vector<int>{sizes}, max_num_active, packed);
   }
 
-  SNode &hash(const Axis &axis, int size, bool packed) {
-    return hash(std::vector<Axis>{axis}, size, packed);
+  SNode &hash(const Axis &axis, int size, int max_num_active, bool packed) {
+    return hash(std::vector<Axis>{axis}, size, max_num_active, packed);
   }
 
   std::string type_name() {
@@ -325,7 +331,7 @@ class SNode {
 
   void set_snode_tree_id(int id);
 
-  int get_snode_tree_id();
+  int get_snode_tree_id() const;
 
  private:
   int snode_tree_id_{0};
@@ -272,6 +272,28 @@ bool TypedConstant::equal_type_and_value(const TypedConstant &o) const {
   }
 }
 
+std::size_t TypedConstant::hash() const {
+  std::size_t value_hash = 0;
+  if (dt->is_primitive(PrimitiveTypeID::f32)) {
+    value_hash = std::hash<float32>()(val_f32);
+  } else if (dt->is_primitive(PrimitiveTypeID::f64)) {
+    value_hash = std::hash<float64>()(val_f64);
+  } else if (dt->is_primitive(PrimitiveTypeID::i8) ||
+             dt->is_primitive(PrimitiveTypeID::u8)) {
+    value_hash = val_u8;
+  } else if (dt->is_primitive(PrimitiveTypeID::i16) ||
+             dt->is_primitive(PrimitiveTypeID::u16)) {
+    value_hash = val_u16;
+  } else if (dt->is_primitive(PrimitiveTypeID::i32) ||
+             dt->is_primitive(PrimitiveTypeID::u32)) {
+    value_hash = val_u32;
+  } else if (dt->is_primitive(PrimitiveTypeID::i64) ||
+             dt->is_primitive(PrimitiveTypeID::u64)) {
+    value_hash = val_u64;
+  }
+  return std::hash<const Type *>()(dt) * 100000007UL + value_hash;
+}
+
 int32 &TypedConstant::val_int32() {
   TI_ASSERT(get_data_type<int32>() == dt);
   return val_i32;
@@ -441,6 +441,9 @@ class TypedConstant {
 
   bool equal_type_and_value(const TypedConstant &o) const;
 
+  // Consistent with equal_type_and_value().
+  std::size_t hash() const;
+
   bool operator==(const TypedConstant &o) const {
     return equal_type_and_value(o);
   }
@@ -24,6 +24,23 @@ class JITSession {
 
   // virtual void remove_module(JITModule *module) = 0;
 
+  // Adds a relocatable object file, e.g. one loaded from the offline cache.
+  virtual JITModule *add_object(const std::string &object_code) {
+    TI_NOT_IMPLEMENTED
+  }
+
+  // Returns and releases the object code generated for the module whose
+  // identifier is |module_id|. Returns an empty string if there is none.
+  virtual std::string take_compiled_object(const std::string &module_id) {
+    return "";
+  }
+
+  // Optimizes |M| and compiles it to position-independent relocatable object
+  // code, without loading it. Used by AOT.
+  virtual std::string compile_to_object(std::unique_ptr<llvm::Module> M) {
+    TI_NOT_IMPLEMENTED
+  }
+
   virtual void *lookup(const std::string Name) {
     TI_NOT_IMPLEMENTED
   }
@@ -455,6 +455,16 @@ void TaichiLLVMContext::set_struct_module(
   }
   // TODO: Move this after ``if (!arch_is_cpu(arch))``.
   data->struct_module = llvm::CloneModule(*module);
+  if (data == main_thread_data) {
+    // Other threads clone the struct module of the main thread on first use.
+    // Drop their copies so that they pick up the new SNode trees.
+    std::lock_guard<std::mutex> _(thread_map_mut);
+    for (auto &it : per_thread_data) {
+      if (it.second.get() != data) {
+        it.second->struct_module.reset();
+      }
+    }
+  }
 }
 
 template <typename T>
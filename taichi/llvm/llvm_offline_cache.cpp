@@ -0,0 +1,189 @@
+#include "taichi/llvm/llvm_offline_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+#include "llvm/Support/Host.h"
+
+#include "taichi/ir/analysis.h"
+#include "taichi/ir/statements.h"
+#include "taichi/ir/transforms.h"
+#include "taichi/program/kernel.h"
+#include "taichi/program/program.h"
+#include "taichi/util/io.h"
+#include "taichi/util/statistics.h"
+
+namespace taichi {
+namespace lang {
+namespace {
+
+namespace fs = std::filesystem;
+
+// FNV-1a. std::hash is not guaranteed to be stable across processes, which
+// is required here since the keys are persisted.
+uint64 fnv1a_64(const std::string &str, uint64 basis) {
+  uint64 h = basis;
+  for (unsigned char c : str) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+void serialize_snode(const SNode *snode, std::string &out) {
+  out += fmt::format("{}:{}:{}:{}:{}:{}(", snode->get_node_type_name_hinted(),
+                     snode->num_active_indices, snode->num_cells_per_container,
+                     snode->cell_size_bytes, snode->chunk_size,
+                     snode->hash_num_slots);
+  for (const auto &ch : snode->ch) {
+    serialize_snode(ch.get(), out);
+  }
+  out += ")";
+}
+
+std::string serialize_config(const CompileConfig &config) {
+  return fmt::format(
+      "arch={} debug={} fast_math={} check_out_of_bound={} packed={} "
+      "opt_level={} cpu_threads={} cpu_block_dim={} cpu_schedule={} "
+      "cpu_simd={} simd_width={} kernel_profiler={} fp={} ip={}",
+      arch_name(config.arch), config.debug, config.fast_math,
+      config.check_out_of_bound, config.packed,
+      config.external_optimization_level, config.cpu_max_num_threads,
+      config.default_cpu_block_dim, config.cpu_range_for_schedule,
+      config.cpu_simd_range_for, config.simd_width, config.kernel_profiler,
+      config.default_fp.to_string(), config.default_ip.to_string());
+}
+
+}  // namespace
+
+LlvmOfflineCache::LlvmOfflineCache(const std::string &path,
+                                   std::size_t max_size_bytes)
+    : path_(path), max_size_bytes_(max_size_bytes) {
+  create_directories(path_);
+}
+
+std::string LlvmOfflineCache::make_kernel_key(Kernel *kernel,
+                                              const CompileConfig &config) {
+  TI_AUTO_PROF
+  auto *ir = kernel->ir.get();
+  // External function calls either embed host function addresses (shared
+  // objects) or depend on files that may change (bitcode). Do not cache them.
+  if (!irpass::analysis::gather_statements(ir, [](Stmt *s) {
+         return s->is<ExternalFuncCallStmt>();
+       }).empty()) {
+    return "";
+  }
+
+  std::string source;
+  irpass::re_id(ir);
+  irpass::print(ir, &source);
+
+  auto *prog = kernel->program;
+  for (int i = 0; i < prog->get_snode_tree_size(); i++) {
+    serialize_snode(prog->get_snode_root(i), source);
+  }
+  source += serialize_config(config);
+  source += llvm::sys::getHostCPUName().str();
+  source += get_version_string();
+  source += get_commit_hash();
+
+  return fmt::format("{}{:016x}{:016x}", kModuleIdPrefix,
+                     fnv1a_64(source, 14695981039346656037ULL),
+                     fnv1a_64(source, 0x9e3779b97f4a7c15ULL));
+}
+
+std::string LlvmOfflineCache::get_cache_file_path(
+    const std::string &key) const {
+  return fmt::format("{}/{}.tcb", path_, key);
+}
+
+bool LlvmOfflineCache::get_kernel(const std::string &key,
+                                  KernelCacheData &data) {
+  TI_AUTO_PROF
+  std::lock_guard<std::mutex> _(mut_);
+  const auto file_path = get_cache_file_path(key);
+  std::error_code ec;
+  if (!fs::exists(file_path, ec)) {
+    num_misses_++;
+    stat.add("llvm_offline_cache_misses");
+    return false;
+  }
+  read_from_binary_file(data, file_path);
+  if (data.kernel_key != key || data.object_code.empty()) {
+    TI_WARN("Ignoring corrupted offline cache file {}", file_path);
+    fs::remove(file_path, ec);
+    num_misses_++;
+    stat.add("llvm_offline_cache_misses");
+    return false;
+  }
+  // Refresh the timestamp so that eviction is least-recently-used.
+  fs::last_write_time(file_path, fs::file_time_type::clock::now(), ec);
+  num_hits_++;
+  stat.add("llvm_offline_cache_hits");
+  TI_TRACE("Offline cache hit: {}", key);
+  return true;
+}
+
+void LlvmOfflineCache::put_kernel(const KernelCacheData &data) {
+  TI_AUTO_PROF
+  std::lock_guard<std::mutex> _(mut_);
+  const auto file_path = get_cache_file_path(data.kernel_key);
+  // Write to a temporary file first, so that concurrent processes sharing the
+  // cache never observe a partially written entry.
+  const auto tmp_path = fmt::format(
+      "{}/{}.{}.tmp.tcb", path_, data.kernel_key,
+      std::chrono::steady_clock::now().time_since_epoch().count());
+  write_to_binary_file(data, tmp_path);
+  std::error_code ec;
+  fs::rename(tmp_path, file_path, ec);
+  if (ec) {
+    TI_WARN("Failed to write offline cache file {}: {}", file_path,
+            ec.message());
+    fs::remove(tmp_path, ec);
+    return;
+  }
+  evict_if_needed();
+}
+
+void LlvmOfflineCache::evict_if_needed() {
+  if (max_size_bytes_ == 0) {
+    // 0 means unlimited
+    return;
+  }
+  struct Entry {
+    fs::path path;
+    fs::file_time_type last_used;
+    std::size_t size;
+  };
+  std::vector<Entry> entries;
+  std::size_t total_size = 0;
+  std::error_code ec;
+  for (const auto &f : fs::directory_iterator(path_, ec)) {
+    if (!f.is_regular_file(ec) || f.path().extension() != ".tcb") {
+      continue;
+    }
+    const auto size = (std::size_t)f.file_size(ec);
+    entries.push_back({f.path(), f.last_write_time(ec), size});
+    total_size += size;
+  }
+  if (total_size <= max_size_bytes_) {
+    return;
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) {
+              return a.last_used < b.last_used;
+            });
+  for (const auto &e : entries) {
+    if (total_size <= max_size_bytes_) {
+      break;
+    }
+    if (fs::remove(e.path, ec)) {
+      total_size -= e.size;
+      stat.add("llvm_offline_cache_evictions");
+    }
+  }
+}
+
+}  // namespace lang
+}  // namespace taichi
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "taichi/common/core.h"
+#include "taichi/common/serialization.h"
+#include "taichi/program/compile_config.h"
+
+namespace taichi {
+namespace lang {
+
+class Kernel;
+
+/**
+ * A persistent on-disk cache of optimized machine code for LLVM CPU kernels.
+ *
+ * Each entry is keyed on a hash of the lowered (offloaded) CHI IR, the SNode
+ * layouts, the codegen-relevant CompileConfig fields, the host CPU and the
+ * Taichi version. A hit allows Kernel::compile() to skip LLVM codegen,
+ * optimization and instruction selection entirely.
+ */
+class LlvmOfflineCache {
+ public:
+  // LLVM modules whose identifiers start with this prefix have their
+  // generated object code retained by the JIT session, so that it can be
+  // written to the cache.
+  static constexpr const char *kModuleIdPrefix = "ticache_";
+
+  struct KernelCacheData {
+    std::string kernel_key;
+    std::vector<std::string> offloaded_task_names;
+    // The number of threads of each range-for task, 0 for other tasks.
+    std::vector<int> range_for_num_threads;
+    std::string object_code;
+
+    TI_IO_DEF(kernel_key,
+              offloaded_task_names,
+              range_for_num_threads,
+              object_code);
+  };
+
+  LlvmOfflineCache(const std::string &path, std::size_t max_size_bytes);
+
+  /**
+   * Computes the cache key of a lowered kernel.
+   *
+   * @return The key, or an empty string if the kernel cannot be cached (e.g.
+   * it embeds host addresses of external functions).
+   */
+  static std::string make_kernel_key(Kernel *kernel,
+                                     const CompileConfig &config);
+
+  bool get_kernel(const std::string &key, KernelCacheData &data);
+
+  void put_kernel(const KernelCacheData &data);
+
+  std::size_t num_hits() const {
+    return num_hits_;
+  }
+
+  std::size_t num_misses() const {
+    return num_misses_;
+  }
+
+ private:
+  std::string get_cache_file_path(const std::string &key) const;
+
+  // Removes the least recently used entries until the total size of the
+  // cache is no larger than |max_size_bytes_|.
+  void evict_if_needed();
+
+  std::string path_;
+  std::size_t max_size_bytes_{0};
+  std::atomic<std::size_t> num_hits_{0};
+  std::atomic<std::size_t> num_misses_{0};
+  std::mutex mut_;
+};
+
+}  // namespace lang
+}  // namespace taichi
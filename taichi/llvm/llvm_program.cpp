@@ -1,5 +1,7 @@
 #include "llvm_program.h"
 
+#include <exception>
+
 #include "taichi/backends/cuda/cuda_driver.h"
 #include "taichi/program/arch.h"
 #include "taichi/platform/cuda/detect_cuda.h"
@@ -8,6 +10,8 @@
 #include "taichi/util/str.h"
 #include "taichi/codegen/codegen.h"
 #include "taichi/ir/statements.h"
+#include "taichi/program/async_engine.h"
+#include "taichi/backends/cpu/aot_module_builder_impl.h"
 #include "taichi/backends/cpu/cpu_device.h"
 #include "taichi/backends/cuda/cuda_device.h"
 
@@ -57,7 +61,11 @@ LlvmProgramImpl::LlvmProgramImpl(CompileConfig &config_,
 
   snode_tree_buffer_manager = std::make_unique<SNodeTreeBufferManager>(this);
 
-  thread_pool = std::make_unique<ThreadPool>(config->cpu_max_num_threads);
+  // Tasks launched concurrently by the async engine run on disjoint groups of
+  // threads.
+  thread_pool = std::make_unique<ThreadPool>(
+      config->cpu_max_num_threads, config->cpu_pin_threads,
+      config->async_mode ? AsyncEngine::get_num_launch_workers(config) : 1);
 
   preallocated_device_buffer = nullptr;
   llvm_runtime = nullptr;
@@ -85,6 +93,18 @@ LlvmProgramImpl::LlvmProgramImpl(CompileConfig &config_,
   if (arch_is_cpu(config->arch)) {
     config_.max_block_dim = 1024;
     device_ = std::make_unique<cpu::CpuDevice>();
+    if (config_.offline_cache) {
+      offline_cache_ = std::make_unique<LlvmOfflineCache>(
+          config_.offline_cache_file_path,
+          (std::size_t)config_.offline_cache_max_size_MB * 1024 * 1024);
+    }
+    if (config_.cpu_async_launch) {
+      cpu_stream_ = std::make_unique<cpu::CpuKernelStream>("cpu_stream");
+    }
+    if (config_.num_compile_threads > 0) {
+      compile_thread_pool_ =
+          std::make_unique<ThreadPool>(config_.num_compile_threads);
+    }
   }
 
   if (config->kernel_profiler && runtime_mem_info) {
@@ -118,6 +138,9 @@ void LlvmProgramImpl::maybe_initialize_cuda_llvm_context() {
 
 FunctionType LlvmProgramImpl::compile(Kernel *kernel,
                                       OffloadedStmt *offloaded) {
+  if (compile_thread_pool_ && offloaded == nullptr) {
+    return compile_batch({kernel})[0];
+  }
   if (!kernel->lowered()) {
     kernel->lower();
   }
@@ -125,7 +148,81 @@ FunctionType LlvmProgramImpl::compile(Kernel *kernel,
   return codegen->codegen();
 }
 
+std::vector<FunctionType> LlvmProgramImpl::compile_batch(
+    const std::vector<Kernel *> &kernels) {
+  if (!compile_thread_pool_) {
+    return ProgramImpl::compile_batch(kernels);
+  }
+  TI_AUTO_PROF
+  struct CompileJob {
+    Kernel *kernel{nullptr};
+    // nullptr to compile the whole kernel as one module.
+    OffloadedStmt *offloaded{nullptr};
+    FunctionType compiled;
+    std::exception_ptr error;
+  };
+  std::vector<CompileJob> jobs;
+  // Jobs [begin, end) of each kernel.
+  std::vector<std::pair<int, int>> kernel_jobs;
+  for (auto *kernel : kernels) {
+    // Lowering installs |kernel| as the current callable of the program, so
+    // the IR passes stay on this thread. Codegen and LLVM run in parallel.
+    if (!kernel->lowered()) {
+      kernel->lower();
+    }
+    const int begin = jobs.size();
+    if (offline_cache_) {
+      // The offline cache only holds whole kernels.
+      jobs.push_back({kernel, nullptr});
+    } else {
+      for (auto &s : kernel->ir->as<Block>()->statements) {
+        jobs.push_back({kernel, s->as<OffloadedStmt>()});
+      }
+    }
+    kernel_jobs.emplace_back(begin, (int)jobs.size());
+  }
+
+  // Each thread generates code into its own LLVMContext. See
+  // TaichiLLVMContext::get_this_thread_context().
+  compile_thread_pool_->run(
+      jobs.size(), config->num_compile_threads, &jobs,
+      [](void *context, int thread_id, int i) {
+        auto &job = (*(std::vector<CompileJob> *)context)[i];
+        try {
+          auto codegen = KernelCodeGen::create(job.kernel->arch, job.kernel,
+                                               job.offloaded);
+          job.compiled = codegen->codegen();
+        } catch (...) {
+          job.error = std::current_exception();
+        }
+      });
+
+  std::vector<FunctionType> ret;
+  for (auto [begin, end] : kernel_jobs) {
+    std::vector<FunctionType> tasks;
+    for (int i = begin; i < end; i++) {
+      if (jobs[i].error) {
+        std::rethrow_exception(jobs[i].error);
+      }
+      tasks.push_back(std::move(jobs[i].compiled));
+    }
+    if (tasks.size() == 1) {
+      ret.push_back(std::move(tasks[0]));
+      continue;
+    }
+    ret.push_back([tasks](RuntimeContext &context) {
+      for (auto &task : tasks) {
+        task(context);
+      }
+    });
+  }
+  return ret;
+}
+
 void LlvmProgramImpl::synchronize() {
+  if (cpu_stream_) {
+    cpu_stream_->synchronize();
+  }
   if (config->arch == Arch::cuda) {
 #if defined(TI_WITH_CUDA)
     CUDADriver::get_instance().stream_synchronize(nullptr);
@@ -186,43 +283,58 @@ void LlvmProgramImpl::initialize_llvm_runtime_snodes(const SNodeTree *tree,
 
   snode_tree_allocs_[tree->id()] = alloc;
 
-  bool all_dense = config->demote_dense_struct_fors;
+  cpu::CompiledSNodeTree compiled_tree;
+  compiled_tree.tree_id = tree->id();
+  compiled_tree.root_id = root_id;
+  compiled_tree.num_snodes = (int)snodes.size();
+  compiled_tree.root_size = scomp->root_size;
+  compiled_tree.all_dense = config->demote_dense_struct_fors;
   for (int i = 0; i < (int)snodes.size(); i++) {
     if (snodes[i]->type != SNodeType::dense &&
         snodes[i]->type != SNodeType::place &&
         snodes[i]->type != SNodeType::root) {
-      all_dense = false;
+      compiled_tree.all_dense = false;
       break;
     }
   }
-
-  runtime_jit->call<void *, std::size_t, int, int, int, std::size_t, Ptr>(
-      "runtime_initialize_snodes", llvm_runtime, scomp->root_size, root_id,
-      (int)snodes.size(), tree->id(), rounded_size, root_buffer, all_dense);
-
   for (int i = 0; i < (int)snodes.size(); i++) {
     if (is_gc_able(snodes[i]->type)) {
-      const auto snode_id = snodes[i]->id;
       std::size_t node_size;
       auto element_size = snodes[i]->cell_size_bytes;
-      if (snodes[i]->type == SNodeType::pointer) {
-        // pointer. Allocators are for single elements
+      if (snodes[i]->type == SNodeType::pointer ||
+          snodes[i]->type == SNodeType::hash) {
+        // pointer and hash. Allocators are for single elements
         node_size = element_size;
       } else {
         // dynamic. Allocators are for the chunks
         node_size = sizeof(void *) + element_size * snodes[i]->chunk_size;
       }
-      TI_TRACE("Initializing allocator for snode {} (node size {})", snode_id,
-               node_size);
-      auto rt = llvm_runtime;
-      runtime_jit->call<void *, int, std::size_t>(
-          "runtime_NodeAllocator_initialize", rt, snode_id, node_size);
-      TI_TRACE("Allocating ambient element for snode {} (node size {})",
-               snode_id, node_size);
-      runtime_jit->call<void *, int>("runtime_allocate_ambient", rt, snode_id,
-                                     node_size);
+      compiled_tree.node_allocators.push_back({snodes[i]->id, node_size});
     }
   }
+
+  runtime_jit->call<void *, std::size_t, int, int, int, std::size_t, Ptr>(
+      "runtime_initialize_snodes", llvm_runtime, scomp->root_size, root_id,
+      (int)snodes.size(), tree->id(), rounded_size, root_buffer,
+      compiled_tree.all_dense);
+
+  for (const auto &allocator : compiled_tree.node_allocators) {
+    const auto snode_id = allocator.snode_id;
+    const auto node_size = allocator.node_size;
+    TI_TRACE("Initializing allocator for snode {} (node size {})", snode_id,
+             node_size);
+    auto rt = llvm_runtime;
+    runtime_jit->call<void *, int, std::size_t>(
+        "runtime_NodeAllocator_initialize", rt, snode_id, node_size);
+    TI_TRACE("Allocating ambient element for snode {} (node size {})",
+             snode_id, node_size);
+    runtime_jit->call<void *, int>("runtime_allocate_ambient", rt, snode_id,
+                                   node_size);
+  }
+
+  if (arch_is_cpu(config->arch)) {
+    compiled_snode_trees_.push_back(std::move(compiled_tree));
+  }
 }
 
 void LlvmProgramImpl::compile_snode_tree_types(
@@ -249,6 +361,8 @@ void LlvmProgramImpl::materialize_snode_tree(
     SNodeTree *tree,
     std::vector<std::unique_ptr<SNodeTree>> &snode_trees_,
     uint64 *result_buffer) {
+  // The runtime must not be modified while kernels are in flight.
+  synchronize();
   compile_snode_tree_types(tree, snode_trees_);
   initialize_llvm_runtime_snodes(tree, struct_compiler_.get(), result_buffer);
 }
@@ -283,13 +397,13 @@ std::size_t LlvmProgramImpl::get_snode_num_dynamically_allocated(
   auto data_list = runtime_query<void *>("NodeManager_get_data_list",
                                          result_buffer, node_allocator);
 
-  return (std::size_t)runtime_query<int32>("ListManager_get_num_elements",
+  return (std::size_t)runtime_query<int64>("ListManager_get_num_elements",
                                            result_buffer, data_list);
 }
 
 void LlvmProgramImpl::print_list_manager_info(void *list_manager,
                                               uint64 *result_buffer) {
-  auto list_manager_len = runtime_query<int32>("ListManager_get_num_elements",
+  auto list_manager_len = runtime_query<int64>("ListManager_get_num_elements",
                                                result_buffer, list_manager);
 
   auto element_size = runtime_query<int32>("ListManager_get_element_size",
@@ -399,7 +513,7 @@ void LlvmProgramImpl::materialize_runtime(MemoryPool *memory_pool,
   if (arch_use_host_memory(config->arch)) {
     runtime_jit->call<void *, void *, void *>(
         "LLVMRuntime_initialize_thread_pool", llvm_runtime, thread_pool.get(),
-        (void *)ThreadPool::static_run);
+        (void *)ThreadPool::static_run_with_thread_id_base);
 
     runtime_jit->call<void *, void *>("LLVMRuntime_set_assert_failed",
                                       llvm_runtime, (void *)assert_failed_host);
@@ -414,6 +528,23 @@ void LlvmProgramImpl::materialize_runtime(MemoryPool *memory_pool,
     runtime_jit->call<void *, void *>(
         "LLVMRuntime_set_profiler_stop", llvm_runtime,
         (void *)&KernelProfilerBase::profiler_stop);
+    runtime_jit->call<void *, void *>(
+        "LLVMRuntime_set_profiler_add_iterations", llvm_runtime,
+        (void *)&KernelProfilerBase::profiler_add_iterations);
+    if (profiler) {
+      profiler->set_thread_pool(thread_pool.get());
+    }
+    if (config->cpu_node_allocator_cache) {
+      // Must be set before the node allocators are created, i.e. before any
+      // SNode tree is materialized.
+      runtime_jit->call<void *, int>(
+          "LLVMRuntime_set_num_node_allocator_caches", llvm_runtime,
+          config->cpu_max_num_threads);
+    }
+    if (config->cpu_gc_lazy_zero_fill) {
+      runtime_jit->call<void *, int>(
+          "LLVMRuntime_set_node_allocator_lazy_zero_fill", llvm_runtime, 1);
+    }
   }
 }
 
@@ -466,6 +597,14 @@ void LlvmProgramImpl::check_runtime_error(uint64 *result_buffer) {
 }
 
 void LlvmProgramImpl::finalize() {
+  if (cpu_stream_) {
+    cpu_stream_->synchronize();
+    cpu_stream_ = nullptr;
+  }
+  if (offline_cache_) {
+    TI_TRACE("LLVM offline cache: {} hits, {} misses",
+             offline_cache_->num_hits(), offline_cache_->num_misses());
+  }
   if (runtime_mem_info)
     runtime_mem_info->set_profiler(nullptr);
 #if defined(TI_WITH_CUDA)
@@ -509,13 +648,13 @@ void LlvmProgramImpl::print_memory_profiler_info(
           auto recycled_list = runtime_query<void *>(
               "NodeManager_get_recycled_list", result_buffer, node_allocator);
 
-          auto free_list_len = runtime_query<int32>(
+          auto free_list_len = runtime_query<int64>(
               "ListManager_get_num_elements", result_buffer, free_list);
 
-          auto recycled_list_len = runtime_query<int32>(
+          auto recycled_list_len = runtime_query<int64>(
               "ListManager_get_num_elements", result_buffer, recycled_list);
 
-          auto free_list_used = runtime_query<int32>(
+          auto free_list_used = runtime_query<int64>(
               "NodeManager_get_free_list_used", result_buffer, node_allocator);
 
           auto data_list = runtime_query<void *>("NodeManager_get_data_list",
@@ -559,6 +698,14 @@ cpu::CpuDevice *LlvmProgramImpl::cpu_device() {
   return static_cast<cpu::CpuDevice *>(device_.get());
 }
 
+std::unique_ptr<AotModuleBuilder> LlvmProgramImpl::make_aot_module_builder() {
+  TI_ERROR_IF(!arch_is_cpu(config->arch),
+              "AOT: the LLVM backend only supports CPU, not {}",
+              arch_name(config->arch));
+  return std::make_unique<cpu::AotModuleBuilderImpl>(this,
+                                                     compiled_snode_trees_);
+}
+
 DevicePtr LlvmProgramImpl::get_snode_tree_device_ptr(int tree_id) {
   DeviceAllocation tree_alloc = snode_tree_allocs_[tree_id];
   return tree_alloc.get_ptr();
@@ -567,6 +714,7 @@ DevicePtr LlvmProgramImpl::get_snode_tree_device_ptr(int tree_id) {
 DeviceAllocation LlvmProgramImpl::allocate_memory_ndarray(
     std::size_t alloc_size,
     uint64 *result_buffer) {
+  synchronize();
   TaichiLLVMContext *tlctx = nullptr;
   if (llvm_context_device) {
     tlctx = llvm_context_device.get();
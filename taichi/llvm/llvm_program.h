@@ -3,7 +3,10 @@
 #include "taichi/inc/constants.h"
 #include "taichi/program/compile_config.h"
 #include "taichi/common/logging.h"
+#include "taichi/backends/cpu/aot_data.h"
+#include "taichi/backends/cpu/cpu_kernel_stream.h"
 #include "taichi/llvm/llvm_context.h"
+#include "taichi/llvm/llvm_offline_cache.h"
 #include "taichi/runtime/runtime.h"
 #include "taichi/system/threading.h"
 #include "llvm/IR/Module.h"
@@ -55,8 +58,31 @@ class LlvmProgramImpl : public ProgramImpl {
     return static_cast<LLVMRuntime *>(llvm_runtime);
   }
 
+  /**
+   * Returns the offline cache of compiled CPU kernels, or nullptr if
+   * CompileConfig::offline_cache is disabled.
+   */
+  LlvmOfflineCache *get_offline_cache() {
+    return offline_cache_.get();
+  }
+
+  ThreadPool *get_thread_pool() {
+    return thread_pool.get();
+  }
+
+  /**
+   * Returns the stream CPU kernels are launched on, or nullptr if
+   * CompileConfig::cpu_async_launch is disabled.
+   */
+  cpu::CpuKernelStream *get_cpu_stream() {
+    return cpu_stream_.get();
+  }
+
   FunctionType compile(Kernel *kernel, OffloadedStmt *offloaded) override;
 
+  std::vector<FunctionType> compile_batch(
+      const std::vector<Kernel *> &kernels) override;
+
   void compile_snode_tree_types(
       SNodeTree *tree,
       std::vector<std::unique_ptr<SNodeTree>> &snode_trees) override;
@@ -84,6 +110,7 @@ class LlvmProgramImpl : public ProgramImpl {
       uint64 *result_buffer) override;
 
   virtual void destroy_snode_tree(SNodeTree *snode_tree) override {
+    synchronize();
     snode_tree_buffer_manager->destroy(snode_tree);
   }
 
@@ -127,6 +154,7 @@ class LlvmProgramImpl : public ProgramImpl {
       tlctx = llvm_context_host.get();
     }
 
+    synchronize();
     auto runtime = tlctx->runtime_jit_module;
     runtime->call<void *, Args...>("runtime_" + key, llvm_runtime,
                                    std::forward<Args>(args)...);
@@ -136,9 +164,7 @@ class LlvmProgramImpl : public ProgramImpl {
 
   void print_list_manager_info(void *list_manager, uint64 *result_buffer);
 
-  std::unique_ptr<AotModuleBuilder> make_aot_module_builder() override {
-    TI_NOT_IMPLEMENTED;
-  }
+  std::unique_ptr<AotModuleBuilder> make_aot_module_builder() override;
 
   virtual Device *get_compute_device() override {
     return device_.get();
@@ -153,12 +179,20 @@ class LlvmProgramImpl : public ProgramImpl {
   std::unique_ptr<Runtime> runtime_mem_info{nullptr};
   std::unique_ptr<SNodeTreeBufferManager> snode_tree_buffer_manager{nullptr};
   std::unique_ptr<StructCompiler> struct_compiler_{nullptr};
+  std::unique_ptr<LlvmOfflineCache> offline_cache_{nullptr};
+  // Compiles offloaded tasks concurrently, see
+  // CompileConfig::num_compile_threads.
+  std::unique_ptr<ThreadPool> compile_thread_pool_{nullptr};
+  // Declared after |thread_pool| so that it is destroyed first.
+  std::unique_ptr<cpu::CpuKernelStream> cpu_stream_{nullptr};
   void *llvm_runtime{nullptr};
   void *preallocated_device_buffer{nullptr};  // TODO: move to memory allocator
 
   DeviceAllocation preallocated_device_buffer_alloc{kDeviceNullAllocation};
 
   std::unordered_map<int, DeviceAllocation> snode_tree_allocs_;
+  // SNode trees materialized on CPU, recorded for AOT modules.
+  std::vector<cpu::CompiledSNodeTree> compiled_snode_trees_;
 
   std::unique_ptr<Device> device_;
   cuda::CudaDevice *cuda_device();
@@ -118,7 +118,8 @@ void ParallelExecutor::worker_loop() {
   }
 }
 
-void ExecutionQueue::enqueue(const TaskLaunchRecord &ker) {
+void ExecutionQueue::enqueue(const TaskLaunchRecord &ker,
+                             const std::vector<int> &deps) {
   auto h = ker.ir_handle.hash();
   auto *stmt = ker.stmt();
   auto kernel = ker.kernel;
@@ -165,12 +166,60 @@ void ExecutionQueue::enqueue(const TaskLaunchRecord &ker) {
     ir_bank_->insert_to_trash_bin(std::move(cloned_stmt));
   }
 
-  launch_worker.enqueue(
-      [kernel_name, async_func, context = ker.context]() mutable {
-        TI_TIMELINE(kernel_name);
-        auto func = async_func->get();
-        func(context);
-      });
+  auto launch = [kernel_name, async_func, context = ker.context]() mutable {
+    TI_TIMELINE(kernel_name);
+    auto func = async_func->get();
+    func(context);
+  };
+  if (launch_worker.get_num_threads() == 1) {
+    launch_worker.enqueue(launch);
+    return;
+  }
+
+  const int id = ker.id;
+  bool ready = false;
+  {
+    std::lock_guard<std::mutex> _(launch_mut_);
+    auto &pending = pending_launches_[id];
+    pending.launch = std::move(launch);
+    for (int dep : deps) {
+      // Tasks no longer in |pending_launches_| have finished.
+      auto it = pending_launches_.find(dep);
+      if (it != pending_launches_.end()) {
+        it->second.dependents.push_back(id);
+        pending.num_unfinished_deps++;
+      }
+    }
+    ready = (pending.num_unfinished_deps == 0);
+  }
+  if (ready) {
+    launch_worker.enqueue([this, id]() { run_launch(id); });
+  }
+}
+
+void ExecutionQueue::run_launch(int id) {
+  ParallelExecutor::TaskType launch;
+  {
+    std::lock_guard<std::mutex> _(launch_mut_);
+    launch = std::move(pending_launches_.at(id).launch);
+  }
+  launch();
+  std::vector<int> ready;
+  {
+    std::lock_guard<std::mutex> _(launch_mut_);
+    auto it = pending_launches_.find(id);
+    for (int dependent : it->second.dependents) {
+      if (--pending_launches_.at(dependent).num_unfinished_deps == 0) {
+        ready.push_back(dependent);
+      }
+    }
+    pending_launches_.erase(it);
+  }
+  // Enqueued before this task returns, so that launch_worker.flush() cannot
+  // see an empty queue while some tasks are still waiting.
+  for (int dependent : ready) {
+    launch_worker.enqueue([this, dependent]() { run_launch(dependent); });
+  }
 }
 
 void ExecutionQueue::synchronize() {
@@ -180,16 +229,26 @@ void ExecutionQueue::synchronize() {
 
 ExecutionQueue::ExecutionQueue(
     IRBank *ir_bank,
-    const BackendExecCompilationFunc &compile_to_backend)
+    const BackendExecCompilationFunc &compile_to_backend,
+    int num_launch_workers)
     : compilation_workers("compiler", 4),  // TODO: remove 4
-      launch_worker("launcher", 1),
+      launch_worker("launcher", num_launch_workers),
       ir_bank_(ir_bank),
       compile_to_backend_(compile_to_backend) {
 }
 
+int AsyncEngine::get_num_launch_workers(const CompileConfig *config) {
+  // GPU tasks are launched into a single stream anyway, and the kernel
+  // profiler expects one task at a time.
+  if (!arch_is_cpu(config->arch) || config->kernel_profiler) {
+    return 1;
+  }
+  return std::max(config->async_max_concurrent_tasks, 1);
+}
+
 AsyncEngine::AsyncEngine(const CompileConfig *const config,
                          const BackendExecCompilationFunc &compile_to_backend)
-    : queue(&ir_bank_, compile_to_backend),
+    : queue(&ir_bank_, compile_to_backend, get_num_launch_workers(config)),
       config_(config),
       sfg(std::make_unique<StateFlowGraph>(this, &ir_bank_, config)) {
   Timeline::get_this_thread_instance().set_name("host");
@@ -244,7 +303,6 @@ void AsyncEngine::flush() {
   TI_AUTO_PROF;
   TI_AUTO_TIMELINE;
 
-  bool modified = true;
   sfg->reid_nodes();
   sfg->reid_pending_nodes();
   sfg->sort_node_edges();
@@ -254,6 +312,31 @@ void AsyncEngine::flush() {
   if (config_->debug) {
     sfg->verify();
   }
+  if (config_->async_opt_trace_cache && sfg->num_pending_tasks() > 0) {
+    optimize_sfg_cached();
+  } else {
+    optimize_sfg();
+  }
+  debug_sfg("final");
+  {
+    TI_TIMELINE("enqueue");
+    const bool concurrent = queue.launch_worker.get_num_threads() > 1;
+    std::vector<std::vector<int>> deps;
+    auto tasks = sfg->extract_to_execute(concurrent ? &deps : nullptr);
+    TI_TRACE("Ended up with {} nodes", tasks.size());
+    for (int i = 0; i < (int)tasks.size(); i++) {
+      if (concurrent) {
+        queue.enqueue(tasks[i], deps[i]);
+      } else {
+        queue.enqueue(tasks[i]);
+      }
+    }
+  }
+  flush_counter_++;
+}
+
+void AsyncEngine::optimize_sfg() {
+  bool modified = true;
   for (int pass = 0; pass < config_->async_opt_passes && modified; pass++) {
     modified = false;
     if (config_->async_opt_activation_demotion) {
@@ -290,16 +373,42 @@ void AsyncEngine::flush() {
     }
     sfg->verify();
   }
-  debug_sfg("final");
-  {
-    TI_TIMELINE("enqueue");
-    auto tasks = sfg->extract_to_execute();
-    TI_TRACE("Ended up with {} nodes", tasks.size());
-    for (auto &task : tasks) {
-      queue.enqueue(task);
+}
+
+void AsyncEngine::optimize_sfg_cached() {
+  constexpr int kMaxCachedTraces = 256;
+  auto trace = sfg->get_pending_trace();
+  auto pending = sfg->get_pending_tasks();
+  auto it = trace_cache_.find(trace);
+  if (it != trace_cache_.end()) {
+    stat.add("sfg_trace_cache_hits");
+    std::vector<TaskLaunchRecord> tasks;
+    tasks.reserve(it->second.size());
+    for (const auto &[index, ir_handle] : it->second) {
+      tasks.push_back(pending[index]->rec);
+      tasks.back().ir_handle = ir_handle;
     }
+    sfg->replace_pending_tasks(tasks);
+    return;
   }
-  flush_counter_++;
+  stat.add("sfg_trace_cache_misses");
+  // The passes modify the records in place or delete them, so the optimized
+  // tasks can be told apart by their ids.
+  std::unordered_map<int, int> index_of;
+  for (int i = 0; i < (int)pending.size(); i++) {
+    index_of[pending[i]->rec.id] = i;
+  }
+  optimize_sfg();
+  std::vector<std::pair<int, IRHandle>> optimized;
+  for (auto *node : sfg->get_pending_tasks()) {
+    if (!node->rec.empty()) {
+      optimized.emplace_back(index_of.at(node->rec.id), node->rec.ir_handle);
+    }
+  }
+  if (trace_cache_.size() >= kMaxCachedTraces) {
+    trace_cache_.clear();
+  }
+  trace_cache_.emplace(std::move(trace), std::move(optimized));
 }
 
 void AsyncEngine::debug_sfg(const std::string &stage) {
@@ -3,6 +3,7 @@
 #include <deque>
 #include <functional>
 #include <future>
+#include <map>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
@@ -76,18 +77,24 @@ class ParallelExecutor {
 using BackendExecCompilationFunc =
     std::function<FunctionType(Kernel &, OffloadedStmt *)>;
 
-// In charge of (parallel) compilation to binary and (serial) kernel launching
+// In charge of (parallel) compilation to binary and kernel launching. With
+// more than one launch worker, a task is launched as soon as the tasks it
+// depends on have finished, so independent tasks may run concurrently.
 class ExecutionQueue {
  public:
   std::mutex mut;
 
   ParallelExecutor compilation_workers;  // parallel compilation
-  ParallelExecutor launch_worker;        // serial launching
+  ParallelExecutor launch_worker;
 
   explicit ExecutionQueue(IRBank *ir_bank,
-                          const BackendExecCompilationFunc &compile_to_backend);
+                          const BackendExecCompilationFunc &compile_to_backend,
+                          int num_launch_workers = 1);
 
-  void enqueue(const TaskLaunchRecord &ker);
+  // Launches |ker| after the tasks with their TaskLaunchRecord::id in |deps|
+  // that are still in the queue. |deps| is ignored with a single launch
+  // worker, which launches the tasks in order.
+  void enqueue(const TaskLaunchRecord &ker, const std::vector<int> &deps = {});
 
   void compile_task() {
   }
@@ -123,6 +130,20 @@ class ExecutionQueue {
   };
   std::unordered_map<uint64, AsyncCompiledFunc> compiled_funcs_;
 
+  struct PendingLaunch {
+    ParallelExecutor::TaskType launch;
+    int num_unfinished_deps{0};
+    // The IDs of the tasks waiting for this one.
+    std::vector<int> dependents;
+  };
+
+  // Launches the task with |id| and then the dependents it unblocks.
+  void run_launch(int id);
+
+  // The tasks enqueued but not finished yet, keyed by TaskLaunchRecord::id.
+  std::unordered_map<int, PendingLaunch> pending_launches_;
+  std::mutex launch_mut_;
+
   IRBank *ir_bank_;  // not owned
   BackendExecCompilationFunc compile_to_backend_;
 };
@@ -153,7 +174,17 @@ class AsyncEngine {
 
   void debug_sfg(const std::string &suffix);
 
+  // The number of tasks that may execute at the same time.
+  static int get_num_launch_workers(const CompileConfig *config);
+
  private:
+  // Runs the optimization passes over the pending tasks of |sfg|.
+  void optimize_sfg();
+
+  // Reuses the result of optimize_sfg() when the pending tasks make the same
+  // trace as before, see StateFlowGraph::get_pending_trace().
+  void optimize_sfg_cached();
+
   IRBank ir_bank_;
 
   struct KernelMeta {
@@ -169,6 +200,11 @@ class AsyncEngine {
   };
 
   std::unordered_map<const Kernel *, KernelMeta> kernel_metas_;
+  // Maps a trace of pending tasks to the tasks optimize_sfg() turned them
+  // into: the position of the pending task whose record is used, and its
+  // optimized IR.
+  std::map<std::vector<uint64>, std::vector<std::pair<int, IRHandle>>>
+      trace_cache_;
   // How many times we have flushed
   int flush_counter_{0};
   // How many times we have synchronized
@@ -241,6 +241,11 @@ TaskMeta *get_task_meta(IRBank *ir_bank, const TaskLaunchRecord &t) {
       meta.output_states.insert(
           ir_bank->get_async_state(clear_list->snode, AsyncState::Type::list));
     }
+    if (stmt->is<ExternalPtrStmt>() || stmt->is<RandStmt>() ||
+        stmt->is<PrintStmt>() || stmt->is<AssertStmt>() ||
+        stmt->is<ExternalFuncCallStmt>() || stmt->is<ReturnStmt>()) {
+      meta.has_untracked_side_effects = true;
+    }
     return false;
   });
 
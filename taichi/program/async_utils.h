@@ -217,6 +217,11 @@ struct TaskMeta {
 
   // element_wise[s] OR loop_unique[s] covers s => surjective access on s
 
+  // Whether the task touches anything that has no AsyncState, such as
+  // external arrays, random states, the print buffer or the return buffer.
+  // Such tasks never execute concurrently with each other.
+  bool has_untracked_side_effects{false};
+
   void print() const;
 };
 
@@ -12,7 +12,6 @@ CompileConfig::CompileConfig() {
   print_ir = false;
   print_preprocessed_ir = false;
   print_accessor_ir = false;
-  print_evaluator_ir = false;
   print_benchmark_stat = false;
   use_llvm = true;
   demote_dense_struct_fors = true;
@@ -48,6 +47,12 @@ CompileConfig::CompileConfig() {
   saturating_grid_dim = 0;
   max_block_dim = 0;
   cpu_max_num_threads = std::thread::hardware_concurrency();
+  cpu_pin_threads = false;
+  cpu_node_allocator_cache = false;
+  cpu_gc_lazy_zero_fill = false;
+  cpu_deterministic_listgen = true;
+  cpu_range_for_schedule = "static";
+  cpu_simd_range_for = false;
   random_seed = 0;
 
   // LLVM backend options:
@@ -55,14 +60,20 @@ CompileConfig::CompileConfig() {
   print_kernel_llvm_ir = false;
   print_kernel_nvptx = false;
   print_kernel_llvm_ir_optimized = false;
+  offline_cache = false;
+  offline_cache_file_path = get_repo_dir() + "ticache";
+  offline_cache_max_size_MB = 1024;
+  cpu_async_launch = false;
+  cpu_aot_link_cmd = "gcc -shared -fPIC -o {} {}";
+  num_compile_threads = 0;
 
   // CUDA backend options:
   device_memory_GB = 1;  // by default, preallocate 1 GB GPU memory
   device_memory_fraction = 0.0;
 
   // C backend options:
-  cc_compile_cmd = "gcc -Wc99-c11-compat -c -o '{}' '{}' -O3";
-  cc_link_cmd = "gcc -shared -fPIC -o '{}' '{}'";
+  cc_compile_cmd = "gcc -Wc99-c11-compat -c -o {} {} -O3";
+  cc_link_cmd = "gcc -shared -fPIC -o {} {}";
 
   // Opengl backend options:
   allow_nv_shader_extension = true;
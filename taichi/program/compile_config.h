@@ -18,7 +18,6 @@ struct CompileConfig {
   bool print_preprocessed_ir;
   bool print_ir;
   bool print_accessor_ir;
-  bool print_evaluator_ir;
   bool print_benchmark_stat;
   bool serial_schedule;
   bool simplify_before_lower_access;
@@ -55,6 +54,22 @@ struct CompileConfig {
   int saturating_grid_dim;
   int max_block_dim;
   int cpu_max_num_threads;
+  // Pin CPU worker threads to cores, NUMA node by node.
+  bool cpu_pin_threads;
+  // Give each CPU thread a cache of pointer/dynamic SNode cells.
+  bool cpu_node_allocator_cache;
+  // Zero-fill sparse SNode cells when they are reused rather than during GC.
+  bool cpu_gc_lazy_zero_fill;
+  // Keep the element lists of struct-fors in serial order when they are
+  // generated on multiple CPU threads.
+  bool cpu_deterministic_listgen;
+  // How CPU range-for loops hand out their iterations to threads: "static",
+  // "dynamic", "guided", or "auto" to time candidate schedules on the first
+  // launches of each loop and keep the fastest.
+  std::string cpu_range_for_schedule;
+  // Generate range-for bodies that run simd_width consecutive iterations in a
+  // loop vectorized by LLVM, instead of one iteration per call.
+  bool cpu_simd_range_for;
   int random_seed;
 
   // LLVM backend options:
@@ -62,12 +77,26 @@ struct CompileConfig {
   bool print_kernel_llvm_ir;
   bool print_kernel_llvm_ir_optimized;
   bool print_kernel_nvptx;
+  // Persist compiled CPU kernels on disk and reuse them across processes.
+  bool offline_cache;
+  std::string offline_cache_file_path;
+  int offline_cache_max_size_MB;  // 0 means unlimited
+  // Launch CPU kernels on a stream without waiting for them to finish.
+  bool cpu_async_launch;
+  // Links the object files of a CPU AOT module into a shared object. The
+  // output path and the object paths are substituted already shell-quoted.
+  std::string cpu_aot_link_cmd;
+  // Compiles the offloaded tasks of CPU kernels as separate LLVM modules on
+  // this many threads. 0 compiles each kernel as one module on the calling
+  // thread.
+  int num_compile_threads;
 
   // CUDA backend options:
   float64 device_memory_GB;
   float64 device_memory_fraction;
 
   // C backend options:
+  // The paths substituted into these commands are already shell-quoted.
   std::string cc_compile_cmd;
   std::string cc_link_cmd;
 
@@ -82,11 +111,17 @@ struct CompileConfig {
   bool async_opt_activation_demotion{true};
   bool async_opt_dse{true};
   bool async_listgen_fast_filtering{true};
+  // Reuse the optimized tasks when a flush sees the same tasks as an earlier
+  // one.
+  bool async_opt_trace_cache{true};
   std::string async_opt_intermediate_file;
   // Setting 0 effectively means do not automatically flush
   int async_flush_every{50};
   // Setting 0 effectively means unlimited
   int async_max_fuse_per_task{1};
+  // How many independent tasks may execute at the same time on CPUs. Tasks
+  // are still ordered by the edges of the state flow graph.
+  int async_max_concurrent_tasks{1};
 
   bool quant_opt_store_fusion{true};
   bool quant_opt_atomic_demotion{true};
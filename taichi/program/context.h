@@ -10,6 +10,17 @@ namespace lang {
 
 struct LLVMRuntime;
 
+// How the iterations of a CPU range-for loop are handed out to threads.
+enum CpuRangeForSchedule : int32 {
+  // Fixed blocks of block_dim iterations, balanced by work stealing.
+  kCpuRangeForStatic = 0,
+  // Each thread repeatedly takes the next block_dim iterations.
+  kCpuRangeForDynamic = 1,
+  // Like dynamic, but blocks shrink from a share of the remaining iterations
+  // down to block_dim.
+  kCpuRangeForGuided = 2,
+};
+
 // "RuntimeContext" holds necessary data for kernel body execution, such as a
 // pointer to the LLVMRuntime struct, kernel arguments, and the thread id (if on
 // CPU).
@@ -17,7 +28,15 @@ struct RuntimeContext {
   LLVMRuntime *runtime;
   uint64 args[taichi_max_num_args_total];
   int32 extra_args[taichi_max_num_args_extra][taichi_max_num_indices];
-  int32 cpu_thread_id;
+  // Id of the CPU thread pool worker running the task, or -1 for contexts
+  // created by the host (e.g. for serial tasks), which may run concurrently
+  // on different launch threads.
+  int32 cpu_thread_id{-1};
+  // Override the scheduling of CPU range-for loops chosen at codegen time,
+  // when nonzero. Set by the host, e.g. while autotuning.
+  int32 cpu_range_for_block_dim{0};
+  int32 cpu_range_for_num_threads{0};
+  int32 cpu_range_for_schedule{0};
 
   static constexpr size_t extra_args_size = sizeof(extra_args);
 
@@ -12,22 +12,15 @@ TLANG_NAMESPACE_BEGIN
 namespace {
 
 uint64 hash(IRNode *stmt) {
+  TI_AUTO_PROF;
   TI_ASSERT(stmt);
-  // TODO: upgrade this using IR comparisons
-  std::string serialized;
-  irpass::re_id(stmt);
-  irpass::print(stmt, &serialized);
+  uint64 ret = irpass::analysis::hash_statements(stmt);
 
   // TODO: separate kernel from IR template
   auto *kernel = stmt->get_kernel();
   if (!kernel->args.empty()) {
     // We need to record the kernel's name if it has arguments.
-    serialized += stmt->get_kernel()->name;
-  }
-
-  uint64 ret = 0;
-  for (uint64 i = 0; i < serialized.size(); i++) {
-    ret = ret * 100000007UL + (uint64)serialized[i];
+    ret = ret * 100000007UL + std::hash<std::string>()(kernel->name);
   }
   return ret;
 }
@@ -55,6 +48,14 @@ bool IRBank::insert(std::unique_ptr<IRNode> &&ir, uint64 hash) {
     ir_bank_.emplace(handle, std::move(ir));
     return true;
   }
+  // Tasks are identified by their hash alone. Comparing the IRs on every
+  // duplicate insert would give back most of the cost saved by hashing, so
+  // collisions are only checked for in debug mode.
+  if (ir->get_kernel()->program->config.debug) {
+    TI_ASSERT_INFO(irpass::analysis::same_statements(
+                       insert_place->second.get(), ir.get()),
+                   "Different IRs with the same hash {}", hash);
+  }
   insert_to_trash_bin(std::move(ir));
   return false;
 }
@@ -115,8 +116,6 @@ IRHandle IRBank::fuse(IRHandle handle_a, IRHandle handle_b, Kernel *kernel) {
 
   irpass::full_simplify(task_a, kernel->program->config,
                         {/*after_lower_access=*/false, kernel->program});
-  // For now, re_id is necessary for the hash to be correct.
-  irpass::re_id(task_a);
 
   auto h = get_hash(task_a);
   result = IRHandle(task_a, h);
@@ -31,7 +31,6 @@ Kernel::Kernel(Program &program,
   }
 #endif
   is_accessor = false;
-  is_evaluator = false;
   compiled_ = nullptr;
   context = std::make_unique<FrontendContext>();
   ir = context->get_root();
@@ -66,7 +65,6 @@ Kernel::Kernel(Program &program,
   this->ir = std::move(ir);
   this->program = &program;
   is_accessor = false;
-  is_evaluator = false;
   compiled_ = nullptr;
   ir_is_ast_ = false;  // CHI IR
   this->ir->as<Block>()->kernel = this;
@@ -88,6 +86,24 @@ void Kernel::compile() {
   compiled_ = program->compile(*this);
 }
 
+void Kernel::compile_batch(Program *program,
+                           const std::vector<Kernel *> &kernels) {
+  std::vector<Kernel *> pending;
+  for (auto *kernel : kernels) {
+    if (!kernel->compiled() &&
+        std::find(pending.begin(), pending.end(), kernel) == pending.end()) {
+      pending.push_back(kernel);
+    }
+  }
+  if (pending.empty()) {
+    return;
+  }
+  auto compiled = program->compile_batch(pending);
+  for (int i = 0; i < (int)pending.size(); i++) {
+    pending[i]->compiled_ = std::move(compiled[i]);
+  }
+}
+
 void Kernel::lower(bool to_executable) {
   TI_ASSERT(!lowered_);
   TI_ASSERT(supports_lowering(arch));
@@ -95,8 +111,7 @@ void Kernel::lower(bool to_executable) {
   CurrentCallableGuard _(program, this);
   auto config = program->config;
   bool verbose = config.print_ir;
-  if ((is_accessor && !config.print_accessor_ir) ||
-      (is_evaluator && !config.print_evaluator_ir))
+  if (is_accessor && !config.print_accessor_ir)
     verbose = false;
 
   if (config.print_preprocessed_ir) {
@@ -127,7 +142,7 @@ void Kernel::lower(bool to_executable) {
 }
 
 void Kernel::operator()(LaunchContextBuilder &ctx_builder) {
-  if (!program->config.async_mode || this->is_evaluator) {
+  if (!program->config.async_mode) {
     if (!compiled_) {
       compile();
     }
@@ -136,7 +151,24 @@ void Kernel::operator()(LaunchContextBuilder &ctx_builder) {
       account_for_offloaded(offloaded->as<OffloadedStmt>());
     }
 
-    compiled_(ctx_builder.get_context());
+    bool launched = false;
+#ifdef TI_WITH_LLVM
+    if (arch_is_cpu(arch) && arch_is_cpu(program->config.arch) &&
+        program->get_llvm_program_impl()->get_cpu_stream()) {
+      // |ctx_builder| does not outlive this call, so the launch works on a
+      // copy of the context. The caller is responsible for synchronizing
+      // before reading the results or releasing external arrays.
+      program->get_llvm_program_impl()->get_cpu_stream()->enqueue(
+          [compiled = compiled_, ctx = ctx_builder.get_context()]() mutable {
+            compiled(ctx);
+          });
+      program->sync = false;
+      launched = true;
+    }
+#endif
+    if (!launched) {
+      compiled_(ctx_builder.get_context());
+    }
 
     program->sync = (program->sync && arch_is_cpu(arch));
     // Note that Kernel::arch may be different from program.config.arch
@@ -268,12 +300,10 @@ void Kernel::LaunchContextBuilder::set_arg_raw(int arg_id, uint64 d) {
                  "Assigning scalar value to external (numpy) array argument is "
                  "not allowed.");
 
-  if (!kernel_->is_evaluator) {
-    ActionRecorder::get_instance().record(
-        "set_arg_raw",
-        {ActionArg("kernel_name", kernel_->name), ActionArg("arg_id", arg_id),
-         ActionArg("val", (int64)d)});
-  }
+  ActionRecorder::get_instance().record(
+      "set_arg_raw",
+      {ActionArg("kernel_name", kernel_->name), ActionArg("arg_id", arg_id),
+       ActionArg("val", (int64)d)});
   ctx_->set_arg<uint64>(arg_id, d);
 }
 
@@ -349,7 +379,7 @@ void Kernel::set_arch(Arch arch) {
 }
 
 void Kernel::account_for_offloaded(OffloadedStmt *stmt) {
-  if (is_evaluator || is_accessor)
+  if (is_accessor)
     return;
   auto task_type = stmt->task_type;
   stat.add("launched_tasks", 1.0);
@@ -9,6 +9,7 @@
 TLANG_NAMESPACE_BEGIN
 
 class Program;
+class LaunchGraph;
 
 class Kernel : public Callable {
  public:
@@ -17,7 +18,6 @@ class Kernel : public Callable {
   Arch arch;
 
   bool is_accessor{false};
-  bool is_evaluator{false};
   bool grad{false};
 
   class LaunchContextBuilder {
@@ -70,6 +70,20 @@ class Kernel : public Callable {
 
   void compile();
 
+  bool compiled() const {
+    return compiled_ != nullptr;
+  }
+
+  /**
+   * Compiles those of |kernels| that are not compiled yet, so that their first
+   * launches do not pay for compilation.
+   *
+   * With CompileConfig::num_compile_threads > 0, the kernels are compiled
+   * concurrently.
+   */
+  static void compile_batch(Program *program,
+                            const std::vector<Kernel *> &kernels);
+
   /**
    * Lowers |ir| to CHI IR level
    *
@@ -100,6 +114,9 @@ class Kernel : public Callable {
   static bool supports_lowering(Arch arch);
 
  private:
+  // Replays |compiled_| directly.
+  friend class LaunchGraph;
+
   // True if |ir| is a frontend AST. False if it's already offloaded to CHI IR.
   bool ir_is_ast_{false};
   // The closure that, if invoked, lauches the backend kernel (shader)
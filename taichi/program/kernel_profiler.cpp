@@ -1,5 +1,9 @@
 #include "kernel_profiler.h"
 
+#include <chrono>
+#include <unordered_map>
+
+#include "taichi/system/threading.h"
 #include "taichi/system/timer.h"
 #include "taichi/backends/cuda/cuda_driver.h"
 #include "taichi/backends/cuda/cuda_profiler.h"
@@ -26,7 +30,7 @@ bool KernelProfileStatisticalResult::operator<(
 void KernelProfilerBase::profiler_start(KernelProfilerBase *profiler,
                                         const char *kernel_name) {
   TI_ASSERT(profiler);
-  profiler->start(std::string(kernel_name));
+  profiler->start_task(kernel_name);
 }
 
 void KernelProfilerBase::profiler_stop(KernelProfilerBase *profiler) {
@@ -34,6 +38,12 @@ void KernelProfilerBase::profiler_stop(KernelProfilerBase *profiler) {
   profiler->stop();
 }
 
+void KernelProfilerBase::profiler_add_iterations(KernelProfilerBase *profiler,
+                                                 int64 n) {
+  TI_ASSERT(profiler);
+  profiler->add_iterations(n);
+}
+
 // TODO : deprecated
 void KernelProfilerBase::query(const std::string &kernel_name,
                                int &counter,
@@ -66,10 +76,48 @@ double KernelProfilerBase::get_total_time() const {
 }
 
 namespace {
-// A simple profiler that uses Time::get_time()
+// A profiler that uses the host clock, for the CPU backends and as the
+// fallback of the others. Launches only intern the task name into an id and
+// write a record into a preallocated ring buffer; the traced records with
+// their names are built in sync().
 class DefaultProfiler : public KernelProfilerBase {
  public:
+  DefaultProfiler() : records_(new Record[kMaxPendingRecords]) {
+    reset_base_time();
+  }
+
   void sync() override {
+    auto &timeline = Timeline::get_this_thread_instance();
+    const bool timeline_enabled = Timelines::get_instance().get_enabled();
+    if (num_records_ - num_synced_records_ > kMaxPendingRecords) {
+      TI_WARN(
+          "The kernel profiler dropped the oldest {} records; call "
+          "ti.print_kernel_profile_info() more often to keep them.",
+          num_records_ - num_synced_records_ - kMaxPendingRecords);
+      num_synced_records_ = num_records_ - kMaxPendingRecords;
+    }
+    for (; num_synced_records_ < num_records_; num_synced_records_++) {
+      const auto &rec = records_[num_synced_records_ % kMaxPendingRecords];
+      KernelProfileTracedRecord record;
+      record.name = task_names_[rec.task_id];
+      record.kernel_elapsed_time_in_ms = (rec.end_ns - rec.start_ns) * 1e-6;
+      record.time_since_base = (rec.start_ns - base_ns_) * 1e-6;
+      record.grid_size = rec.grid_size;
+      record.block_size = rec.block_size;
+      record.iterations = rec.iterations;
+      record.load_imbalance = rec.load_imbalance;
+      traced_records_.push_back(record);
+      if (timeline_enabled) {
+        // On the clock of Timeline::Guard, so that the tasks line up with the
+        // host events in Timelines::save().
+        timeline.insert_event({record.name, /*begin=*/true,
+                               base_time_ + (rec.start_ns - base_ns_) * 1e-9,
+                               "cpu"});
+        timeline.insert_event({record.name, /*begin=*/false,
+                               base_time_ + (rec.end_ns - base_ns_) * 1e-9,
+                               "cpu"});
+      }
+    }
   }
 
   void clear() override {
@@ -77,38 +125,154 @@ class DefaultProfiler : public KernelProfilerBase {
     total_time_ms_ = 0;
     traced_records_.clear();
     statistical_results_.clear();
+    std::fill(result_index_.begin(), result_index_.end(), -1);
+    num_synced_records_ = num_records_;
+    reset_base_time();
+  }
+
+  void set_thread_pool(ThreadPool *pool) override {
+    pool_ = pool;
+    if (pool_) {
+      pool_->set_profiling(true);
+      busy_ns_.resize(pool_->max_num_threads);
+    }
   }
 
   void start(const std::string &kernel_name) override {
-    start_t_ = Time::get_time();
-    event_name_ = kernel_name;
+    auto it = task_ids_.find(kernel_name);
+    if (it == task_ids_.end()) {
+      it = task_ids_.emplace(kernel_name, add_task(kernel_name)).first;
+    }
+    start_id(it->second);
   }
 
-  void stop() override {
-    auto t = Time::get_time() - start_t_;
-    auto ms = t * 1000.0;
-    // trace record
-    KernelProfileTracedRecord record;
-    record.name = event_name_;
-    record.kernel_elapsed_time_in_ms = ms;
-    traced_records_.push_back(record);
-    // count record
-    auto it =
-        std::find_if(statistical_results_.begin(), statistical_results_.end(),
-                     [&](KernelProfileStatisticalResult &r) {
-                       return r.name == event_name_;
-                     });
-    if (it == statistical_results_.end()) {
-      statistical_results_.emplace_back(event_name_);
-      it = std::prev(statistical_results_.end());
+  void start_task(const char *task_name) override {
+    // Task names are constants of the kernels' modules, which stay alive
+    // with the program, so their addresses identify them.
+    auto it = task_ids_by_address_.find(task_name);
+    if (it == task_ids_by_address_.end()) {
+      std::string name(task_name);
+      auto name_it = task_ids_.find(name);
+      int id = name_it != task_ids_.end() ? name_it->second : add_task(name);
+      task_ids_.emplace(name, id);
+      it = task_ids_by_address_.emplace(task_name, id).first;
     }
-    it->insert_record(ms);
+    start_id(it->second);
+  }
+
+  void add_iterations(int64 n) override {
+    iterations_ += n;
+  }
+
+  void stop() override {
+    const auto end_ns = now_ns();
+    auto &rec = records_[num_records_++ % kMaxPendingRecords];
+    rec.task_id = task_id_;
+    rec.grid_size = launch_grid_size_;
+    rec.block_size = launch_block_size_;
+    rec.iterations = iterations_;
+    rec.load_imbalance = 0;
+    rec.start_ns = start_ns_;
+    rec.end_ns = end_ns;
+
+    const double ms = (end_ns - start_ns_) * 1e-6;
+    auto &result = get_result(task_id_);
+    result.insert_record(ms);
+    result.iterations += iterations_;
     total_time_ms_ += ms;
+
+    if (pool_) {
+      result.worker_time.resize(busy_ns_.size());
+      uint64 max_busy_ns = 0, total_busy_ns = 0;
+      int num_busy_workers = 0;
+      for (int i = 0; i < (int)busy_ns_.size(); i++) {
+        const uint64 busy_ns = pool_->get_busy_time_ns(i) - busy_ns_[i];
+        if (busy_ns > 0) {
+          result.worker_time[i] += busy_ns * 1e-6;
+          max_busy_ns = std::max(max_busy_ns, busy_ns);
+          total_busy_ns += busy_ns;
+          num_busy_workers++;
+        }
+      }
+      if (total_busy_ns > 0) {
+        rec.load_imbalance =
+            (float)((double)max_busy_ns * num_busy_workers / total_busy_ns);
+      }
+    }
   }
 
  private:
-  double start_t_;
-  std::string event_name_;
+  // Launches between two sync() calls beyond this many overwrite the oldest
+  // records.
+  static constexpr int64 kMaxPendingRecords = 1 << 20;
+
+  struct Record {
+    int task_id;
+    int grid_size;
+    int block_size;
+    float load_imbalance;
+    int64 iterations;
+    uint64 start_ns;
+    uint64 end_ns;
+  };
+
+  static uint64 now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void reset_base_time() {
+    base_time_ = Time::get_time();
+    base_ns_ = now_ns();
+  }
+
+  int add_task(const std::string &name) {
+    task_names_.push_back(name);
+    result_index_.push_back(-1);
+    return (int)task_names_.size() - 1;
+  }
+
+  KernelProfileStatisticalResult &get_result(int task_id) {
+    auto &index = result_index_[task_id];
+    if (index == -1) {
+      index = (int)statistical_results_.size();
+      statistical_results_.emplace_back(task_names_[task_id]);
+    }
+    return statistical_results_[index];
+  }
+
+  void start_id(int task_id) {
+    task_id_ = task_id;
+    iterations_ = 0;
+    for (int i = 0; i < (int)busy_ns_.size(); i++) {
+      busy_ns_[i] = pool_->get_busy_time_ns(i);
+    }
+    start_ns_ = now_ns();
+  }
+
+  std::unique_ptr<Record[]> records_;
+  // Records [num_synced_records_, num_records_) are not synced yet.
+  int64 num_records_{0};
+  int64 num_synced_records_{0};
+
+  std::vector<std::string> task_names_;
+  std::unordered_map<std::string, int> task_ids_;
+  std::unordered_map<const char *, int> task_ids_by_address_;
+  // Index of each task's entry in statistical_results_, or -1.
+  std::vector<int> result_index_;
+
+  // The host time and the steady clock at the same instant.
+  double base_time_;
+  uint64 base_ns_;
+
+  ThreadPool *pool_{nullptr};
+  // The busy time of each worker when the current task started.
+  std::vector<uint64> busy_ns_;
+
+  int task_id_{0};
+  int64 iterations_{0};
+  uint64 start_ns_{0};
 };
 
 }  // namespace
@@ -10,6 +10,10 @@
 #include <memory>
 #include <regex>
 
+TI_NAMESPACE_BEGIN
+class ThreadPool;
+TI_NAMESPACE_END
+
 TLANG_NAMESPACE_BEGIN
 
 struct KernelProfileTracedRecord {
@@ -22,6 +26,10 @@ struct KernelProfileTracedRecord {
   // kernel time
   float kernel_elapsed_time_in_ms{0.0};
   float time_since_base{0.0};        // for Timeline
+  // CPU only: range-for iterations executed (0 if unknown), and the busy time
+  // of the busiest thread-pool worker over the average of the busy workers.
+  int64 iterations{0};
+  float load_imbalance{0.0};
   std::string name;                  // kernel name
   std::vector<float> metric_values;  // user selected metrics
 };
@@ -32,6 +40,10 @@ struct KernelProfileStatisticalResult {
   double min;
   double max;
   double total;
+  // CPU only: the totals of the iterations executed and of the busy time of
+  // each thread-pool worker, in ms.
+  int64 iterations{0};
+  std::vector<double> worker_time;
 
   KernelProfileStatisticalResult(const std::string &name)
       : name(name), counter(0), min(0), max(0), total(0) {
@@ -48,6 +60,10 @@ class KernelProfilerBase {
   std::vector<KernelProfileTracedRecord> traced_records_;
   std::vector<KernelProfileStatisticalResult> statistical_results_;
   double total_time_ms_{0};
+  // Recorded with the tasks profiled by backends that choose them at launch
+  // time, such as autotuned CPU range-fors. 0 means unknown.
+  int launch_grid_size_{0};
+  int launch_block_size_{0};
 
  public:
   // Needed for the CUDA backend since we need to know which task to "stop"
@@ -67,6 +83,12 @@ class KernelProfilerBase {
   virtual TaskHandle start_with_handle(const std::string &kernel_name){
       TI_NOT_IMPLEMENTED};
 
+  // Called by CPU kernels with the name of the task, a string constant of the
+  // kernel's module.
+  virtual void start_task(const char *task_name) {
+    start(std::string(task_name));
+  }
+
   static void profiler_start(KernelProfilerBase *profiler,
                              const char *kernel_name);
 
@@ -76,6 +98,16 @@ class KernelProfilerBase {
 
   static void profiler_stop(KernelProfilerBase *profiler);
 
+  // Adds to the iterations executed by the current task.
+  virtual void add_iterations(int64 n) {
+  }
+
+  static void profiler_add_iterations(KernelProfilerBase *profiler, int64 n);
+
+  // Lets CPU profilers record how long each worker of |pool| is busy.
+  virtual void set_thread_pool(ThreadPool *pool) {
+  }
+
   void query(const std::string &kernel_name,
              int &counter,
              double &min,
@@ -86,8 +118,17 @@ class KernelProfilerBase {
     return traced_records_;
   }
 
+  std::vector<KernelProfileStatisticalResult> get_statistical_results() {
+    return statistical_results_;
+  }
+
   double get_total_time() const;
 
+  void set_launch_dims(int grid_size, int block_size) {
+    launch_grid_size_ = grid_size;
+    launch_block_size_ = block_size;
+  }
+
   virtual std::string get_device_name() {
     std::string str(" ");
     return str;
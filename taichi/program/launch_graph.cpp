@@ -0,0 +1,127 @@
+#include "taichi/program/launch_graph.h"
+
+#include "taichi/program/program.h"
+
+#ifdef TI_WITH_LLVM
+#include "taichi/llvm/llvm_program.h"
+#endif
+
+TLANG_NAMESPACE_BEGIN
+
+LaunchGraph::LaunchGraph(Program *program)
+    : program_(program),
+      compiled_(std::make_shared<std::vector<FunctionType>>()) {
+}
+
+int LaunchGraph::add_launch(Kernel *kernel,
+                            Kernel::LaunchContextBuilder &ctx_builder) {
+  TI_ERROR_IF(program_->config.async_mode,
+              "Kernel launches cannot be captured in async mode.");
+  TI_ASSERT(kernel->program == program_);
+  if (!kernel->compiled_) {
+    kernel->compile();
+  }
+  auto compiled = std::make_shared<std::vector<FunctionType>>(*compiled_);
+  compiled->push_back(kernel->compiled_);
+  compiled_ = std::move(compiled);
+  kernels_.push_back(kernel);
+  contexts_.push_back(ctx_builder.get_context());
+  ext_arr_sizes_.emplace_back();
+  for (int i = 0; i < (int)kernel->args.size(); i++) {
+    if (kernel->args[i].is_external_array) {
+      ext_arr_sizes_.back().emplace_back(i, kernel->args[i].size);
+    }
+  }
+  return (int)kernels_.size() - 1;
+}
+
+void LaunchGraph::bind_arg(const std::string &name, int launch_id, int arg_id) {
+  TI_ASSERT(launch_id >= 0 && launch_id < num_launches());
+  auto &args = kernels_[launch_id]->args;
+  TI_ASSERT(arg_id >= 0 && arg_id < (int)args.size());
+  TI_ERROR_IF(args[arg_id].is_external_array,
+              "Argument {} of kernel {} is an external array and cannot be "
+              "updated.",
+              arg_id, kernels_[launch_id]->name);
+  args_[name].push_back({launch_id, arg_id, args[arg_id].dt});
+}
+
+template <typename T>
+void LaunchGraph::set_arg(const std::string &name, T d) {
+  auto it = args_.find(name);
+  TI_ERROR_IF(it == args_.end(), "No argument named \"{}\" in the graph.",
+              name);
+  for (const auto &slot : it->second) {
+    auto &ctx = contexts_[slot.launch_id];
+    auto dt = slot.dt;
+    if (dt->is_primitive(PrimitiveTypeID::f32) ||
+        dt->is_primitive(PrimitiveTypeID::f16)) {
+      // f16 arguments are passed as f32, as in set_arg_float().
+      ctx.set_arg(slot.arg_id, (float32)d);
+    } else if (dt->is_primitive(PrimitiveTypeID::f64)) {
+      ctx.set_arg(slot.arg_id, (float64)d);
+    } else if (dt->is_primitive(PrimitiveTypeID::i32)) {
+      ctx.set_arg(slot.arg_id, (int32)d);
+    } else if (dt->is_primitive(PrimitiveTypeID::i64)) {
+      ctx.set_arg(slot.arg_id, (int64)d);
+    } else if (dt->is_primitive(PrimitiveTypeID::i8)) {
+      ctx.set_arg(slot.arg_id, (int8)d);
+    } else if (dt->is_primitive(PrimitiveTypeID::i16)) {
+      ctx.set_arg(slot.arg_id, (int16)d);
+    } else if (dt->is_primitive(PrimitiveTypeID::u8)) {
+      ctx.set_arg(slot.arg_id, (uint8)d);
+    } else if (dt->is_primitive(PrimitiveTypeID::u16)) {
+      ctx.set_arg(slot.arg_id, (uint16)d);
+    } else if (dt->is_primitive(PrimitiveTypeID::u32)) {
+      ctx.set_arg(slot.arg_id, (uint32)d);
+    } else if (dt->is_primitive(PrimitiveTypeID::u64)) {
+      ctx.set_arg(slot.arg_id, (uint64)d);
+    } else {
+      TI_NOT_IMPLEMENTED
+    }
+  }
+}
+
+void LaunchGraph::set_arg_float(const std::string &name, float64 d) {
+  set_arg(name, d);
+}
+
+void LaunchGraph::set_arg_int(const std::string &name, int64 d) {
+  set_arg(name, d);
+}
+
+void LaunchGraph::run() {
+  const auto arch = program_->config.arch;
+  bool launched = false;
+#ifdef TI_WITH_LLVM
+  auto *stream = arch_is_cpu(arch)
+                     ? program_->get_llvm_program_impl()->get_cpu_stream()
+                     : nullptr;
+  if (stream) {
+    // The whole graph is a single task on the stream. It works on copies of
+    // the contexts so that the arguments can be updated before it runs.
+    stream->enqueue([compiled = compiled_, contexts = contexts_]() mutable {
+      for (int i = 0; i < (int)contexts.size(); i++) {
+        (*compiled)[i](contexts[i]);
+      }
+    });
+    program_->sync = false;
+    launched = true;
+  }
+#endif
+  if (!launched) {
+    for (int i = 0; i < (int)kernels_.size(); i++) {
+      for (const auto &[arg_id, size] : ext_arr_sizes_[i]) {
+        kernels_[i]->args[arg_id].size = size;
+      }
+      (*compiled_)[i](contexts_[i]);
+    }
+  }
+
+  program_->sync = (program_->sync && arch_is_cpu(arch));
+  if (program_->config.debug && (arch_is_cpu(arch) || arch == Arch::cuda)) {
+    program_->check_runtime_error();
+  }
+}
+
+TLANG_NAMESPACE_END
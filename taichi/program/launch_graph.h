@@ -0,0 +1,77 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "taichi/lang_util.h"
+#include "taichi/program/kernel.h"
+#define TI_RUNTIME_HOST
+#include "taichi/program/context.h"
+#undef TI_RUNTIME_HOST
+
+TLANG_NAMESPACE_BEGIN
+
+class Program;
+
+/**
+ * A fixed sequence of kernel launches, captured once and replayed with a
+ * single call.
+ *
+ * Each launch keeps the RuntimeContext it was captured with, so a replay does
+ * not allocate contexts, record arguments or account for offloaded tasks: it
+ * calls the compiled kernels one after another. Scalar arguments bound to a
+ * name can be updated between replays.
+ */
+class LaunchGraph {
+ public:
+  explicit LaunchGraph(Program *program);
+
+  /**
+   * Compiles |kernel| if needed and appends a launch of it with the arguments
+   * set in |ctx_builder|. The kernel is not launched.
+   *
+   * @return The index of the launch.
+   */
+  int add_launch(Kernel *kernel, Kernel::LaunchContextBuilder &ctx_builder);
+
+  // Makes the |arg_id|-th argument of the |launch_id|-th launch updatable
+  // through set_arg_*(|name|, ...). A name can be bound to several arguments.
+  void bind_arg(const std::string &name, int launch_id, int arg_id);
+
+  void set_arg_float(const std::string &name, float64 d);
+
+  void set_arg_int(const std::string &name, int64 d);
+
+  // Replays all launches in the order they were added.
+  void run();
+
+  int num_launches() const {
+    return (int)kernels_.size();
+  }
+
+ private:
+  struct ArgSlot {
+    int launch_id;
+    int arg_id;
+    DataType dt;
+  };
+
+  template <typename T>
+  void set_arg(const std::string &name, T d);
+
+  Program *program_;
+  std::vector<Kernel *> kernels_;
+  // Shared with the replays enqueued on the CPU kernel stream, so it is
+  // replaced rather than modified when a launch is added.
+  std::shared_ptr<const std::vector<FunctionType>> compiled_;
+  std::vector<RuntimeContext> contexts_;
+  // (arg id, size) of the external array arguments of each launch. The CUDA
+  // launcher reads the sizes from the kernel, which launches share.
+  std::vector<std::vector<std::pair<int, uint64>>> ext_arr_sizes_;
+  std::unordered_map<std::string, std::vector<ArgSlot>> args_;
+};
+
+TLANG_NAMESPACE_END
@@ -173,6 +173,16 @@ FunctionType Program::compile(Kernel &kernel, OffloadedStmt *offloaded) {
   return ret;
 }
 
+std::vector<FunctionType> Program::compile_batch(
+    const std::vector<Kernel *> &kernels) {
+  auto start_t = Time::get_time();
+  TI_AUTO_PROF;
+  auto ret = program_impl_->compile_batch(kernels);
+  TI_ASSERT(ret.size() == kernels.size());
+  total_compilation_time_ += Time::get_time() - start_t;
+  return ret;
+}
+
 void Program::materialize_runtime() {
   program_impl_->materialize_runtime(memory_pool_.get(), profiler.get(),
                                      &result_buffer);
@@ -226,6 +236,52 @@ void Program::synchronize() {
   }
 }
 
+uint64 Program::record_event() {
+#ifdef TI_WITH_LLVM
+  if (arch_is_cpu(config.arch)) {
+    if (auto *stream = get_llvm_program_impl()->get_cpu_stream()) {
+      return stream->record_event();
+    }
+  }
+#endif
+  synchronize();
+  return 0;
+}
+
+bool Program::query_event(uint64 event) {
+#ifdef TI_WITH_LLVM
+  if (arch_is_cpu(config.arch)) {
+    if (auto *stream = get_llvm_program_impl()->get_cpu_stream()) {
+      return stream->query(event);
+    }
+  }
+#endif
+  return true;
+}
+
+void Program::wait_event(uint64 event) {
+#ifdef TI_WITH_LLVM
+  if (arch_is_cpu(config.arch)) {
+    if (auto *stream = get_llvm_program_impl()->get_cpu_stream()) {
+      stream->wait(event);
+    }
+  }
+#endif
+}
+
+SparseMatrixBuilder Program::create_sparse_matrix_builder(int rows,
+                                                          int cols,
+                                                          int max_num_triplets,
+                                                          DataType dtype) {
+  TI_ERROR_IF(!arch_is_cpu(config.arch),
+              "SparseMatrix only supports CPU for now.");
+  ThreadPool *thread_pool = nullptr;
+#ifdef TI_WITH_LLVM
+  thread_pool = get_llvm_program_impl()->get_thread_pool();
+#endif
+  return SparseMatrixBuilder(rows, cols, max_num_triplets, dtype, thread_pool);
+}
+
 void Program::async_flush() {
   if (!config.async_mode) {
     TI_WARN("No point calling async_flush() when async mode is disabled.");
@@ -496,7 +552,7 @@ void Program::finalize() {
 }
 
 int Program::default_block_dim(const CompileConfig &config) {
-  if (arch_is_cpu(config.arch)) {
+  if (arch_is_cpu(config.arch) || config.arch == Arch::cc) {
     return config.default_cpu_block_dim;
   } else {
     return config.default_gpu_block_dim;
@@ -32,48 +32,6 @@
 namespace taichi {
 namespace lang {
 
-struct JITEvaluatorId {
-  std::thread::id thread_id;
-  // Note that on certain backends (e.g. CUDA), functions created in one
-  // thread cannot be used in another. Hence the thread_id member.
-  int op;
-  DataType ret, lhs, rhs;
-  bool is_binary;
-
-  UnaryOpType unary_op() const {
-    TI_ASSERT(!is_binary);
-    return (UnaryOpType)op;
-  }
-
-  BinaryOpType binary_op() const {
-    TI_ASSERT(is_binary);
-    return (BinaryOpType)op;
-  }
-
-  bool operator==(const JITEvaluatorId &o) const {
-    return thread_id == o.thread_id && op == o.op && ret == o.ret &&
-           lhs == o.lhs && rhs == o.rhs && is_binary == o.is_binary;
-  }
-};
-
-}  // namespace lang
-}  // namespace taichi
-
-namespace std {
-template <>
-struct hash<taichi::lang::JITEvaluatorId> {
-  std::size_t operator()(
-      taichi::lang::JITEvaluatorId const &id) const noexcept {
-    return ((std::size_t)id.op | (id.ret.hash() << 8) | (id.lhs.hash() << 16) |
-            (id.rhs.hash() << 24) | ((std::size_t)id.is_binary << 31)) ^
-           (std::hash<std::thread::id>{}(id.thread_id) << 32);
-  }
-};
-}  // namespace std
-
-namespace taichi {
-namespace lang {
-
 extern Program *current_program;
 
 TI_FORCE_INLINE Program &get_current_program() {
@@ -112,11 +70,6 @@ class Program {
 
   std::unique_ptr<KernelProfilerBase> profiler{nullptr};
 
-  std::unordered_map<JITEvaluatorId, std::unique_ptr<Kernel>>
-      jit_evaluator_cache;
-  std::mutex jit_evaluator_cache_mut;
-  std::atomic<uint32_t> jit_evaluator_id{0};
-
   // Note: for now we let all Programs share a single TypeFactory for smooth
   // migration. In the future each program should have its own copy.
   static TypeFactory &get_type_factory();
@@ -160,6 +113,36 @@ class Program {
 
   void synchronize();
 
+  /**
+   * Records an event that completes once all the kernels launched so far
+   * have finished.
+   *
+   * Only CPU kernels launched with CompileConfig::cpu_async_launch are tracked
+   * individually. Otherwise this synchronizes, and returns an event that has
+   * already completed.
+   */
+  uint64 record_event();
+
+  /**
+   * Returns whether |event| has completed, without blocking.
+   */
+  bool query_event(uint64 event);
+
+  /**
+   * Blocks until |event| has completed. Errors raised by kernels launched
+   * before |event| are rethrown here.
+   */
+  void wait_event(uint64 event);
+
+  /**
+   * Creates a builder that assembles its matrices on the CPU thread pool of
+   * this program.
+   */
+  SparseMatrixBuilder create_sparse_matrix_builder(int rows,
+                                                   int cols,
+                                                   int max_num_triplets,
+                                                   DataType dtype);
+
   // See AsyncEngine::flush().
   // Only useful when async mode is enabled.
   void async_flush();
@@ -191,6 +174,13 @@ class Program {
   // future.
   FunctionType compile(Kernel &kernel, OffloadedStmt *offloaded = nullptr);
 
+  /**
+   * Compiles |kernels| concurrently if CompileConfig::num_compile_threads > 0.
+   *
+   * @return The compiled kernels, in the order of @param kernels.
+   */
+  std::vector<FunctionType> compile_batch(const std::vector<Kernel *> &kernels);
+
   void check_runtime_error();
 
   Kernel &get_snode_reader(SNode *snode);
@@ -6,6 +6,15 @@ namespace lang {
 ProgramImpl::ProgramImpl(CompileConfig &config_) : config(&config_) {
 }
 
+std::vector<FunctionType> ProgramImpl::compile_batch(
+    const std::vector<Kernel *> &kernels) {
+  std::vector<FunctionType> ret;
+  for (auto *kernel : kernels) {
+    ret.push_back(compile(kernel, /*offloaded=*/nullptr));
+  }
+  return ret;
+}
+
 void ProgramImpl::compile_snode_tree_types(
     SNodeTree *tree,
     std::vector<std::unique_ptr<SNodeTree>> &snode_trees) {
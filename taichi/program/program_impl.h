@@ -24,6 +24,14 @@ class ProgramImpl {
    */
   virtual FunctionType compile(Kernel *kernel, OffloadedStmt *offloaded) = 0;
 
+  /**
+   * Codegen a batch of kernels. Backends may compile them concurrently.
+   *
+   * @return The compiled kernels, in the order of @param kernels.
+   */
+  virtual std::vector<FunctionType> compile_batch(
+      const std::vector<Kernel *> &kernels);
+
   /**
    * Allocate runtime buffer, e.g result_buffer or backend specific runtime
    * buffer, e.g. preallocated_device_buffer on CUDA.
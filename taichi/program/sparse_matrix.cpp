@@ -1,131 +1,389 @@
 #include "taichi/program/sparse_matrix.h"
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <sstream>
 
 #include "Eigen/Dense"
 #include "Eigen/SparseLU"
+#include "taichi/system/threading.h"
 
 namespace taichi {
 namespace lang {
+namespace {
+
+// The layout insert_triplet() and insert_triplet_f64() in the runtime write.
+template <typename T>
+struct Triplet {
+  int32 row;
+  int32 col;
+  T value;
+};
+
+// Triplets and outer vectors are handed out to the threads in blocks.
+constexpr int64 kTripletsPerTask = 1 << 16;
+constexpr int64 kOutersPerTask = 1 << 10;
+
+int64 num_tasks(int64 n, int64 per_task) {
+  return (n + per_task - 1) / per_task;
+}
+
+// Runs |func(thread_id, i)| for i in [0, n) on |pool|, or on the calling
+// thread if there is no pool.
+template <typename Func>
+void parallel_for(ThreadPool *pool, int64 n, const Func &func) {
+  if (pool == nullptr) {
+    for (int64 i = 0; i < n; i++) {
+      func(0, (int)i);
+    }
+    return;
+  }
+  pool->run((int)n, pool->max_num_threads, (void *)&func,
+            [](void *context, int thread_id, int i) {
+              (*(const Func *)context)(thread_id, i);
+            });
+}
+
+template <typename T>
+void atomic_add_value(T *dest, T val) {
+  using Bits = std::conditional_t<sizeof(T) == 4, uint32, uint64>;
+  auto *bits = reinterpret_cast<std::atomic<Bits> *>(dest);
+  Bits old_bits = bits->load(std::memory_order_relaxed);
+  while (!bits->compare_exchange_weak(
+      old_bits,
+      taichi_union_cast<Bits>(taichi_union_cast<T>(old_bits) + val),
+      std::memory_order_relaxed)) {
+  }
+}
+
+template <typename T>
+void print_triplets_impl(const void *data, uint64 num_triplets) {
+  const auto *triplets = (const Triplet<T> *)data;
+  for (uint64 i = 0; i < num_triplets; i++) {
+    fmt::print("({}, {}) val={}", triplets[i].row, triplets[i].col,
+               triplets[i].value);
+  }
+}
+
+template <typename EigenMatrix>
+struct MatrixTag {
+  using type = EigenMatrix;
+};
+
+template <typename T, int Options, typename StorageIndex>
+using SparseMatrixTag =
+    MatrixTag<Eigen::SparseMatrix<T, Options, StorageIndex>>;
+
+// Calls |func| with the MatrixTag of the Eigen matrix type to use.
+template <typename Func>
+std::unique_ptr<SparseMatrix> dispatch_matrix_type(
+    DataType dtype,
+    const std::string &storage_format,
+    DataType index_dtype,
+    const Func &func) {
+  TI_ERROR_IF(storage_format != "CSR" && storage_format != "CSC",
+              "Unsupported sparse matrix format: {}", storage_format);
+  TI_ERROR_IF(
+      index_dtype != PrimitiveType::i32 && index_dtype != PrimitiveType::i64,
+      "Sparse matrix indices must be i32 or i64, not {}",
+      data_type_name(index_dtype));
+  const bool row_major = storage_format == "CSR";
+  const bool wide_index = index_dtype == PrimitiveType::i64;
+  auto dispatch_layout = [&](auto scalar) -> std::unique_ptr<SparseMatrix> {
+    using T = decltype(scalar);
+    if (row_major) {
+      if (wide_index) {
+        return func(SparseMatrixTag<T, Eigen::RowMajor, int64>{});
+      }
+      return func(SparseMatrixTag<T, Eigen::RowMajor, int32>{});
+    }
+    if (wide_index) {
+      return func(SparseMatrixTag<T, Eigen::ColMajor, int64>{});
+    }
+    return func(SparseMatrixTag<T, Eigen::ColMajor, int32>{});
+  };
+  if (dtype == PrimitiveType::f32) {
+    return dispatch_layout(float32(0));
+  } else if (dtype == PrimitiveType::f64) {
+    return dispatch_layout(float64(0));
+  }
+  TI_ERROR("Unsupported sparse matrix data type: {}", data_type_name(dtype));
+}
+
+}  // namespace
 
 SparseMatrixBuilder::SparseMatrixBuilder(int rows,
                                          int cols,
-                                         int max_num_triplets)
-    : rows_(rows), cols_(cols), max_num_triplets_(max_num_triplets) {
-  data_.reserve(max_num_triplets * 3);
+                                         int max_num_triplets,
+                                         DataType dtype,
+                                         ThreadPool *thread_pool)
+    : rows_(rows),
+      cols_(cols),
+      max_num_triplets_(max_num_triplets),
+      dtype_(dtype),
+      thread_pool_(thread_pool) {
+  TI_ERROR_IF(dtype != PrimitiveType::f32 && dtype != PrimitiveType::f64,
+              "Unsupported sparse matrix data type: {}",
+              data_type_name(dtype));
+  const std::size_t triplet_size = dtype == PrimitiveType::f32
+                                       ? sizeof(Triplet<float32>)
+                                       : sizeof(Triplet<float64>);
+  // Left uninitialized, kernels fill it.
+  data_.reset(new uchar[max_num_triplets_ * triplet_size]);
   data_base_ptr_ = get_data_base_ptr();
 }
 
 void *SparseMatrixBuilder::get_data_base_ptr() {
-  return data_.data();
+  return data_.get();
 }
 
 void SparseMatrixBuilder::print_triplets() {
   fmt::print("n={}, m={}, num_triplets={} (max={})", rows_, cols_,
              num_triplets_, max_num_triplets_);
-  for (int64 i = 0; i < num_triplets_; i++) {
-    fmt::print("({}, {}) val={}", data_[i * 3], data_[i * 3 + 1],
-               taichi_union_cast<float32>(data_[i * 3 + 2]));
+  if (dtype_ == PrimitiveType::f32) {
+    print_triplets_impl<float32>(data_base_ptr_, num_triplets_);
+  } else {
+    print_triplets_impl<float64>(data_base_ptr_, num_triplets_);
   }
   fmt::print("\n");
 }
 
-SparseMatrix SparseMatrixBuilder::build() {
+std::unique_ptr<SparseMatrix> SparseMatrixBuilder::build(
+    const std::string &storage_format,
+    DataType index_dtype,
+    bool reuse_pattern) {
   TI_ASSERT(built_ == false);
   built_ = true;
-  using T = Eigen::Triplet<float32>;
-  std::vector<T> triplets;
-  for (int i = 0; i < num_triplets_; i++) {
-    triplets.push_back(T(data_[i * 3], data_[i * 3 + 1],
-                         taichi_union_cast<float32>(data_[i * 3 + 2])));
-  }
-  SparseMatrix sm(rows_, cols_);
-  sm.get_matrix().setFromTriplets(triplets.begin(), triplets.end());
+  TI_ERROR_IF(num_triplets_ > max_num_triplets_,
+              "{} triplets were inserted into a sparse matrix builder of at "
+              "most {} triplets",
+              num_triplets_, max_num_triplets_);
+  auto sm = dispatch_matrix_type(
+      dtype_, storage_format, index_dtype,
+      [&](auto tag) -> std::unique_ptr<SparseMatrix> {
+        return build_template<typename decltype(tag)::type>(reuse_pattern);
+      });
   clear();
   return sm;
 }
 
-void SparseMatrixBuilder::clear() {
-  built_ = false;
-  num_triplets_ = 0;
-}
+template <typename EigenMatrix>
+std::unique_ptr<SparseMatrix> SparseMatrixBuilder::build_template(
+    bool reuse_pattern) {
+  auto ret = std::make_unique<EigenSparseMatrix<EigenMatrix>>(rows_, cols_);
+  auto &matrix = ret->get_matrix();
+  if (reuse_pattern && pattern_ &&
+      dynamic_cast<EigenSparseMatrix<EigenMatrix> *>(pattern_.get())) {
+    matrix = pattern_->as<EigenMatrix>();
+    if (rebuild_from_pattern(matrix)) {
+      return ret;
+    }
+  }
 
-SparseMatrix::SparseMatrix(Eigen::SparseMatrix<float32> &matrix) {
-  this->matrix_ = matrix;
-}
+  using Scalar = typename EigenMatrix::Scalar;
+  using StorageIndex = typename EigenMatrix::StorageIndex;
+  constexpr bool kRowMajor = EigenMatrix::IsRowMajor;
+  const auto *triplets = (const Triplet<Scalar> *)data_base_ptr_;
+  const int64 n = num_triplets_;
+  const int64 outer_size = kRowMajor ? rows_ : cols_;
+  const int num_threads = thread_pool_ ? thread_pool_->max_num_threads : 1;
 
-SparseMatrix::SparseMatrix(int rows, int cols) : matrix_(rows, cols) {
-}
+  // Count the triplets of each outer vector (row for CSR, column for CSC).
+  std::vector<std::atomic<int64>> cursors(outer_size);
+  std::atomic<bool> out_of_range{false};
+  parallel_for(thread_pool_, num_tasks(n, kTripletsPerTask),
+               [&](int thread_id, int task) {
+                 const int64 end = std::min(n, (task + 1) * kTripletsPerTask);
+                 for (int64 i = task * kTripletsPerTask; i < end; i++) {
+                   const auto &t = triplets[i];
+                   if (t.row < 0 || t.row >= rows_ || t.col < 0 ||
+                       t.col >= cols_) {
+                     out_of_range = true;
+                     return;
+                   }
+                   cursors[kRowMajor ? t.row : t.col].fetch_add(
+                       1, std::memory_order_relaxed);
+                 }
+               });
+  TI_ERROR_IF(out_of_range,
+              "Triplet index out of range of the {}x{} sparse matrix", rows_,
+              cols_);
 
-const std::string SparseMatrix::to_string() const {
-  Eigen::IOFormat clean_fmt(4, 0, ", ", "\n", "[", "]");
-  // Note that the code below first converts the sparse matrix into a dense one.
-  // https://stackoverflow.com/questions/38553335/how-can-i-print-in-console-a-formatted-sparse-matrix-with-eigen
-  std::ostringstream ostr;
-  ostr << Eigen::MatrixXf(matrix_).format(clean_fmt);
-  return ostr.str();
-}
-
-const int SparseMatrix::num_rows() const {
-  return matrix_.rows();
-}
-const int SparseMatrix::num_cols() const {
-  return matrix_.cols();
-}
+  std::vector<int64> starts(outer_size + 1);
+  starts[0] = 0;
+  for (int64 o = 0; o < outer_size; o++) {
+    starts[o + 1] = starts[o] + cursors[o];
+    cursors[o] = starts[o];
+  }
 
-Eigen::SparseMatrix<float32> &SparseMatrix::get_matrix() {
-  return matrix_;
-}
+  // Bucket the triplets by outer vector, straight from the builder buffer.
+  std::unique_ptr<StorageIndex[]> inner(new StorageIndex[n]);
+  std::unique_ptr<Scalar[]> values(new Scalar[n]);
+  parallel_for(thread_pool_, num_tasks(n, kTripletsPerTask),
+               [&](int thread_id, int task) {
+                 const int64 end = std::min(n, (task + 1) * kTripletsPerTask);
+                 for (int64 i = task * kTripletsPerTask; i < end; i++) {
+                   const auto &t = triplets[i];
+                   const int64 pos =
+                       cursors[kRowMajor ? t.row : t.col].fetch_add(
+                           1, std::memory_order_relaxed);
+                   inner[pos] = kRowMajor ? t.col : t.row;
+                   values[pos] = t.value;
+                 }
+               });
 
-const Eigen::SparseMatrix<float32> &SparseMatrix::get_matrix() const {
-  return matrix_;
-}
+  // Sort every outer vector by inner index and sum up the duplicates, in
+  // place.
+  std::vector<int64> outer_nnz(outer_size);
+  std::vector<std::vector<std::pair<StorageIndex, Scalar>>> scratch(
+      num_threads);
+  parallel_for(
+      thread_pool_, num_tasks(outer_size, kOutersPerTask),
+      [&](int thread_id, int task) {
+        auto &entries = scratch[thread_id];
+        const int64 end = std::min(outer_size, (task + 1) * kOutersPerTask);
+        for (int64 o = task * kOutersPerTask; o < end; o++) {
+          entries.clear();
+          for (int64 k = starts[o]; k < starts[o + 1]; k++) {
+            entries.emplace_back(inner[k], values[k]);
+          }
+          std::sort(entries.begin(), entries.end(),
+                    [](const auto &a, const auto &b) {
+                      return a.first < b.first;
+                    });
+          int64 m = starts[o];
+          for (int64 k = 0; k < (int64)entries.size(); k++) {
+            if (k > 0 && entries[k].first == entries[k - 1].first) {
+              values[m - 1] += entries[k].second;
+            } else {
+              inner[m] = entries[k].first;
+              values[m] = entries[k].second;
+              m++;
+            }
+          }
+          outer_nnz[o] = m - starts[o];
+        }
+      });
 
-SparseMatrix operator+(const SparseMatrix &sm1, const SparseMatrix &sm2) {
-  Eigen::SparseMatrix<float32> res(sm1.matrix_ + sm2.matrix_);
-  return SparseMatrix(res);
-}
+  int64 nnz = 0;
+  for (int64 o = 0; o < outer_size; o++) {
+    nnz += outer_nnz[o];
+  }
+  TI_ERROR_IF(nnz > std::numeric_limits<StorageIndex>::max(),
+              "{} non-zeros overflow the i32 indices of the sparse matrix, "
+              "use i64 indices instead",
+              nnz);
 
-SparseMatrix operator-(const SparseMatrix &sm1, const SparseMatrix &sm2) {
-  Eigen::SparseMatrix<float32> res(sm1.matrix_ - sm2.matrix_);
-  return SparseMatrix(res);
-}
+  // Compact the outer vectors into the compressed storage of the result.
+  matrix.resize(rows_, cols_);
+  matrix.resizeNonZeros(nnz);
+  auto *outer_ptr = matrix.outerIndexPtr();
+  outer_ptr[0] = 0;
+  for (int64 o = 0; o < outer_size; o++) {
+    outer_ptr[o + 1] = outer_ptr[o] + outer_nnz[o];
+  }
+  parallel_for(thread_pool_, num_tasks(outer_size, kOutersPerTask),
+               [&](int thread_id, int task) {
+                 const int64 end =
+                     std::min(outer_size, (task + 1) * kOutersPerTask);
+                 for (int64 o = task * kOutersPerTask; o < end; o++) {
+                   std::copy(inner.get() + starts[o],
+                             inner.get() + starts[o] + outer_nnz[o],
+                             matrix.innerIndexPtr() + outer_ptr[o]);
+                   std::copy(values.get() + starts[o],
+                             values.get() + starts[o] + outer_nnz[o],
+                             matrix.valuePtr() + outer_ptr[o]);
+                 }
+               });
 
-SparseMatrix operator*(float scale, const SparseMatrix &sm) {
-  Eigen::SparseMatrix<float32> res(scale * sm.matrix_);
-  return SparseMatrix(res);
+  if (reuse_pattern) {
+    pattern_ = ret->clone();
+  }
+  return ret;
 }
 
-SparseMatrix operator*(const SparseMatrix &sm, float scale) {
-  return scale * sm;
-}
+template <typename EigenMatrix>
+bool SparseMatrixBuilder::rebuild_from_pattern(EigenMatrix &matrix) {
+  using Scalar = typename EigenMatrix::Scalar;
+  using StorageIndex = typename EigenMatrix::StorageIndex;
+  constexpr bool kRowMajor = EigenMatrix::IsRowMajor;
+  const auto *triplets = (const Triplet<Scalar> *)data_base_ptr_;
+  const int64 n = num_triplets_;
+  const auto *outer_ptr = matrix.outerIndexPtr();
+  const auto *inner_ptr = matrix.innerIndexPtr();
+  auto *value_ptr = matrix.valuePtr();
+  std::fill(value_ptr, value_ptr + matrix.nonZeros(), Scalar(0));
 
-SparseMatrix operator*(const SparseMatrix &sm1, const SparseMatrix &sm2) {
-  Eigen::SparseMatrix<float32> res(sm1.matrix_.cwiseProduct(sm2.matrix_));
-  return SparseMatrix(res);
+  std::atomic<bool> missed{false};
+  parallel_for(
+      thread_pool_, num_tasks(n, kTripletsPerTask),
+      [&](int thread_id, int task) {
+        const int64 end = std::min(n, (task + 1) * kTripletsPerTask);
+        for (int64 i = task * kTripletsPerTask; i < end; i++) {
+          if (missed.load(std::memory_order_relaxed)) {
+            return;
+          }
+          const auto &t = triplets[i];
+          if (t.row < 0 || t.row >= rows_ || t.col < 0 || t.col >= cols_) {
+            missed = true;
+            return;
+          }
+          const int64 o = kRowMajor ? t.row : t.col;
+          const StorageIndex key = kRowMajor ? t.col : t.row;
+          const auto *begin = inner_ptr + outer_ptr[o];
+          const auto *end = inner_ptr + outer_ptr[o + 1];
+          const auto *it = std::lower_bound(begin, end, key);
+          if (it == end || *it != key) {
+            missed = true;
+            return;
+          }
+          atomic_add_value(value_ptr + (it - inner_ptr), t.value);
+        }
+      });
+  return !missed;
 }
 
-SparseMatrix SparseMatrix::matmul(const SparseMatrix &sm) {
-  Eigen::SparseMatrix<float32> res(matrix_ * sm.matrix_);
-  return SparseMatrix(res);
+void SparseMatrixBuilder::clear() {
+  built_ = false;
+  num_triplets_ = 0;
 }
 
-Eigen::VectorXf SparseMatrix::mat_vec_mul(
-    const Eigen::Ref<const Eigen::VectorXf> &b) {
-  return matrix_ * b;
+template <typename EigenMatrix>
+const std::string EigenSparseMatrix<EigenMatrix>::to_string() const {
+  Eigen::IOFormat clean_fmt(4, 0, ", ", "\n", "[", "]");
+  // Note that the code below first converts the sparse matrix into a dense one.
+  // https://stackoverflow.com/questions/38553335/how-can-i-print-in-console-a-formatted-sparse-matrix-with-eigen
+  std::ostringstream ostr;
+  ostr << Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>(matrix_)
+              .format(clean_fmt);
+  return ostr.str();
 }
 
-SparseMatrix SparseMatrix::transpose() {
-  Eigen::SparseMatrix<float32> res(matrix_.transpose());
-  return SparseMatrix(res);
-}
+#define INSTANTIATE_SPARSE_MATRIX(T, ORDER, INDEX) \
+  template class EigenSparseMatrix<Eigen::SparseMatrix<T, Eigen::ORDER, INDEX>>;
 
-float32 SparseMatrix::get_element(int row, int col) {
-  return matrix_.coeff(row, col);
-}
+INSTANTIATE_SPARSE_MATRIX(float32, ColMajor, int32)
+INSTANTIATE_SPARSE_MATRIX(float32, ColMajor, int64)
+INSTANTIATE_SPARSE_MATRIX(float32, RowMajor, int32)
+INSTANTIATE_SPARSE_MATRIX(float32, RowMajor, int64)
+INSTANTIATE_SPARSE_MATRIX(float64, ColMajor, int32)
+INSTANTIATE_SPARSE_MATRIX(float64, ColMajor, int64)
+INSTANTIATE_SPARSE_MATRIX(float64, RowMajor, int32)
+INSTANTIATE_SPARSE_MATRIX(float64, RowMajor, int64)
 
-void SparseMatrix::set_element(int row, int col, float32 value) {
-  matrix_.coeffRef(row, col) = value;
+std::unique_ptr<SparseMatrix> make_sparse_matrix(
+    int rows,
+    int cols,
+    DataType dtype,
+    const std::string &storage_format,
+    DataType index_dtype) {
+  return dispatch_matrix_type(
+      dtype, storage_format, index_dtype,
+      [&](auto tag) -> std::unique_ptr<SparseMatrix> {
+        using EigenMatrix = typename decltype(tag)::type;
+        return std::make_unique<EigenSparseMatrix<EigenMatrix>>(rows, cols);
+      });
 }
 
 }  // namespace lang
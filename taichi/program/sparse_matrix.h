@@ -2,8 +2,13 @@
 
 #include "taichi/common/core.h"
 #include "taichi/inc/constants.h"
+#include "taichi/ir/type_utils.h"
 #include "Eigen/Sparse"
 
+TI_NAMESPACE_BEGIN
+class ThreadPool;
+TI_NAMESPACE_END
+
 namespace taichi {
 namespace lang {
 
@@ -11,55 +16,206 @@ class SparseMatrix;
 
 class SparseMatrixBuilder {
  public:
-  SparseMatrixBuilder(int rows, int cols, int max_num_triplets);
+  /**
+   * @param dtype: f32 or f64, the type of the values inserted by kernels.
+   * @param thread_pool: Used to assemble the matrices in parallel. May be
+   * nullptr.
+   */
+  SparseMatrixBuilder(int rows,
+                      int cols,
+                      int max_num_triplets,
+                      DataType dtype = PrimitiveType::f32,
+                      ThreadPool *thread_pool = nullptr);
 
   void *get_data_base_ptr();
 
   void print_triplets();
 
-  SparseMatrix build();
+  /**
+   * Assembles the inserted triplets into a compressed matrix, summing up
+   * duplicates.
+   *
+   * @param storage_format: "CSR" or "CSC".
+   * @param index_dtype: i32 or i64, the type of the row and column indices.
+   * @param reuse_pattern: Keep the sparsity pattern of the result. If the
+   * triplets of the next build with the same format only hit that pattern,
+   * they are summed into it directly instead of being sorted. Entries of the
+   * pattern no triplet hits are then kept as explicit zeros.
+   */
+  std::unique_ptr<SparseMatrix> build(
+      const std::string &storage_format = "CSC",
+      DataType index_dtype = PrimitiveType::i32,
+      bool reuse_pattern = false);
 
   void clear();
 
+  DataType get_data_type() const {
+    return dtype_;
+  }
+
  private:
+  template <typename EigenMatrix>
+  std::unique_ptr<SparseMatrix> build_template(bool reuse_pattern);
+
+  template <typename EigenMatrix>
+  bool rebuild_from_pattern(EigenMatrix &matrix);
+
+  // insert_triplet() in the runtime reads these two through the address of
+  // the builder. Keep them first.
   uint64 num_triplets_{0};
   void *data_base_ptr_{nullptr};
-  std::vector<uint32> data_;
+  std::unique_ptr<uchar[]> data_;
   int rows_{0};
   int cols_{0};
   uint64 max_num_triplets_{0};
   bool built_{false};
+  DataType dtype_;
+  ThreadPool *thread_pool_{nullptr};
+  // The result of the last build with |reuse_pattern|.
+  std::unique_ptr<SparseMatrix> pattern_{nullptr};
 };
 
+template <typename EigenMatrix>
+class EigenSparseMatrix;
+
+/**
+ * A sparse matrix stored in Eigen, whose value type, storage order and index
+ * type are only known at runtime. See EigenSparseMatrix.
+ */
 class SparseMatrix {
  public:
   SparseMatrix() = delete;
-  SparseMatrix(int rows, int cols);
-  SparseMatrix(Eigen::SparseMatrix<float32> &matrix);
-
-  const int num_rows() const;
-  const int num_cols() const;
-  const std::string to_string() const;
-  Eigen::SparseMatrix<float32> &get_matrix();
-  const Eigen::SparseMatrix<float32> &get_matrix() const;
-  float32 get_element(int row, int col);
-  void set_element(int row, int col, float32 value);
-
-  friend SparseMatrix operator+(const SparseMatrix &sm1,
-                                const SparseMatrix &sm2);
-  friend SparseMatrix operator-(const SparseMatrix &sm1,
-                                const SparseMatrix &sm2);
-  friend SparseMatrix operator*(float scale, const SparseMatrix &sm);
-  friend SparseMatrix operator*(const SparseMatrix &sm, float scale);
-  friend SparseMatrix operator*(const SparseMatrix &sm1,
-                                const SparseMatrix &sm2);
-  SparseMatrix matmul(const SparseMatrix &sm);
-  Eigen::VectorXf mat_vec_mul(const Eigen::Ref<const Eigen::VectorXf> &b);
-
-  SparseMatrix transpose();
+  SparseMatrix(int rows, int cols, DataType dtype)
+      : rows_(rows), cols_(cols), dtype_(dtype) {
+  }
+  virtual ~SparseMatrix() = default;
+
+  const int num_rows() const {
+    return rows_;
+  }
+  const int num_cols() const {
+    return cols_;
+  }
+  DataType get_data_type() const {
+    return dtype_;
+  }
+  virtual const std::string to_string() const = 0;
+  virtual int64 num_nonzeros() const = 0;
+  virtual std::string get_storage_format() const = 0;
+  virtual std::unique_ptr<SparseMatrix> clone() const = 0;
+
+  template <typename EigenMatrix>
+  EigenMatrix &as() {
+    auto *sm = dynamic_cast<EigenSparseMatrix<EigenMatrix> *>(this);
+    TI_ERROR_IF(sm == nullptr, "Unexpected type of sparse matrix");
+    return sm->get_matrix();
+  }
+
+  template <typename EigenMatrix>
+  const EigenMatrix &as() const {
+    auto *sm = dynamic_cast<const EigenSparseMatrix<EigenMatrix> *>(this);
+    TI_ERROR_IF(sm == nullptr, "Unexpected type of sparse matrix");
+    return sm->get_matrix();
+  }
+
+ protected:
+  int rows_{0};
+  int cols_{0};
+  DataType dtype_;
+};
+
+template <typename EigenMatrix>
+class EigenSparseMatrix : public SparseMatrix {
+ public:
+  using Scalar = typename EigenMatrix::Scalar;
+  using Vector = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+  EigenSparseMatrix(int rows, int cols)
+      : SparseMatrix(rows, cols, lang::get_data_type<Scalar>()),
+        matrix_(rows, cols) {
+  }
+  explicit EigenSparseMatrix(const EigenMatrix &matrix)
+      : SparseMatrix(matrix.rows(),
+                     matrix.cols(),
+                     lang::get_data_type<Scalar>()),
+        matrix_(matrix) {
+  }
+
+  const std::string to_string() const override;
+
+  int64 num_nonzeros() const override {
+    return matrix_.nonZeros();
+  }
+
+  std::string get_storage_format() const override {
+    return EigenMatrix::IsRowMajor ? "CSR" : "CSC";
+  }
+
+  std::unique_ptr<SparseMatrix> clone() const override {
+    return std::make_unique<EigenSparseMatrix>(matrix_);
+  }
+
+  EigenMatrix &get_matrix() {
+    return matrix_;
+  }
+  const EigenMatrix &get_matrix() const {
+    return matrix_;
+  }
+
+  Scalar get_element(int row, int col) {
+    return matrix_.coeff(row, col);
+  }
+  void set_element(int row, int col, Scalar value) {
+    matrix_.coeffRef(row, col) = value;
+  }
+
+  friend EigenSparseMatrix operator+(const EigenSparseMatrix &sm1,
+                                     const EigenSparseMatrix &sm2) {
+    return EigenSparseMatrix(EigenMatrix(sm1.matrix_ + sm2.matrix_));
+  }
+  friend EigenSparseMatrix operator-(const EigenSparseMatrix &sm1,
+                                     const EigenSparseMatrix &sm2) {
+    return EigenSparseMatrix(EigenMatrix(sm1.matrix_ - sm2.matrix_));
+  }
+  friend EigenSparseMatrix operator*(float64 scale,
+                                     const EigenSparseMatrix &sm) {
+    return EigenSparseMatrix(EigenMatrix(Scalar(scale) * sm.matrix_));
+  }
+  friend EigenSparseMatrix operator*(const EigenSparseMatrix &sm,
+                                     float64 scale) {
+    return scale * sm;
+  }
+  friend EigenSparseMatrix operator*(const EigenSparseMatrix &sm1,
+                                     const EigenSparseMatrix &sm2) {
+    return EigenSparseMatrix(
+        EigenMatrix(sm1.matrix_.cwiseProduct(sm2.matrix_)));
+  }
+  EigenSparseMatrix matmul(const EigenSparseMatrix &sm) {
+    return EigenSparseMatrix(EigenMatrix(matrix_ * sm.matrix_));
+  }
+  Vector mat_vec_mul(const Eigen::Ref<const Vector> &b) {
+    return matrix_ * b;
+  }
+
+  EigenSparseMatrix transpose() {
+    return EigenSparseMatrix(EigenMatrix(matrix_.transpose()));
+  }
 
  private:
-  Eigen::SparseMatrix<float32, Eigen::ColMajor> matrix_;
+  EigenMatrix matrix_;
 };
+
+/**
+ * @param dtype: f32 or f64.
+ * @param storage_format: "CSR" or "CSC".
+ * @param index_dtype: i32 or i64.
+ */
+std::unique_ptr<SparseMatrix> make_sparse_matrix(
+    int rows,
+    int cols,
+    DataType dtype = PrimitiveType::f32,
+    const std::string &storage_format = "CSC",
+    DataType index_dtype = PrimitiveType::i32);
+
 }  // namespace lang
 }  // namespace taichi
@@ -2,14 +2,15 @@
 
 #include <unordered_map>
 
-#define MAKE_SOLVER(type, order)                                              \
-  {                                                                           \
-    {#type, #order}, []() -> std::unique_ptr<SparseSolver> {                  \
-      using T =                                                               \
-          Eigen::Simplicial##type<Eigen::SparseMatrix<float32>, Eigen::Lower, \
-                                  Eigen::order##Ordering<int>>;               \
-      return std::make_unique<EigenSparseSolver<T>>();                        \
-    }                                                                         \
+#define MAKE_SOLVER(type, order)                                             \
+  {                                                                          \
+    {#type, #order}, []() -> std::unique_ptr<SparseSolver> {                 \
+      using T = Eigen::Simplicial##type<Eigen::SparseMatrix<Scalar>,         \
+                                        Eigen::Lower,                        \
+                                        Eigen::order##Ordering<int>>;        \
+      return std::make_unique<                                               \
+          EigenSparseSolver<T, Eigen::SparseMatrix<Scalar>>>();              \
+    }                                                                        \
   }
 
 namespace {
@@ -25,38 +26,188 @@ struct pair_hash {
 
 namespace taichi {
 namespace lang {
+namespace {
+
+template <typename EigenMatrix>
+const EigenMatrix &get_eigen_matrix(const SparseMatrix &sm,
+                                    DataType solver_dtype) {
+  TI_ERROR_IF(sm.get_data_type() != solver_dtype,
+              "A {} SparseSolver cannot solve a {} matrix",
+              data_type_name(solver_dtype), data_type_name(sm.get_data_type()));
+  TI_ERROR_IF(sm.get_storage_format() != "CSC",
+              "SparseSolver only supports matrices in CSC format for now");
+  return sm.as<EigenMatrix>();
+}
+
+}  // namespace
+
+Eigen::MatrixXf SparseSolver::solve_with_guess(
+    const Eigen::Ref<const Eigen::MatrixXf> &b,
+    const Eigen::Ref<const Eigen::MatrixXf> &x0) {
+  TI_ERROR("Only iterative sparse solvers support initial guesses");
+}
+
+Eigen::MatrixXd SparseSolver::solve_with_guess(
+    const Eigen::Ref<const Eigen::MatrixXd> &b,
+    const Eigen::Ref<const Eigen::MatrixXd> &x0) {
+  TI_ERROR("Only iterative sparse solvers support initial guesses");
+}
+
+void SparseSolver::set_tolerance(float64 tolerance) {
+  TI_ERROR("Only iterative sparse solvers have a tolerance");
+}
+
+void SparseSolver::set_max_iterations(int max_iterations) {
+  TI_ERROR("Only iterative sparse solvers have a maximum number of iterations");
+}
+
+int SparseSolver::num_iterations() {
+  TI_ERROR("Only iterative sparse solvers have a number of iterations");
+}
 
-template <class EigenSolver>
-bool EigenSparseSolver<EigenSolver>::compute(const SparseMatrix &sm) {
-  solver_.compute(sm.get_matrix());
-  if (solver_.info() != Eigen::Success) {
+float64 SparseSolver::error() {
+  TI_ERROR("Only iterative sparse solvers have an estimated error");
+}
+
+template <class EigenSolver, class EigenMatrix>
+bool EigenSparseSolver<EigenSolver, EigenMatrix>::compute(
+    const SparseMatrix &sm) {
+  analyze_pattern(sm);
+  factorize(sm);
+  return info();
+}
+
+template <class EigenSolver, class EigenMatrix>
+void EigenSparseSolver<EigenSolver, EigenMatrix>::analyze_pattern(
+    const SparseMatrix &sm) {
+  const auto &matrix = keep_matrix(get_eigen_matrix<EigenMatrix>(sm, dtype_));
+  solver_.analyzePattern(matrix);
+  // Uncompressed matrices are always analyzed again.
+  analyzed_ = matrix.isCompressed();
+  if (analyzed_) {
+    const auto outer_size = matrix.outerSize();
+    outer_pattern_.assign(matrix.outerIndexPtr(),
+                          matrix.outerIndexPtr() + outer_size + 1);
+    inner_pattern_.assign(matrix.innerIndexPtr(),
+                          matrix.innerIndexPtr() + matrix.nonZeros());
+  }
+}
+
+template <class EigenSolver, class EigenMatrix>
+void EigenSparseSolver<EigenSolver, EigenMatrix>::factorize(
+    const SparseMatrix &sm) {
+  const auto &matrix = get_eigen_matrix<EigenMatrix>(sm, dtype_);
+  if (!same_pattern(matrix)) {
+    analyze_pattern(sm);
+  }
+  solver_.factorize(keep_matrix(matrix));
+}
+
+template <class EigenSolver, class EigenMatrix>
+bool EigenSparseSolver<EigenSolver, EigenMatrix>::same_pattern(
+    const EigenMatrix &matrix) const {
+  if (!analyzed_ || !matrix.isCompressed() ||
+      matrix.outerSize() + 1 != (int64)outer_pattern_.size() ||
+      matrix.nonZeros() != (int64)inner_pattern_.size()) {
     return false;
-  } else
-    return true;
+  }
+  return std::equal(outer_pattern_.begin(), outer_pattern_.end(),
+                    matrix.outerIndexPtr()) &&
+         std::equal(inner_pattern_.begin(), inner_pattern_.end(),
+                    matrix.innerIndexPtr());
 }
-template <class EigenSolver>
-void EigenSparseSolver<EigenSolver>::analyze_pattern(const SparseMatrix &sm) {
-  solver_.analyzePattern(sm.get_matrix());
+
+template <class EigenSolver, class EigenMatrix>
+template <typename DenseMatrix>
+DenseMatrix EigenSparseSolver<EigenSolver, EigenMatrix>::solve_typed(
+    const Eigen::Ref<const DenseMatrix> &b) {
+  if constexpr (std::is_same_v<typename DenseMatrix::Scalar, Scalar>) {
+    return solver_.solve(b);
+  } else {
+    using SolverMatrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+    SolverMatrix x = solver_.solve(b.template cast<Scalar>());
+    return x.template cast<typename DenseMatrix::Scalar>();
+  }
 }
 
-template <class EigenSolver>
-void EigenSparseSolver<EigenSolver>::factorize(const SparseMatrix &sm) {
-  solver_.factorize(sm.get_matrix());
+template <class EigenSolver, class EigenMatrix>
+Eigen::MatrixXf EigenSparseSolver<EigenSolver, EigenMatrix>::solve(
+    const Eigen::Ref<const Eigen::MatrixXf> &b) {
+  return solve_typed<Eigen::MatrixXf>(b);
 }
 
-template <class EigenSolver>
-Eigen::VectorXf EigenSparseSolver<EigenSolver>::solve(
-    const Eigen::Ref<const Eigen::VectorXf> &b) {
-  return solver_.solve(b);
+template <class EigenSolver, class EigenMatrix>
+Eigen::MatrixXd EigenSparseSolver<EigenSolver, EigenMatrix>::solve(
+    const Eigen::Ref<const Eigen::MatrixXd> &b) {
+  return solve_typed<Eigen::MatrixXd>(b);
 }
 
-template <class EigenSolver>
-bool EigenSparseSolver<EigenSolver>::info() {
+template <class EigenSolver, class EigenMatrix>
+bool EigenSparseSolver<EigenSolver, EigenMatrix>::info() {
   return solver_.info() == Eigen::Success;
 }
 
-std::unique_ptr<SparseSolver> make_sparse_solver(const std::string &solver_type,
-                                                 const std::string &ordering) {
+template <class EigenSolver, class EigenMatrix>
+template <typename DenseMatrix>
+DenseMatrix
+EigenIterativeSolver<EigenSolver, EigenMatrix>::solve_with_guess_typed(
+    const Eigen::Ref<const DenseMatrix> &b,
+    const Eigen::Ref<const DenseMatrix> &x0) {
+  using Scalar = typename EigenMatrix::Scalar;
+  if constexpr (std::is_same_v<typename DenseMatrix::Scalar, Scalar>) {
+    return this->solver_.solveWithGuess(b, x0);
+  } else {
+    using SolverMatrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+    SolverMatrix x = this->solver_.solveWithGuess(b.template cast<Scalar>(),
+                                                  x0.template cast<Scalar>());
+    return x.template cast<typename DenseMatrix::Scalar>();
+  }
+}
+
+template <class EigenSolver, class EigenMatrix>
+Eigen::MatrixXf
+EigenIterativeSolver<EigenSolver, EigenMatrix>::solve_with_guess(
+    const Eigen::Ref<const Eigen::MatrixXf> &b,
+    const Eigen::Ref<const Eigen::MatrixXf> &x0) {
+  return solve_with_guess_typed<Eigen::MatrixXf>(b, x0);
+}
+
+template <class EigenSolver, class EigenMatrix>
+Eigen::MatrixXd
+EigenIterativeSolver<EigenSolver, EigenMatrix>::solve_with_guess(
+    const Eigen::Ref<const Eigen::MatrixXd> &b,
+    const Eigen::Ref<const Eigen::MatrixXd> &x0) {
+  return solve_with_guess_typed<Eigen::MatrixXd>(b, x0);
+}
+
+template <class EigenSolver, class EigenMatrix>
+void EigenIterativeSolver<EigenSolver, EigenMatrix>::set_tolerance(
+    float64 tolerance) {
+  this->solver_.setTolerance(tolerance);
+}
+
+template <class EigenSolver, class EigenMatrix>
+void EigenIterativeSolver<EigenSolver, EigenMatrix>::set_max_iterations(
+    int max_iterations) {
+  this->solver_.setMaxIterations(max_iterations);
+}
+
+template <class EigenSolver, class EigenMatrix>
+int EigenIterativeSolver<EigenSolver, EigenMatrix>::num_iterations() {
+  return this->solver_.iterations();
+}
+
+template <class EigenSolver, class EigenMatrix>
+float64 EigenIterativeSolver<EigenSolver, EigenMatrix>::error() {
+  return this->solver_.error();
+}
+
+namespace {
+
+template <typename Scalar>
+std::unique_ptr<SparseSolver> make_sparse_solver_typed(
+    const std::string &solver_type,
+    const std::string &ordering) {
   using key_type = std::pair<std::string, std::string>;
   using func_type = std::unique_ptr<SparseSolver> (*)();
   static const std::unordered_map<key_type, func_type, pair_hash>
@@ -73,11 +224,64 @@ std::unique_ptr<SparseSolver> make_sparse_solver(const std::string &solver_type,
     auto solver_func = solver_factory.at(solver_key);
     return solver_func();
   } else if (solver_type == "LU") {
-    using LU = Eigen::SparseLU<Eigen::SparseMatrix<float32>>;
-    return std::make_unique<EigenSparseSolver<LU>>();
+    using Matrix = Eigen::SparseMatrix<Scalar>;
+    using LU = Eigen::SparseLU<Matrix>;
+    return std::make_unique<EigenSparseSolver<LU, Matrix>>();
   } else
     TI_ERROR("Not supported sparse solver type: {}", solver_type);
 }
 
+template <typename Scalar>
+std::unique_ptr<SparseSolver> make_iterative_solver_typed(
+    const std::string &solver_type,
+    const std::string &preconditioner) {
+  using Matrix = Eigen::SparseMatrix<Scalar>;
+  using Jacobi = Eigen::DiagonalPreconditioner<Scalar>;
+  constexpr int kUpLo = Eigen::Lower | Eigen::Upper;
+  if (solver_type == "CG" && preconditioner == "Jacobi") {
+    using T = Eigen::ConjugateGradient<Matrix, kUpLo, Jacobi>;
+    return std::make_unique<EigenIterativeSolver<T, Matrix>>();
+  } else if (solver_type == "CG" && preconditioner == "IC") {
+    using IC = Eigen::IncompleteCholesky<Scalar>;
+    using T = Eigen::ConjugateGradient<Matrix, kUpLo, IC>;
+    return std::make_unique<EigenIterativeSolver<T, Matrix>>();
+  } else if (solver_type == "BICGSTAB" && preconditioner == "Jacobi") {
+    using T = Eigen::BiCGSTAB<Matrix, Jacobi>;
+    return std::make_unique<EigenIterativeSolver<T, Matrix>>();
+  } else if (solver_type == "BICGSTAB" && preconditioner == "ILUT") {
+    using T = Eigen::BiCGSTAB<Matrix, Eigen::IncompleteLUT<Scalar>>;
+    return std::make_unique<EigenIterativeSolver<T, Matrix>>();
+  } else
+    TI_ERROR("Not supported iterative sparse solver: {} with {}", solver_type,
+             preconditioner);
+}
+
+}  // namespace
+
+std::unique_ptr<SparseSolver> make_sparse_solver(DataType dtype,
+                                                 const std::string &solver_type,
+                                                 const std::string &ordering) {
+  if (dtype == PrimitiveType::f32) {
+    return make_sparse_solver_typed<float32>(solver_type, ordering);
+  } else if (dtype == PrimitiveType::f64) {
+    return make_sparse_solver_typed<float64>(solver_type, ordering);
+  } else
+    TI_ERROR("Not supported sparse solver data type: {}",
+             data_type_name(dtype));
+}
+
+std::unique_ptr<SparseSolver> make_iterative_solver(
+    DataType dtype,
+    const std::string &solver_type,
+    const std::string &preconditioner) {
+  if (dtype == PrimitiveType::f32) {
+    return make_iterative_solver_typed<float32>(solver_type, preconditioner);
+  } else if (dtype == PrimitiveType::f64) {
+    return make_iterative_solver_typed<float64>(solver_type, preconditioner);
+  } else
+    TI_ERROR("Not supported sparse solver data type: {}",
+             data_type_name(dtype));
+}
+
 }  // namespace lang
 }  // namespace taichi
@@ -5,33 +5,143 @@
 namespace taichi {
 namespace lang {
 
+/**
+ * A solver session of a sparse linear system. The symbolic analysis of the
+ * matrix is kept across factorize() calls as long as the sparsity pattern
+ * does not change, so that only the numerical factorization is redone when
+ * the values of the matrix change.
+ *
+ * The right-hand sides are dense matrices, one system per column. They are
+ * converted to the value type of the solver if needed.
+ */
 class SparseSolver {
  public:
   virtual ~SparseSolver() = default;
   virtual bool compute(const SparseMatrix &sm) = 0;
   virtual void analyze_pattern(const SparseMatrix &sm) = 0;
+  /**
+   * Redoes the symbolic analysis first if the sparsity pattern of |sm|
+   * differs from the last analyzed one.
+   */
   virtual void factorize(const SparseMatrix &sm) = 0;
-  virtual Eigen::VectorXf solve(const Eigen::Ref<const Eigen::VectorXf> &b) = 0;
+  virtual Eigen::MatrixXf solve(
+      const Eigen::Ref<const Eigen::MatrixXf> &b) = 0;
+  virtual Eigen::MatrixXd solve(
+      const Eigen::Ref<const Eigen::MatrixXd> &b) = 0;
   virtual bool info() = 0;
+
+  DataType get_data_type() const {
+    return dtype_;
+  }
+
+  // Only supported by the iterative solvers.
+  virtual Eigen::MatrixXf solve_with_guess(
+      const Eigen::Ref<const Eigen::MatrixXf> &b,
+      const Eigen::Ref<const Eigen::MatrixXf> &x0);
+  virtual Eigen::MatrixXd solve_with_guess(
+      const Eigen::Ref<const Eigen::MatrixXd> &b,
+      const Eigen::Ref<const Eigen::MatrixXd> &x0);
+  virtual void set_tolerance(float64 tolerance);
+  virtual void set_max_iterations(int max_iterations);
+  virtual int num_iterations();
+  virtual float64 error();
+
+ protected:
+  explicit SparseSolver(DataType dtype) : dtype_(dtype) {
+  }
+
+  DataType dtype_;
 };
 
-template <class EigenSolver>
+template <class EigenSolver, class EigenMatrix>
 class EigenSparseSolver : public SparseSolver {
- private:
-  EigenSolver solver_;
-
  public:
+  using Scalar = typename EigenMatrix::Scalar;
+
+  EigenSparseSolver() : SparseSolver(lang::get_data_type<Scalar>()) {
+  }
   virtual ~EigenSparseSolver() = default;
   virtual bool compute(const SparseMatrix &sm) override;
   virtual void analyze_pattern(const SparseMatrix &sm) override;
   virtual void factorize(const SparseMatrix &sm) override;
-  virtual Eigen::VectorXf solve(
-      const Eigen::Ref<const Eigen::VectorXf> &b) override;
+  virtual Eigen::MatrixXf solve(
+      const Eigen::Ref<const Eigen::MatrixXf> &b) override;
+  virtual Eigen::MatrixXd solve(
+      const Eigen::Ref<const Eigen::MatrixXd> &b) override;
   virtual bool info() override;
+
+ protected:
+  // Eigen solvers may keep a reference to the matrix they are given.
+  virtual const EigenMatrix &keep_matrix(const EigenMatrix &matrix) {
+    return matrix;
+  }
+
+  template <typename DenseMatrix>
+  DenseMatrix solve_typed(const Eigen::Ref<const DenseMatrix> &b);
+
+  EigenSolver solver_;
+
+ private:
+  bool same_pattern(const EigenMatrix &matrix) const;
+
+  bool analyzed_{false};
+  std::vector<typename EigenMatrix::StorageIndex> outer_pattern_;
+  std::vector<typename EigenMatrix::StorageIndex> inner_pattern_;
 };
 
-std::unique_ptr<SparseSolver> make_sparse_solver(const std::string &solver_type,
+/**
+ * Eigen's iterative solvers, e.g. ConjugateGradient. factorize() computes
+ * the preconditioner.
+ */
+template <class EigenSolver, class EigenMatrix>
+class EigenIterativeSolver
+    : public EigenSparseSolver<EigenSolver, EigenMatrix> {
+ public:
+  virtual Eigen::MatrixXf solve_with_guess(
+      const Eigen::Ref<const Eigen::MatrixXf> &b,
+      const Eigen::Ref<const Eigen::MatrixXf> &x0) override;
+  virtual Eigen::MatrixXd solve_with_guess(
+      const Eigen::Ref<const Eigen::MatrixXd> &b,
+      const Eigen::Ref<const Eigen::MatrixXd> &x0) override;
+  virtual void set_tolerance(float64 tolerance) override;
+  virtual void set_max_iterations(int max_iterations) override;
+  virtual int num_iterations() override;
+  virtual float64 error() override;
+
+ protected:
+  const EigenMatrix &keep_matrix(const EigenMatrix &matrix) override {
+    matrix_ = matrix;
+    return matrix_;
+  }
+
+ private:
+  template <typename DenseMatrix>
+  DenseMatrix solve_with_guess_typed(const Eigen::Ref<const DenseMatrix> &b,
+                                     const Eigen::Ref<const DenseMatrix> &x0);
+
+  EigenMatrix matrix_;
+};
+
+/**
+ * @param dtype: f32 or f64, the value type of the matrices to solve.
+ * @param solver_type: "LLT", "LDLT" or "LU".
+ * @param ordering: "AMD" or "COLAMD".
+ */
+std::unique_ptr<SparseSolver> make_sparse_solver(DataType dtype,
+                                                 const std::string &solver_type,
                                                  const std::string &ordering);
 
+/**
+ * @param dtype: f32 or f64, the value type of the matrices to solve.
+ * @param solver_type: "CG" for symmetric positive definite matrices, or
+ * "BICGSTAB".
+ * @param preconditioner: "Jacobi", or "IC" (incomplete Cholesky) for CG and
+ * "ILUT" (incomplete LU) for BICGSTAB.
+ */
+std::unique_ptr<SparseSolver> make_iterative_solver(
+    DataType dtype,
+    const std::string &solver_type,
+    const std::string &preconditioner);
+
 }  // namespace lang
 }  // namespace taichi
@@ -1,6 +1,7 @@
 #include "taichi/program/state_flow_graph.h"
 
 #include <algorithm>
+#include <cstring>
 #include <limits>
 #include <set>
 #include <sstream>
@@ -865,6 +866,12 @@ void StateFlowGraph::rebuild_graph(bool sort) {
         num_executed_tasks++;
     }
   }
+  rebuild_graph_from(tasks, num_executed_tasks);
+}
+
+void StateFlowGraph::rebuild_graph_from(
+    const std::vector<TaskLaunchRecord> &tasks,
+    int num_executed_tasks) {
   clear();
   insert_tasks(tasks, false);
   for (int i = 1; i <= num_executed_tasks; i++) {
@@ -877,14 +884,103 @@ void StateFlowGraph::rebuild_graph(bool sort) {
   sort_node_edges();
 }
 
-std::vector<TaskLaunchRecord> StateFlowGraph::extract_to_execute() {
+std::vector<uint64> StateFlowGraph::get_pending_trace() const {
+  TI_AUTO_PROF;
+  std::vector<uint64> trace;
+  trace.reserve(1 + first_pending_task_index_ + 3 * num_pending_tasks());
+  trace.push_back(first_pending_task_index_);
+  for (int i = 1; i < first_pending_task_index_; i++) {
+    trace.push_back(nodes_[i]->rec.ir_handle.hash());
+  }
+  // The pending tasks launching each kernel, by position.
+  std::unordered_map<const Kernel *, std::vector<int>> launches;
+  for (int i = first_pending_task_index_; i < (int)nodes_.size(); i++) {
+    const auto &rec = nodes_[i]->rec;
+    const int num_args = rec.kernel->args.size();
+    // The position of the first task with the same kernel and arguments.
+    int same_args = i - first_pending_task_index_;
+    auto &kernel_launches = launches[rec.kernel];
+    for (int j : kernel_launches) {
+      const auto &other = nodes_[first_pending_task_index_ + j]->rec.context;
+      if (std::memcmp(other.args, rec.context.args,
+                      num_args * sizeof(rec.context.args[0])) == 0 &&
+          std::memcmp(other.extra_args, rec.context.extra_args,
+                      sizeof(rec.context.extra_args)) == 0) {
+        same_args = j;
+        break;
+      }
+    }
+    if (same_args == i - first_pending_task_index_) {
+      kernel_launches.push_back(same_args);
+    }
+    trace.push_back(rec.ir_handle.hash());
+    trace.push_back(reinterpret_cast<uint64>(rec.kernel));
+    trace.push_back(same_args);
+  }
+  return trace;
+}
+
+void StateFlowGraph::replace_pending_tasks(
+    const std::vector<TaskLaunchRecord> &tasks) {
+  TI_AUTO_PROF;
+  std::vector<TaskLaunchRecord> records;
+  records.reserve(first_pending_task_index_ + tasks.size());
+  for (int i = 1; i < first_pending_task_index_; i++) {
+    records.push_back(nodes_[i]->rec);
+  }
+  const int num_executed_tasks = records.size();
+  records.insert(records.end(), tasks.begin(), tasks.end());
+  rebuild_graph_from(records, num_executed_tasks);
+}
+
+std::vector<TaskLaunchRecord> StateFlowGraph::extract_to_execute(
+    std::vector<std::vector<int>> *deps) {
   TI_AUTO_PROF;
   auto nodes = get_pending_tasks();
   std::vector<TaskLaunchRecord> tasks;
   tasks.reserve(nodes.size());
+  if (deps) {
+    deps->clear();
+    deps->reserve(nodes.size());
+  }
+  std::unordered_set<int> has_dependents;
   for (auto &node : nodes) {
     if (!node->rec.empty()) {
       tasks.push_back(node->rec);
+      if (deps) {
+        // Edges of all kinds (RAW, WAR and WAW) go into |input_edges|, and
+        // a node can have several edges from the same node. Only the edges
+        // between pending tasks are complete: the readers of a state are
+        // not retained once executed, so their WAR edges are lost.
+        auto &task_deps = deps->emplace_back();
+        for (const auto &edge : node->input_edges.get_all_edges()) {
+          if (edge.second->pending()) {
+            task_deps.push_back(edge.second->rec.id);
+          }
+        }
+        if (task_deps.empty()) {
+          // The other tasks depend on this one or on its successors.
+          task_deps = last_extracted_sinks_;
+        }
+        if (node->meta->has_untracked_side_effects) {
+          if (last_untracked_side_effect_task_ >= 0) {
+            task_deps.push_back(last_untracked_side_effect_task_);
+          }
+          last_untracked_side_effect_task_ = node->rec.id;
+        }
+        std::sort(task_deps.begin(), task_deps.end());
+        task_deps.erase(std::unique(task_deps.begin(), task_deps.end()),
+                        task_deps.end());
+        has_dependents.insert(task_deps.begin(), task_deps.end());
+      }
+    }
+  }
+  if (deps) {
+    last_extracted_sinks_.clear();
+    for (const auto &task : tasks) {
+      if (has_dependents.count(task.id) == 0) {
+        last_extracted_sinks_.push_back(task.id);
+      }
     }
   }
   mark_pending_tasks_as_executed();
@@ -296,8 +296,23 @@ class StateFlowGraph {
   // Extract all pending tasks and insert them in topological/original order.
   void rebuild_graph(bool sort);
 
-  // Extract all tasks to execute.
-  std::vector<TaskLaunchRecord> extract_to_execute();
+  // Identifies what the optimization passes see: the IR of the executed tasks
+  // retained in the graph, and the IR and kernel of the pending tasks. Launch
+  // arguments only count through which pending tasks launch the same kernel
+  // with the same arguments.
+  std::vector<uint64> get_pending_trace() const;
+
+  // Replaces the pending tasks with |tasks|.
+  void replace_pending_tasks(const std::vector<TaskLaunchRecord> &tasks);
+
+  // Extract all tasks to execute. If |deps| is not null, (*deps)[i] receives
+  // the TaskLaunchRecord::id of the tasks that the i-th task must execute
+  // after: the pending tasks it has an edge from, and the previous task with
+  // untracked side effects if it has some too. Tasks without either depend
+  // on the tasks extracted last time that nothing depended on, so that the
+  // tasks extracted now start after those extracted earlier.
+  std::vector<TaskLaunchRecord> extract_to_execute(
+      std::vector<std::vector<int>> *deps = nullptr);
 
   std::size_t size() const {
     return nodes_.size();
@@ -321,6 +336,11 @@ class StateFlowGraph {
       llvm::SmallVector<std::pair<AsyncState, llvm::SmallSet<Node *, 8>>, 4>;
 
  private:
+  // Rebuilds the graph from |tasks|, the first |num_executed_tasks| of which
+  // have been executed.
+  void rebuild_graph_from(const std::vector<TaskLaunchRecord> &tasks,
+                          int num_executed_tasks);
+
   std::vector<std::unique_ptr<Node>> nodes_;
   Node *initial_node_;  // The initial node holds all the initial states.
   int first_pending_task_index_;
@@ -330,6 +350,12 @@ class StateFlowGraph {
   std::unordered_map<std::string, int> task_name_to_launch_ids_;
   IRBank *ir_bank_;
   std::unordered_map<SNode *, bool> list_up_to_date_;
+  // The TaskLaunchRecord::id of the last extracted task with untracked side
+  // effects, or -1.
+  int last_untracked_side_effect_task_{-1};
+  // The TaskLaunchRecord::id of the tasks of the last extract_to_execute()
+  // that no other task extracted with them depended on.
+  std::vector<int> last_extracted_sinks_;
   [[maybe_unused]] AsyncEngine *engine_;
   const CompileConfig *const config_;
 };
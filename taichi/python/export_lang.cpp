@@ -19,6 +19,7 @@
 #include "taichi/program/snode_rw_accessors_bank.h"
 #include "taichi/program/ndarray.h"
 #include "taichi/program/ndarray_rw_accessors_bank.h"
+#include "taichi/program/launch_graph.h"
 #include "taichi/common/interface.h"
 #include "taichi/python/export.h"
 #include "taichi/gui/gui.h"
@@ -37,6 +38,10 @@
 #include "taichi/backends/cuda/cuda_context.h"
 #endif
 
+#if defined(TI_WITH_LLVM)
+#include "taichi/backends/cpu/aot_module_loader_impl.h"
+#endif
+
 TI_NAMESPACE_BEGIN
 bool test_threading();
 
@@ -137,7 +142,6 @@ void export_lang(py::module &m) {
       .def_readwrite("cfg_optimization", &CompileConfig::cfg_optimization)
       .def_readwrite("check_out_of_bound", &CompileConfig::check_out_of_bound)
       .def_readwrite("print_accessor_ir", &CompileConfig::print_accessor_ir)
-      .def_readwrite("print_evaluator_ir", &CompileConfig::print_evaluator_ir)
       .def_readwrite("use_llvm", &CompileConfig::use_llvm)
       .def_readwrite("print_benchmark_stat",
                      &CompileConfig::print_benchmark_stat)
@@ -148,6 +152,11 @@ void export_lang(py::module &m) {
       .def_readwrite("print_kernel_llvm_ir_optimized",
                      &CompileConfig::print_kernel_llvm_ir_optimized)
       .def_readwrite("print_kernel_nvptx", &CompileConfig::print_kernel_nvptx)
+      .def_readwrite("offline_cache", &CompileConfig::offline_cache)
+      .def_readwrite("offline_cache_file_path",
+                     &CompileConfig::offline_cache_file_path)
+      .def_readwrite("offline_cache_max_size_MB",
+                     &CompileConfig::offline_cache_max_size_MB)
       .def_readwrite("simplify_before_lower_access",
                      &CompileConfig::simplify_before_lower_access)
       .def_readwrite("simplify_after_lower_access",
@@ -163,6 +172,21 @@ void export_lang(py::module &m) {
       .def_readwrite("saturating_grid_dim", &CompileConfig::saturating_grid_dim)
       .def_readwrite("max_block_dim", &CompileConfig::max_block_dim)
       .def_readwrite("cpu_max_num_threads", &CompileConfig::cpu_max_num_threads)
+      .def_readwrite("cpu_pin_threads", &CompileConfig::cpu_pin_threads)
+      .def_readwrite("cpu_node_allocator_cache",
+                     &CompileConfig::cpu_node_allocator_cache)
+      .def_readwrite("cpu_gc_lazy_zero_fill",
+                     &CompileConfig::cpu_gc_lazy_zero_fill)
+      .def_readwrite("cpu_deterministic_listgen",
+                     &CompileConfig::cpu_deterministic_listgen)
+      .def_readwrite("cpu_range_for_schedule",
+                     &CompileConfig::cpu_range_for_schedule)
+      .def_readwrite("cpu_simd_range_for", &CompileConfig::cpu_simd_range_for)
+      .def_readwrite("simd_width", &CompileConfig::simd_width)
+      .def_readwrite("cpu_async_launch", &CompileConfig::cpu_async_launch)
+      .def_readwrite("cpu_aot_link_cmd", &CompileConfig::cpu_aot_link_cmd)
+      .def_readwrite("num_compile_threads",
+                     &CompileConfig::num_compile_threads)
       .def_readwrite("random_seed", &CompileConfig::random_seed)
       .def_readwrite("verbose_kernel_launches",
                      &CompileConfig::verbose_kernel_launches)
@@ -199,11 +223,15 @@ void export_lang(py::module &m) {
       .def_readwrite("async_opt_dse", &CompileConfig::async_opt_dse)
       .def_readwrite("async_listgen_fast_filtering",
                      &CompileConfig::async_listgen_fast_filtering)
+      .def_readwrite("async_opt_trace_cache",
+                     &CompileConfig::async_opt_trace_cache)
       .def_readwrite("async_opt_intermediate_file",
                      &CompileConfig::async_opt_intermediate_file)
       .def_readwrite("async_flush_every", &CompileConfig::async_flush_every)
       .def_readwrite("async_max_fuse_per_task",
                      &CompileConfig::async_max_fuse_per_task)
+      .def_readwrite("async_max_concurrent_tasks",
+                     &CompileConfig::async_max_concurrent_tasks)
       .def_readwrite("quant_opt_store_fusion",
                      &CompileConfig::quant_opt_store_fusion)
       .def_readwrite("quant_opt_atomic_demotion",
@@ -251,14 +279,31 @@ void export_lang(py::module &m) {
                      &KernelProfileTracedRecord::kernel_elapsed_time_in_ms)
       .def_readwrite("base_time", &KernelProfileTracedRecord::time_since_base)
       .def_readwrite("name", &KernelProfileTracedRecord::name)
+      .def_readwrite("iterations", &KernelProfileTracedRecord::iterations)
+      .def_readwrite("load_imbalance",
+                     &KernelProfileTracedRecord::load_imbalance)
       .def_readwrite("metric_values",
                      &KernelProfileTracedRecord::metric_values);
 
+  py::class_<KernelProfileStatisticalResult>(m,
+                                             "KernelProfileStatisticalResult")
+      .def_readonly("name", &KernelProfileStatisticalResult::name)
+      .def_readonly("counter", &KernelProfileStatisticalResult::counter)
+      .def_readonly("min", &KernelProfileStatisticalResult::min)
+      .def_readonly("max", &KernelProfileStatisticalResult::max)
+      .def_readonly("total", &KernelProfileStatisticalResult::total)
+      .def_readonly("iterations", &KernelProfileStatisticalResult::iterations)
+      .def_readonly("worker_time",
+                    &KernelProfileStatisticalResult::worker_time);
+
   py::class_<Program>(m, "Program")
       .def(py::init<>())
       .def_readonly("config", &Program::config)
       .def("sync_kernel_profiler",
-           [](Program *program) { program->profiler->sync(); })
+           [](Program *program) {
+             program->synchronize();
+             program->profiler->sync();
+           })
       .def("query_kernel_profile_info",
            [](Program *program, const std::string &name) {
              return program->query_kernel_profile_info(name);
@@ -267,6 +312,10 @@ void export_lang(py::module &m) {
            [](Program *program) {
              return program->profiler->get_traced_records();
            })
+      .def("get_kernel_profiler_statistics",
+           [](Program *program) {
+             return program->profiler->get_statistical_results();
+           })
       .def(
           "get_kernel_profiler_device_name",
           [](Program *program) { return program->profiler->get_device_name(); })
@@ -294,6 +343,9 @@ void export_lang(py::module &m) {
              program->async_engine->sfg->benchmark_rebuild_graph();
            })
       .def("synchronize", &Program::synchronize)
+      .def("record_event", &Program::record_event)
+      .def("query_event", &Program::query_event)
+      .def("wait_event", &Program::wait_event)
       .def("async_flush", &Program::async_flush)
       .def("materialize_runtime", &Program::materialize_runtime)
       .def("make_aot_module_builder", &Program::make_aot_module_builder)
@@ -307,6 +359,42 @@ void export_lang(py::module &m) {
       .def("add_kernel_template", &AotModuleBuilder::add_kernel_template)
       .def("dump", &AotModuleBuilder::dump);
 
+#if defined(TI_WITH_LLVM)
+  py::class_<cpu::AotModuleLoaderImpl>(m, "CpuAotModuleLoader")
+      .def(py::init<const std::string &, const std::string &>())
+      .def("run_kernel",
+           [](cpu::AotModuleLoaderImpl *self, const std::string &identifier,
+              py::args args) {
+             using Loader = cpu::AotModuleLoaderImpl;
+             const auto &kernel = self->get_kernel_data(identifier);
+             TI_ERROR_IF(args.size() != kernel.args.size(),
+                         "AOT: kernel {} takes {} arguments, {} given",
+                         identifier, kernel.args.size(), args.size());
+             auto context = self->make_context();
+             for (int i = 0; i < (int)args.size(); i++) {
+               const auto &arg = kernel.args[i];
+               if (arg.is_external_array) {
+                 // Written in place, so no contiguous copy is made.
+                 auto array = args[i].cast<py::array>();
+                 TI_ERROR_IF(!(array.flags() & py::array::c_style),
+                             "AOT: ndarray argument {} is not contiguous", i);
+                 std::vector<int> shape(array.shape(),
+                                        array.shape() + array.ndim());
+                 Loader::set_arg_ndarray(context, arg, i, array.mutable_data(),
+                                         shape);
+               } else if (py::isinstance<py::int_>(args[i])) {
+                 Loader::set_arg_int(context, arg, i, args[i].cast<int64>());
+               } else {
+                 Loader::set_arg_float(context, arg, i,
+                                       args[i].cast<float64>());
+               }
+             }
+             self->get_kernel(identifier)(context);
+           })
+      .def("get_ret_i32", &cpu::AotModuleLoaderImpl::get_ret<int32>)
+      .def("get_ret_f32", &cpu::AotModuleLoaderImpl::get_ret<float32>);
+#endif
+
   m.def("get_current_program", get_current_program,
         py::return_value_policy::reference);
 
@@ -332,7 +420,8 @@ void export_lang(py::module &m) {
           py::return_value_policy::reference)
       .def("hash",
            (SNode & (SNode::*)(const std::vector<Axis> &,
-                               const std::vector<int> &, bool))(&SNode::hash),
+                               const std::vector<int> &, int,
+                               bool))(&SNode::hash),
            py::return_value_policy::reference)
       .def("dynamic", &SNode::dynamic, py::return_value_policy::reference)
       .def("bitmasked",
@@ -453,6 +542,18 @@ void export_lang(py::module &m) {
       .def("set_extra_arg_int",
            &Kernel::LaunchContextBuilder::set_extra_arg_int);
 
+  py::class_<LaunchGraph>(m, "LaunchGraph")
+      .def(py::init<Program *>())
+      .def("add_launch", &LaunchGraph::add_launch)
+      .def("bind_arg", &LaunchGraph::bind_arg)
+      .def("set_arg_int", &LaunchGraph::set_arg_int)
+      .def("set_arg_float", &LaunchGraph::set_arg_float)
+      .def("num_launches", &LaunchGraph::num_launches)
+      .def("run", [](LaunchGraph *graph) {
+        py::gil_scoped_release release;
+        graph->run();
+      });
+
   py::class_<Function>(m, "Function")
       .def("set_function_body",
            py::overload_cast<const std::function<void()> &>(
@@ -894,6 +995,11 @@ void export_lang(py::module &m) {
       },
       py::return_value_policy::reference);
 
+  m.def("compile_kernels", [](const std::vector<Kernel *> &kernels) {
+    py::gil_scoped_release release;
+    Kernel::compile_batch(&get_current_program(), kernels);
+  });
+
   m.def(
       "create_function",
       [&](const FunctionKey &funcid) {
@@ -1115,46 +1221,91 @@ void export_lang(py::module &m) {
   py::class_<SparseMatrixBuilder>(m, "SparseMatrixBuilder")
       .def("print_triplets", &SparseMatrixBuilder::print_triplets)
       .def("build", &SparseMatrixBuilder::build)
+      .def("get_data_type", &SparseMatrixBuilder::get_data_type)
       .def("get_addr", [](SparseMatrixBuilder *mat) { return uint64(mat); });
 
   m.def("create_sparse_matrix_builder",
-        [](int n, int m, uint64 max_num_entries) {
-          TI_ERROR_IF(!arch_is_cpu(get_current_program().config.arch),
-                      "SparseMatrix only supports CPU for now.");
-          return SparseMatrixBuilder(n, m, max_num_entries);
+        [](int n, int m, uint64 max_num_entries, DataType dtype) {
+          return get_current_program().create_sparse_matrix_builder(
+              n, m, max_num_entries, dtype);
         });
 
   py::class_<SparseMatrix>(m, "SparseMatrix")
       .def("to_string", &SparseMatrix::to_string)
-      .def(py::self + py::self, py::return_value_policy::reference_internal)
-      .def(py::self - py::self, py::return_value_policy::reference_internal)
-      .def(float() * py::self, py::return_value_policy::reference_internal)
-      .def(py::self * float(), py::return_value_policy::reference_internal)
-      .def(py::self * py::self, py::return_value_policy::reference_internal)
-      .def("matmul", &SparseMatrix::matmul,
-           py::return_value_policy::reference_internal)
-      .def("mat_vec_mul", &SparseMatrix::mat_vec_mul)
-      .def("transpose", &SparseMatrix::transpose,
-           py::return_value_policy::reference_internal)
-      .def("get_element", &SparseMatrix::get_element)
-      .def("set_element", &SparseMatrix::set_element)
       .def("num_rows", &SparseMatrix::num_rows)
-      .def("num_cols", &SparseMatrix::num_cols);
-
-  m.def("create_sparse_matrix", [](int n, int m) {
+      .def("num_cols", &SparseMatrix::num_cols)
+      .def("num_nonzeros", &SparseMatrix::num_nonzeros)
+      .def("get_data_type", &SparseMatrix::get_data_type)
+      .def("get_storage_format", &SparseMatrix::get_storage_format);
+
+#define MAKE_SPARSE_MATRIX(TYPE, ORDER, INDEX)                                 \
+  {                                                                            \
+    using T = EigenSparseMatrix<                                               \
+        Eigen::SparseMatrix<float##TYPE, Eigen::ORDER, int##INDEX>>;           \
+    py::class_<T, SparseMatrix>(m, "EigenSparseMatrixf" #TYPE #ORDER #INDEX)   \
+        .def(py::self + py::self, py::return_value_policy::reference_internal) \
+        .def(py::self - py::self, py::return_value_policy::reference_internal) \
+        .def(float64() * py::self,                                             \
+             py::return_value_policy::reference_internal)                      \
+        .def(py::self * float64(),                                             \
+             py::return_value_policy::reference_internal)                      \
+        .def(py::self * py::self, py::return_value_policy::reference_internal) \
+        .def("matmul", &T::matmul,                                             \
+             py::return_value_policy::reference_internal)                      \
+        .def("mat_vec_mul", &T::mat_vec_mul)                                   \
+        .def("transpose", &T::transpose,                                       \
+             py::return_value_policy::reference_internal)                      \
+        .def("get_element", &T::get_element)                                   \
+        .def("set_element", &T::set_element);                                  \
+  }
+
+  MAKE_SPARSE_MATRIX(32, ColMajor, 32);
+  MAKE_SPARSE_MATRIX(32, ColMajor, 64);
+  MAKE_SPARSE_MATRIX(32, RowMajor, 32);
+  MAKE_SPARSE_MATRIX(32, RowMajor, 64);
+  MAKE_SPARSE_MATRIX(64, ColMajor, 32);
+  MAKE_SPARSE_MATRIX(64, ColMajor, 64);
+  MAKE_SPARSE_MATRIX(64, RowMajor, 32);
+  MAKE_SPARSE_MATRIX(64, RowMajor, 64);
+#undef MAKE_SPARSE_MATRIX
+
+  m.def("create_sparse_matrix", [](int n, int m, DataType dtype,
+                                   const std::string &storage_format,
+                                   DataType index_dtype) {
     TI_ERROR_IF(!arch_is_cpu(get_current_program().config.arch),
                 "SparseMatrix only supports CPU for now.");
-    return SparseMatrix(n, m);
+    return make_sparse_matrix(n, m, dtype, storage_format, index_dtype);
   });
 
+  using DenseMatrixf = Eigen::Ref<const Eigen::MatrixXf>;
+  using DenseMatrixd = Eigen::Ref<const Eigen::MatrixXd>;
   py::class_<SparseSolver>(m, "SparseSolver")
       .def("compute", &SparseSolver::compute)
       .def("analyze_pattern", &SparseSolver::analyze_pattern)
       .def("factorize", &SparseSolver::factorize)
-      .def("solve", &SparseSolver::solve)
+      .def("solve", py::overload_cast<const DenseMatrixf &>(
+                        &SparseSolver::solve),
+           py::call_guard<py::gil_scoped_release>())
+      .def("solve", py::overload_cast<const DenseMatrixd &>(
+                        &SparseSolver::solve),
+           py::call_guard<py::gil_scoped_release>())
+      .def("solve_with_guess",
+           py::overload_cast<const DenseMatrixf &, const DenseMatrixf &>(
+               &SparseSolver::solve_with_guess),
+           py::call_guard<py::gil_scoped_release>())
+      .def("solve_with_guess",
+           py::overload_cast<const DenseMatrixd &, const DenseMatrixd &>(
+               &SparseSolver::solve_with_guess),
+           py::call_guard<py::gil_scoped_release>())
+      .def("set_tolerance", &SparseSolver::set_tolerance)
+      .def("set_max_iterations", &SparseSolver::set_max_iterations)
+      .def("num_iterations", &SparseSolver::num_iterations)
+      .def("error", &SparseSolver::error)
+      .def("get_data_type", &SparseSolver::get_data_type)
       .def("info", &SparseSolver::info);
 
   m.def("make_sparse_solver", &make_sparse_solver);
+  m.def("make_iterative_solver", &make_iterative_solver);
 
   // Mesh Class
   // Mesh related.
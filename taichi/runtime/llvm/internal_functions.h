@@ -37,6 +37,24 @@ i32 insert_triplet(RuntimeContext *context,
   return 0;
 }
 
+// Triplets of f64 builders are padded to 16 bytes.
+i32 insert_triplet_f64(RuntimeContext *context,
+                       int64 base_ptr_,
+                       int i,
+                       int j,
+                       float64 value) {
+  auto base_ptr = (int64 *)base_ptr_;
+
+  int64 *num_triplets = base_ptr;
+  auto data_base_ptr = *(int32 **)(base_ptr + 1);
+
+  auto triplet_id = atomic_add_i64(num_triplets, 1);
+  data_base_ptr[triplet_id * 4] = i;
+  data_base_ptr[triplet_id * 4 + 1] = j;
+  *(float64 *)(data_base_ptr + triplet_id * 4 + 2) = value;
+  return 0;
+}
+
 i32 test_internal_func_args(RuntimeContext *context,
                             float32 i,
                             float32 j,
@@ -95,7 +113,7 @@ i32 test_node_allocator(RuntimeContext *context) {
   for (int i = 19; i < 24; i++) {
     auto idx = nodes->locate(ptrs[i]);
     taichi_printf(runtime, "i %d", i);
-    taichi_printf(runtime, "idx %d", idx);
+    taichi_printf(runtime, "idx %lld", idx);
     TI_TEST_CHECK(idx == i - 19, runtime);
   }
   return 0;
@@ -139,12 +157,34 @@ i32 test_node_allocator_gc_cpu(RuntimeContext *context) {
   }
   nodes->gc_serial();
   // After GC, all items should be returned to |free_list|.
-  taichi_printf(runtime, "free_list_size=%d\n", nodes->free_list->size());
+  taichi_printf(runtime, "free_list_size=%lld\n", nodes->free_list->size());
   TI_TEST_CHECK(nodes->free_list->size() == kN, runtime);
 
   return 0;
 }
 
+i32 test_list_manager_large(RuntimeContext *context) {
+  auto runtime = context->runtime;
+  constexpr i64 kN = (i64(1) << 31) + 1000;
+  constexpr i64 kBatch = i64(1) << 24;
+  auto list =
+      context->runtime->create<ListManager>(runtime, 1, 1 << 20, true);
+  while (list->size() < kN) {
+    auto n = list->size();
+    TI_TEST_CHECK(list->reserve_new_elements(min_i64(kBatch, kN - n)) == n,
+                  runtime);
+  }
+  TI_TEST_CHECK(list->size() == kN, runtime);
+  for (i64 i = kN - 2000; i < kN; i++) {
+    list->get<u8>(i) = u8(i % 251);
+  }
+  for (i64 i = kN - 2000; i < kN; i++) {
+    TI_TEST_CHECK(list->get<u8>(i) == u8(i % 251), runtime);
+    TI_TEST_CHECK(list->ptr2index(list->get_element_ptr(i)) == i, runtime);
+  }
+  return 0;
+}
+
 i32 test_active_mask(RuntimeContext *context) {
   auto rt = context->runtime;
   taichi_printf(rt, "%d activemask %x\n", thread_idx(), cuda_active_mask());
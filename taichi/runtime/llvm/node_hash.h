@@ -0,0 +1,199 @@
+#pragma once
+
+// A hash node maps the active cells of a potentially huge index space to
+// cells allocated on demand, using a fixed-size open-addressing table with
+// linear probing. A slot is claimed for a cell with a CAS on its key, so that
+// concurrent activations of the same cell agree on a single slot.
+//
+// A deactivated slot keeps its key so that concurrent probes never run into
+// a hole. Such dead slots are reclaimed by Hash_compact, which runs serially
+// during the GC task of the node and before its element list is generated.
+
+// Specialized Attributes and functions
+struct HashMeta : public StructMeta {
+  // A power of two.
+  i32 num_slots;
+};
+
+STRUCT_FIELD(HashMeta, num_slots);
+
+struct HashHeader {
+  // Slots claimed by a cell, dead or alive.
+  i32 num_used;
+  // Slots deactivated since the last compaction.
+  i32 num_dead;
+};
+
+struct HashSlot {
+  // The cell index plus one, or zero if the slot has never been claimed.
+  u32 key;
+  i32 lock;
+  Ptr data;
+};
+
+HashSlot *Hash_get_slots(Ptr node) {
+  return (HashSlot *)(node + sizeof(HashHeader));
+}
+
+i32 Hash_get_home_slot(u32 key, i32 num_slots) {
+  // Spread runs of neighboring cells over the table.
+  u32 h = key * 2654435769u;
+  return (i32)((h ^ (h >> 16)) & u32(num_slots - 1));
+}
+
+// Returns the slot of cell |i|, or nullptr if it has never been activated.
+HashSlot *Hash_find_slot(HashMeta *meta, Ptr node, int i) {
+  auto slots = Hash_get_slots(node);
+  auto num_slots = meta->num_slots;
+  u32 key = u32(i) + 1;
+  auto s = Hash_get_home_slot(key, num_slots);
+  while (true) {
+    auto k = __atomic_load_n(&slots[s].key, __ATOMIC_ACQUIRE);
+    if (k == key) {
+      return &slots[s];
+    }
+    if (k == 0) {
+      return nullptr;
+    }
+    s = (s + 1) & (num_slots - 1);
+  }
+}
+
+// Returns the slot of cell |i|, claiming one if needed, or nullptr if the
+// table is full.
+HashSlot *Hash_claim_slot(HashMeta *meta, Ptr node, int i) {
+  auto header = (HashHeader *)node;
+  auto slots = Hash_get_slots(node);
+  auto num_slots = meta->num_slots;
+  u32 key = u32(i) + 1;
+  bool reserved = false;
+  auto s = Hash_get_home_slot(key, num_slots);
+  while (true) {
+    auto k = __atomic_load_n(&slots[s].key, __ATOMIC_ACQUIRE);
+    if (k == 0) {
+      if (!reserved) {
+        // Keep at least one slot empty so that every probe terminates.
+        if (atomic_add_i32(&header->num_used, 1) >= num_slots - 1) {
+          atomic_add_i32(&header->num_used, -1);
+          taichi_assert(meta->context, 0,
+                        "Hash node is full. Please increase max_num_active.");
+          return nullptr;
+        }
+        reserved = true;
+      }
+      if (__atomic_compare_exchange_n(&slots[s].key, &k, key, false,
+                                      __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        return &slots[s];
+      }
+      // |k| now holds the key of the thread that got there first.
+    }
+    if (k == key) {
+      if (reserved) {
+        atomic_add_i32(&header->num_used, -1);
+      }
+      return &slots[s];
+    }
+    s = (s + 1) & (num_slots - 1);
+  }
+}
+
+// Empties the dead slots, then reinserts the live entries so that no probe
+// sequence runs into the new holes. Must not run concurrently with any other
+// access to the node.
+void Hash_compact(HashMeta *meta, Ptr node) {
+  auto header = (HashHeader *)node;
+  if (header->num_dead == 0) {
+    return;
+  }
+  auto slots = Hash_get_slots(node);
+  auto num_slots = meta->num_slots;
+  auto mask = num_slots - 1;
+  // No probe sequence crosses a slot that has never been claimed, so the
+  // reinsertion starts right after one.
+  i32 start = 0;
+  while (slots[start].key != 0) {
+    start++;
+  }
+  for (i32 s = 0; s < num_slots; s++) {
+    if (slots[s].key != 0 && slots[s].data == nullptr) {
+      slots[s].key = 0;
+      header->num_used--;
+    }
+  }
+  // Each live entry moves to the first empty slot of its probe sequence,
+  // which is never past its current position.
+  for (i32 t = 1; t < num_slots; t++) {
+    auto s = (start + t) & mask;
+    auto key = slots[s].key;
+    if (key == 0) {
+      continue;
+    }
+    auto data = slots[s].data;
+    slots[s].key = 0;
+    slots[s].data = nullptr;
+    auto d = Hash_get_home_slot(key, num_slots);
+    while (slots[d].key != 0) {
+      d = (d + 1) & mask;
+    }
+    slots[d].key = key;
+    slots[d].data = data;
+  }
+  header->num_dead = 0;
+}
+
+i32 Hash_get_num_elements(Ptr meta, Ptr node) {
+  return ((StructMeta *)meta)->max_num_elements;
+}
+
+void Hash_activate(Ptr meta_, Ptr node, int i) {
+  auto meta = (HashMeta *)meta_;
+  auto slot = Hash_claim_slot(meta, node, i);
+  if (slot == nullptr || slot->data != nullptr) {
+    return;
+  }
+  auto alloc = meta->context->runtime->node_allocators[meta->snode_id];
+#if defined(ARCH_x64) || defined(ARCH_arm64)
+  if (alloc->caches != nullptr) {
+    auto allocated = alloc->allocate(meta->context);
+    Ptr expected = nullptr;
+    if (!__atomic_compare_exchange_n(&slot->data, &expected, allocated, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+      alloc->release_unused(meta->context, allocated);
+    }
+    return;
+  }
+#endif
+  locked_task(
+      &slot->lock, [&] { slot->data = alloc->allocate(meta->context); },
+      [&]() { return slot->data == nullptr; });
+}
+
+void Hash_deactivate(Ptr meta_, Ptr node, int i) {
+  auto meta = (HashMeta *)meta_;
+  auto slot = Hash_find_slot(meta, node, i);
+  if (slot == nullptr || slot->data == nullptr) {
+    return;
+  }
+  locked_task(&slot->lock, [&] {
+    if (slot->data != nullptr) {
+      auto alloc = meta->context->runtime->node_allocators[meta->snode_id];
+      alloc->recycle(meta->context, slot->data);
+      slot->data = nullptr;
+      atomic_add_i32(&((HashHeader *)node)->num_dead, 1);
+    }
+  });
+}
+
+i32 Hash_is_active(Ptr meta, Ptr node, int i) {
+  auto slot = Hash_find_slot((HashMeta *)meta, node, i);
+  return slot != nullptr && slot->data != nullptr;
+}
+
+Ptr Hash_lookup_element(Ptr meta, Ptr node, int i) {
+  auto slot = Hash_find_slot((HashMeta *)meta, node, i);
+  if (slot == nullptr || slot->data == nullptr) {
+    auto smeta = (StructMeta *)meta;
+    return smeta->context->runtime->ambient_elements[smeta->snode_id];
+  }
+  return slot->data;
+}
@@ -45,6 +45,21 @@ void Pointer_activate(Ptr meta_, Ptr node, int i) {
   volatile Ptr *data_ptr = (Ptr *)(node + 8 * (num_elements + i));
 
   if (*data_ptr == nullptr) {
+#if defined(ARCH_x64) || defined(ARCH_arm64)
+    auto alloc = meta->context->runtime->node_allocators[meta->snode_id];
+    if (alloc->caches != nullptr) {
+      // Lock-free: install a node from this thread's cache, and hand it back
+      // if another thread got there first.
+      auto allocated = alloc->allocate(meta->context);
+      Ptr expected = nullptr;
+      if (!__atomic_compare_exchange_n((Ptr *)data_ptr, &expected, allocated,
+                                       false, __ATOMIC_SEQ_CST,
+                                       __ATOMIC_SEQ_CST)) {
+        alloc->release_unused(meta->context, allocated);
+      }
+      return;
+    }
+#endif
     // The cuda_ calls will return 0 or do noop on CPUs
     u32 mask = cuda_active_mask();
     if (is_representative(mask, (u64)lock)) {
@@ -74,7 +89,7 @@ void Pointer_deactivate(Ptr meta, Ptr node, int i) {
         auto smeta = (StructMeta *)meta;
         auto rt = smeta->context->runtime;
         auto alloc = rt->node_allocators[smeta->snode_id];
-        alloc->recycle(data_ptr);
+        alloc->recycle(smeta->context, data_ptr);
         data_ptr = nullptr;
       }
     });
@@ -35,12 +35,19 @@ using host_vsnprintf_type = int (*)(char *,
                                     std::va_list);
 using vm_allocator_type = void *(*)(void *, std::size_t, std::size_t);
 using RangeForTaskFunc = void(RuntimeContext *, const char *tls, int i);
+// Runs the iterations of a range-for in [begin, end), in descending order if
+// the loop is reversed.
+using RangeForBlockTaskFunc = void(RuntimeContext *,
+                                   const char *tls,
+                                   int begin,
+                                   int end);
 using MeshForTaskFunc = void(RuntimeContext *, const char *tls, uint32_t i);
 using parallel_for_type = void (*)(void *thread_pool,
                                    int splits,
                                    int num_desired_threads,
                                    void *context,
-                                   void (*func)(void *, int thread_id, int i));
+                                   void (*func)(void *, int thread_id, int i),
+                                   int *thread_id_base);
 
 #if defined(__linux__) && !ARCH_cuda && defined(TI_ARCH_x64)
 __asm__(".symver logf,logf@GLIBC_2.2.5");
@@ -417,21 +424,28 @@ A simple list data structure that is infinitely long.
 Data are organized in chunks, where each chunk is allocated on demand.
 */
 
-// TODO: there are many i32 types in this class, which may be an issue if there
-// are >= 2 ** 31 elements.
 struct ListManager {
   static constexpr std::size_t max_num_chunks = 128 * 1024;
+  // Bytes in front of the elements of a chunk of a locatable list, holding
+  // the id of the chunk.
+  static constexpr std::size_t chunk_header_size = 64;
   Ptr chunks[max_num_chunks];
   std::size_t element_size{0};
   std::size_t max_num_elements_per_chunk;
   i32 log2chunk_num_elements;
   i32 lock;
-  i32 num_elements;
+  i64 num_elements;
+  // Non-zero if the list is locatable, i.e. supports ptr2index() in O(1):
+  // each chunk then starts at a multiple of this power of two, which is no
+  // smaller than the chunk, so the chunk header can be found from the address
+  // of any of its elements.
+  std::size_t chunk_alignment;
   LLVMRuntime *runtime;
 
   ListManager(LLVMRuntime *runtime,
               std::size_t element_size,
-              std::size_t num_elements_per_chunk)
+              std::size_t num_elements_per_chunk,
+              bool locatable = false)
       : element_size(element_size),
         max_num_elements_per_chunk(num_elements_per_chunk),
         runtime(runtime) {
@@ -440,17 +454,38 @@ struct ListManager {
     lock = 0;
     num_elements = 0;
     log2chunk_num_elements = taichi::log2int(num_elements_per_chunk);
+    chunk_alignment = 0;
+    if (locatable) {
+      chunk_alignment = 4096;
+      while (chunk_alignment < chunk_header_size + get_chunk_size()) {
+        chunk_alignment *= 2;
+      }
+    }
+  }
+
+  std::size_t get_chunk_size() {
+    return max_num_elements_per_chunk * element_size;
   }
 
   void append(void *data_ptr);
 
-  i32 reserve_new_element() {
-    auto i = atomic_add_i32(&num_elements, 1);
+  i64 reserve_new_element() {
+    auto i = atomic_add_i64(&num_elements, 1);
     auto chunk_id = i >> log2chunk_num_elements;
     touch_chunk(chunk_id);
     return i;
   }
 
+  // Reserves |n| consecutive elements, and returns the index of the first.
+  i64 reserve_new_elements(i64 n) {
+    auto i = atomic_add_i64(&num_elements, n);
+    for (auto chunk_id = i >> log2chunk_num_elements;
+         chunk_id <= ((i + n - 1) >> log2chunk_num_elements); chunk_id++) {
+      touch_chunk(chunk_id);
+    }
+    return i;
+  }
+
   template <typename T>
   void push_back(const T &t) {
     this->append((void *)&t);
@@ -458,7 +493,7 @@ struct ListManager {
 
   Ptr allocate();
 
-  void touch_chunk(int chunk_id);
+  void touch_chunk(i64 chunk_id);
 
   i32 get_num_active_chunks() {
     i32 counter = 0;
@@ -472,36 +507,42 @@ struct ListManager {
     num_elements = 0;
   }
 
-  void resize(i32 n) {
+  void resize(i64 n) {
     num_elements = n;
   }
 
-  Ptr get_element_ptr(i32 i) {
+  Ptr get_element_ptr(i64 i) {
     return chunks[i >> log2chunk_num_elements] +
-           element_size * (i & ((1 << log2chunk_num_elements) - 1));
+           element_size * (i & ((i64(1) << log2chunk_num_elements) - 1));
   }
 
   template <typename T>
-  T &get(i32 i) {
+  T &get(i64 i) {
     return *(T *)get_element_ptr(i);
   }
 
-  Ptr touch_and_get(i32 i) {
+  Ptr touch_and_get(i64 i) {
     touch_chunk(i >> log2chunk_num_elements);
     return get_element_ptr(i);
   }
 
-  i32 size() {
+  i64 size() {
     return num_elements;
   }
 
-  i32 ptr2index(Ptr ptr) {
-    auto chunk_size = max_num_elements_per_chunk * element_size;
+  i64 ptr2index(Ptr ptr) {
+    if (chunk_alignment != 0) {
+      auto header = (Ptr)((u64)ptr & ~(u64)(chunk_alignment - 1));
+      auto chunk_id = *(i64 *)header;
+      return (chunk_id << log2chunk_num_elements) +
+             i64((ptr - chunks[chunk_id]) / element_size);
+    }
+    auto chunk_size = get_chunk_size();
     for (int i = 0; i < max_num_chunks; i++) {
       taichi_assert_runtime(runtime, chunks[i] != nullptr, "ptr not found.");
       if (chunks[i] <= ptr && ptr < chunks[i] + chunk_size) {
-        return (i << log2chunk_num_elements) +
-               i32((ptr - chunks[i]) / element_size);
+        return (i64(i) << log2chunk_num_elements) +
+               i64((ptr - chunks[i]) / element_size);
       }
     }
     return -1;
@@ -570,6 +611,11 @@ struct LLVMRuntime {
   Ptr profiler;
   void (*profiler_start)(Ptr, Ptr);
   void (*profiler_stop)(Ptr);
+  void (*profiler_add_iterations)(Ptr, i64);
+  // Number of per-thread caches in each NodeManager. 0 disables them.
+  i32 num_node_allocator_caches;
+  // Zero-fill recycled elements when they are reused rather than during GC.
+  i32 node_allocator_lazy_zero_fill;
 
   char error_message_template[taichi_error_message_max_length];
   uint64 error_message_arguments[taichi_error_message_max_num_arguments];
@@ -612,6 +658,24 @@ STRUCT_FIELD(LLVMRuntime, host_vsnprintf);
 STRUCT_FIELD(LLVMRuntime, profiler);
 STRUCT_FIELD(LLVMRuntime, profiler_start);
 STRUCT_FIELD(LLVMRuntime, profiler_stop);
+STRUCT_FIELD(LLVMRuntime, profiler_add_iterations);
+STRUCT_FIELD(LLVMRuntime, num_node_allocator_caches);
+STRUCT_FIELD(LLVMRuntime, node_allocator_lazy_zero_fill);
+
+// A per-thread cache of elements of a NodeManager (CPU only). Allocations
+// are served from |free| which is refilled in batches, and recycled elements
+// are buffered in |recycled| and returned to the NodeManager in batches, so
+// that most allocations and recycles do not touch the shared lists.
+struct alignas(64) NodeAllocatorCache {
+  static constexpr i32 capacity = 64;
+  static constexpr i32 batch_size = capacity / 2;
+
+  i32 num_free;
+  i32 num_recycled;
+  // Indices into NodeManager::data_list. Elements in |free| are zero-filled.
+  i64 free[capacity];
+  i64 recycled[capacity];
+};
 
 // NodeManager of node S (hash, pointer) managers the memory allocation of S_ch
 // It makes use of three ListManagers.
@@ -621,12 +685,23 @@ struct NodeManager {
 
   i32 element_size;
   i32 chunk_num_elements;
-  i32 free_list_used;
+  i64 free_list_used;
 
   ListManager *free_list, *recycled_list, *data_list;
-  i32 recycle_list_size_backup;
+  i64 recycle_list_size_backup;
+
+  // One per CPU thread, indexed by RuntimeContext::cpu_thread_id.
+  NodeAllocatorCache *caches;
+  i32 num_caches;
 
-  using list_data_type = i32;
+  // If set, elements on the free list may hold stale data, and are
+  // zero-filled when allocated instead of during GC.
+  i32 lazy_zero_fill;
+
+  using list_data_type = i64;
+
+  // Number of free/recycled list entries handled by one task of gc_parallel().
+  static constexpr i32 gc_block_size = 4096;
 
   NodeManager(LLVMRuntime *runtime,
               i32 element_size,
@@ -647,24 +722,101 @@ struct NodeManager {
                                              chunk_num_elements);
     recycled_list = runtime->create<ListManager>(
         runtime, sizeof(list_data_type), chunk_num_elements);
-    data_list =
-        runtime->create<ListManager>(runtime, element_size, chunk_num_elements);
+#if ARCH_cuda
+    // Aligning chunks would waste preallocated device memory, so CUDA sticks
+    // to the linear search in ListManager::ptr2index.
+    constexpr bool locatable = false;
+#else
+    constexpr bool locatable = true;
+#endif
+    data_list = runtime->create<ListManager>(runtime, element_size,
+                                             chunk_num_elements, locatable);
+    lazy_zero_fill = runtime->node_allocator_lazy_zero_fill;
+    num_caches = runtime->num_node_allocator_caches;
+    caches = nullptr;
+    if (num_caches > 0) {
+      caches = (NodeAllocatorCache *)runtime->request_allocate_aligned(
+          sizeof(NodeAllocatorCache) * num_caches, 4096);
+      for (int i = 0; i < num_caches; i++) {
+        caches[i].num_free = 0;
+        caches[i].num_recycled = 0;
+      }
+    }
   }
 
   Ptr allocate() {
-    int old_cursor = atomic_add_i32(&free_list_used, 1);
-    i32 l;
+    auto old_cursor = atomic_add_i64(&free_list_used, 1);
+    i64 l;
     if (old_cursor >= free_list->size()) {
       // running out of free list. allocate new.
       l = data_list->reserve_new_element();
     } else {
       // reuse
       l = free_list->get<list_data_type>(old_cursor);
+      if (lazy_zero_fill) {
+        zero_fill(l);
+      }
     }
     return data_list->get_element_ptr(l);
   }
 
-  i32 locate(Ptr ptr) {
+  void zero_fill(i64 index) {
+    std::memset(data_list->get_element_ptr(index), 0, element_size);
+  }
+
+  // Returns the cache of |context|'s thread, or nullptr if there is none.
+  NodeAllocatorCache *get_cache(RuntimeContext *context) {
+    auto thread_id = context->cpu_thread_id;
+    if (caches == nullptr || thread_id < 0 || thread_id >= num_caches) {
+      return nullptr;
+    }
+    return &caches[thread_id];
+  }
+
+  Ptr allocate(RuntimeContext *context) {
+    auto cache = get_cache(context);
+    if (cache == nullptr) {
+      return allocate();
+    }
+    if (cache->num_free == 0) {
+      refill(cache);
+    }
+    return data_list->get_element_ptr(cache->free[--cache->num_free]);
+  }
+
+  // Takes back an element obtained from allocate(context) that has not been
+  // written to, e.g. when another thread activated the same cell first.
+  void release_unused(RuntimeContext *context, Ptr ptr) {
+    auto cache = get_cache(context);
+    if (cache == nullptr || cache->num_free == NodeAllocatorCache::capacity) {
+      // The free list must not grow while allocate() and refill() read it,
+      // so the element waits for the next GC on the recycled list.
+      recycle(ptr);
+      return;
+    }
+    cache->free[cache->num_free++] = locate(ptr);
+  }
+
+  void refill(NodeAllocatorCache *cache) {
+    constexpr auto n = NodeAllocatorCache::batch_size;
+    auto cursor = atomic_add_i64(&free_list_used, n);
+    auto num_reused = (i32)min_i64(max_i64(free_list->size() - cursor, 0), n);
+    for (int i = 0; i < num_reused; i++) {
+      auto index = free_list->get<list_data_type>(cursor + i);
+      if (lazy_zero_fill) {
+        zero_fill(index);
+      }
+      cache->free[cache->num_free++] = index;
+    }
+    if (num_reused < n) {
+      auto first = data_list->reserve_new_elements(n - num_reused);
+      for (int i = 0; i < n - num_reused; i++) {
+        cache->free[cache->num_free++] = first + i;
+      }
+    }
+  }
+
+  i64 locate(Ptr ptr) {
     return data_list->ptr2index(ptr);
   }
 
@@ -673,25 +825,61 @@ struct NodeManager {
     recycled_list->append(&index);
   }
 
+  void recycle(RuntimeContext *context, Ptr ptr) {
+    auto cache = get_cache(context);
+    if (cache == nullptr) {
+      recycle(ptr);
+      return;
+    }
+    cache->recycled[cache->num_recycled++] = locate(ptr);
+    if (cache->num_recycled == NodeAllocatorCache::capacity) {
+      flush_recycled(cache);
+    }
+  }
+
+  void flush_recycled(NodeAllocatorCache *cache) {
+    if (cache->num_recycled == 0) {
+      return;
+    }
+    auto first = recycled_list->reserve_new_elements(cache->num_recycled);
+    for (int i = 0; i < cache->num_recycled; i++) {
+      recycled_list->get<list_data_type>(first + i) = cache->recycled[i];
+    }
+    cache->num_recycled = 0;
+  }
+
+  void flush_all_recycled() {
+    // Elements recycled since the last GC may still be buffered per thread.
+    for (int i = 0; i < num_caches; i++) {
+      flush_recycled(&caches[i]);
+    }
+  }
+
   void gc_serial() {
+    flush_all_recycled();
+
     // compact free list
-    for (int i = free_list_used; i < free_list->size(); i++) {
+    for (i64 i = free_list_used; i < free_list->size(); i++) {
       free_list->get<list_data_type>(i - free_list_used) =
           free_list->get<list_data_type>(i);
     }
-    const i32 num_unused = max_i32(free_list->size() - free_list_used, 0);
+    const i64 num_unused = max_i64(free_list->size() - free_list_used, 0);
     free_list_used = 0;
     free_list->resize(num_unused);
 
     // zero-fill recycled and push to free list
-    for (int i = 0; i < recycled_list->size(); i++) {
+    for (i64 i = 0; i < recycled_list->size(); i++) {
       auto idx = recycled_list->get<list_data_type>(i);
-      auto ptr = data_list->get_element_ptr(idx);
-      std::memset(ptr, 0, element_size);
+      if (!lazy_zero_fill) {
+        zero_fill(idx);
+      }
       free_list->push_back(idx);
     }
     recycled_list->clear();
   }
+
+  // Same as gc_serial(), but spreads the work over the CPU thread pool.
+  void gc_parallel(i32 num_threads);
 };
 
 extern "C" {
@@ -915,6 +1103,8 @@ void runtime_initialize(
   runtime->memory_pool = memory_pool;
 
   runtime->total_requested_memory = 0;
+  runtime->num_node_allocator_caches = 0;
+  runtime->node_allocator_lazy_zero_fill = 0;
 
   // runtime->allocate ready to use
   runtime->mem_req_queue = (MemRequestQueue *)runtime->allocate_aligned(
@@ -1147,7 +1337,9 @@ void clear_list(LLVMRuntime *runtime, StructMeta *parent, StructMeta *child) {
 // therefore we use a special kernel for more parallelism.
 void element_listgen_root(LLVMRuntime *runtime,
                           StructMeta *parent,
-                          StructMeta *child) {
+                          StructMeta *child,
+                          int num_threads,
+                          int deterministic) {
   // If there's just one element in the parent list, we need to use the blocks
   // (instead of threads) to split the parent container
   auto parent_list = runtime->element_lists[parent->snode_id];
@@ -1181,6 +1373,7 @@ void element_listgen_root(LLVMRuntime *runtime,
   auto ch_element_size =
       std::min(ch_num_elements, taichi_listgen_max_element_size);
 
+#if ARCH_cuda
   // Here is a grid-stride loop.
   for (int c = c_start; c * ch_element_size < ch_num_elements; c += c_step) {
     Element elem;
@@ -1192,110 +1385,344 @@ void element_listgen_root(LLVMRuntime *runtime,
     elem.pcoord = element.pcoord;
     child_list->append(&elem);
   }
+#else
+  // The number of child elements is known upfront, so reserve them at once
+  // instead of appending one by one.
+  if (ch_num_elements == 0) {
+    return;
+  }
+  int num_ch_elements =
+      (ch_num_elements + ch_element_size - 1) / ch_element_size;
+  auto first = child_list->reserve_new_elements(num_ch_elements);
+  for (int c = 0; c < num_ch_elements; c++) {
+    auto &elem = child_list->get<Element>(first + c);
+    elem.element = ch_element;
+    elem.loop_bounds[0] = c * ch_element_size;
+    elem.loop_bounds[1] = std::min((c + 1) * ch_element_size, ch_num_elements);
+    elem.pcoord = element.pcoord;
+  }
+#endif
 }
 
-void element_listgen_nonroot(LLVMRuntime *runtime,
-                             StructMeta *parent,
-                             StructMeta *child) {
-  auto parent_list = runtime->element_lists[parent->snode_id];
-  int num_parent_elements = parent_list->size();
-  auto child_list = runtime->element_lists[child->snode_id];
+// Calls |f| on each child element of the active children of |element| in
+// the parent list, visiting children j_start, j_start + j_step, ...
+extern "C++" {
+template <typename F>
+void for_each_child_element(StructMeta *parent,
+                            StructMeta *child,
+                            Element &element,
+                            int j_start,
+                            int j_step,
+                            const F &f) {
   // Cache the func pointers here for better compiler optimization
   auto parent_refine_coordinates = parent->refine_coordinates;
   auto parent_is_active = parent->is_active;
   auto parent_lookup_element = parent->lookup_element;
   auto child_get_num_elements = child->get_num_elements;
   auto child_from_parent_element = child->from_parent_element;
+  int j_lower = element.loop_bounds[0] + j_start;
+  int j_higher = element.loop_bounds[1];
+  for (int j = j_lower; j < j_higher; j += j_step) {
+    if (parent_is_active((Ptr)parent, element.element, j)) {
+      PhysicalCoordinates refined_coord;
+      parent_refine_coordinates(&element.pcoord, &refined_coord, j);
+      auto ch_element = parent_lookup_element((Ptr)parent, element.element, j);
+      ch_element = child_from_parent_element((Ptr)ch_element);
+      auto ch_num_elements = child_get_num_elements((Ptr)child, ch_element);
+      auto ch_element_size =
+          std::min(ch_num_elements, taichi_listgen_max_element_size);
+      for (int ch_lower = 0; ch_lower < ch_num_elements;
+           ch_lower += ch_element_size) {
+        Element elem;
+        elem.element = ch_element;
+        elem.loop_bounds[0] = ch_lower;
+        elem.loop_bounds[1] =
+            std::min(ch_lower + ch_element_size, ch_num_elements);
+        elem.pcoord = refined_coord;
+        f(elem);
+      }
+    }
+  }
+}
+}
+
+#if !ARCH_cuda
+// The parent list is split into at most this many tasks.
+constexpr i64 listgen_max_num_tasks = 1024;
+// Shorter parent lists are expanded on the calling thread.
+constexpr i64 listgen_min_parallel_parent_elements = 16;
+// Child elements buffered by a task before they are flushed into the child
+// list, in the non-deterministic mode.
+constexpr int listgen_buffer_size = 64;
+
+struct listgen_task_context {
+  StructMeta *parent;
+  StructMeta *child;
+  ListManager *parent_list;
+  ListManager *child_list;
+  i64 num_parent_elements;
+  // Each task expands parent elements [i * block_size, (i + 1) * block_size).
+  i64 block_size;
+  // Deterministic mode: the number of child elements of each task, then the
+  // index of its first child element in the child list.
+  i64 *offsets;
+};
+
+void listgen_count_task(void *ctx_, int thread_id, int i) {
+  auto ctx = (listgen_task_context *)ctx_;
+  auto end = min_i64((i + 1) * ctx->block_size, ctx->num_parent_elements);
+  i64 count = 0;
+  for (i64 k = i * ctx->block_size; k < end; k++) {
+    for_each_child_element(ctx->parent, ctx->child,
+                           ctx->parent_list->get<Element>(k), 0, 1,
+                           [&](const Element &elem) { count++; });
+  }
+  ctx->offsets[i] = count;
+}
+
+void listgen_write_task(void *ctx_, int thread_id, int i) {
+  auto ctx = (listgen_task_context *)ctx_;
+  auto end = min_i64((i + 1) * ctx->block_size, ctx->num_parent_elements);
+  i64 cursor = ctx->offsets[i];
+  for (i64 k = i * ctx->block_size; k < end; k++) {
+    for_each_child_element(ctx->parent, ctx->child,
+                           ctx->parent_list->get<Element>(k), 0, 1,
+                           [&](const Element &elem) {
+                             ctx->child_list->get<Element>(cursor++) = elem;
+                           });
+  }
+}
+
+void listgen_buffered_task(void *ctx_, int thread_id, int i) {
+  auto ctx = (listgen_task_context *)ctx_;
+  auto end = min_i64((i + 1) * ctx->block_size, ctx->num_parent_elements);
+  Element buffer[listgen_buffer_size];
+  int num_buffered = 0;
+  auto flush = [&]() {
+    auto first = ctx->child_list->reserve_new_elements(num_buffered);
+    for (int b = 0; b < num_buffered; b++) {
+      ctx->child_list->get<Element>(first + b) = buffer[b];
+    }
+    num_buffered = 0;
+  };
+  for (i64 k = i * ctx->block_size; k < end; k++) {
+    for_each_child_element(ctx->parent, ctx->child,
+                           ctx->parent_list->get<Element>(k), 0, 1,
+                           [&](const Element &elem) {
+                             buffer[num_buffered++] = elem;
+                             if (num_buffered == listgen_buffer_size) {
+                               flush();
+                             }
+                           });
+  }
+  if (num_buffered > 0) {
+    flush();
+  }
+}
+#endif
+
+void element_listgen_nonroot(LLVMRuntime *runtime,
+                             StructMeta *parent,
+                             StructMeta *child,
+                             int num_threads,
+                             int deterministic) {
+  auto parent_list = runtime->element_lists[parent->snode_id];
+  i64 num_parent_elements = parent_list->size();
+  auto child_list = runtime->element_lists[child->snode_id];
 #if ARCH_cuda
   // Each block processes a slice of a parent container
-  int i_start = block_idx();
-  int i_step = grid_dim();
+  i64 i_start = block_idx();
+  i64 i_step = grid_dim();
   // Each thread processes an element of the parent container
   int j_start = thread_idx();
   int j_step = block_dim();
+  for (i64 i = i_start; i < num_parent_elements; i += i_step) {
+    for_each_child_element(
+        parent, child, parent_list->get<Element>(i), j_start, j_step,
+        [&](const Element &elem) { child_list->append((void *)&elem); });
+  }
 #else
-  int i_start = 0;
-  int i_step = 1;
-  int j_start = 0;
-  int j_step = 1;
-#endif
-  for (int i = i_start; i < num_parent_elements; i += i_step) {
-    auto element = parent_list->get<Element>(i);
-    int j_lower = element.loop_bounds[0] + j_start;
-    int j_higher = element.loop_bounds[1];
-    for (int j = j_lower; j < j_higher; j += j_step) {
-      PhysicalCoordinates refined_coord;
-      parent_refine_coordinates(&element.pcoord, &refined_coord, j);
-      if (parent_is_active((Ptr)parent, element.element, j)) {
-        auto ch_element =
-            parent_lookup_element((Ptr)parent, element.element, j);
-        ch_element = child_from_parent_element((Ptr)ch_element);
-        auto ch_num_elements = child_get_num_elements((Ptr)child, ch_element);
-        auto ch_element_size =
-            std::min(ch_num_elements, taichi_listgen_max_element_size);
-        for (int ch_lower = 0; ch_lower < ch_num_elements;
-             ch_lower += ch_element_size) {
-          Element elem;
-          elem.element = ch_element;
-          elem.loop_bounds[0] = ch_lower;
-          elem.loop_bounds[1] =
-              std::min(ch_lower + ch_element_size, ch_num_elements);
-          elem.pcoord = refined_coord;
-          child_list->append(&elem);
-        }
-      }
+  if (num_threads <= 1 ||
+      num_parent_elements < listgen_min_parallel_parent_elements) {
+    for (i64 i = 0; i < num_parent_elements; i++) {
+      for_each_child_element(
+          parent, child, parent_list->get<Element>(i), 0, 1,
+          [&](const Element &elem) { child_list->append((void *)&elem); });
     }
+    return;
   }
+  listgen_task_context ctx;
+  ctx.parent = parent;
+  ctx.child = child;
+  ctx.parent_list = parent_list;
+  ctx.child_list = child_list;
+  ctx.num_parent_elements = num_parent_elements;
+  ctx.block_size = (num_parent_elements + listgen_max_num_tasks - 1) /
+                   listgen_max_num_tasks;
+  int num_tasks =
+      (int)((num_parent_elements + ctx.block_size - 1) / ctx.block_size);
+  if (!deterministic) {
+    ctx.offsets = nullptr;
+    runtime->parallel_for(runtime->thread_pool, num_tasks, num_threads, &ctx,
+                          listgen_buffered_task, nullptr);
+    return;
+  }
+  // Count the child elements of each task, then let each task write its
+  // elements at its own offset, so that the child list comes out in the
+  // same order as a serial expansion.
+  i64 offsets[listgen_max_num_tasks];
+  ctx.offsets = offsets;
+  runtime->parallel_for(runtime->thread_pool, num_tasks, num_threads, &ctx,
+                        listgen_count_task, nullptr);
+  i64 total = 0;
+  for (int i = 0; i < num_tasks; i++) {
+    auto count = offsets[i];
+    offsets[i] = total;
+    total += count;
+  }
+  if (total == 0) {
+    return;
+  }
+  auto first = child_list->reserve_new_elements(total);
+  for (int i = 0; i < num_tasks; i++) {
+    offsets[i] += first;
+  }
+  runtime->parallel_for(runtime->thread_pool, num_tasks, num_threads, &ctx,
+                        listgen_write_task, nullptr);
+#endif
 }
 
 using BlockTask = void(RuntimeContext *, char *, Element *, int, int);
 
+using range_for_xlogue = void (*)(RuntimeContext *, /*TLS*/ char *tls_base);
+using mesh_for_xlogue = void (*)(RuntimeContext *,
+                                 /*TLS*/ char *tls_base,
+                                 uint32_t patch_idx);
+
+// The state of each worker thread of a CPU launch, which lives as long as the
+// launch instead of a single task: a copy of the context with the thread id
+// set, and the thread-local storage of the loop. The TLS prologue runs on the
+// first task of each thread and the epilogue once per thread after all tasks,
+// so a reduction performs one global atomic per thread instead of per block.
+struct cpu_worker_states {
+  RuntimeContext *context;
+  range_for_xlogue prologue{nullptr};
+  range_for_xlogue epilogue{nullptr};
+  // Padded to a cache line so that the threads do not share one.
+  std::size_t tls_stride;
+  RuntimeContext *thread_contexts;
+  char *tls_buffers;
+  i32 *ready;
+  // The thread pool id of thread 0 of the current parallel_for launch.
+  i32 thread_id_base{0};
+};
+
+std::size_t cpu_worker_tls_stride(std::size_t tls_size) {
+  return (tls_size + 63) / 64 * 64;
+}
+
+void cpu_worker_states_init(cpu_worker_states *states,
+                            RuntimeContext *context,
+                            range_for_xlogue prologue,
+                            range_for_xlogue epilogue,
+                            std::size_t tls_size,
+                            RuntimeContext *thread_contexts,
+                            char *tls_buffers,
+                            i32 *ready,
+                            int num_threads) {
+  states->context = context;
+  states->prologue = prologue;
+  states->epilogue = epilogue;
+  states->tls_stride = cpu_worker_tls_stride(tls_size);
+  states->thread_contexts = thread_contexts;
+  states->tls_buffers = tls_buffers;
+  states->ready = ready;
+  for (int i = 0; i < num_threads; i++) {
+    ready[i] = 0;
+  }
+}
+
+// Called by thread |thread_id| only, so that no synchronization is needed.
+RuntimeContext *cpu_worker_context(cpu_worker_states *states,
+                                   int thread_id,
+                                   char *&tls_ptr) {
+  auto thread_context = &states->thread_contexts[thread_id];
+  tls_ptr = states->tls_buffers + thread_id * states->tls_stride;
+  if (!states->ready[thread_id]) {
+    *thread_context = *states->context;
+    if (states->prologue)
+      states->prologue(states->context, tls_ptr);
+    states->ready[thread_id] = 1;
+  }
+  // Launches running concurrently get disjoint thread pool ids, which index
+  // the per-thread node allocator caches.
+  thread_context->cpu_thread_id = states->thread_id_base + thread_id;
+  return thread_context;
+}
+
+// Runs the epilogues once the launch has joined.
+void cpu_worker_states_finish(cpu_worker_states *states, int num_threads) {
+  if (!states->epilogue) {
+    return;
+  }
+  for (int i = 0; i < num_threads; i++) {
+    if (states->ready[i]) {
+      states->epilogue(states->context,
+                       states->tls_buffers + i * states->tls_stride);
+    }
+  }
+}
+
 struct cpu_block_task_helper_context {
   RuntimeContext *context;
   BlockTask *task;
   ListManager *list;
   int element_size;
   int element_split;
-  std::size_t tls_buffer_size;
+  // Index of the first split of the current parallel_for launch.
+  i64 split_begin;
+  cpu_worker_states *workers;
 };
 
 // TODO: To enforce inlining, we need to create in LLVM a new function that
 // calls block_helper and the BLS xlogues, and pass that function to the
 // scheduler.
 
-// TODO: TLS should be directly passed to the scheduler, so that it lives
-// with the threads (instead of blocks).
-
-void cpu_struct_for_block_helper(void *ctx_, int thread_id, int i) {
+void cpu_struct_for_block_helper(void *ctx_, int thread_id, int i_) {
   auto ctx = (cpu_block_task_helper_context *)(ctx_);
-  int element_id = i / ctx->element_split;
+  i64 i = ctx->split_begin + i_;
+  i64 element_id = i / ctx->element_split;
   int part_size = ctx->element_size / ctx->element_split;
   int part_id = i % ctx->element_split;
   auto &e = ctx->list->get<Element>(element_id);
   int lower = e.loop_bounds[0] + part_id * part_size;
   int upper = e.loop_bounds[0] + (part_id + 1) * part_size;
   upper = std::min(upper, e.loop_bounds[1]);
-  alignas(8) char tls_buffer[ctx->tls_buffer_size];
 
-  RuntimeContext this_thread_context = *ctx->context;
-  this_thread_context.cpu_thread_id = thread_id;
   if (lower < upper) {
-    (*ctx->task)(&this_thread_context, tls_buffer,
+    char *tls_ptr;
+    auto this_thread_context =
+        cpu_worker_context(ctx->workers, thread_id, tls_ptr);
+    (*ctx->task)(this_thread_context, tls_ptr,
                  &ctx->list->get<Element>(element_id), lower, upper);
   }
 }
 
+// On CPUs the TLS xlogues are passed separately and run once per thread. On
+// GPUs they are part of |task| and |prologue| and |epilogue| are null.
 void parallel_struct_for(RuntimeContext *context,
                          int snode_id,
                          int element_size,
                          int element_split,
                          BlockTask *task,
+                         range_for_xlogue prologue,
+                         range_for_xlogue epilogue,
                          std::size_t tls_buffer_size,
                          int num_threads) {
   auto list = (context->runtime)->element_lists[snode_id];
   auto list_tail = list->size();
 #if ARCH_cuda
-  int i = block_idx();
+  i64 i = block_idx();
   // Note: CUDA requires compile-time constant local array sizes.
   // We use "1" here and modify it during codegen to tls_buffer_size.
   alignas(8) char tls_buffer[1];
@@ -1303,7 +1730,7 @@ void parallel_struct_for(RuntimeContext *context,
   element_split = 1;
   const auto part_size = element_size / element_split;
   while (true) {
-    int element_id = i / element_split;
+    i64 element_id = i / element_split;
     if (element_id >= list_tail)
       break;
     auto part_id = i % element_split;
@@ -1322,56 +1749,110 @@ void parallel_struct_for(RuntimeContext *context,
   ctx.list = list;
   ctx.element_size = element_size;
   ctx.element_split = element_split;
-  ctx.tls_buffer_size = tls_buffer_size;
+  cpu_worker_states workers;
+  RuntimeContext thread_contexts[num_threads];
+  alignas(64) char tls_buffers[num_threads *
+                               cpu_worker_tls_stride(tls_buffer_size)];
+  i32 ready[num_threads];
+  cpu_worker_states_init(&workers, context, prologue, epilogue,
+                         tls_buffer_size, thread_contexts, tls_buffers, ready,
+                         num_threads);
+  ctx.workers = &workers;
   auto runtime = context->runtime;
-  runtime->parallel_for(runtime->thread_pool, list_tail * element_split,
-                        num_threads, &ctx, cpu_struct_for_block_helper);
+  // The thread pool takes an i32 number of splits.
+  constexpr i64 max_splits_per_launch = (i64(1) << 31) - 1;
+  const i64 num_splits = list_tail * element_split;
+  for (ctx.split_begin = 0; ctx.split_begin < num_splits;
+       ctx.split_begin += max_splits_per_launch) {
+    runtime->parallel_for(
+        runtime->thread_pool,
+        (int)min_i64(num_splits - ctx.split_begin, max_splits_per_launch),
+        num_threads, &ctx, cpu_struct_for_block_helper,
+        &workers.thread_id_base);
+  }
+  cpu_worker_states_finish(&workers, num_threads);
 #endif
 }
 
-using range_for_xlogue = void (*)(RuntimeContext *, /*TLS*/ char *tls_base);
-using mesh_for_xlogue = void (*)(RuntimeContext *,
-                                 /*TLS*/ char *tls_base,
-                                 uint32_t patch_idx);
-
 struct range_task_helper_context {
   RuntimeContext *context;
-  range_for_xlogue prologue{nullptr};
-  RangeForTaskFunc *body{nullptr};
-  range_for_xlogue epilogue{nullptr};
-  std::size_t tls_size{1};
+  RangeForBlockTaskFunc *body{nullptr};
   int begin;
   int end;
   int block_size;
   int step;
+  int schedule;
+  int num_threads;
+  // The number of iterations handed out so far, for the dynamic and guided
+  // schedules.
+  i64 next;
+  cpu_worker_states *workers;
 };
 
+// Runs the |k|-th iterations for k in [k_begin, k_end), counting from the
+// first iteration in the order given by the step.
+void cpu_range_for_run_block(range_task_helper_context *ctx,
+                             RuntimeContext *context,
+                             char *tls_ptr,
+                             int k_begin,
+                             int k_end) {
+  if (ctx->step == 1) {
+    ctx->body(context, tls_ptr, ctx->begin + k_begin, ctx->begin + k_end);
+  } else {
+    ctx->body(context, tls_ptr, ctx->end - k_end, ctx->end - k_begin);
+  }
+}
+
+// Takes the next block of iterations of a dynamic or guided schedule.
+//
+// @return Whether there were iterations left.
+bool cpu_range_for_take_block(range_task_helper_context *ctx,
+                              int &k_begin,
+                              int &k_end) {
+  i64 n = ctx->end - ctx->begin;
+  i64 start;
+  i64 size = ctx->block_size;
+  if (ctx->schedule == kCpuRangeForDynamic) {
+    start = __atomic_fetch_add(&ctx->next, size, __ATOMIC_RELAXED);
+  } else {
+    start = __atomic_load_n(&ctx->next, __ATOMIC_RELAXED);
+    do {
+      if (start >= n) {
+        return false;
+      }
+      size = std::max((i64)ctx->block_size,
+                      (n - start) / (ctx->num_threads * 2));
+    } while (!__atomic_compare_exchange_n(&ctx->next, &start, start + size,
+                                          true, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED));
+  }
+  if (start >= n) {
+    return false;
+  }
+  k_begin = (int)start;
+  k_end = (int)std::min(start + size, n);
+  return true;
+}
+
 void cpu_parallel_range_for_task(void *range_context,
                                  int thread_id,
                                  int task_id) {
-  auto ctx = *(range_task_helper_context *)range_context;
-  alignas(8) char tls_buffer[ctx.tls_size];
-  auto tls_ptr = &tls_buffer[0];
-  if (ctx.prologue)
-    ctx.prologue(ctx.context, tls_ptr);
-
-  RuntimeContext this_thread_context = *ctx.context;
-  this_thread_context.cpu_thread_id = thread_id;
-  if (ctx.step == 1) {
-    int block_start = ctx.begin + task_id * ctx.block_size;
-    int block_end = std::min(block_start + ctx.block_size, ctx.end);
-    for (int i = block_start; i < block_end; i++) {
-      ctx.body(&this_thread_context, tls_ptr, i);
-    }
-  } else if (ctx.step == -1) {
-    int block_start = ctx.end - task_id * ctx.block_size;
-    int block_end = std::max(ctx.begin, block_start * ctx.block_size);
-    for (int i = block_start - 1; i >= block_end; i--) {
-      ctx.body(&this_thread_context, tls_ptr, i);
+  auto ctx = (range_task_helper_context *)range_context;
+  char *tls_ptr;
+  auto this_thread_context =
+      cpu_worker_context(ctx->workers, thread_id, tls_ptr);
+  if (ctx->schedule == kCpuRangeForStatic) {
+    int k_begin = task_id * ctx->block_size;
+    int k_end = std::min(k_begin + ctx->block_size, ctx->end - ctx->begin);
+    cpu_range_for_run_block(ctx, this_thread_context, tls_ptr, k_begin, k_end);
+  } else {
+    // One task per thread, which keeps taking blocks until none are left.
+    int k_begin, k_end;
+    while (cpu_range_for_take_block(ctx, k_begin, k_end)) {
+      cpu_range_for_run_block(ctx, this_thread_context, tls_ptr, k_begin,
+                              k_end);
     }
   }
-  if (ctx.epilogue)
-    ctx.epilogue(ctx.context, tls_ptr);
 }
 
 void cpu_parallel_range_for(RuntimeContext *context,
@@ -1380,16 +1861,15 @@ void cpu_parallel_range_for(RuntimeContext *context,
                             int end,
                             int step,
                             int block_dim,
+                            int schedule,
                             range_for_xlogue prologue,
-                            RangeForTaskFunc *body,
+                            RangeForBlockTaskFunc *body,
+                            int simd_width,
                             range_for_xlogue epilogue,
                             std::size_t tls_size) {
   range_task_helper_context ctx;
   ctx.context = context;
-  ctx.prologue = prologue;
-  ctx.tls_size = tls_size;
   ctx.body = body;
-  ctx.epilogue = epilogue;
   ctx.begin = begin;
   ctx.end = end;
   ctx.step = step;
@@ -1397,18 +1877,52 @@ void cpu_parallel_range_for(RuntimeContext *context,
     taichi_printf(context->runtime, "step must not be %d\n", step);
     exit(-1);
   }
+  if (begin >= end) {
+    return;
+  }
+  if (context->cpu_range_for_num_threads != 0) {
+    num_threads = context->cpu_range_for_num_threads;
+  }
+  if (context->cpu_range_for_block_dim != 0) {
+    block_dim = context->cpu_range_for_block_dim;
+  }
+  if (context->cpu_range_for_schedule != 0) {
+    schedule = context->cpu_range_for_schedule;
+  }
+  auto num_items = end - begin;
   if (block_dim == 0) {
     // adaptive block dim
-    auto num_items = (ctx.end - ctx.begin) / std::abs(step);
     // ensure each thread has at least ~32 tasks for load balancing
     // and each task has at least 512 items to amortize scheduler overhead
     block_dim = std::min(512, std::max(1, num_items / (num_threads * 32)));
   }
+  if (simd_width > 1) {
+    // Only the last vector of a block may be partial.
+    block_dim = (block_dim + simd_width - 1) / simd_width * simd_width;
+  }
   ctx.block_size = block_dim;
+  ctx.schedule = schedule;
+  ctx.num_threads = num_threads;
+  ctx.next = 0;
+  cpu_worker_states workers;
+  RuntimeContext thread_contexts[num_threads];
+  alignas(64) char tls_buffers[num_threads * cpu_worker_tls_stride(tls_size)];
+  i32 ready[num_threads];
+  cpu_worker_states_init(&workers, context, prologue, epilogue, tls_size,
+                         thread_contexts, tls_buffers, ready, num_threads);
+  ctx.workers = &workers;
+  int num_blocks = (num_items - 1) / block_dim + 1;
+  int num_tasks = num_blocks;
+  if (schedule != kCpuRangeForStatic) {
+    num_tasks = std::min(num_threads, num_blocks);
+  }
   auto runtime = context->runtime;
-  runtime->parallel_for(runtime->thread_pool,
-                        (end - begin + block_dim - 1) / block_dim, num_threads,
-                        &ctx, cpu_parallel_range_for_task);
+  if (runtime->profiler) {
+    runtime->profiler_add_iterations(runtime->profiler, num_items);
+  }
+  runtime->parallel_for(runtime->thread_pool, num_tasks, num_threads, &ctx,
+                        cpu_parallel_range_for_task, &workers.thread_id_base);
+  cpu_worker_states_finish(&workers, num_threads);
 }
 
 void gpu_parallel_range_for(RuntimeContext *context,
@@ -1439,6 +1953,7 @@ struct mesh_task_helper_context {
   std::size_t tls_size{1};
   int num_patches;
   int block_size;
+  i32 thread_id_base{0};
 };
 
 void cpu_parallel_mesh_for_task(void *range_context,
@@ -1449,7 +1964,7 @@ void cpu_parallel_mesh_for_task(void *range_context,
   auto tls_ptr = &tls_buffer[0];
 
   RuntimeContext this_thread_context = *ctx.context;
-  this_thread_context.cpu_thread_id = thread_id;
+  this_thread_context.cpu_thread_id = ctx.thread_id_base + thread_id;
 
   int block_start = task_id * ctx.block_size;
   int block_end = std::min(block_start + ctx.block_size, ctx.num_patches);
@@ -1488,7 +2003,8 @@ void cpu_parallel_mesh_for(RuntimeContext *context,
   auto runtime = context->runtime;
   runtime->parallel_for(runtime->thread_pool,
                         (num_patches + block_dim - 1) / block_dim, num_threads,
-                        &ctx, cpu_parallel_mesh_for_task);
+                        &ctx, cpu_parallel_mesh_for_task,
+                        &ctx.thread_id_base);
 }
 
 void gpu_parallel_mesh_for(RuntimeContext *context,
@@ -1512,7 +2028,8 @@ i32 linear_thread_idx(RuntimeContext *context) {
 #if ARCH_cuda
   return block_idx() * block_dim() + thread_idx();
 #else
-  return context->cpu_thread_id;
+  // Host contexts (-1) share the state of worker 0.
+  return std::max(context->cpu_thread_id, 0);
 #endif
 }
 
@@ -1521,8 +2038,122 @@ i32 linear_thread_idx(RuntimeContext *context) {
 #include "node_pointer.h"
 #include "node_root.h"
 #include "node_bitmasked.h"
+#include "node_hash.h"
+
+// The element list of a hash node has one element per active cell, so that
+// the struct-fors over it visit neither the inactive cells nor the empty
+// slots. Hash nodes are children of the root and only exist on CPUs.
+
+#if !ARCH_cuda
+// Tables with fewer slots are scanned on the calling thread.
+constexpr i32 hash_listgen_min_slots_per_task = 1 << 14;
+
+struct hash_listgen_task_context {
+  HashMeta *meta;
+  Ptr node;
+  // Each task scans slots [i * slots_per_task, (i + 1) * slots_per_task).
+  i32 slots_per_task;
+  PhysicalCoordinates pcoord;
+  ListManager *child_list;
+  // The number of active cells in the slots of each task, then the index of
+  // its first element in the child list.
+  i64 *offsets;
+};
+
+void hash_listgen_count_task(void *ctx_, int thread_id, int i) {
+  auto ctx = (hash_listgen_task_context *)ctx_;
+  auto slots = Hash_get_slots(ctx->node);
+  auto end = std::min((i + 1) * ctx->slots_per_task, ctx->meta->num_slots);
+  i64 count = 0;
+  for (i32 s = i * ctx->slots_per_task; s < end; s++) {
+    count += slots[s].data != nullptr;
+  }
+  ctx->offsets[i] = count;
+}
+
+void hash_listgen_write_task(void *ctx_, int thread_id, int i) {
+  auto ctx = (hash_listgen_task_context *)ctx_;
+  auto slots = Hash_get_slots(ctx->node);
+  auto end = std::min((i + 1) * ctx->slots_per_task, ctx->meta->num_slots);
+  i64 cursor = ctx->offsets[i];
+  for (i32 s = i * ctx->slots_per_task; s < end; s++) {
+    if (slots[s].data != nullptr) {
+      auto &elem = ctx->child_list->get<Element>(cursor++);
+      elem.element = ctx->node;
+      elem.loop_bounds[0] = slots[s].key - 1;
+      elem.loop_bounds[1] = slots[s].key;
+      elem.pcoord = ctx->pcoord;
+    }
+  }
+}
+#endif
+
+// Returns the single node of hash |child|, a child of the root |parent|.
+Ptr hash_get_node(LLVMRuntime *runtime, StructMeta *parent, StructMeta *child) {
+  auto &element = runtime->element_lists[parent->snode_id]->get<Element>(0);
+  auto node = parent->lookup_element((Ptr)parent, element.element, 0);
+  return child->from_parent_element(node);
+}
+
+void element_listgen_hash(LLVMRuntime *runtime,
+                          StructMeta *parent,
+                          StructMeta *child,
+                          int num_threads) {
+  auto parent_list = runtime->element_lists[parent->snode_id];
+  auto child_list = runtime->element_lists[child->snode_id];
+  auto meta = (HashMeta *)child;
+  auto &element = parent_list->get<Element>(0);
+  auto node = hash_get_node(runtime, parent, child);
+  Hash_compact(meta, node);
+  auto slots = Hash_get_slots(node);
+#if !ARCH_cuda
+  if (num_threads > 1 && meta->num_slots > hash_listgen_min_slots_per_task) {
+    hash_listgen_task_context ctx;
+    ctx.meta = meta;
+    ctx.node = node;
+    ctx.slots_per_task = std::max(
+        hash_listgen_min_slots_per_task,
+        (i32)((meta->num_slots + listgen_max_num_tasks - 1) /
+              listgen_max_num_tasks));
+    ctx.pcoord = element.pcoord;
+    ctx.child_list = child_list;
+    int num_tasks =
+        (meta->num_slots + ctx.slots_per_task - 1) / ctx.slots_per_task;
+    i64 offsets[listgen_max_num_tasks];
+    ctx.offsets = offsets;
+    runtime->parallel_for(runtime->thread_pool, num_tasks, num_threads, &ctx,
+                          hash_listgen_count_task, nullptr);
+    i64 total = 0;
+    for (int i = 0; i < num_tasks; i++) {
+      auto count = ctx.offsets[i];
+      ctx.offsets[i] = total;
+      total += count;
+    }
+    if (total == 0) {
+      return;
+    }
+    auto first = child_list->reserve_new_elements(total);
+    for (int i = 0; i < num_tasks; i++) {
+      ctx.offsets[i] += first;
+    }
+    runtime->parallel_for(runtime->thread_pool, num_tasks, num_threads, &ctx,
+                          hash_listgen_write_task, nullptr);
+    return;
+  }
+#endif
+  for (i32 s = 0; s < meta->num_slots; s++) {
+    if (slots[s].data != nullptr) {
+      Element elem;
+      elem.element = node;
+      elem.loop_bounds[0] = slots[s].key - 1;
+      elem.loop_bounds[1] = slots[s].key;
+      elem.pcoord = element.pcoord;
+      child_list->append(&elem);
+    }
+  }
+}
 
-void ListManager::touch_chunk(int chunk_id) {
+void ListManager::touch_chunk(i64 chunk_id) {
   taichi_assert_runtime(runtime, chunk_id < max_num_chunks,
                         "List manager out of chunks.");
   if (!chunks[chunk_id]) {
@@ -1530,8 +2161,15 @@ void ListManager::touch_chunk(int chunk_id) {
       // may have been allocated during lock contention
       if (!chunks[chunk_id]) {
         grid_memfence();
-        auto chunk_ptr = runtime->request_allocate_aligned(
-            max_num_elements_per_chunk * element_size, 4096);
+        Ptr chunk_ptr;
+        if (chunk_alignment != 0) {
+          auto header = runtime->request_allocate_aligned(
+              chunk_header_size + get_chunk_size(), chunk_alignment);
+          *(i64 *)header = chunk_id;
+          chunk_ptr = header + chunk_header_size;
+        } else {
+          chunk_ptr = runtime->request_allocate_aligned(get_chunk_size(), 4096);
+        }
         atomic_exchange_u64((u64 *)&chunks[chunk_id], (u64)chunk_ptr);
       }
     });
@@ -1548,8 +2186,94 @@ Ptr ListManager::allocate() {
   return get_element_ptr(i);
 }
 
-void node_gc(LLVMRuntime *runtime, int snode_id) {
+struct node_gc_task_context {
+  NodeManager *allocator;
+  // gc_compact_task: moves free list entries [src_begin, src_begin + count)
+  // to [0, count).
+  // gc_recycle_task: moves recycled list entries [0, count) to free list
+  // entries [dst_begin, dst_begin + count).
+  i64 src_begin;
+  i64 dst_begin;
+  i64 count;
+};
+
+void gc_compact_task(void *ctx_, int thread_id, int i) {
+  auto ctx = (node_gc_task_context *)ctx_;
+  auto free_list = ctx->allocator->free_list;
+  using T = NodeManager::list_data_type;
+  auto end = min_i64(i64(i + 1) * NodeManager::gc_block_size, ctx->count);
+  for (i64 j = i64(i) * NodeManager::gc_block_size; j < end; j++) {
+    free_list->get<T>(j) = free_list->get<T>(ctx->src_begin + j);
+  }
+}
+
+void gc_recycle_task(void *ctx_, int thread_id, int i) {
+  auto ctx = (node_gc_task_context *)ctx_;
+  auto allocator = ctx->allocator;
+  using T = NodeManager::list_data_type;
+  auto end = min_i64(i64(i + 1) * NodeManager::gc_block_size, ctx->count);
+  for (i64 j = i64(i) * NodeManager::gc_block_size; j < end; j++) {
+    auto idx = allocator->recycled_list->get<T>(j);
+    if (!allocator->lazy_zero_fill) {
+      allocator->zero_fill(idx);
+    }
+    allocator->free_list->get<T>(ctx->dst_begin + j) = idx;
+  }
+}
+
+void NodeManager::gc_parallel(i32 num_threads) {
+  flush_all_recycled();
+
+  const i64 num_unused = max_i64(free_list->size() - free_list_used, 0);
+  // Only the entries that do not already lie within [0, num_unused) move.
+  const i64 num_moved = min_i64(free_list_used, num_unused);
+  const i64 num_recycled = recycled_list->size();
+  if (num_threads <= 1 ||
+      max_i64(num_moved, num_recycled) < NodeManager::gc_block_size) {
+    // Not worth waking up the thread pool.
+    gc_serial();
+    return;
+  }
+
+  auto num_blocks = [](i64 n) {
+    return (int)((n + NodeManager::gc_block_size - 1) /
+                 NodeManager::gc_block_size);
+  };
+
+  // compact free list
+  node_gc_task_context ctx;
+  ctx.allocator = this;
+  ctx.src_begin = free_list->size() - num_moved;
+  ctx.count = num_moved;
+  runtime->parallel_for(runtime->thread_pool, num_blocks(num_moved),
+                        num_threads, &ctx, gc_compact_task, nullptr);
+  free_list_used = 0;
+  free_list->resize(num_unused);
+
+  // zero-fill recycled and push to free list
+  ctx.dst_begin = free_list->reserve_new_elements(num_recycled);
+  ctx.count = num_recycled;
+  runtime->parallel_for(runtime->thread_pool, num_blocks(num_recycled),
+                        num_threads, &ctx, gc_recycle_task, nullptr);
+  recycled_list->clear();
+}
+
+void node_gc(LLVMRuntime *runtime, int snode_id, int num_threads) {
+#if ARCH_cuda
   runtime->node_allocators[snode_id]->gc_serial();
+#else
+  runtime->node_allocators[snode_id]->gc_parallel(num_threads);
+#endif
+}
+
+// Also reclaims the dead slots of the table, so that nodes that are
+// activated and deactivated repeatedly do not fill up without a struct-for.
+void node_gc_hash(LLVMRuntime *runtime,
+                  StructMeta *parent,
+                  StructMeta *child,
+                  int num_threads) {
+  Hash_compact((HashMeta *)child, hash_get_node(runtime, parent, child));
+  node_gc(runtime, child->snode_id, num_threads);
 }
 
 void gc_parallel_0(RuntimeContext *context, int snode_id) {
@@ -1561,7 +2285,7 @@ void gc_parallel_0(RuntimeContext *context, int snode_id) {
   using T = NodeManager::list_data_type;
 
   // Move unused elements to the beginning of the free_list
-  int i = linear_thread_idx(context);
+  i64 i = linear_thread_idx(context);
   if (free_list_used * 2 > free_list_size) {
     // Directly copy. Dst and src does not overlap
     auto items_to_copy = free_list_size - free_list_used;
@@ -1585,8 +2309,8 @@ void gc_parallel_1(RuntimeContext *context, int snode_id) {
   auto allocator = runtime->node_allocators[snode_id];
   auto free_list = allocator->free_list;
 
-  const i32 num_unused =
-      max_i32(free_list->size() - allocator->free_list_used, 0);
+  const i64 num_unused =
+      max_i64(free_list->size() - allocator->free_list_used, 0);
   free_list->resize(num_unused);
 
   allocator->free_list_used = 0;
@@ -1603,7 +2327,7 @@ void gc_parallel_2(RuntimeContext *context, int snode_id) {
   auto data_list = allocator->data_list;
   auto element_size = allocator->element_size;
   using T = NodeManager::list_data_type;
-  auto i = block_idx();
+  i64 i = block_idx();
   while (i < elements) {
     auto idx = recycled_list->get<T>(i);
     auto ptr = data_list->get_element_ptr(idx);
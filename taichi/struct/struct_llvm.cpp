@@ -127,6 +127,19 @@ void StructCompilerLLVM::generate_types(SNode &snode) {
                                     snode.max_num_elements());
     body_type = llvm::ArrayType::get(llvm::PointerType::getInt8PtrTy(*ctx),
                                      snode.max_num_elements());
+  } else if (type == SNodeType::hash) {
+    TI_ERROR_IF(!arch_is_cpu(arch_),
+                "Hash SNodes are only supported on CPU backends.");
+    // number of used and dead slots
+    aux_type =
+        llvm::StructType::get(*ctx, {llvm::PointerType::getInt32Ty(*ctx),
+                                     llvm::PointerType::getInt32Ty(*ctx)});
+    // slots: key, mutex and pointer to the cell
+    auto slot_type = llvm::StructType::get(
+        *ctx, {llvm::PointerType::getInt32Ty(*ctx),
+               llvm::PointerType::getInt32Ty(*ctx),
+               llvm::PointerType::getInt8PtrTy(*ctx)});
+    body_type = llvm::ArrayType::get(slot_type, snode.hash_num_slots);
   } else if (type == SNodeType::dynamic) {
     // mutex and n (number of elements)
     aux_type =
@@ -41,7 +41,8 @@ void *MemoryPool::allocate(std::size_t size, std::size_t alignment) {
   }
   if (!ret) {
     // allocation have failed
-    auto new_buffer_size = std::max(size, default_allocator_size);
+    // Buffers are only page-aligned, so leave room for aligning |ret|.
+    auto new_buffer_size = std::max(size + alignment, default_allocator_size);
     allocators.emplace_back(
         std::make_unique<UnifiedAllocator>(new_buffer_size, arch_, device_));
     ret = allocators.back()->allocate(size, alignment);
@@ -6,12 +6,134 @@
 #include "taichi/system/threading.h"
 
 #include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <fstream>
 #include <thread>
 #include <vector>
 
+#if defined(TI_ARCH_x64)
+#include <immintrin.h>
+#endif
+
+#if defined(TI_PLATFORM_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 TI_NAMESPACE_BEGIN
 
+namespace {
+
+// Number of polls an idle worker (or a waiting master) performs before
+// parking on a condition variable.
+constexpr int kSpinIterations = 1 << 12;
+
+// Interval at which busy waits yield the CPU.
+constexpr int kYieldInterval = 64;
+
+inline void cpu_relax() {
+#if defined(TI_ARCH_x64)
+  _mm_pause();
+#elif defined(TI_ARCH_ARM)
+  asm volatile("yield");
+#else
+  std::this_thread::yield();
+#endif
+}
+
+inline uint64 now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+inline uint64 pack_range(uint32 begin, uint32 end) {
+  return ((uint64)end << 32) | begin;
+}
+
+inline uint32 range_begin(uint64 range) {
+  return (uint32)range;
+}
+
+inline uint32 range_end(uint64 range) {
+  return (uint32)(range >> 32);
+}
+
+struct CpuInfo {
+  int cpu;
+  int numa_node;
+};
+
+// Parses a Linux cpulist such as "0-3,8-11".
+std::vector<int> parse_cpu_list(const std::string &list) {
+  std::vector<int> cpus;
+  std::size_t pos = 0;
+  while (pos < list.size()) {
+    auto next = list.find(',', pos);
+    if (next == std::string::npos) {
+      next = list.size();
+    }
+    auto item = list.substr(pos, next - pos);
+    auto dash = item.find('-');
+    try {
+      if (dash == std::string::npos) {
+        cpus.push_back(std::stoi(item));
+      } else {
+        int lo = std::stoi(item.substr(0, dash));
+        int hi = std::stoi(item.substr(dash + 1));
+        for (int c = lo; c <= hi; c++) {
+          cpus.push_back(c);
+        }
+      }
+    } catch (const std::exception &) {
+      // Ignore malformed items.
+    }
+    pos = next + 1;
+  }
+  return cpus;
+}
+
+// Returns the CPUs of the machine ordered NUMA node by node.
+std::vector<CpuInfo> get_cpu_topology() {
+  std::vector<CpuInfo> cpus;
+#if defined(TI_PLATFORM_LINUX)
+  for (int node = 0;; node++) {
+    std::ifstream f(fmt::format("/sys/devices/system/node/node{}/cpulist",
+                                node));
+    if (!f) {
+      break;
+    }
+    std::string list;
+    std::getline(f, list);
+    for (int c : parse_cpu_list(list)) {
+      cpus.push_back({c, node});
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    int n = std::max(1u, std::thread::hardware_concurrency());
+    for (int c = 0; c < n; c++) {
+      cpus.push_back({c, 0});
+    }
+  }
+  return cpus;
+}
+
+#if defined(TI_PLATFORM_LINUX)
+void pin_thread_to_cpu(std::thread &th, int cpu) {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  if (pthread_setaffinity_np(th.native_handle(), sizeof(cpu_set_t),
+                             &cpuset) != 0) {
+    TI_WARN("Failed to pin thread to CPU {}", cpu);
+  }
+}
+#endif
+
+}  // namespace
+
 bool test_threading() {
   auto tp = ThreadPool(20);
   for (int j = 0; j < 100; j++) {
@@ -26,113 +148,302 @@ bool test_threading() {
   return true;
 }
 
-ThreadPool::ThreadPool(int max_num_threads) : max_num_threads(max_num_threads) {
-  exiting = false;
-  started = false;
-  running_threads = 0;
-  timestamp = 1;
-  last_finished = 0;
-  task_head = 0;
-  task_tail = 0;
-  thread_counter = 0;
-  threads.resize((std::size_t)max_num_threads);
-  for (int i = 0; i < max_num_threads; i++) {
-    threads[i] = std::thread([this] { this->target(); });
+ThreadPool::ThreadPool(int max_num_threads, bool pin_threads, int num_groups)
+    : max_num_threads(std::max(max_num_threads, 1)),
+      pin_threads(pin_threads),
+      num_groups(std::min(std::max(num_groups, 1), this->max_num_threads)) {
+  const int n = this->max_num_threads;
+  workers_ = std::make_unique<Worker[]>(n);
+  groups_ = std::make_unique<Group[]>(this->num_groups);
+  for (int g = 0; g < this->num_groups; g++) {
+    groups_[g].begin = (int)((int64)n * g / this->num_groups);
+    groups_[g].end = (int)((int64)n * (g + 1) / this->num_groups);
+    for (int i = groups_[g].begin; i < groups_[g].end; i++) {
+      workers_[i].group = g;
+    }
+  }
+  if (n <= (int)std::thread::hardware_concurrency()) {
+    spin_iterations_ = kSpinIterations;
+  }
+
+  // Thread i runs on cpus[i % cpus.size()] when pinned. Without pinning the
+  // NUMA node of a thread is unknown, so all threads are treated as local.
+  const auto cpus = get_cpu_topology();
+  auto node_of = [&](int thread_id) {
+    return pin_threads ? cpus[thread_id % cpus.size()].numa_node : 0;
+  };
+  for (int i = 0; i < n; i++) {
+    const auto &group = groups_[workers_[i].group];
+    const int size = group.end - group.begin;
+    auto neighbor = [&](int d) {
+      return group.begin + (i - group.begin + d) % size;
+    };
+    auto &victims = workers_[i].victims;
+    // Steal from neighbors first, and from the same NUMA node before others.
+    for (int d = 1; d < size; d++) {
+      if (node_of(neighbor(d)) == node_of(i)) {
+        victims.push_back(neighbor(d));
+      }
+    }
+    for (int d = 1; d < size; d++) {
+      if (node_of(neighbor(d)) != node_of(i)) {
+        victims.push_back(neighbor(d));
+      }
+    }
+  }
+
+#if !defined(TI_PLATFORM_LINUX)
+  if (pin_threads) {
+    TI_WARN("Thread pinning is only supported on Linux.");
+  }
+#endif
+
+  // The first thread of each group is whoever calls run().
+  for (int i = 0; i < n; i++) {
+    if (i == groups_[workers_[i].group].begin) {
+      continue;
+    }
+    threads_.emplace_back([this, i] { this->target(i); });
+#if defined(TI_PLATFORM_LINUX)
+    if (pin_threads) {
+      pin_thread_to_cpu(threads_.back(), cpus[i % cpus.size()].cpu);
+    }
+#endif
+  }
+}
+
+ThreadPool::Group &ThreadPool::acquire_group() {
+  for (int g = 0; g < num_groups; g++) {
+    if (groups_[g].launch_mut.try_lock()) {
+      return groups_[g];
+    }
   }
+  groups_[0].launch_mut.lock();
+  return groups_[0];
 }
 
 void ThreadPool::run(int splits,
                      int desired_num_threads,
                      void *range_for_task_context,
-                     RangeForTaskFunc *func) {
-  {
-    std::lock_guard _(mutex);
-    this->range_for_task_context = range_for_task_context;
-    this->func = func;
-    this->desired_num_threads = std::min(desired_num_threads, max_num_threads);
-    TI_ASSERT(this->desired_num_threads > 0);
-    // TI_P(this->desired_num_threads);
-    started = false;
-    task_head = 0;
-    task_tail = splits;
-    timestamp++;
-    TI_ASSERT(timestamp < (1LL << 62));  // avoid overflowing here
-  }
-
-  // wake up all slaves
-  slave_cv.notify_all();
-  {
-    std::unique_lock<std::mutex> lock(mutex);
-    // TODO: the workers may have finished before master waiting on master_cv
-    master_cv.wait(lock, [this] { return started && running_threads == 0; });
+                     RangeForTaskFunc *func,
+                     int *thread_id_base) {
+  if (splits <= 0) {
+    return;
   }
-  TI_ASSERT(task_head >= task_tail);
-}
 
-void ThreadPool::target() {
-  uint64 last_timestamp = 0;
-  int thread_id;
+  // Concurrent callers (e.g. the launch workers of the async engine) run on
+  // different groups if there are enough, since a group's thread ids and
+  // launch state serve one launch at a time.
+  auto &group = acquire_group();
+  std::lock_guard<std::mutex> _(group.launch_mut, std::adopt_lock);
+  desired_num_threads =
+      std::min(desired_num_threads, group.end - group.begin);
+  TI_ASSERT(desired_num_threads > 0);
+  if (thread_id_base) {
+    *thread_id_base = group.begin;
+  }
+
+  if (desired_num_threads == 1 || splits == 1) {
+    // Nothing to distribute: run on the calling thread as thread 0.
+    const bool profiling = profiling_.load(std::memory_order_relaxed);
+    const uint64 begin_ns = profiling ? now_ns() : 0;
+    for (int i = 0; i < splits; i++) {
+      func(range_for_task_context, 0, i);
+    }
+    if (profiling) {
+      add_busy_time(group.begin, begin_ns);
+    }
+    return;
+  }
+
+  // Wait for workers still finishing the previous launch (they have no tasks
+  // left, but may be polling the ranges).
+  group.installing.store(true);
+  for (int i = 1; group.busy_workers.load() != 0; i++) {
+    if (i % kYieldInterval == 0) {
+      std::this_thread::yield();
+    } else {
+      cpu_relax();
+    }
+  }
+
+  group.range_for_task_context = range_for_task_context;
+  group.func = func;
+  group.desired_num_threads.store(desired_num_threads,
+                                  std::memory_order_relaxed);
+  group.remaining_tasks.store(splits, std::memory_order_relaxed);
+  for (int i = 0; i < group.end - group.begin; i++) {
+    uint32 begin = 0, end = 0;
+    if (i < desired_num_threads) {
+      begin = (uint32)((int64)splits * i / desired_num_threads);
+      end = (uint32)((int64)splits * (i + 1) / desired_num_threads);
+    }
+    workers_[group.begin + i].range.store(pack_range(begin, end),
+                                          std::memory_order_release);
+  }
+  group.installing.store(false);
+  group.epoch.fetch_add(1);
+
+  if (group.parked_workers.load() > 0) {
+    {
+      std::lock_guard<std::mutex> lock(group.mut);
+    }
+    group.worker_cv.notify_all();
+  }
+
+  work(group, group.begin);
+
+  // Wait for tasks taken by other threads.
+  for (int i = 0; i < spin_iterations_; i++) {
+    if (group.remaining_tasks.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+    cpu_relax();
+  }
+  group.master_waiting.store(true);
   {
-    std::lock_guard<std::mutex> lock(mutex);
-    thread_id = thread_counter++;
+    std::unique_lock<std::mutex> lock(group.mut);
+    group.master_cv.wait(
+        lock, [&group] { return group.remaining_tasks.load() == 0; });
   }
+  group.master_waiting.store(false);
+}
+
+void ThreadPool::work(Group &group, int thread_id) {
+  const bool profiling = profiling_.load(std::memory_order_relaxed);
+  uint64 begin_ns = 0;
+  int executed = 0;
   while (true) {
-    {
-      std::unique_lock<std::mutex> lock(mutex);
-      slave_cv.wait(lock, [this, last_timestamp, thread_id] {
-        return (timestamp > last_timestamp &&
-                thread_id < desired_num_threads) ||
-               this->exiting;
-      });
-      last_timestamp = timestamp;
-      if (exiting) {
-        break;
-      } else {
-        if (last_finished >= last_timestamp) {
-          continue;
-          // This could happen when part of the desired threads wake up and
-          // finish all the task, and then this thread wake up finding nothing
-          // to do. Should skip this task directly.
-        } else {
-          started = true;
-          running_threads++;
+    int task_id;
+    if (pop(thread_id, task_id)) {
+      if (profiling && executed == 0) {
+        begin_ns = now_ns();
+      }
+      group.func(group.range_for_task_context, thread_id - group.begin,
+                 task_id);
+      executed++;
+      continue;
+    }
+    if (executed > 0) {
+      // Before the tasks are reported done, so that the busy time is complete
+      // when run() returns.
+      if (profiling) {
+        add_busy_time(thread_id, begin_ns);
+      }
+      if (group.remaining_tasks.fetch_sub(executed) == executed &&
+          thread_id != group.begin && group.master_waiting.load()) {
+        {
+          std::lock_guard<std::mutex> lock(group.mut);
         }
+        group.master_cv.notify_one();
       }
+      executed = 0;
+    }
+    if (!steal(thread_id)) {
+      break;
     }
+  }
+}
+
+void ThreadPool::add_busy_time(int thread_id, uint64 begin_ns) {
+  auto &busy_ns = workers_[thread_id].busy_ns;
+  busy_ns.store(busy_ns.load(std::memory_order_relaxed) + now_ns() - begin_ns,
+                std::memory_order_relaxed);
+}
+
+bool ThreadPool::pop(int thread_id, int &task_id) {
+  auto &range = workers_[thread_id].range;
+  auto cur = range.load(std::memory_order_acquire);
+  while (true) {
+    auto begin = range_begin(cur), end = range_end(cur);
+    if (begin >= end) {
+      return false;
+    }
+    if (range.compare_exchange_weak(cur, pack_range(begin + 1, end),
+                                    std::memory_order_acq_rel,
+                                    std::memory_order_acquire)) {
+      task_id = (int)begin;
+      return true;
+    }
+  }
+}
 
+bool ThreadPool::steal(int thread_id) {
+  auto &own = workers_[thread_id].range;
+  for (int victim : workers_[thread_id].victims) {
+    auto &range = workers_[victim].range;
+    auto cur = range.load(std::memory_order_acquire);
     while (true) {
-      // For a single parallel task
-      int task_id;
-      {
-        task_id = task_head.fetch_add(1, std::memory_order_relaxed);
-        if (task_id >= task_tail)
-          break;
+      auto begin = range_begin(cur), end = range_end(cur);
+      if (begin >= end) {
+        break;
       }
+      // Take the back half, leaving the front to the owner.
+      auto mid = end - (end - begin + 1) / 2;
+      if (range.compare_exchange_weak(cur, pack_range(begin, mid),
+                                      std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+        own.store(pack_range(mid, end), std::memory_order_release);
+        return true;
+      }
+    }
+  }
+  return false;
+}
 
-      func(this->range_for_task_context, thread_id, task_id);
+void ThreadPool::wait_for_launch(Group &group, uint64 &last_epoch) {
+  auto launched = [&] {
+    return group.epoch.load(std::memory_order_acquire) != last_epoch ||
+           exiting_.load(std::memory_order_relaxed);
+  };
+  for (int i = 0; i < spin_iterations_; i++) {
+    if (launched()) {
+      last_epoch = group.epoch.load(std::memory_order_acquire);
+      return;
     }
+    cpu_relax();
+  }
+  {
+    std::unique_lock<std::mutex> lock(group.mut);
+    group.parked_workers.fetch_add(1);
+    group.worker_cv.wait(lock, [&] {
+      return group.epoch.load() != last_epoch || exiting_.load();
+    });
+    group.parked_workers.fetch_sub(1);
+  }
+  last_epoch = group.epoch.load(std::memory_order_acquire);
+}
 
-    bool all_finished = false;
-    {
-      std::lock_guard<std::mutex> lock(mutex);
-      running_threads--;
-      if (running_threads == 0) {
-        all_finished = true;
-        last_finished = last_timestamp;
-      }
+void ThreadPool::target(int thread_id) {
+  auto &group = groups_[workers_[thread_id].group];
+  uint64 last_epoch = 0;
+  while (true) {
+    wait_for_launch(group, last_epoch);
+    if (exiting_.load()) {
+      break;
+    }
+    group.busy_workers.fetch_add(1);
+    // If the ranges are not being installed, either they belong to the launch
+    // that bumped the epoch (and |desired_num_threads| is up to date), or
+    // that launch is already done and they are all empty.
+    if (!group.installing.load() &&
+        thread_id - group.begin <
+            group.desired_num_threads.load(std::memory_order_relaxed)) {
+      work(group, thread_id);
     }
-    if (all_finished)
-      master_cv.notify_one();
+    group.busy_workers.fetch_sub(1);
   }
 }
 
 ThreadPool::~ThreadPool() {
-  {
-    std::lock_guard<std::mutex> lg(mutex);
-    exiting = true;
+  exiting_.store(true);
+  for (int g = 0; g < num_groups; g++) {
+    {
+      std::lock_guard<std::mutex> lg(groups_[g].mut);
+    }
+    groups_[g].worker_cv.notify_all();
   }
-  slave_cv.notify_all();
-  for (auto &th : threads)
+  for (auto &th : threads_)
     th.join();
 }
 
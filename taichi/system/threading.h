@@ -10,6 +10,8 @@
 #include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
 
 TI_NAMESPACE_BEGIN
@@ -17,34 +19,55 @@ TI_NAMESPACE_BEGIN
 using RangeForTaskFunc = void(void *, int thread_id, int i);
 using ParallelFor = void(int n, int num_threads, void *, RangeForTaskFunc func);
 
+// A work-stealing thread pool.
+//
+// Each launch splits task ids [0, splits) evenly into per-thread ranges.
+// Every participating thread pops tasks from the front of its own range and,
+// once that is empty, steals the back half of another thread's range. The
+// thread calling run() participates as thread 0, so single-threaded launches
+// never touch the workers. Idle workers spin for a while before parking on a
+// condition variable, so that back-to-back launches of small kernels do not
+// pay a full wakeup.
+//
+// The threads can be partitioned into groups with launch state of their own.
+// Concurrent callers of run() (e.g. the launch workers of the async engine)
+// each take a free group, so that up to |num_groups| launches execute at the
+// same time on disjoint threads.
 class ThreadPool {
  public:
-  std::vector<std::thread> threads;
-  std::condition_variable slave_cv;
-  std::condition_variable master_cv;
-  std::mutex mutex;
-  std::atomic<int> task_head;
-  int task_tail;
-  int running_threads;
   int max_num_threads;
-  int desired_num_threads;
-  uint64 timestamp;
-  uint64 last_finished;
-  bool started;
-  bool exiting;
-  RangeForTaskFunc *func;
-  void *range_for_task_context;  // Note: this is a pointer to a
-                                 // range_task_helper_context defined in the
-                                 // LLVM runtime, which is different from
-                                 // taichi::lang::Context.
-  int thread_counter;
-
-  ThreadPool(int max_num_threads);
+  bool pin_threads;
+  int num_groups;
 
+  // |pin_threads|: pin each worker to one CPU. Workers are laid out NUMA node
+  // by node, and prefer stealing from threads on the same node.
+  // |num_groups|: split the threads into this many groups of about equal
+  // size. A launch only uses the threads of its group.
+  explicit ThreadPool(int max_num_threads,
+                      bool pin_threads = false,
+                      int num_groups = 1);
+
+  // Runs |func| on task ids [0, splits), using up to |desired_num_threads|
+  // threads, which |func| sees as thread ids [0, desired_num_threads). If
+  // |thread_id_base| is not null, it receives the pool-wide id of thread 0;
+  // the pool-wide ids of concurrent launches never overlap.
   void run(int splits,
            int desired_num_threads,
            void *range_for_task_context,
-           RangeForTaskFunc *func);
+           RangeForTaskFunc *func,
+           int *thread_id_base = nullptr);
+
+  // While enabled, each thread accumulates the time it spends executing
+  // tasks, which the kernel profiler reads to expose load imbalance.
+  void set_profiling(bool enabled) {
+    profiling_.store(enabled, std::memory_order_relaxed);
+  }
+
+  // The busy time of pool-wide thread |thread_id| in nanoseconds, complete
+  // for all launches that have returned from run().
+  uint64 get_busy_time_ns(int thread_id) const {
+    return workers_[thread_id].busy_ns.load(std::memory_order_relaxed);
+  }
 
   static void static_run(ThreadPool *pool,
                          int splits,
@@ -54,9 +77,89 @@ class ThreadPool {
     return pool->run(splits, desired_num_threads, range_for_task_context, func);
   }
 
-  void target();
+  // The entry point of the LLVM runtime, which also needs the pool-wide id
+  // of thread 0.
+  static void static_run_with_thread_id_base(ThreadPool *pool,
+                                             int splits,
+                                             int desired_num_threads,
+                                             void *range_for_task_context,
+                                             RangeForTaskFunc *func,
+                                             int *thread_id_base) {
+    return pool->run(splits, desired_num_threads, range_for_task_context, func,
+                     thread_id_base);
+  }
 
   ~ThreadPool();
+
+ private:
+  struct alignas(64) Worker {
+    // The task ids [begin, end) not yet taken, packed as (end << 32) | begin
+    // so that the owner and thieves can update it with a single CAS.
+    std::atomic<uint64> range{0};
+    // Threads of the same group to steal from, in order of preference.
+    std::vector<int> victims;
+    // Written by the owner only, while profiling.
+    std::atomic<uint64> busy_ns{0};
+    int group{0};
+  };
+
+  // The launch state of the pool-wide threads [begin, end). Thread |begin| is
+  // whoever calls run().
+  struct alignas(64) Group {
+    int begin{0};
+    int end{0};
+
+    // Note: this is a pointer to a range_task_helper_context defined in the
+    // LLVM runtime, which is different from taichi::lang::Context.
+    void *range_for_task_context{nullptr};
+    RangeForTaskFunc *func{nullptr};
+
+    std::atomic<uint64> epoch{0};
+    std::atomic<int> desired_num_threads{1};
+    // Set while run() installs the ranges of a new launch. Workers that woke
+    // up too late for the previous launch must not touch the ranges
+    // meanwhile.
+    std::atomic<bool> installing{false};
+    std::atomic<bool> master_waiting{false};
+    std::atomic<int> remaining_tasks{0};
+    std::atomic<int> busy_workers{0};
+    std::atomic<int> parked_workers{0};
+
+    // Protects parking and unparking only; launches are lock-free otherwise.
+    std::mutex mut;
+    std::condition_variable worker_cv;
+    std::condition_variable master_cv;
+    // Held by the caller of run() for the whole launch.
+    std::mutex launch_mut;
+  };
+
+  // Locks a group no other launch is using, or waits for the first one if
+  // all are taken.
+  Group &acquire_group();
+
+  void add_busy_time(int thread_id, uint64 begin_ns);
+
+  void target(int thread_id);
+
+  // Executes tasks until no more can be popped or stolen.
+  void work(Group &group, int thread_id);
+
+  bool pop(int thread_id, int &task_id);
+
+  bool steal(int thread_id);
+
+  void wait_for_launch(Group &group, uint64 &last_epoch);
+
+  std::unique_ptr<Worker[]> workers_;
+  std::unique_ptr<Group[]> groups_;
+  std::vector<std::thread> threads_;
+
+  // Polls before parking; 0 when the machine is oversubscribed, since
+  // spinning threads would then steal cycles from the working ones.
+  int spin_iterations_{0};
+
+  std::atomic<bool> exiting_{false};
+  std::atomic<bool> profiling_{false};
 };
 
 TI_NAMESPACE_END
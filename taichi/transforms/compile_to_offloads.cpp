@@ -56,18 +56,6 @@ void compile_to_offloads(IRNode *ir,
   print("Typechecked");
   irpass::analysis::verify(ir);
 
-  if (kernel->is_evaluator) {
-    TI_ASSERT(!grad);
-
-    irpass::demote_operations(ir, config);
-    print("Operations demoted");
-
-    irpass::offload(ir, config);
-    print("Offloaded");
-    irpass::analysis::verify(ir);
-    return;
-  }
-
   if (vectorize) {
     irpass::loop_vectorize(ir, config);
     print("Loop Vectorized");
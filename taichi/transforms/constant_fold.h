@@ -9,9 +9,7 @@ class ConstantFoldPass : public Pass {
  public:
   static const PassID id;
 
-  struct Args {
-    Program *program;
-  };
+  struct Args {};
 };
 
 }  // namespace lang
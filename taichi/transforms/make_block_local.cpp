@@ -4,11 +4,16 @@
 #include "taichi/ir/analysis.h"
 #include "taichi/ir/scratch_pad.h"
 #include "taichi/transforms/make_block_local.h"
+#include "taichi/util/statistics.h"
 
 TLANG_NAMESPACE_BEGIN
 
 namespace {
 
+// On CPUs the BLS buffer only pays off while it stays in the cache. This is a
+// typical L2 size per core.
+constexpr std::size_t kCpuBlsMaxBytes = 256 * 1024;
+
 void make_block_local_offload(OffloadedStmt *offload,
                               const CompileConfig &config,
                               const std::string &kernel_name) {
@@ -19,6 +24,32 @@ void make_block_local_offload(OffloadedStmt *offload,
 
   auto pads = irpass::initialize_scratch_pad(offload);
 
+  // On CPUs a single thread runs a whole block, with the BLS buffer in
+  // thread-local memory.
+  const bool cpu = arch_is_cpu(config.arch);
+  if (cpu) {
+    if (pads->pads.empty()) {
+      return;
+    }
+    std::size_t bls_bytes = 0;
+    for (auto &pad : pads->pads) {
+      bls_bytes += data_type_size(pad.first->dt.ptr_removed()) *
+                   pad.second.pad_size_linear();
+    }
+    if (bls_bytes > kCpuBlsMaxBytes) {
+      TI_WARN(
+          "(kernel={}) BLS skipped: the buffers take {} bytes, more than {} "
+          "bytes fit in the cache. Consider smaller leaf blocks.",
+          kernel_name, bls_bytes, kCpuBlsMaxBytes);
+      stat.add("bls_skipped_cpu");
+      return;
+    }
+    // Splitting a list element among tasks would fetch its halo once per
+    // split.
+    offload->block_dim = (int)std::min(offload->snode->max_num_elements(),
+                                       (int64)taichi_listgen_max_element_size);
+  }
+
   std::size_t bls_offset_in_bytes = 0;
 
   for (auto &pad : pads->pads) {
@@ -58,16 +89,87 @@ void make_block_local_offload(OffloadedStmt *offload,
     bls_offset_in_bytes +=
         (dtype_size - bls_offset_in_bytes % dtype_size) % dtype_size;
 
+    using XlogueOperation =
+        std::function<void(Block * element_block,
+                           std::vector<Stmt *> global_indices,
+                           Stmt * bls_element_offset_bytes)>;
+
+    // On CPUs the xlogues loop over the BLS buffer with one loop per
+    // dimension, the last one innermost, so that both the global accesses and
+    // the buffer accesses are contiguous and no division is needed.
+    auto create_cpu_xlogue = [&](Block *block,
+                                 const XlogueOperation &operation) {
+      std::vector<Stmt *> bls_coords(dim);
+      std::function<void(Block *, int)> create_loop = [&](Block *parent,
+                                                          int i) {
+        if (i == dim) {
+          std::vector<Stmt *> global_indices(dim);
+          Stmt *bls_element_id = nullptr;
+          for (int j = 0; j < dim; j++) {
+            Stmt *global_index = parent->push_back<BinaryOpStmt>(
+                BinaryOpType::add, bls_coords[j],
+                parent->push_back<ConstStmt>(
+                    TypedConstant(pad.second.bounds[j].low)));
+            Stmt *block_corner =
+                parent->push_back<BlockCornerIndexStmt>(offload, j);
+            if (pad.second.coefficients[j] > 1) {
+              block_corner = parent->push_back<BinaryOpStmt>(
+                  BinaryOpType::mul, block_corner,
+                  parent->push_back<ConstStmt>(
+                      TypedConstant(pad.second.coefficients[j])));
+            }
+            global_indices[j] = parent->push_back<BinaryOpStmt>(
+                BinaryOpType::add, global_index, block_corner);
+            auto inc = parent->push_back<BinaryOpStmt>(
+                BinaryOpType::mul, bls_coords[j],
+                parent->push_back<ConstStmt>(TypedConstant(bls_strides[j])));
+            bls_element_id =
+                bls_element_id ? parent->push_back<BinaryOpStmt>(
+                                     BinaryOpType::add, bls_element_id, inc)
+                               : inc;
+          }
+          auto bls_element_offset_bytes = parent->push_back<BinaryOpStmt>(
+              BinaryOpType::mul, bls_element_id,
+              parent->push_back<ConstStmt>(TypedConstant(dtype_size)));
+          bls_element_offset_bytes = parent->push_back<BinaryOpStmt>(
+              BinaryOpType::add, bls_element_offset_bytes,
+              parent->push_back<ConstStmt>(
+                  TypedConstant((int32)bls_offset_in_bytes)));
+          operation(parent, global_indices, bls_element_offset_bytes);
+          return;
+        }
+        // for (int c = 0; c < pad_size[i]; c++)
+        auto coord = parent->push_back<AllocaStmt>(PrimitiveType::i32);
+        parent->push_back<LocalStoreStmt>(
+            coord, parent->push_back<ConstStmt>(TypedConstant(0)));
+        auto body = std::make_unique<Block>();
+        auto coord_val = body->push_back<LocalLoadStmt>(LocalAddress{coord, 0});
+        auto cond = body->push_back<BinaryOpStmt>(
+            BinaryOpType::cmp_lt, coord_val,
+            body->push_back<ConstStmt>(TypedConstant(pad.second.pad_size[i])));
+        body->push_back<WhileControlStmt>(nullptr, cond);
+        bls_coords[i] = coord_val;
+        create_loop(body.get(), i + 1);
+        body->push_back<LocalStoreStmt>(
+            coord, body->push_back<BinaryOpStmt>(
+                       BinaryOpType::add, coord_val,
+                       body->push_back<ConstStmt>(TypedConstant(1))));
+        parent->push_back<WhileStmt>(std::move(body));
+      };
+      create_loop(block, 0);
+    };
+
     // This lambda is used for both BLS prologue and epilogue creation
     auto create_xlogue =
-        [&](std::unique_ptr<Block> &block,
-            const std::function<void(
-                Block * element_block, std::vector<Stmt *> global_indices,
-                Stmt * bls_element_offset_bytes)> &operation) {
+        [&](std::unique_ptr<Block> &block, const XlogueOperation &operation) {
           if (block == nullptr) {
             block = std::make_unique<Block>();
             block->parent_stmt = offload;
           }
+          if (cpu) {
+            create_cpu_xlogue(block.get(), operation);
+            return;
+          }
           // Equivalent to CUDA threadIdx
           Stmt *thread_idx_stmt =
               block->push_back<LoopLinearIndexStmt>(offload);
@@ -629,7 +629,7 @@ void full_simplify(IRNode *root,
       if (binary_op_simplify(root, config))
         modified = true;
       if (config.constant_folding &&
-          constant_fold(root, config, {args.program}))
+          constant_fold(root, config, {}))
         modified = true;
       if (die(root))
         modified = true;
@@ -657,7 +657,7 @@ void full_simplify(IRNode *root,
     return;
   }
   if (config.constant_folding) {
-    constant_fold(root, config, {args.program});
+    constant_fold(root, config, {});
     die(root);
   }
   simplify(root, config);
@@ -5,10 +5,12 @@ TI_NAMESPACE_BEGIN
 Statistics stat;
 
 void Statistics::add(std::string key, Statistics::value_type value) {
+  std::lock_guard<std::mutex> guard(mut_);
   counters_[key] += value;
 }
 
 void Statistics::print(std::string *output) {
+  std::lock_guard<std::mutex> guard(mut_);
   std::vector<std::string> keys;
   for (auto const &item : counters_)
     keys.push_back(item.first);
@@ -27,7 +29,13 @@ void Statistics::print(std::string *output) {
 }
 
 void Statistics::clear() {
+  std::lock_guard<std::mutex> guard(mut_);
   counters_.clear();
 }
 
+Statistics::counters_map Statistics::get_counters() {
+  std::lock_guard<std::mutex> guard(mut_);
+  return counters_;
+}
+
 TI_NAMESPACE_END
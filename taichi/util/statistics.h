@@ -1,3 +1,4 @@
+#include <mutex>
 #include <unordered_map>
 
 #include "taichi/common/core.h"
@@ -17,11 +18,12 @@ class Statistics {
 
   void clear();
 
-  inline const counters_map &get_counters() {
-    return counters_;
-  }
+  // Returns a snapshot, since counters may be updated by compilation
+  // workers concurrently.
+  counters_map get_counters();
 
  private:
+  std::mutex mut_;
   counters_map counters_;
 };
 
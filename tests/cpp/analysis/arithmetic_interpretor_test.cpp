@@ -0,0 +1,200 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "gtest/gtest.h"
+#include "taichi/analysis/arithmetic_interpretor.h"
+#include "taichi/ir/ir_builder.h"
+#include "taichi/ir/statements.h"
+
+namespace taichi {
+namespace lang {
+namespace {
+
+TEST(ArithmeticInterpretor, Basic) {
+  IRBuilder builder;
+  auto *lhs = builder.get_int32(7);
+  auto *rhs = builder.get_int32(-2);
+  auto *div = builder.create_div(lhs, rhs);
+  auto *floordiv = builder.create_floordiv(lhs, rhs);
+  builder.create_select(builder.create_cmp_lt(lhs, rhs), div,
+                        builder.create_mul(floordiv, lhs));
+  // The end of the region is exclusive.
+  auto *end = builder.get_int32(0);
+  auto block = builder.extract_ir();
+
+  ArithmeticInterpretor ai;
+  ArithmeticInterpretor::CodeRegion region;
+  region.block = block.get();
+  region.end = end;
+  auto res = ai.evaluate(region, {});
+  ASSERT_TRUE(res.has_value());
+  // 7 // -2 * 7
+  EXPECT_EQ(res->val_i32, -28);
+}
+
+TEST(ArithmeticInterpretor, IntegerWrapAround) {
+  ArithmeticInterpretor ai;
+  const TypedConstant max_i32(std::numeric_limits<int32>::max());
+  auto res = ai.evaluate_binary_op(BinaryOpType::add, max_i32,
+                                   TypedConstant(int32(1)));
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_i32, std::numeric_limits<int32>::min());
+
+  res = ai.evaluate_binary_op(BinaryOpType::mul,
+                              TypedConstant(uint32(1u << 31)),
+                              TypedConstant(uint32(2)));
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_u32, 0);
+
+  res = ai.evaluate_unary_op(UnaryOpType::neg, TypedConstant(uint64(1)));
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_u64, std::numeric_limits<uint64>::max());
+
+  res = ai.evaluate_binary_op(BinaryOpType::pow, TypedConstant(int32(3)),
+                              TypedConstant(int32(21)));
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_i32, int32(uint32(10460353203ULL)));
+}
+
+TEST(ArithmeticInterpretor, UndefinedIntegerOps) {
+  ArithmeticInterpretor ai;
+  const TypedConstant zero(int32(0));
+  const TypedConstant min_i32(std::numeric_limits<int32>::min());
+  EXPECT_FALSE(ai.evaluate_binary_op(BinaryOpType::div, TypedConstant(1), zero)
+                   .has_value());
+  EXPECT_FALSE(ai.evaluate_binary_op(BinaryOpType::mod, min_i32,
+                                     TypedConstant(int32(-1)))
+                   .has_value());
+  EXPECT_FALSE(ai.evaluate_binary_op(BinaryOpType::bit_shl, TypedConstant(1),
+                                     TypedConstant(32))
+                   .has_value());
+  EXPECT_FALSE(ai.evaluate_unary_op(UnaryOpType::abs, min_i32).has_value());
+  EXPECT_FALSE(ai.evaluate_binary_op(BinaryOpType::pow, TypedConstant(2),
+                                     TypedConstant(-1))
+                   .has_value());
+  // Unsigned divisions are performed as signed ones by the LLVM backends.
+  EXPECT_FALSE(ai.evaluate_binary_op(BinaryOpType::div,
+                                     TypedConstant(uint32(1u << 31)),
+                                     TypedConstant(uint32(3)))
+                   .has_value());
+  auto res = ai.evaluate_binary_op(BinaryOpType::div, TypedConstant(uint32(9)),
+                                   TypedConstant(uint32(4)));
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_u32, 2);
+}
+
+TEST(ArithmeticInterpretor, Shifts) {
+  ArithmeticInterpretor ai;
+  const TypedConstant minus_eight(int32(-8));
+  const TypedConstant one(int32(1));
+  auto res = ai.evaluate_binary_op(BinaryOpType::bit_sar, minus_eight, one);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_i32, -4);
+  res = ai.evaluate_binary_op(BinaryOpType::bit_shr, minus_eight, one);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_i32, 0x7ffffffc);
+  res = ai.evaluate_binary_op(BinaryOpType::bit_sar,
+                              TypedConstant(uint32(0x80000000u)),
+                              TypedConstant(uint32(4)));
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_u32, 0x08000000u);
+}
+
+TEST(ArithmeticInterpretor, Comparisons) {
+  ArithmeticInterpretor ai;
+  const TypedConstant nan(std::numeric_limits<float32>::quiet_NaN());
+  const TypedConstant one(float32(1));
+  auto res = ai.evaluate_binary_op(BinaryOpType::cmp_lt, TypedConstant(0.5f),
+                                   one);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->dt, PrimitiveType::i32);
+  EXPECT_EQ(res->val_i32, -1);
+  // The backends disagree on whether NaN != 1.
+  for (auto op : {BinaryOpType::cmp_eq, BinaryOpType::cmp_ne}) {
+    EXPECT_FALSE(ai.evaluate_binary_op(op, nan, one).has_value());
+  }
+}
+
+TEST(ArithmeticInterpretor, Casts) {
+  ArithmeticInterpretor ai;
+  // Rounded once, not through f64, which would yield 2^53.
+  const int64 big = (int64(1) << 53) + (int64(1) << 29) + 1;
+  auto res = ai.evaluate_unary_op(UnaryOpType::cast_value, TypedConstant(big),
+                                  PrimitiveType::f32);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_f32, float32((int64(1) << 53) + (int64(1) << 30)));
+
+  res = ai.evaluate_unary_op(UnaryOpType::cast_value, TypedConstant(-2.75f),
+                             PrimitiveType::i32);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_i32, -2);
+  EXPECT_FALSE(ai.evaluate_unary_op(UnaryOpType::cast_value,
+                                    TypedConstant(3e9f), PrimitiveType::i32)
+                   .has_value());
+  EXPECT_FALSE(ai.evaluate_unary_op(
+                     UnaryOpType::cast_value,
+                     TypedConstant(std::numeric_limits<float64>::quiet_NaN()),
+                     PrimitiveType::i64)
+                   .has_value());
+
+  res = ai.evaluate_unary_op(UnaryOpType::cast_value, TypedConstant(int32(-1)),
+                             PrimitiveType::u64);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_u64, std::numeric_limits<uint64>::max());
+
+  res = ai.evaluate_unary_op(UnaryOpType::cast_bits, TypedConstant(1.0f),
+                             PrimitiveType::i32);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_i32, 0x3f800000);
+  EXPECT_EQ(res->value_bits, 0x3f800000u);
+}
+
+TEST(ArithmeticInterpretor, PerBackendFloatOps) {
+  const TypedConstant one(float32(1));
+  const TypedConstant three(float32(3));
+  const TypedConstant denorm(std::numeric_limits<float32>::denorm_min());
+
+  ArithmeticInterpretor cpu(Arch::x64, /*fast_math=*/true);
+  auto res = cpu.evaluate_binary_op(BinaryOpType::div, one, three);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_f32, 1.0f / 3.0f);
+  res = cpu.evaluate_unary_op(UnaryOpType::sin, one);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_f32, std::sin(1.0f));
+  res = cpu.evaluate_binary_op(BinaryOpType::mul, denorm, three);
+  ASSERT_TRUE(res.has_value());
+
+  ArithmeticInterpretor cuda(Arch::cuda, /*fast_math=*/false);
+  EXPECT_TRUE(cuda.evaluate_binary_op(BinaryOpType::div, one, three));
+  EXPECT_TRUE(cuda.evaluate_unary_op(UnaryOpType::sqrt, three));
+  EXPECT_FALSE(cuda.evaluate_unary_op(UnaryOpType::sin, one));
+  EXPECT_FALSE(cuda.evaluate_binary_op(BinaryOpType::mul, denorm, three));
+
+  ArithmeticInterpretor cuda_fast(Arch::cuda, /*fast_math=*/true);
+  EXPECT_FALSE(cuda_fast.evaluate_binary_op(BinaryOpType::div, one, three));
+  EXPECT_TRUE(cuda_fast.evaluate_binary_op(BinaryOpType::add, one, three));
+
+  ArithmeticInterpretor vulkan(Arch::vulkan, /*fast_math=*/false);
+  EXPECT_FALSE(vulkan.evaluate_unary_op(UnaryOpType::sqrt, three));
+  EXPECT_TRUE(vulkan.evaluate_unary_op(UnaryOpType::floor, three));
+}
+
+TEST(ArithmeticInterpretor, Select) {
+  ArithmeticInterpretor ai;
+  const TypedConstant a(1.5f), b(2.5f);
+  auto res = ai.evaluate_ternary_op(TernaryOpType::select, TypedConstant(-1),
+                                    a, b);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_f32, 1.5f);
+  res = ai.evaluate_ternary_op(TernaryOpType::select, TypedConstant(0), a, b);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->val_f32, 2.5f);
+  // The LLVM backends only test the lowest bit of the condition.
+  EXPECT_FALSE(
+      ai.evaluate_ternary_op(TernaryOpType::select, TypedConstant(2), a, b));
+}
+
+}  // namespace
+}  // namespace lang
+}  // namespace taichi
@@ -170,5 +170,67 @@ TEST(SameStatements, TestSameLoopIndex) {
   EXPECT_TRUE(irpass::analysis::same_value(loop_index_a, loop_index_b));
 }
 
+TEST(SameStatements, TestHashStatements) {
+  auto block = std::make_unique<Block>();
+  auto one = block->push_back<ConstStmt>(TypedConstant(1));
+  auto two = block->push_back<ConstStmt>(TypedConstant(2));
+  auto if_stmt = block->push_back<IfStmt>(one)->as<IfStmt>();
+
+  auto true_clause = std::make_unique<Block>();
+  auto true_two = true_clause->push_back<ConstStmt>(TypedConstant(2));
+  auto true_add =
+      true_clause->push_back<BinaryOpStmt>(BinaryOpType::add, one, true_two);
+  true_clause->push_back<BinaryOpStmt>(BinaryOpType::mul, true_add, true_add);
+  if_stmt->set_true_statements(std::move(true_clause));
+
+  auto false_clause = std::make_unique<Block>();
+  auto false_two = false_clause->push_back<ConstStmt>(TypedConstant(2));
+  auto false_add =
+      false_clause->push_back<BinaryOpStmt>(BinaryOpType::add, one, false_two);
+  false_clause->push_back<BinaryOpStmt>(BinaryOpType::mul, false_add, one);
+  if_stmt->set_false_statements(std::move(false_clause));
+
+  irpass::type_check(block.get(), CompileConfig());
+  irpass::re_id(block.get());
+
+  using irpass::analysis::hash_statements;
+  EXPECT_EQ(hash_statements(true_two), hash_statements(two));
+  EXPECT_NE(hash_statements(one), hash_statements(two));
+  EXPECT_EQ(hash_statements(true_add), hash_statements(false_add));
+  // Same structure, but the last operand is different.
+  EXPECT_FALSE(irpass::analysis::same_statements(
+      if_stmt->true_statements.get(), if_stmt->false_statements.get()));
+  EXPECT_NE(hash_statements(if_stmt->true_statements.get()),
+            hash_statements(if_stmt->false_statements.get()));
+
+  // The hash does not depend on the ids of the statements in the root.
+  auto cloned = irpass::analysis::clone(block.get());
+  EXPECT_TRUE(irpass::analysis::same_statements(block.get(), cloned.get()));
+  EXPECT_EQ(hash_statements(block.get()), hash_statements(cloned.get()));
+}
+
+TEST(SameStatements, TestHashSetFields) {
+  auto root = std::make_unique<SNode>(/*depth=*/0, /*t=*/SNodeType::root);
+  auto *a = &root->dense({Axis{0}}, /*sizes=*/4, false);
+  auto *b = &root->dense({Axis{0}}, /*sizes=*/4, false);
+
+  auto block = std::make_unique<Block>();
+  auto one = block->push_back<ConstStmt>(TypedConstant(1));
+  auto unique_ab =
+      block->push_back<LoopUniqueStmt>(one, std::vector<SNode *>{a, b});
+  auto unique_ba =
+      block->push_back<LoopUniqueStmt>(one, std::vector<SNode *>{b, a});
+  auto unique_a =
+      block->push_back<LoopUniqueStmt>(one, std::vector<SNode *>{a});
+  auto unique_b =
+      block->push_back<LoopUniqueStmt>(one, std::vector<SNode *>{b});
+
+  // Equal statements must hash equally, whatever the order of the sets.
+  using irpass::analysis::hash_statements;
+  EXPECT_EQ(hash_statements(unique_ab), hash_statements(unique_ba));
+  EXPECT_NE(hash_statements(unique_a), hash_statements(unique_b));
+  EXPECT_NE(hash_statements(unique_a), hash_statements(unique_ab));
+}
+
 }  // namespace lang
 }  // namespace taichi
@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "taichi/system/threading.h"
+
+namespace taichi {
+
+TEST(ThreadPool, CreateAndDestruct) {
+  ThreadPool pool(8);
+}
+
+TEST(ThreadPool, RunsEveryTaskOnce) {
+  constexpr int kNumThreads = 8;
+  ThreadPool pool(kNumThreads);
+  for (int splits : {1, 2, 7, 64, 1000, 100003}) {
+    for (int desired : {1, 3, kNumThreads, 2 * kNumThreads}) {
+      struct Ctx {
+        std::vector<std::atomic<int>> counts;
+        std::atomic<int> bad_thread_ids{0};
+        int num_threads;
+      } ctx{std::vector<std::atomic<int>>(splits), {0},
+            std::min(desired, kNumThreads)};
+      pool.run(splits, desired, &ctx, [](void *p, int thread_id, int i) {
+        auto *ctx = (Ctx *)p;
+        ctx->counts[i]++;
+        if (thread_id < 0 || thread_id >= ctx->num_threads)
+          ctx->bad_thread_ids++;
+      });
+      for (int i = 0; i < splits; i++) {
+        EXPECT_EQ(ctx.counts[i].load(), 1);
+      }
+      EXPECT_EQ(ctx.bad_thread_ids.load(), 0);
+    }
+  }
+}
+
+TEST(ThreadPool, ManySmallLaunches) {
+  ThreadPool pool(4);
+  std::atomic<int64> sum{0};
+  for (int j = 0; j < 10000; j++) {
+    pool.run(4, 4, &sum, [](void *p, int thread_id, int i) {
+      ((std::atomic<int64> *)p)->fetch_add(i + 1);
+    });
+  }
+  EXPECT_EQ(sum.load(), 10000 * 10);
+}
+
+TEST(ThreadPool, PinThreads) {
+  ThreadPool pool(4, /*pin_threads=*/true);
+  std::atomic<int> count{0};
+  pool.run(100, 4, &count, [](void *p, int thread_id, int i) {
+    (*(std::atomic<int> *)p)++;
+  });
+  EXPECT_EQ(count.load(), 100);
+}
+
+TEST(ThreadPool, ConcurrentLaunchesUseDisjointThreadIds) {
+  constexpr int kNumThreads = 8;
+  constexpr int kNumGroups = 4;
+  ThreadPool pool(kNumThreads, /*pin_threads=*/false, kNumGroups);
+  std::atomic<int> in_use[kNumThreads];
+  std::atomic<int> overlaps{0};
+  std::atomic<int> bad_thread_ids{0};
+  std::atomic<int64> count{0};
+  for (auto &u : in_use) {
+    u = 0;
+  }
+  struct Ctx {
+    std::atomic<int> *in_use;
+    std::atomic<int> *overlaps;
+    std::atomic<int> *bad_thread_ids;
+    std::atomic<int64> *count;
+    int group_size;
+    int num_threads;
+    int thread_id_base;
+  };
+  std::vector<std::thread> callers;
+  for (int c = 0; c < kNumGroups; c++) {
+    callers.emplace_back([&, c] {
+      for (int j = 0; j < 2000; j++) {
+        Ctx ctx{in_use, &overlaps, &bad_thread_ids, &count,
+                kNumThreads / kNumGroups, kNumThreads, -1};
+        // Alternates between inline and distributed launches.
+        pool.run((j + c) % 2 ? 16 : 1, kNumThreads, &ctx,
+                 [](void *p, int thread_id, int i) {
+                   auto *ctx = (Ctx *)p;
+                   int id = ctx->thread_id_base + thread_id;
+                   if (thread_id >= ctx->group_size || id < 0 ||
+                       id >= ctx->num_threads) {
+                     (*ctx->bad_thread_ids)++;
+                     return;
+                   }
+                   if (ctx->in_use[id]++ != 0)
+                     (*ctx->overlaps)++;
+                   ctx->in_use[id]--;
+                   (*ctx->count)++;
+                 },
+                 &ctx.thread_id_base);
+      }
+    });
+  }
+  for (auto &t : callers) {
+    t.join();
+  }
+  EXPECT_EQ(bad_thread_ids.load(), 0);
+  EXPECT_EQ(overlaps.load(), 0);
+  EXPECT_EQ(count.load(), kNumGroups * 1000 * (16 + 1));
+}
+
+}  // namespace taichi
@@ -76,6 +76,18 @@ def test_non_dense_snode():
         m.add_field('y', y)
 
 
+@ti.test(arch=ti.opengl)
+def test_non_cpu_rejects_ext_arr():
+    @ti.kernel
+    def fill(arr: ti.ext_arr()):
+        for i in range(4):
+            arr[i] = i
+
+    m = ti.aot.Module(ti.opengl)
+    with pytest.raises(RuntimeError, match='not supported yet'):
+        m.add_kernel(fill, example_any_arrays={0: np.zeros(4, np.int32)})
+
+
 @ti.test(arch=ti.opengl)
 def test_mpm88_aot():
     n_particles = 8192
@@ -239,3 +251,82 @@ def test_opengl_exceed_max_ssbo():
     with pytest.raises(RuntimeError):
         init(0, density1, density2, density3, density4, density5, density6,
              density7)
+
+
+@ti.test(arch=ti.cpu)
+def test_cpu_save_and_load():
+    n = 16
+    x = ti.field(ti.i32, shape=n)
+
+    @ti.kernel
+    def init():
+        for i in x:
+            x[i] = i * 2
+
+    @ti.kernel
+    def total() -> ti.i32:
+        s = 0
+        for i in x:
+            s += x[i]
+        return s
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        m = ti.aot.Module(ti.cpu)
+        m.add_field('x', x)
+        m.add_kernel(init)
+        m.add_kernel(total)
+        filename = 'taichi_aot_cpu'
+        m.save(tmpdir, filename)
+        assert os.path.exists(os.path.join(tmpdir, f'{filename}.so'))
+        with open(os.path.join(tmpdir,
+                               f'{filename}_metadata.json')) as json_file:
+            json.load(json_file)
+
+        # Runs against a runtime of its own, not the one of this program.
+        loader = ti.core.CpuAotModuleLoader(tmpdir, filename)
+        loader.run_kernel('init')
+        loader.run_kernel('total')
+        assert loader.get_ret_i32(0) == n * (n - 1)
+        assert x.to_numpy().sum() == 0
+
+
+@ti.test(arch=ti.cpu)
+def test_cpu_load_kernel_with_args():
+    n = 16
+    x = ti.field(ti.f32, shape=n)
+
+    @ti.kernel
+    def axpy(a: ti.f32, b: ti.i32, arr: ti.ext_arr()):
+        for i in x:
+            x[i] = a * arr[i, 1] + b
+
+    @ti.kernel
+    def to_array(arr: ti.ext_arr()):
+        for i in x:
+            arr[i] = x[i]
+
+    @ti.kernel
+    def total() -> ti.f32:
+        s = 0.0
+        for i in x:
+            s += x[i]
+        return s
+
+    arr2d = np.zeros((n, 2), dtype=np.float32)
+    arr1d = np.zeros(n, dtype=np.float32)
+    with tempfile.TemporaryDirectory() as tmpdir:
+        m = ti.aot.Module(ti.cpu)
+        m.add_field('x', x)
+        m.add_kernel(axpy, example_any_arrays={2: arr2d})
+        m.add_kernel(to_array, example_any_arrays={0: arr1d})
+        m.add_kernel(total)
+        filename = 'taichi_aot_cpu_args'
+        m.save(tmpdir, filename)
+
+        loader = ti.core.CpuAotModuleLoader(tmpdir, filename)
+        arr2d[:, 1] = np.arange(n)
+        loader.run_kernel('axpy', 0.5, 3, arr2d)
+        loader.run_kernel('total')
+        assert loader.get_ret_f32(0) == 0.5 * n * (n - 1) / 2 + 3 * n
+        loader.run_kernel('to_array', arr1d)
+        assert (arr1d == 0.5 * np.arange(n) + 3).all()
@@ -53,3 +53,152 @@ def test_listgen_opt_with_offsets():
 
     ti.sync()
     assert ti.get_kernel_stats().get_counters()['launched_tasks_list_gen'] <= 2
+
+
+@ti.test(arch=ti.cpu, async_mode=True, async_max_concurrent_tasks=4)
+def test_concurrent_tasks():
+    n = 4096
+    m = 8
+    fields = [ti.field(dtype=ti.i32, shape=n) for _ in range(m)]
+    total = ti.field(dtype=ti.i64, shape=())
+
+    @ti.kernel
+    def inc(x: ti.template(), k: ti.i32):
+        for i in x:
+            x[i] = x[i] * 3 + k
+
+    @ti.kernel
+    def accumulate(x: ti.template()):
+        for i in x:
+            total[None] += x[i]
+
+    expected = np.zeros((m, n), dtype=np.int64)
+    expected_total = 0
+    for step in range(5):
+        # Independent across the fields, ordered within each field.
+        for j in range(m):
+            inc(fields[j], j + step)
+            expected[j] = expected[j] * 3 + j + step
+        accumulate(fields[step % m])
+        expected_total += expected[step % m].sum()
+    ti.sync()
+    for j in range(m):
+        assert (fields[j].to_numpy() == expected[j]).all()
+    assert total[None] == expected_total
+
+
+@ti.test(arch=ti.cpu, async_mode=True, async_max_concurrent_tasks=4)
+def test_concurrent_tasks_external_array():
+    n = 1024
+
+    @ti.kernel
+    def inc(a: ti.ext_arr()):
+        for i in range(n):
+            a[i] = a[i] * 2 + i
+
+    x = np.zeros(dtype=np.int64, shape=n)
+    expected = np.zeros(dtype=np.int64, shape=n)
+    for _ in range(10):
+        inc(x)
+        expected = expected * 2 + np.arange(n)
+    ti.sync()
+    assert (x == expected).all()
+
+
+@ti.test(arch=ti.cpu,
+         async_mode=True,
+         async_max_concurrent_tasks=4,
+         cpu_node_allocator_cache=True)
+def test_concurrent_tasks_sparse_activation():
+    n = 4096
+    m = 8
+    fields = []
+    for _ in range(m):
+        x = ti.field(dtype=ti.i32)
+        ti.root.pointer(ti.i, n // 16).dense(ti.i, 16).place(x)
+        fields.append(x)
+
+    @ti.kernel
+    def activate(x: ti.template(), k: ti.i32):
+        for i in range(n):
+            if i % 3 == k % 3:
+                x[i] = i + k
+
+    @ti.kernel
+    def activate_serial(x: ti.template(), k: ti.i32):
+        # Not a loop: a serial task.
+        x[k] = k
+
+    @ti.kernel
+    def clear(x: ti.template()):
+        for i in x.parent(2):
+            ti.deactivate(x.parent(2), i)
+
+    for step in range(4):
+        # Independent across the fields, so that activations run concurrently.
+        for j in range(m):
+            activate(fields[j], j + step)
+            activate_serial(fields[j], n - 1 - j - step)
+        if step < 3:
+            for j in range(m):
+                clear(fields[j])
+    ti.sync()
+    for j in range(m):
+        k = j + 3
+        expected = np.zeros(n, dtype=np.int32)
+        expected[k % 3::3] = np.arange(k % 3, n, 3) + k
+        expected[n - 1 - k] = n - 1 - k
+        assert (fields[j].to_numpy() == expected).all()
+
+
+def _test_trace_cache():
+    n = 1024
+    x = ti.field(dtype=ti.f32)
+    y = ti.field(dtype=ti.f32)
+    ti.root.pointer(ti.i, n // 64).dense(ti.i, 64).place(x, y)
+
+    @ti.kernel
+    def init():
+        for i in range(0, n, 2):
+            x[i] = i
+
+    @ti.kernel
+    def scale(k: ti.f32):
+        for i in x:
+            x[i] = x[i] * k
+
+    @ti.kernel
+    def copy():
+        for i in x:
+            y[i] = x[i] + 1
+
+    init()
+    ti.sync()
+    ti.get_kernel_stats().clear()
+    for frame in range(10):
+        scale(0.5)
+        scale(4)
+        copy()
+        ti.async_flush()
+    ti.sync()
+    expected_x = np.zeros(n, dtype=np.float32)
+    expected_x[::2] = np.arange(0, n, 2) * 2.0**10
+    assert np.allclose(x.to_numpy(), expected_x)
+    expected_y = expected_x + 1
+    expected_y[1::2] = 1
+    assert np.allclose(y.to_numpy(), expected_y)
+    return ti.get_kernel_stats().get_counters()
+
+
+@ti.test(require=ti.extension.async_mode, async_mode=True)
+def test_trace_cache():
+    counters = _test_trace_cache()
+    assert counters.get('sfg_trace_cache_hits', 0) >= 5
+
+
+@ti.test(require=ti.extension.async_mode,
+         async_mode=True,
+         async_opt_trace_cache=False)
+def test_trace_cache_disabled():
+    counters = _test_trace_cache()
+    assert counters.get('sfg_trace_cache_hits', 0) == 0
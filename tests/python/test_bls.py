@@ -170,6 +170,35 @@ def test_bls_large_block():
     foo()
 
 
-# TODO: BLS on CPU
+@ti.test(arch=ti.cpu)
+def test_bls_cpu_exceeding_cache():
+    # A 66^3 f32 buffer does not fit into the cache, so BLS is skipped.
+    n = 64
+    a = ti.field(dtype=ti.f32)
+    b = ti.field(dtype=ti.f32)
+    block = ti.root.pointer(ti.ijk, 1)
+    block.dense(ti.ijk, n).place(a)
+    block.dense(ti.ijk, n).place(b)
+
+    @ti.kernel
+    def populate():
+        for i, j, k in ti.ndrange(n, n, n):
+            a[i, j, k] = i + j * 2 + k * 3
+
+    @ti.kernel
+    def stencil():
+        ti.block_local(a)
+        for i, j, k in a:
+            b[i, j, k] = a[i - 1, j, k] + a[i + 1, j, k] + a[i, j - 1, k] + a[
+                i, j + 1, k] + a[i, j, k - 1] + a[i, j, k + 1]
+
+    stats = ti.get_kernel_stats()
+    stats.clear()
+    populate()
+    stencil()
+    assert stats.get_counters().get('bls_skipped_cpu', 0) == 1
+    assert b[1, 1, 1] == 6 * (1 + 2 + 3)
+
+
 # TODO: BLS boundary out of bound
 # TODO: BLS with TLS
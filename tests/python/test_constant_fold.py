@@ -16,3 +16,50 @@ def test_constant_fold():
     # \sum_{i=1}^n (i^2) = n * (n + 1) * (2n + 1) / 6
     expected = n * (n + 1) * (2 * n + 1) // 6
     assert series() == expected
+
+
+def _test_folded_same_as_runtime(dt, ops, values):
+    n = len(ops)
+    a = ti.field(dt, shape=())
+    b = ti.field(dt, shape=())
+    folded = ti.field(dt, shape=n)
+    computed = ti.field(dt, shape=n)
+
+    @ti.kernel
+    def run(x: ti.template(), y: ti.template()):
+        for i in ti.static(range(n)):
+            folded[i] = ops[i](ti.cast(x, dt), ti.cast(y, dt))
+            computed[i] = ops[i](a[None], b[None])
+
+    for x, y in values:
+        a[None] = x
+        b[None] = y
+        run(x, y)
+        for i in range(n):
+            assert folded[i] == computed[i]
+
+
+@ti.test(arch=ti.cpu)
+def test_fold_int_same_as_runtime():
+    ops = [
+        lambda x, y: x + y, lambda x, y: x - y, lambda x, y: x * y,
+        lambda x, y: x // y, lambda x, y: x % y, lambda x, y: x & y,
+        lambda x, y: x ^ ~y, lambda x, y: x << (y & 15),
+        lambda x, y: x >> (y & 15), lambda x, y: ti.max(x, y),
+        lambda x, y: ti.abs(x) + (x < y) + (x != y), lambda x, y: -x
+    ]
+    values = [(7, 3), (-7, 3), (7, -3), (2147483647, 2), (-1, 5)]
+    _test_folded_same_as_runtime(ti.i32, ops, values)
+
+
+@ti.test(arch=ti.cpu)
+def test_fold_float_same_as_runtime():
+    ops = [
+        lambda x, y: x / y, lambda x, y: x // y, lambda x, y: ti.sqrt(x),
+        lambda x, y: ti.sin(x) + ti.cos(y), lambda x, y: ti.exp(y),
+        lambda x, y: ti.log(x), lambda x, y: ti.atan2(x, y),
+        lambda x, y: x**y, lambda x, y: ti.floor(x / y) * ti.ceil(y),
+        lambda x, y: ti.cast(ti.cast(x * 1e9, ti.i64), ti.f32)
+    ]
+    values = [(1.0, 3.0), (2.5, -0.7), (1e-3, 17.25)]
+    _test_folded_same_as_runtime(ti.f32, ops, values)
@@ -0,0 +1,88 @@
+import math
+
+import numpy as np
+import pytest
+
+import taichi as ti
+
+
+@ti.test(arch=ti.cpu, cpu_async_launch=True)
+def test_ordered_launches():
+    n = 1024
+    x = ti.field(ti.i32, shape=n)
+
+    @ti.kernel
+    def inc():
+        for i in x:
+            x[i] = x[i] * 2 + i
+
+    @ti.kernel
+    def total() -> ti.i32:
+        s = 0
+        for i in x:
+            s += x[i]
+        return s
+
+    expected = np.zeros(n, dtype=np.int64)
+    for _ in range(10):
+        inc()
+        expected = expected * 2 + np.arange(n)
+    assert total() == expected.sum()
+    assert (x.to_numpy() == expected).all()
+
+
+@ti.test(arch=ti.cpu, cpu_async_launch=True)
+def test_args_are_captured_at_launch():
+    x = ti.field(ti.f32, shape=())
+
+    @ti.kernel
+    def add(v: ti.f32):
+        x[None] += v
+
+    for i in range(100):
+        add(i)
+    ti.sync()
+    assert x[None] == 4950
+
+
+@ti.test(arch=ti.cpu, cpu_async_launch=True)
+def test_events():
+    x = ti.field(ti.f32, shape=1024 * 1024)
+
+    @ti.kernel
+    def fill(v: ti.f32):
+        for i in x:
+            x[i] = ti.sqrt(v + i)
+
+    fill(1.0)
+    e1 = ti.record_event()
+    fill(2.0)
+    e2 = ti.record_event()
+    assert e2 > e1
+    ti.wait_event(e2)
+    assert ti.query_event(e1)
+    assert ti.query_event(e2)
+    assert x[3] == pytest.approx(math.sqrt(5.0))
+
+
+@ti.test(arch=ti.cpu,
+         cpu_async_launch=True,
+         debug=True,
+         gdb_trigger=False,
+         require=ti.extension.assertion)
+def test_runtime_error():
+    @ti.kernel
+    def func(x: ti.i32):
+        assert x < 10
+
+    func(1)
+    with pytest.raises(RuntimeError):
+        func(20)
+    func(2)
+
+
+@ti.test(arch=ti.cpu)
+def test_events_without_async_launch():
+    e = ti.record_event()
+    assert ti.query_event(e)
+    ti.wait_event(e)
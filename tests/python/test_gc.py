@@ -132,3 +132,73 @@ def test_fuse_allocator_state():
     for i, y in enumerate(ys):
         expected = N if i == N else 0
         assert y == expected
+
+
+def _test_pointer_gc_reuse():
+    # Enough cells for the GC to run on the thread pool on CPU.
+    N = 64 * 1024
+    x = ti.field(dtype=ti.i32)
+    y = ti.field(dtype=ti.i32)
+
+    L = ti.root.pointer(ti.i, N)
+    L.dense(ti.i, 2).place(x, y)
+
+    @ti.kernel
+    def fill_x(k: ti.i32):
+        for i in range(N * 2):
+            x[i] = i + k
+
+    @ti.kernel
+    def fill_y(k: ti.i32):
+        for i in range(N * 2):
+            y[i] = i + k
+
+    @ti.kernel
+    def check_xy(k: ti.i32) -> ti.i32:
+        bad = 0
+        for i in range(N * 2):
+            if x[i] != i + k or y[i] != 0:
+                bad += 1
+        return bad
+
+    for k in range(4):
+        fill_x(k)
+        # Cells reused from earlier rounds must not leak the old values of y.
+        assert check_xy(k) == 0
+        fill_y(k)
+        L.deactivate_all()
+
+
+@ti.test(require=ti.extension.sparse)
+def test_pointer_gc_reuse():
+    _test_pointer_gc_reuse()
+
+
+@ti.test(arch=ti.cpu, cpu_max_num_threads=1)
+def test_pointer_gc_reuse_single_thread():
+    _test_pointer_gc_reuse()
+
+
+@ti.test(arch=ti.cpu, cpu_gc_lazy_zero_fill=True)
+def test_pointer_gc_reuse_lazy_zero_fill():
+    _test_pointer_gc_reuse()
+
+
+@ti.test(arch=ti.cpu, kernel_profiler=True)
+def test_gc_profiled():
+    x = ti.field(dtype=ti.i32)
+    L = ti.root.pointer(ti.i, 1024)
+    L.place(x)
+
+    @ti.kernel
+    def clear():
+        for i in x:
+            ti.deactivate(L, i)
+
+    x[3] = 1
+    clear()
+    ti.sync()
+    prog = ti.get_runtime().prog
+    prog.sync_kernel_profiler()
+    records = prog.get_kernel_profiler_records()
+    assert any('_gc_' in r.name for r in records)
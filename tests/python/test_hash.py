@@ -0,0 +1,172 @@
+import pytest
+
+import taichi as ti
+
+
+@ti.test(arch=ti.cpu)
+def test_hash_activate_on_write():
+    x = ti.field(ti.i32)
+    n = 1 << 15
+    ti.root.hash(ti.ij, (n, n), max_num_active=1024).place(x)
+
+    @ti.kernel
+    def fill():
+        for i in range(500):
+            x[i * 61, i * 53 + 7] = i + 1
+
+    @ti.kernel
+    def count() -> ti.i32:
+        s = 0
+        for i, j in x:
+            ti.atomic_add(s, 1)
+            assert x[i, j] * 61 == i + 61
+            assert j == (i // 61) * 53 + 7
+        return s
+
+    fill()
+    assert count() == 500
+    assert x[61, 60] == 2
+    assert x[1, 0] == 0
+
+
+@ti.test(arch=ti.cpu)
+def test_hash_blocks():
+    x = ti.field(ti.f32)
+    s = ti.field(ti.f32, shape=())
+    block = ti.root.hash(ti.ij, (4096, 4096), max_num_active=4096)
+    block.dense(ti.ij, 4).place(x)
+
+    @ti.kernel
+    def fill():
+        for i, j in ti.ndrange(64, 64):
+            x[i * 250, j * 200] = 1
+
+    @ti.kernel
+    def total():
+        for i, j in x:
+            s[None] += x[i, j] + 0.5
+
+    fill()
+    total()
+    # Each of the 64 * 64 cells activates a 4 x 4 block.
+    assert s[None] == 64 * 64 + 64 * 64 * 16 * 0.5
+
+
+@ti.test(arch=ti.cpu)
+def test_hash_is_active_and_deactivate():
+    x = ti.field(ti.i32)
+    h = ti.root.hash(ti.i, 1 << 26, max_num_active=64)
+    h.place(x)
+
+    @ti.kernel
+    def activate(k: ti.i32):
+        ti.activate(h, [k])
+
+    @ti.kernel
+    def deactivate(k: ti.i32):
+        ti.deactivate(h, [k])
+
+    @ti.kernel
+    def is_active(k: ti.i32) -> ti.i32:
+        return ti.is_active(h, [k])
+
+    @ti.kernel
+    def count() -> ti.i32:
+        s = 0
+        for i in x:
+            ti.atomic_add(s, 1)
+        return s
+
+    # Cycle through many more keys than the table holds at once.
+    for r in range(20):
+        keys = [r * 1000003 + k * 12345 for k in range(50)]
+        for k in keys:
+            activate(k)
+        for k in keys:
+            assert is_active(k)
+        assert not is_active(r * 1000003 + 1)
+        assert count() == 50
+        for k in keys[::2]:
+            deactivate(k)
+            assert not is_active(k)
+        assert count() == 25
+        h.deactivate_all()
+        assert count() == 0
+
+
+def _test_hash_concurrent_activation():
+    x = ti.field(ti.i32)
+    n = 1 << 16
+    ti.root.hash(ti.i, 1 << 30, max_num_active=n).place(x)
+
+    @ti.kernel
+    def fill():
+        # Every cell is written by four iterations.
+        for i in range(n * 4):
+            ti.atomic_add(x[(i % n) * 9973], 1)
+
+    @ti.kernel
+    def check() -> ti.i32:
+        s = 0
+        for i in x:
+            if x[i] == 4:
+                ti.atomic_add(s, 1)
+        return s
+
+    fill()
+    assert check() == n
+
+
+@ti.test(arch=ti.cpu, cpu_max_num_threads=1)
+def test_hash_activation_serial():
+    _test_hash_concurrent_activation()
+
+
+@ti.test(arch=ti.cpu, cpu_max_num_threads=8)
+def test_hash_concurrent_activation():
+    _test_hash_concurrent_activation()
+
+
+@ti.test(arch=ti.cpu, debug=True, gdb_trigger=False)
+def test_hash_full():
+    x = ti.field(ti.i32)
+    ti.root.hash(ti.i, 1024, max_num_active=4).place(x)
+
+    @ti.kernel
+    def fill(n: ti.i32):
+        for i in range(n):
+            x[i * 3] = 1
+
+    fill(7)
+    with pytest.raises(RuntimeError, match='Hash node is full'):
+        fill(8)
+
+
+@ti.test(arch=ti.cpu, debug=True, gdb_trigger=False)
+def test_hash_reuse_dead_slots_without_struct_for():
+    x = ti.field(ti.i32)
+    h = ti.root.hash(ti.i, 1 << 20, max_num_active=4)
+    h.place(x)
+
+    @ti.kernel
+    def activate(base: ti.i32):
+        for i in range(4):
+            x[base + i * 7] = i + 1
+
+    @ti.kernel
+    def deactivate(base: ti.i32):
+        for i in range(4):
+            ti.deactivate(h, [base + i * 7])
+
+    @ti.kernel
+    def is_active(k: ti.i32) -> ti.i32:
+        return ti.is_active(h, [k])
+
+    # The dead slots must be reclaimed by GC, as no struct-for compacts the
+    # table here.
+    for r in range(64):
+        base = r * 1009
+        activate(base)
+        assert is_active(base + 21)
+        deactivate(base)
+        assert not is_active(base)
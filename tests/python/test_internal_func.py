@@ -1,5 +1,8 @@
+import os
 import time
 
+import pytest
+
 import taichi as ti
 
 
@@ -62,6 +65,17 @@ def test_node_manager_gc():
     test_cpu()
 
 
+@pytest.mark.skipif(not os.environ.get('TI_LARGE_MEMORY_TESTS'),
+                    reason='Reserves over 4 GB of address space.')
+@ti.test(arch=ti.cpu)
+def test_list_manager_large():
+    @ti.kernel
+    def test():
+        ti.call_internal("test_list_manager_large")
+
+    test()
+
+
 @ti.test(arch=[ti.cpu, ti.cuda], debug=True)
 def test_return():
     @ti.kernel
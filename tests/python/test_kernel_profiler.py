@@ -0,0 +1,49 @@
+import json
+import os
+import tempfile
+
+import taichi as ti
+
+
+@ti.test(arch=ti.cpu, kernel_profiler=True, timeline=True)
+def test_cpu_kernel_profiler():
+    n = 100000
+    x = ti.field(ti.f32, shape=n)
+
+    @ti.kernel
+    def fill():
+        for i in range(n):
+            x[i] = i
+
+    ti.timeline_clear()
+    for _ in range(3):
+        fill()
+    ti.sync()
+    prog = ti.get_runtime().prog
+    prog.sync_kernel_profiler()
+    records = [
+        r for r in prog.get_kernel_profiler_records()
+        if 'fill' in r.name and 'range_for' in r.name
+    ]
+    assert len(records) == 3
+    for r in records:
+        assert r.iterations == n
+        assert r.load_imbalance >= 0.99
+    stats = [
+        s for s in prog.get_kernel_profiler_statistics()
+        if 'fill' in s.name and 'range_for' in s.name
+    ]
+    assert len(stats) == 1
+    assert stats[0].counter == 3
+    assert stats[0].iterations == 3 * n
+    assert sum(stats[0].worker_time) > 0
+
+    with tempfile.TemporaryDirectory() as d:
+        fn = os.path.join(d, 'timeline.json')
+        ti.timeline_save(fn)
+        with open(fn) as f:
+            events = json.load(f)
+    cpu_events = [
+        e for e in events if e['tid'] == 'cpu' and 'fill' in e['name']
+    ]
+    assert len(cpu_events) == 6
@@ -0,0 +1,79 @@
+import numpy as np
+import pytest
+
+import taichi as ti
+
+
+def _test_launch_graph():
+    n = 128
+    x = ti.field(ti.f32, shape=n)
+    steps = ti.field(ti.i32, shape=())
+
+    @ti.kernel
+    def advance(dt: ti.f32, scale: ti.i32):
+        for i in x:
+            x[i] += dt * scale * i
+
+    @ti.kernel
+    def count():
+        steps[None] += 1
+
+    graph = ti.LaunchGraph()
+    with graph.capture():
+        for _ in range(3):
+            advance(graph.arg('dt', 0.5), 2)
+            count()
+    assert graph.num_launches == 6
+    # Capturing does not launch the kernels.
+    assert steps[None] == 0
+
+    graph.run()
+    graph.run()
+    graph.set_arg('dt', 0.25)
+    graph.run()
+    expected = (2 * 3 * 0.5 * 2 + 3 * 0.25 * 2) * np.arange(n)
+    assert np.allclose(x.to_numpy(), expected)
+    assert steps[None] == 9
+
+
+@ti.test()
+def test_launch_graph():
+    _test_launch_graph()
+
+
+@ti.test(arch=ti.cpu, cpu_async_launch=True)
+def test_launch_graph_async_launch():
+    _test_launch_graph()
+
+
+@ti.test(arch=ti.cpu)
+def test_launch_graph_external_array():
+    n = 16
+    a = np.zeros(n, dtype=np.int32)
+
+    @ti.kernel
+    def add(arr: ti.ext_arr(), v: ti.i32):
+        for i in range(n):
+            arr[i] += v + i
+
+    graph = ti.LaunchGraph()
+    with graph.capture():
+        add(a, graph.arg('v', 1))
+    for v in range(4):
+        graph.set_arg('v', v)
+        graph.run()
+    ti.sync()
+    assert (a == 6 + 4 * np.arange(n)).all()
+
+
+@ti.test(arch=ti.cpu)
+def test_launch_graph_rejects_return_values():
+    @ti.kernel
+    def one() -> ti.i32:
+        return 1
+
+    graph = ti.LaunchGraph()
+    with pytest.raises(ValueError):
+        with graph.capture():
+            one()
+    assert one() == 1
@@ -59,3 +59,75 @@ def test_nested_3d():
     for _ in range(1000):
         i, j, k = randrange(n), randrange(n), randrange(n)
         assert x[i, j, k] == (i * n + j) * n + k
+
+
+def _test_sparse_listgen():
+    x = ti.field(ti.i32)
+    n = 512
+
+    ti.root.pointer(ti.ij, 64).bitmasked(ti.ij, 4).dense(ti.ij, 2).place(x)
+
+    @ti.kernel
+    def activate():
+        for i, j in ti.ndrange(n, n):
+            if (i // 8 + j // 8) % 3 == 0 and (i + j) % 16 < 8:
+                x[i, j] = 1
+
+    @ti.kernel
+    def count() -> ti.i32:
+        s = 0
+        for i, j in x:
+            s += x[i, j]
+        return s
+
+    @ti.kernel
+    def count_blocks() -> ti.i32:
+        s = 0
+        for i, j in x.parent().parent():
+            s += 1
+        return s
+
+    activate()
+    xnp = x.to_numpy()
+    assert count() == xnp.sum()
+    assert count_blocks() == (
+        xnp.reshape(n // 2, 2, n // 2, 2).max(axis=(1, 3)) > 0).sum()
+
+
+@ti.test(arch=ti.cpu, cpu_deterministic_listgen=True)
+def test_sparse_listgen_deterministic():
+    _test_sparse_listgen()
+
+
+@ti.test(arch=ti.cpu, cpu_deterministic_listgen=False)
+def test_sparse_listgen_nondeterministic():
+    _test_sparse_listgen()
+
+
+@ti.test(arch=ti.cpu, cpu_deterministic_listgen=True)
+def test_deterministic_listgen_order():
+    x = ti.field(ti.i32)
+    order = ti.field(ti.i32)
+    n = 1 << 16
+    ti.root.pointer(ti.i, n // 64).pointer(ti.i, 8).dense(ti.i, 8).place(x)
+    ti.root.dynamic(ti.i, n, chunk_size=1024).place(order)
+
+    @ti.kernel
+    def activate():
+        for i in range(n):
+            if (i // 8 + i // 64) % 3 == 0:
+                x[i] = 1
+
+    @ti.kernel
+    def record():
+        # The lists are still generated on all threads.
+        ti.serialize()
+        for i in x:
+            ti.append(order.parent(), [], i)
+
+    activate()
+    record()
+    # A serial struct-for visits the cells in the order of the serially
+    # generated lists, i.e. by increasing index in 1D.
+    expected = [i for i in range(n) if (i // 8 + i // 64) % 3 == 0]
+    assert order.to_numpy()[:len(expected)].tolist() == expected
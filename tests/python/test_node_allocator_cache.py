@@ -0,0 +1,74 @@
+import taichi as ti
+
+
+@ti.test(arch=ti.cpu, cpu_node_allocator_cache=True)
+def test_pointer():
+    n = 256
+    x = ti.field(ti.i32)
+    block = ti.root.pointer(ti.ij, n // 8)
+    block.pointer(ti.ij, 2).dense(ti.ij, 4).place(x)
+
+    @ti.kernel
+    def fill(k: ti.i32):
+        for i, j in ti.ndrange(n, n):
+            if (i + j) % k == 0:
+                x[i, j] = i * n + j
+
+    @ti.kernel
+    def count() -> ti.i32:
+        s = 0
+        for i, j in x:
+            s += 1
+        return s
+
+    @ti.kernel
+    def check(k: ti.i32) -> ti.i32:
+        bad = 0
+        for i, j in ti.ndrange(n, n):
+            expected = 0
+            if (i + j) % k == 0:
+                expected = i * n + j
+            if x[i, j] != expected:
+                bad += 1
+        return bad
+
+    for k in [3, 7, 2, 5]:
+        block.deactivate_all()
+        fill(k)
+        assert check(k) == 0
+    assert count() > 0
+
+
+@ti.test(arch=ti.cpu, cpu_node_allocator_cache=True)
+def test_dynamic():
+    n = 64
+    m = 1000
+    x = ti.field(ti.i32)
+    block = ti.root.dense(ti.i, n)
+    pixel = block.dynamic(ti.j, m, chunk_size=4)
+    pixel.place(x)
+
+    @ti.kernel
+    def append(k: ti.i32):
+        for i, j in ti.ndrange(n, m):
+            if j % k == 0:
+                ti.append(pixel, i, j)
+
+    @ti.kernel
+    def total() -> ti.i32:
+        s = 0
+        for i in range(n):
+            for j in range(ti.length(pixel, i)):
+                s += x[i, j]
+        return s
+
+    @ti.kernel
+    def clear():
+        for i in range(n):
+            ti.deactivate(pixel, i)
+
+    for k in [1, 3, 7]:
+        append(k)
+        expected = n * sum(range(0, m, k))
+        assert total() == expected
+        clear()
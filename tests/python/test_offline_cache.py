@@ -0,0 +1,75 @@
+import tempfile
+
+import taichi as ti
+
+
+def run_saxpy(cache_dir, arch=ti.cpu):
+    ti.init(arch=arch, offline_cache=True, offline_cache_file_path=cache_dir)
+    n = 1024
+    x = ti.field(ti.f32, shape=n)
+    y = ti.field(ti.f32, shape=n)
+
+    @ti.kernel
+    def init():
+        for i in x:
+            x[i] = i
+            y[i] = 1
+
+    @ti.kernel
+    def saxpy(a: ti.f32) -> ti.f32:
+        s = 0.0
+        for i in x:
+            y[i] = a * x[i] + y[i]
+            s += y[i]
+        return s
+
+    init()
+    return saxpy(2.0)
+
+
+@ti.test(arch=ti.cpu)
+def test_offline_cache_hit():
+    with tempfile.TemporaryDirectory() as cache_dir:
+        stats = ti.get_kernel_stats()
+        stats.clear()
+        cold = run_saxpy(cache_dir)
+        assert stats.get_counters().get('llvm_offline_cache_hits', 0) == 0
+
+        stats.clear()
+        warm = run_saxpy(cache_dir)
+        assert stats.get_counters()['llvm_offline_cache_hits'] >= 2
+        assert cold == warm == 1024 * 1023 + 1024
+
+
+@ti.test(arch=ti.cc)
+def test_offline_cache_hit_cc():
+    with tempfile.TemporaryDirectory() as cache_dir:
+        stats = ti.get_kernel_stats()
+        stats.clear()
+        cold = run_saxpy(cache_dir, arch=ti.cc)
+        assert stats.get_counters().get('cc_kernel_cache_hits', 0) == 0
+
+        # The kernels are renamed, but their shared objects are reused.
+        stats.clear()
+        warm = run_saxpy(cache_dir, arch=ti.cc)
+        assert stats.get_counters()['cc_kernel_cache_hits'] >= 2
+        assert stats.get_counters().get('cc_kernel_cache_misses', 0) == 0
+        assert cold == warm == 1024 * 1023 + 1024
+
+
+@ti.test(arch=ti.cpu)
+def test_offline_cache_layout_change():
+    with tempfile.TemporaryDirectory() as cache_dir:
+        for n in [16, 32]:
+            ti.init(arch=ti.cpu,
+                    offline_cache=True,
+                    offline_cache_file_path=cache_dir)
+            x = ti.field(ti.i32, shape=n)
+
+            @ti.kernel
+            def fill():
+                for i in x:
+                    x[i] = i
+
+            fill()
+            assert x.to_numpy().sum() == n * (n - 1) // 2
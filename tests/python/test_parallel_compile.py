@@ -0,0 +1,95 @@
+import numpy as np
+
+import taichi as ti
+
+
+@ti.test(arch=ti.cpu, num_compile_threads=4)
+def test_multiple_offloads():
+    n = 128
+    x = ti.field(ti.i32, shape=n)
+    y = ti.field(ti.i32, shape=n)
+
+    @ti.kernel
+    def run() -> ti.i32:
+        for i in x:
+            x[i] = i
+        for i in y:
+            y[i] = x[n - 1 - i] * 2
+        s = 0
+        for i in y:
+            s += y[i] - x[i]
+        return s
+
+    assert run() == n * (n - 1) // 2
+    assert (y.to_numpy() == np.arange(n)[::-1] * 2).all()
+
+
+@ti.test(arch=[ti.cpu, ti.cc], num_compile_threads=4)
+def test_precompile():
+    n = 64
+    x = ti.field(ti.f32, shape=n)
+
+    @ti.kernel
+    def fill(v: ti.f32):
+        for i in x:
+            x[i] = v + i
+
+    @ti.kernel
+    def scale(k: ti.template()):
+        for i in x:
+            x[i] *= k
+
+    @ti.kernel
+    def total() -> ti.f32:
+        s = 0.0
+        for i in x:
+            s += x[i]
+        return s
+
+    ti.precompile((fill, (0.0, )), (scale, (2, )), (scale, (3, )), total)
+    fill(1.0)
+    scale(2)
+    scale(3)
+    assert total() == sum((1.0 + i) * 6 for i in range(n))
+
+
+@ti.test(arch=ti.cpu)
+def test_precompile_without_compile_threads():
+    x = ti.field(ti.i32, shape=())
+
+    @ti.kernel
+    def inc(v: ti.i32):
+        x[None] += v
+
+    ti.precompile((inc, (0, )))
+    ti.precompile((inc, (0, )))
+    inc(3)
+    assert x[None] == 3
+
+
+@ti.test(arch=ti.cpu, num_compile_threads=4)
+def test_new_fields_after_compile():
+    a = ti.field(ti.i32, shape=8)
+
+    @ti.kernel
+    def fill_a():
+        for i in a:
+            a[i] = i
+
+    fill_a()
+
+    # Kernels compiled after the SNode tree grows must see the new fields on
+    # every compile thread.
+    b = ti.field(ti.i32, shape=8)
+
+    @ti.kernel
+    def fill_b():
+        for i in b:
+            b[i] = a[i] * 3
+        for i in a:
+            a[i] += 1
+
+    ti.precompile(fill_b)
+    fill_b()
+    assert (b.to_numpy() == np.arange(8) * 3).all()
+    assert (a.to_numpy() == np.arange(8) + 1).all()
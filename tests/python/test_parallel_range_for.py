@@ -19,3 +19,141 @@ def test_parallel_range_for():
     val_np = val.to_numpy()
     for i in range(n):
         assert val_np[i] == i
+
+
+def _test_parallel_range_for_reductions():
+    n = 100000
+    x = ti.field(ti.f32, shape=n)
+    total = ti.field(ti.i32, shape=())
+    hist = ti.field(ti.i32, shape=7)
+    max_val = ti.field(ti.f32, shape=())
+
+    @ti.kernel
+    def fill():
+        for i in x:
+            x[i] = (i * 37 % 1001) * 0.5
+
+    @ti.kernel
+    def reduce(m: ti.i32):
+        for i in range(m):
+            total[None] += i % 3
+            hist[i % 7] += 1
+            ti.atomic_max(max_val[None], x[i])
+
+    fill()
+    m = n - 3
+    reduce(m)
+    assert total[None] == sum(i % 3 for i in range(m))
+    for k in range(7):
+        assert hist[k] == len(range(k, m, 7))
+    assert max_val[None] == 500.0
+
+
+@ti.test(arch=[ti.cc, ti.cpu])
+def test_parallel_range_for_reductions():
+    _test_parallel_range_for_reductions()
+
+
+@ti.test(arch=[ti.cc, ti.cpu], cpu_max_num_threads=1)
+def test_parallel_range_for_reductions_serial():
+    _test_parallel_range_for_reductions()
+
+
+@ti.test(arch=[ti.cc, ti.cpu], default_cpu_block_dim=4)
+def test_parallel_range_for_reductions_small_blocks():
+    _test_parallel_range_for_reductions()
+
+
+def _test_range_for_schedule():
+    n = 10000
+    x = ti.field(ti.i32, shape=n)
+    total = ti.field(ti.i64, shape=())
+
+    @ti.kernel
+    def skewed(m: ti.i32):
+        for i in range(m):
+            # Iterations get more expensive towards the end of the range.
+            s = 0
+            for j in range(i // 100):
+                s += j
+            x[i] = s
+            total[None] += i
+
+    # Enough launches to go through all the candidates when autotuning.
+    for k in range(40):
+        m = n - k
+        total[None] = 0
+        skewed(m)
+        assert total[None] == m * (m - 1) // 2
+    x_np = x.to_numpy()
+    for i in [0, 99, 100, 5000, n - 40]:
+        assert x_np[i] == (i // 100) * (i // 100 - 1) // 2
+
+
+@ti.test(arch=ti.cpu, cpu_range_for_schedule='dynamic')
+def test_range_for_schedule_dynamic():
+    _test_range_for_schedule()
+
+
+@ti.test(arch=ti.cpu, cpu_range_for_schedule='guided')
+def test_range_for_schedule_guided():
+    _test_range_for_schedule()
+
+
+@ti.test(arch=ti.cpu, cpu_range_for_schedule='auto')
+def test_range_for_schedule_auto():
+    _test_range_for_schedule()
+
+
+@ti.test(arch=ti.cpu, cpu_range_for_schedule='auto', kernel_profiler=True)
+def test_range_for_schedule_auto_profiled():
+    _test_range_for_schedule()
+
+
+def _test_simd_range_for():
+    # Not a multiple of any SIMD width, so that the last vector is partial.
+    n = 1027
+    x = ti.field(ti.f32, shape=n)
+    y = ti.field(ti.f32, shape=n)
+    idx = ti.field(ti.i32, shape=n)
+    total = ti.field(ti.i32, shape=())
+
+    @ti.kernel
+    def fill():
+        for i in range(n):
+            x[i] = i * 0.5
+            idx[i] = (i * 7) % n
+
+    @ti.kernel
+    def saxpy(a: ti.f32, m: ti.i32):
+        for i in range(3, m):
+            y[i] = a * x[i] + x[idx[i]]
+
+    @ti.kernel
+    def count_odd():
+        for i in range(n):
+            if i % 2 == 0:
+                continue
+            total[None] += 1
+
+    fill()
+    saxpy(2.0, n - 1)
+    y_np = y.to_numpy()
+    for i in range(n):
+        expected = 0 if i < 3 or i == n - 1 else i + (i * 7) % n * 0.5
+        assert y_np[i] == expected
+    count_odd()
+    assert total[None] == n // 2
+
+
+@ti.test(arch=ti.cpu, cpu_simd_range_for=True)
+def test_simd_range_for():
+    _test_simd_range_for()
+
+
+@ti.test(arch=ti.cpu,
+         cpu_simd_range_for=True,
+         simd_width=4,
+         cpu_range_for_schedule='dynamic')
+def test_simd_range_for_width_4_dynamic():
+    _test_simd_range_for()
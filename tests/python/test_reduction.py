@@ -143,3 +143,39 @@ def test_reduction_any_arr():
     n = 1024
     x = np.ones(n, dtype=np.int32)
     assert reduce(x) == -n
+
+
+def _test_reduction_struct_for():
+    n = 1024 * 64
+    x = ti.field(ti.i32)
+    ti.root.pointer(ti.i, n // 256).dense(ti.i, 256).place(x)
+    total = ti.field(ti.i32, shape=())
+    max_val = ti.field(ti.i32, shape=())
+
+    @ti.kernel
+    def fill():
+        for i in range(n):
+            if i // 256 % 3 != 1:
+                x[i] = i % 1000
+
+    @ti.kernel
+    def reduce():
+        for i in x:
+            total[None] += x[i]
+            ti.atomic_max(max_val[None], x[i] * 2 + 1)
+
+    fill()
+    reduce()
+    active = [i for i in range(n) if i // 256 % 3 != 1]
+    assert total[None] == sum(i % 1000 for i in active)
+    assert max_val[None] == 1999
+
+
+@ti.test(require=ti.extension.sparse)
+def test_reduction_struct_for():
+    _test_reduction_struct_for()
+
+
+@ti.test(arch=ti.cpu, cpu_max_num_threads=1)
+def test_reduction_struct_for_serial():
+    _test_reduction_struct_for()
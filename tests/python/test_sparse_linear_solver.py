@@ -52,3 +52,101 @@ def test_sparse_LLT_solver(solver_type):
     x = solver.solve(b)
     for i in range(n):
         assert x[i] == ti.approx(res[i])
+
+
+def fill_builder(n, dtype, scale=1.0):
+    Abuilder = ti.linalg.SparseMatrixBuilder(n,
+                                             n,
+                                             max_num_triplets=100,
+                                             dtype=dtype)
+
+    @ti.kernel
+    def fill(Abuilder: ti.linalg.sparse_matrix_builder(dtype=dtype),
+             InputArray: ti.ext_arr(), scale: ti.f64):
+        for i, j in ti.ndrange(n, n):
+            Abuilder[i, j] += InputArray[i, j] * scale
+
+    fill(Abuilder, Aarray, scale)
+    return Abuilder
+
+
+@pytest.mark.parametrize("dtype", [ti.f32, ti.f64])
+@pytest.mark.parametrize("solver_type", ["LLT", "LDLT", "LU"])
+@ti.test(arch=ti.cpu)
+def test_sparse_solver_multiple_rhs(dtype, solver_type):
+    n = 4
+    A = fill_builder(n, dtype).build(dtype=dtype)
+    solver = ti.linalg.SparseSolver(dtype=dtype, solver_type=solver_type)
+    assert solver.compute(A)
+    b = np.stack([np.arange(1, n + 1), np.arange(1, n + 1) * 2], axis=1)
+    x = solver.solve(b)
+    assert x.shape == (n, 2)
+    assert x.dtype == (np.float64 if dtype == ti.f64 else np.float32)
+    rel = 1e-12 if dtype == ti.f64 else 1e-4
+    for i in range(n):
+        assert x[i, 0] == pytest.approx(res[i], rel=rel)
+        assert x[i, 1] == pytest.approx(res[i] * 2, rel=rel)
+
+
+@ti.test(arch=ti.cpu)
+def test_sparse_solver_refactorize_from_builder():
+    n = 4
+    solver = ti.linalg.SparseSolver(dtype=ti.f64, solver_type="LLT")
+    b = np.arange(1, n + 1, dtype=np.float64)
+    Abuilder = ti.linalg.SparseMatrixBuilder(n,
+                                             n,
+                                             max_num_triplets=100,
+                                             dtype=ti.f64)
+
+    @ti.kernel
+    def fill(Abuilder: ti.linalg.sparse_matrix_builder(dtype=ti.f64),
+             InputArray: ti.ext_arr(), scale: ti.f64):
+        for i, j in ti.ndrange(n, n):
+            Abuilder[i, j] += InputArray[i, j] * scale
+
+    fill(Abuilder, Aarray, 1.0)
+    solver.analyze_pattern(Abuilder.build(reuse_pattern=True))
+    for scale in [1.0, 2.0, 4.0]:
+        fill(Abuilder, Aarray, scale)
+        solver.factorize(Abuilder)
+        assert solver.info()
+        x = solver.solve(b)
+        for i in range(n):
+            assert x[i] == pytest.approx(res[i] / scale)
+
+
+@pytest.mark.parametrize("dtype", [ti.f32, ti.f64])
+@pytest.mark.parametrize("solver_type,preconditioner", [("CG", "Jacobi"),
+                                                        ("CG", "IC"),
+                                                        ("BICGSTAB", "Jacobi"),
+                                                        ("BICGSTAB", "ILUT")])
+@ti.test(arch=ti.cpu)
+def test_sparse_iterative_solver(dtype, solver_type, preconditioner):
+    n = 4
+    A = fill_builder(n, dtype).build()
+    solver = ti.linalg.SparseSolver(dtype=dtype,
+                                    solver_type=solver_type,
+                                    preconditioner=preconditioner,
+                                    tol=1e-12 if dtype == ti.f64 else 1e-6)
+    solver.compute(A)
+    b = np.arange(1, n + 1)
+    x = solver.solve(b)
+    assert solver.info()
+    for i in range(n):
+        assert x[i] == ti.approx(res[i])
+    cold_iterations = solver.num_iterations()
+
+    x = solver.solve(b, x0=res)
+    assert solver.info()
+    assert solver.num_iterations() <= cold_iterations
+    for i in range(n):
+        assert x[i] == ti.approx(res[i])
+
+
+@ti.test(arch=ti.cpu)
+def test_sparse_solver_dtype_mismatch():
+    n = 4
+    A = fill_builder(n, ti.f32).build()
+    solver = ti.linalg.SparseSolver(dtype=ti.f64)
+    with pytest.raises(RuntimeError):
+        solver.compute(A)
@@ -1,3 +1,5 @@
+import pytest
+
 import taichi as ti
 
 
@@ -197,3 +199,124 @@ def test_sparse_matrix_nonsymmetric_multiplication():
     for i in range(n):
         for j in range(m):
             assert C[i, j] == GT[i][j]
+
+
+@ti.test(arch=ti.cpu)
+def test_sparse_matrix_builder_f64():
+    n = 8
+    Abuilder = ti.linalg.SparseMatrixBuilder(n,
+                                             n,
+                                             max_num_triplets=100,
+                                             dtype=ti.f64)
+
+    @ti.kernel
+    def fill(Abuilder: ti.linalg.sparse_matrix_builder(dtype=ti.f64)):
+        for i, j in ti.ndrange(n, n):
+            Abuilder[i, j] += (i + j) * 1e-10
+
+    fill(Abuilder)
+    A = Abuilder.build()
+    assert A.dtype == ti.f64
+    for i in range(n):
+        for j in range(n):
+            assert A[i, j] == (i + j) * 1e-10
+    # The scale is not narrowed to f32, which would round it to 1.
+    scale = 1 + 1e-12
+    B = A * scale
+    C = scale * A
+    for i in range(n):
+        for j in range(n):
+            assert B[i, j] == (i + j) * 1e-10 * scale
+            assert C[i, j] == (i + j) * 1e-10 * scale
+
+
+@ti.test(arch=ti.cpu)
+def test_sparse_matrix_builder_dtype_mismatch():
+    n = 8
+    Abuilder = ti.linalg.SparseMatrixBuilder(n, n, max_num_triplets=100)
+
+    @ti.kernel
+    def fill(Abuilder: ti.linalg.sparse_matrix_builder(dtype=ti.f64)):
+        for i in range(n):
+            Abuilder[i, i] += i
+
+    with pytest.raises(ti.KernelArgError):
+        fill(Abuilder)
+
+
+@pytest.mark.parametrize('fmt', ['CSC', 'CSR'])
+@pytest.mark.parametrize('index_dtype', [ti.i32, ti.i64])
+@ti.test(arch=ti.cpu)
+def test_sparse_matrix_builder_formats(fmt, index_dtype):
+    n = 64
+    Abuilder = ti.linalg.SparseMatrixBuilder(n, n, max_num_triplets=n * n)
+
+    @ti.kernel
+    def fill(Abuilder: ti.linalg.sparse_matrix_builder()):
+        for i, j in ti.ndrange(n, n):
+            if (i * 7 + j * 3) % 5 == 0:
+                Abuilder[i, j] += i - j
+
+    fill(Abuilder)
+    A = Abuilder.build(_format=fmt, index_dtype=index_dtype)
+    assert A.format == fmt
+    for i in range(n):
+        for j in range(n):
+            expected = i - j if (i * 7 + j * 3) % 5 == 0 else 0
+            assert A[i, j] == expected
+
+
+@ti.test(arch=ti.cpu)
+def test_sparse_matrix_builder_duplicates():
+    n = 16
+    m = 1000
+    Abuilder = ti.linalg.SparseMatrixBuilder(n, n, max_num_triplets=n * m)
+
+    @ti.kernel
+    def fill(Abuilder: ti.linalg.sparse_matrix_builder()):
+        for i, k in ti.ndrange(n, m):
+            Abuilder[i, (i + k) % 2] += 1
+            if k % 2 == 0:
+                Abuilder[i, (i + k) % 2] -= 1
+
+    fill(Abuilder)
+    A = Abuilder.build()
+    assert A.num_nonzeros() == 2 * n
+    for i in range(n):
+        assert A[i, 0] == m // 2
+        assert A[i, 1] == m // 2
+
+
+@pytest.mark.parametrize('fmt', ['CSC', 'CSR'])
+@ti.test(arch=ti.cpu)
+def test_sparse_matrix_builder_reuse_pattern(fmt):
+    n = 32
+    Abuilder = ti.linalg.SparseMatrixBuilder(n, n, max_num_triplets=3 * n)
+
+    @ti.kernel
+    def fill(Abuilder: ti.linalg.sparse_matrix_builder(), k: ti.f32):
+        for i in range(n):
+            Abuilder[i, i] += 2 * k
+            if i > 0:
+                Abuilder[i, i - 1] -= k
+            if i < n - 1:
+                Abuilder[i, i + 1] -= k
+
+    fill(Abuilder, 1)
+    A = Abuilder.build(_format=fmt, reuse_pattern=True)
+    fill(Abuilder, 3)
+    B = Abuilder.build(_format=fmt, reuse_pattern=True)
+    assert B.num_nonzeros() == A.num_nonzeros()
+    for i in range(n):
+        for j in range(n):
+            assert B[i, j] == 3 * A[i, j]
+
+    # Triplets outside of the kept pattern fall back to a full build.
+    @ti.kernel
+    def fill_corner(Abuilder: ti.linalg.sparse_matrix_builder()):
+        Abuilder[0, n - 1] += 1
+
+    fill_corner(Abuilder)
+    C = Abuilder.build(_format=fmt, reuse_pattern=True)
+    assert C.num_nonzeros() == 1
+    assert C[0, n - 1] == 1